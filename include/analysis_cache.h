@@ -0,0 +1,66 @@
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+#include "base.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Cache de analise enderecado por conteudo
+ *
+ * Guarda o resultado de uma classe (saida formatada ou fragmento do
+ * indice) sob uma chave de 64 bits = hash dos bytes do .class misturado
+ * com o que muda o resultado (modo de saida, flags, versao do formato).
+ * Nas proximas execucoes a classe inalterada so e lida e hasheada: parse,
+ * disassembly e formatacao sao pulados.
+ *
+ * Em disco: <dir>/<2 hexa>/<16 hexa>, cada entrada com cabecalho
+ * (magic, chave, tamanho) e o payload; gravada com tmp + rename, entao
+ * execucoes concorrentes nunca veem entrada parcial. LRU pelo mtime: um
+ * acerto "toca" a entrada e, ao fechar, se o total passar do limite, as
+ * menos usadas sao apagadas ate 90% dele.
+ *
+ * get/put sao seguros entre threads.
+ * ----------------------------------------------------------- */
+
+#define ANALYSIS_CACHE_DEFAULT_MAX (256ull * 1024 * 1024)
+
+/* Versao dos resultados guardados: mude quando a saida ou os fragmentos mudarem de formato */
+#define ANALYSIS_CACHE_FORMAT 2u
+
+typedef struct analysis_cache AnalysisCache;
+
+/* Cria o diretorio se preciso. max_bytes = 0: ANALYSIS_CACHE_DEFAULT_MAX. */
+AnalysisCache *analysis_cache_open(const char *dir, uint64_t max_bytes, Status *out_status);
+
+/* Se o total passou do limite, apaga as entradas menos usadas (LRU) ate 90% dele. */
+void analysis_cache_trim(AnalysisCache *c);
+
+/* Aplica o limite, grava o total e libera (seguro com NULL). */
+void analysis_cache_close(AnalysisCache *c);
+
+/* Hash rapido nao criptografico (64 bits) de data, encadeavel via seed. */
+uint64_t analysis_cache_hash(const void *data, size_t len, uint64_t seed);
+
+/* Semente das chaves de um tipo de resultado ("saida modo=...", "index"...), com ANALYSIS_CACHE_FORMAT. */
+uint64_t analysis_cache_seed(const char *description);
+
+/* Acerto: *out_data (malloc) e *out_len; false se ausente ou corrompida. */
+bool analysis_cache_get(AnalysisCache *c, uint64_t key, char **out_data, size_t *out_len);
+
+/* Grava (ou substitui) a entrada; falhas de IO so deixam de cachear. */
+Status analysis_cache_put(AnalysisCache *c, uint64_t key, const void *data, size_t len);
+
+/* Estatisticas da execucao. */
+void analysis_cache_stats(const AnalysisCache *c, uint64_t *hits, uint64_t *misses, uint64_t *evicted);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ANALYSIS_CACHE_H */
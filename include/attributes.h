@@ -44,6 +44,7 @@ typedef struct {
     LocalVariableTableEntry *local_variable_table;
 } CodeAttribute;
 
+// Em falha, libera o que alocou e deixa out zerado (free_code_attribute vira no-op)
 Status parse_code_attribute(const ClassFile *cf, const AttributeInfo *attr, CodeAttribute *out);
 
 void free_code_attribute(CodeAttribute *code_attr);
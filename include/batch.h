@@ -0,0 +1,32 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "cli.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Visualizacao em lote
+ *
+ * Cada entrada pode ser um .class, um diretorio (recursivo), um jar/zip,
+ * "app.jar!/pkg/A.class" ou "@lista" (arquivo com um desses caminhos por
+ * linha; linhas vazias e iniciadas por '#' sao ignoradas).
+ *
+ * As classes sao processadas em janelas: leitura, parse, disassembly e
+ * formatacao (pretty/json) de cada classe rodam no pool de threads e
+ * escrevem num buffer proprio; a classe e liberada logo em seguida. Os
+ * buffers vao para o stdout na ordem das entradas ao fim de cada janela
+ * (saida em fluxo, memoria limitada pela janela), ou, com --unordered,
+ * assim que cada classe fica pronta.
+ * ----------------------------------------------------------- */
+
+/* Processa options->inputs; retorna o codigo de saida do processo (0 ou 1). */
+int batch_run(const CliOptions *options);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BATCH_H */
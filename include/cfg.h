@@ -0,0 +1,116 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include "attributes.h"
+#include "base.h"
+#include "disasm.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Grafo de fluxo de controle (blocos basicos) de um metodo
+ *
+ * Construido sobre a saida de disasm_decode: uma instrucao inicia bloco
+ * se for a primeira, alvo de salto/switch, inicio de handler, inicio ou
+ * fim de faixa protegida, ou se seguir um salto/switch/retorno/athrow.
+ * Arestas: fluxo sequencial, saltos (if*, goto, jsr), todos os alvos de
+ * tableswitch/lookupswitch (sem repeticao) e, para cada bloco dentro de
+ * uma faixa da exception_table, uma aresta para o handler.
+ *
+ * Sobre o grafo: ordem pos-ordem reversa (a partir do bloco 0; blocos
+ * inalcancaveis ficam de fora), dominadores imediatos (Cooper, Harvey e
+ * Kennedy) e lacos naturais (aresta de volta u -> h com h dominando u),
+ * aninhados pelo cabecalho. Ciclos sem cabecalho dominante (irredutiveis)
+ * so ligam 'irreducible'.
+ *
+ * Tudo e proporcional ao numero de instrucoes e arestas (os lacos, ao
+ * tamanho dos corpos): metodos de dezenas de milhares de instrucoes sao
+ * processados sem custo quadratico. A memoria fica no Cfg e e reaproveitada
+ * entre metodos (so cresce), como a DisasmArena.
+ *
+ * jsr/ret: jsr tem aresta para a sub-rotina e para a instrucao seguinte;
+ * ret encerra o bloco sem sucessores.
+ * ----------------------------------------------------------- */
+
+#define CFG_NONE UINT32_MAX
+
+typedef enum {
+    CFG_EDGE_FALLTHROUGH = 0,   /* proxima instrucao */
+    CFG_EDGE_BRANCH,            /* if*, goto, jsr */
+    CFG_EDGE_SWITCH,            /* alvo (ou default) de tableswitch/lookupswitch */
+    CFG_EDGE_EXCEPTION          /* bloco protegido -> handler */
+} CfgEdgeKind;
+
+#define CFG_BLOCK_REACHABLE   0x01
+#define CFG_BLOCK_HANDLER     0x02   /* inicio de handler de excecao */
+#define CFG_BLOCK_LOOP_HEADER 0x04
+
+typedef struct {
+    uint32_t from, to;          /* indices de bloco */
+    uint8_t kind;               /* CfgEdgeKind */
+} CfgEdge;
+
+typedef struct {
+    uint32_t start_pc, end_pc;  /* [start_pc, end_pc) */
+    uint32_t first_insn, insn_count;    /* faixa em DisasmMethod.insns */
+    uint32_t succ_first, succ_count;    /* edges[succ_first ..]: arestas que saem do bloco */
+    uint32_t pred_first, pred_count;    /* preds[pred_first ..]: indices das arestas que chegam */
+    uint32_t idom;              /* dominador imediato; CFG_NONE na entrada e nos inalcancaveis */
+    uint32_t rpo;               /* posicao na pos-ordem reversa; CFG_NONE se inalcancavel */
+    uint32_t loop;              /* laco mais interno (loops[]); CFG_NONE fora de lacos */
+    uint32_t dom_pre, dom_post; /* numeracao da arvore de dominadores (cfg_dominates) */
+    uint16_t loop_depth;        /* 0 fora de lacos */
+    uint8_t flags;              /* CFG_BLOCK_* */
+} CfgBlock;
+
+typedef struct {
+    uint32_t header;            /* bloco cabecalho */
+    uint32_t parent;            /* laco que contem este; CFG_NONE se externo */
+    uint32_t block_count;       /* blocos do corpo (cabecalho e lacos internos inclusos) */
+    uint16_t depth;             /* 1 = laco externo */
+} CfgLoop;
+
+typedef struct {
+    CfgBlock *blocks;
+    uint32_t block_count;
+    CfgEdge *edges;             /* agrupadas por origem, na ordem dos blocos */
+    uint32_t edge_count;
+    uint32_t *preds;            /* indices em edges, agrupados por destino */
+    uint32_t *order;            /* blocos alcancaveis em pos-ordem reversa */
+    uint32_t reachable_count;
+    CfgLoop *loops;             /* externos antes dos internos */
+    uint32_t loop_count;
+    bool irreducible;
+
+    /* uso interno: vetores reaproveitados (ver cfg.c) */
+    void *mem[12];
+    size_t cap[12];
+} Cfg;
+
+void cfg_init(Cfg *cfg);
+void cfg_free(Cfg *cfg);
+
+/*
+ * Monta o grafo das instrucoes em m (decodificadas de code). Os blocos
+ * apontam para m->insns por indice; validos ate o proximo cfg_build.
+ * Alvos fora do codigo ou no meio de uma instrucao sao ignorados.
+ *
+ * @return OK, ou ERR_MEMORY.
+ */
+Status cfg_build(Cfg *cfg, const DisasmMethod *m, const CodeAttribute *code);
+
+/* true se o bloco a domina o bloco b (ambos alcancaveis; a domina a si mesmo). */
+bool cfg_dominates(const Cfg *cfg, uint32_t a, uint32_t b);
+
+/* Nome da aresta ("fallthrough", "branch", "switch", "exception"). */
+const char *cfg_edge_kind_name(uint8_t kind);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFG_H */
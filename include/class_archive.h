@@ -0,0 +1,66 @@
+#ifndef CLASS_ARCHIVE_H
+#define CLASS_ARCHIVE_H
+
+#include "base.h"
+#include "classfile.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Arquivo de classes compartilhado (estilo CDS)
+ *
+ * class_archive_dump() serializa classes ja analisadas num unico arquivo
+ * relocavel (so offsets, nenhum ponteiro): constant pool, tabela de
+ * simbolos internados (cada Utf8 aparece uma vez), membros, atributos
+ * crus e as tabelas do member_index.
+ *
+ * class_archive_open() mapeia o arquivo somente-leitura (MAP_SHARED), de
+ * modo que varios processos no mesmo host dividem as mesmas paginas. As
+ * classes sao materializadas sob demanda: os vetores de ponteiros do
+ * ClassFile sao montados num bloco unico, mas strings Utf8, interfaces,
+ * payloads de atributos (inclusive o bytecode) e slots do indice de
+ * membros apontam direto para o mapeamento. Nenhum byte e re-analisado.
+ *
+ * O formato usa a ordem de bytes e o layout nativos do host, como um
+ * cache local: um arquivo gerado em outra arquitetura e recusado.
+ * ----------------------------------------------------------- */
+
+typedef struct class_archive ClassArchive;
+
+/*
+ * Grava as classes em path (via arquivo temporario + rename). Classes com
+ * o mesmo nome interno aparecem uma vez (vale a primeira). out_size
+ * (opcional) recebe o tamanho final em bytes.
+ */
+Status class_archive_dump(const char *path, ClassFile *const *classes, size_t count,
+                          size_t *out_size);
+
+/* Mapeia e valida o cabecalho. NULL em erro (codigo em *out_status). */
+ClassArchive *class_archive_open(const char *path, Status *out_status);
+
+/* Libera as classes materializadas e desfaz o mapeamento (seguro com NULL). */
+void class_archive_close(ClassArchive *ar);
+
+/* Numero de classes; os indices seguem a ordem do nome interno. */
+size_t class_archive_count(const ClassArchive *ar);
+const char *class_archive_name(const ClassArchive *ar, size_t i);
+
+/*
+ * Materializa (uma vez) a i-esima classe. NULL se o registro estiver
+ * corrompido. O arquivo continua dono da classe: free_classfile() sobre
+ * ela so libera o estado de execucao (cp_cache.h) e ela vive ate
+ * class_archive_close().
+ */
+ClassFile *class_archive_get(ClassArchive *ar, size_t i);
+
+/* Busca por nome interno (ex: "java/lang/Object"); NULL se ausente. */
+ClassFile *class_archive_find(ClassArchive *ar, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLASS_ARCHIVE_H */
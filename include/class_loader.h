@@ -0,0 +1,120 @@
+#ifndef CLASS_LOADER_H
+#define CLASS_LOADER_H
+
+#include "base.h"
+#include "class_archive.h"
+#include "classfile.h"
+#include "class_registry.h"
+#include "thread_pool.h"
+#include "zip_source.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Carregador de classes em lote
+ *
+ * 1. class_list_collect() enumera os .class de um arquivo, diretorio
+ *    (recursivo) ou jar/zip, em ordem lexicografica de caminho. Entradas
+ *    de jar aparecem como "app.jar!/pkg/A.class".
+ * 2. class_loader_parse_all() le e faz o parse de todos em paralelo
+ *    (parse_classfile e puro dado seu proprio Buffer) e publica cada
+ *    classe no registro. O resultado fica em items[i], na mesma ordem
+ *    da lista, entao a saida e deterministica.
+ * ----------------------------------------------------------- */
+
+typedef struct {
+    char *path;                 /* caminho de origem (alocado) */
+    const ZipArchive *zip;      /* != NULL: entrada 'entry' deste jar */
+    size_t entry;
+    ClassFile *cf;              /* NULL se a leitura/parse falhou */
+    Status io_status;
+    ClassFileStatus cf_status;
+    bool published;             /* true: o registro e dono de cf */
+} LoadedClass;
+
+typedef struct {
+    LoadedClass *items;
+    size_t count;
+    size_t capacity;
+    ZipArchive **zips;          /* jars abertos pela lista (fechados em class_list_free) */
+    size_t zip_count;
+} ClassList;
+
+/* true se path e um diretorio */
+bool class_source_is_dir(const char *path);
+
+/* true se path termina em .jar/.zip (o jar inteiro, nao "app.jar!/entrada") */
+bool class_source_is_jar(const char *path);
+
+/*
+ * Le os bytes de uma classe: arquivo solto ou "app.jar!/pkg/A.class"
+ * (busca O(1) no indice do jar). O buffer sempre e do chamador.
+ */
+Status class_source_read(const char *path, Buffer *out);
+
+/*
+ * Acrescenta a lista os .class encontrados em path (arquivo ou diretorio).
+ * Os itens acrescentados ficam ordenados por caminho.
+ */
+Status class_list_collect(ClassList *list, const char *path);
+
+/*
+ * Le e analisa todos os itens usando o pool (NULL = serial) e publica
+ * as classes validas em reg (pode ser NULL). Retorna quantas falharam.
+ */
+size_t class_loader_parse_all(ClassList *list, ThreadPool *pool, ClassRegistry *reg);
+
+/*
+ * Le e analisa um unico item (sem registro); seguro em paralelo para
+ * itens distintos. false em erro (codigos em io_status/cf_status).
+ */
+bool class_loader_parse_item(LoadedClass *lc);
+
+/*
+ * Os dois passos de class_loader_parse_item, para quem precisa dos bytes
+ * antes do parse (ex.: cache por conteudo). parse_buffer libera o buffer.
+ */
+bool class_loader_read_item(LoadedClass *lc, Buffer *out);
+bool class_loader_parse_buffer(LoadedClass *lc, Buffer *buffer);
+
+/* Libera a classe de um item antes de class_list_free (se nao publicada). */
+void class_loader_release_item(LoadedClass *lc);
+
+/* Libera a lista, os jars e as classes que nao foram publicadas no registro. */
+void class_list_free(ClassList *list);
+
+/* -----------------------------------------------------------
+ * Classpath para execucao
+ *
+ * Carga preguicosa por nome interno, na ordem: registro (classes ja
+ * carregadas), arquivo compartilhado, e cada entrada do classpath
+ * (diretorio: dir/pkg/A.class; jar: busca no indice do jar). Classes
+ * lidas do disco sao publicadas no registro, que passa a ser dono.
+ * ----------------------------------------------------------- */
+
+typedef struct class_path ClassPath;
+
+/* reg nao pode ser NULL; continua sendo do chamador. */
+ClassPath *class_path_new(ClassRegistry *reg);
+
+/* Acrescenta entradas separadas por ':' (diretorios e jars). */
+Status class_path_add(ClassPath *cp, const char *entries);
+
+/* Consulta ar (nao e dono) antes das entradas do classpath. */
+void class_path_set_archive(ClassPath *cp, ClassArchive *ar);
+
+/* Busca/carrega a classe (ex: "pkg/Util"); NULL se ausente. Assinatura de ClassLookup. */
+ClassFile *class_path_load(void *cp, const char *name);
+
+/* Fecha os jars do classpath (as classes ficam no registro). */
+void class_path_free(ClassPath *cp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLASS_LOADER_H */
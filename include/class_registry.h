@@ -0,0 +1,51 @@
+#ifndef CLASS_REGISTRY_H
+#define CLASS_REGISTRY_H
+
+#include "classfile.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Registro concorrente de classes carregadas
+ *
+ * Mapa nome interno (ex: "java/lang/Object") -> ClassFile*.
+ * Dividido em shards, cada um com seu proprio rwlock, para que
+ * varias threads de carga publiquem ao mesmo tempo sem disputar
+ * um unico lock. O registro passa a ser dono das classes publicadas.
+ * ----------------------------------------------------------- */
+
+typedef struct class_registry ClassRegistry;
+
+typedef void (*ClassRegistryVisitor)(void *ctx, ClassFile *cf);
+
+ClassRegistry *class_registry_new(void);
+
+/* Libera o registro e todas as classes publicadas (seguro com NULL). */
+void class_registry_free(ClassRegistry *reg);
+
+/*
+ * Publica cf sob o nome de this_class. Se ja existir uma classe com o
+ * mesmo nome, nada muda e a existente e retornada (o chamador continua
+ * dono de cf). Retorna cf quando publicado, NULL em falha de alocacao.
+ */
+ClassFile *class_registry_publish(ClassRegistry *reg, ClassFile *cf);
+
+/* Busca por nome interno; NULL se ausente. */
+ClassFile *class_registry_find(ClassRegistry *reg, const char *name);
+
+size_t class_registry_count(ClassRegistry *reg);
+
+/* Visita todas as classes (ordem nao especificada). */
+void class_registry_for_each(ClassRegistry *reg, ClassRegistryVisitor visit, void *ctx);
+
+/* Nome interno de this_class ("" se invalido). */
+const char *classfile_this_name(const ClassFile *cf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CLASS_REGISTRY_H */
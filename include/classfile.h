@@ -92,6 +92,12 @@ typedef struct class_file {
 
     u2 attributes_count;
     AttributeInfo *attributes; /* atributos de nível de classe (crus) */
+
+    struct member_index *members; /* (nome, descritor) -> membro; ver member_index.h */
+    struct resolved_entry *resolved; /* paralelo ao constant pool; ver cp_cache.h */
+    struct class_layout *layout;     /* estado de execucao (campos, estaticos, Code) */
+    struct resolve_memo *names;      /* textos do CP ja formatados; ver resolve.h */
+    u1 mapped;             /* 1: visao sobre um class_archive (memoria do arquivo; free_classfile ignora) */
 } ClassFile;
 
 /* -----------------------------------------------------------
@@ -9,6 +9,8 @@
 typedef enum {
     OUTPUT_MODE_PRETTY, // Impressão legível [cite: 41]
     OUTPUT_MODE_JSON,    // Impressão em JSON [cite: 42]
+    OUTPUT_MODE_JSONL,   // JSON Lines: um registro compacto por classe (ou por metodo)
+    OUTPUT_MODE_DOT,     // Graphviz: grafo de fluxo de controle de cada metodo
     OUTPUT_MODE_READER   // Modo Leitor (apenas leitura, sem exibição)
 } OutputMode;
 
@@ -26,8 +28,11 @@ typedef enum {
  * @brief Estrutura para armazenar todas as opções parseadas da linha de comando.
  */
 typedef struct {
-    const char *input_file; // Caminho para o arquivo .class
+    const char *input_file; // Caminho para o .class, diretorio, jar ou "app.jar!/pkg/A.class"
+    const char **inputs;    // Todas as entradas (input_file == inputs[0]); "@lista" = um caminho por linha
+    int input_count;
     OutputMode output_mode;
+    bool jsonl_per_method;  // --jsonl-methods: um registro JSONL por metodo
     bool is_reader_mode; // Flag para o modo leitor (sem exibição)
 
     // Flags de controle de impressão (baseado nas flags --cp, --no-code, etc) 
@@ -38,9 +43,24 @@ typedef struct {
     bool print_methods;
     bool print_attributes;
     bool disassemble_code; // Controlado por --no-code 
+    bool print_cfg;        // --cfg: blocos basicos, dominadores e lacos de cada metodo
 
     // Modo de execução da JVM (Pessoa 2)
     ExecutionMode execution_mode; // MODE_NONE, MODE_EXECUTE, MODE_DEBUG
+    bool jit;                     // --jit: compila os metodos quentes para codigo nativo (jit.h)
+    unsigned jit_threshold;       // --jit-threshold <n>: invocacoes ate compilar (0 = padrao)
+    unsigned osr_threshold;       // --osr-threshold <n>: saltos para tras ate o OSR (0 = padrao)
+    int jit_threads;              // --jit-threads <n>: compiladoras em segundo plano (0 = na thread que executa)
+    unsigned code_cache_kib;      // --code-cache <KiB>: limite do cache de codigo (0 = padrao, 64 MiB)
+    bool perf_map;                // --perf-map: nomes do codigo gerado em /tmp/perf-<pid>.map
+    bool regvm;                   // --regvm: executa pela IR de registradores (regvm.h)
+    unsigned inline_size;         // --inline-size <n>: bytes de bytecode do maior metodo inlinado (0 = padrao)
+    bool no_inline;               // --no-inline: a IR de registradores nao inlina chamadas
+    bool deopt_stress;            // --deopt-stress: toda guarda da IR de registradores desotimiza
+    bool no_vectorize;            // --no-vectorize: lacos sobre int[] ficam escalares
+    unsigned simd;                // --simd <isa>: limite dos kernels (0 = o melhor, 1 scalar, 2 sse2, 3 avx2)
+    bool no_peephole;             // --no-peephole: executa o bytecode como veio da classe
+    bool peephole_stats;          // --peephole-stats: instrucoes removidas por metodo (peephole.h)
 
     // Status
     bool show_help;
@@ -49,6 +69,28 @@ typedef struct {
 
     bool verbose;
 
+    // Carga em lote (diretorios): numero de threads do parse (0 = CPUs online)
+    int threads;
+    bool unordered;         // --unordered: saida do lote na ordem em que as classes ficam prontas
+
+    // Arquivo de classes compartilhado (class_archive.h)
+    const char *dump_archive; // --dump-archive: grava as classes da entrada neste arquivo
+    const char *use_archive;  // --use-archive: le as classes deste arquivo mapeado
+
+    // Exportacao binaria de metadados para indexadores (meta_reader.h)
+    const char *export_meta;  // --export-meta: grava classes, membros, referencias e bytecode neste arquivo
+
+    // Indice de referencias entre classes (ref_index.h)
+    const char *build_index;  // "index <arq>" / --build-index: indexa os usos das entradas neste arquivo
+    const char *query_index;  // "query <arq>" / --query-index: as entradas sao consultas ("Dono[.nome[desc]]")
+
+    // Cache de analise por conteudo (analysis_cache.h): lote e index
+    const char *cache_dir;    // --cache <dir>: NULL = sem cache
+    int cache_max_mb;         // --cache-max <MiB>: limite do cache (0 = padrao)
+
+    // Classpath da execucao (-run/-debug): diretorios e jars separados por ':'
+    const char *classpath;    // NULL = raiz de pacotes da classe de entrada
+
 } CliOptions;
 
 /**
@@ -61,6 +103,13 @@ typedef struct {
  */
 void parse_cli_options(int argc, char *argv[], CliOptions *options);
 
+/**
+ * @brief Libera o que parse_cli_options alocou (lista de entradas).
+ *
+ * @param options Estrutura preenchida por parse_cli_options.
+ */
+void free_cli_options(CliOptions *options);
+
 /**
  * @brief Imprime a mensagem de uso/ajuda do programa.
  *
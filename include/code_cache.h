@@ -0,0 +1,72 @@
+#ifndef CODE_CACHE_H
+#define CODE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Cache de codigo do JIT: memoria executavel em segmentos
+ *
+ * Segmentos de CODE_CACHE_SEGMENT bytes (ou maiores, para um bloco que
+ * nao caiba) sao mapeados sob demanda; dentro de cada um, blocos
+ * first-fit com os vizinhos livres reunidos ao liberar, e um segmento
+ * que esvazia volta ao sistema. O limite vale para os blocos em uso; o
+ * mapeado so passa dele pelo arredondamento de pagina. Os metadados dos
+ * blocos ficam fora da memoria executavel.
+ *
+ * W^X: no Linux cada segmento e um memfd mapeado duas vezes, uma vista
+ * so de leitura/execucao (onde o codigo roda) e outra de escrita (onde e
+ * copiado), e os blocos tem granularidade de 64 bytes. Sem memfd, o
+ * segmento e um mapeamento anonimo e cada bloco ocupa paginas inteiras,
+ * liberadas para escrita (mprotect) so durante a copia, antes de
+ * qualquer thread poder executa-las.
+ *
+ * Com perf_map, cada bloco nomeado vira uma linha "inicio tamanho nome"
+ * em /tmp/perf-<pid>.map, que o perf do Linux usa para dar nome aos
+ * enderecos do codigo gerado. O arquivo so cresce: um endereco reusado
+ * depois de um despejo aparece de novo com o nome novo.
+ *
+ * Todas as funcoes sao seguras entre threads.
+ * ----------------------------------------------------------- */
+
+#define CODE_CACHE_SEGMENT (1024u * 1024u)
+#define CODE_CACHE_DEFAULT_CAPACITY (64u * 1024u * 1024u)
+
+typedef struct code_cache CodeCache;
+
+typedef struct {
+    size_t capacity;            /* limite total */
+    size_t mapped;              /* segmentos mapeados */
+    size_t used;                /* blocos em uso (arredondados) */
+    unsigned segments;
+    unsigned blocks;
+} CodeCacheStats;
+
+/* capacity = 0: CODE_CACHE_DEFAULT_CAPACITY. NULL em falha. */
+CodeCache *code_cache_new(size_t capacity, bool perf_map);
+
+/*
+ * Copia len bytes de codigo para um bloco novo e devolve o endereco
+ * executavel. name (pode ser NULL) vai para o perf map. NULL se o limite
+ * nao comporta o bloco (ou sem memoria): o chamador pode liberar outros
+ * blocos e tentar de novo.
+ */
+void *code_cache_install(CodeCache *cache, const void *code, size_t len, const char *name);
+
+/* Devolve o bloco ao cache. Nenhuma thread pode estar executando nele. */
+void code_cache_release(CodeCache *cache, void *code);
+
+void code_cache_stats(CodeCache *cache, CodeCacheStats *out);
+
+/* Desfaz todos os mapeamentos (seguro com NULL). */
+void code_cache_free(CodeCache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CODE_CACHE_H */
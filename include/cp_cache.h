@@ -0,0 +1,145 @@
+#ifndef CP_CACHE_H
+#define CP_CACHE_H
+
+#include "classfile.h"
+#include "attributes.h"
+#include "heap_manager.h"
+#include "jvm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Cache de resolucao do constant pool
+ *
+ * Vetor paralelo a ClassFile.constant_pool (cf->resolved). Na primeira
+ * execucao de uma instrucao que referencia o indice i, a cadeia
+ * Ref -> NameAndType -> Utf8 e percorrida uma vez e o resultado (classe,
+ * metodo, offset de campo, string...) fica em cf->resolved[i]. Dali em
+ * diante basta uma leitura do vetor (cp_resolved).
+ *
+ * Publicacao segura entre threads: os resolvedores sao serializados por
+ * um mutex e gravam 'kind' por ultimo com semantica release; o caminho
+ * rapido le 'kind' com acquire e nunca trava.
+ *
+ * Tambem guarda o estado de execucao por classe (cf->layout): offsets dos
+ * campos, area de estaticos, estado de <clinit>, o Code de cada metodo
+ * ja decodificado e quais metodos ja tem sobrescrita entre as classes
+ * preparadas (analise de hierarquia).
+ * ----------------------------------------------------------- */
+
+typedef enum {
+    RESOLVED_NONE = 0,      /* ainda nao resolvido */
+    RESOLVED_CLASS,         /* cls */
+    RESOLVED_METHOD,        /* cls + u.method (bytecode) */
+    RESOLVED_NATIVE,        /* u.native (implementacao em C) */
+    RESOLVED_FIELD,         /* u.offset em Object.fields */
+    RESOLVED_STATIC,        /* u.static_slot na area de estaticos de cls */
+    RESOLVED_STRING,        /* u.string (ldc) */
+    RESOLVED_CONSTANT,      /* u.value (ldc de Integer/Float) */
+    RESOLVED_UNAVAILABLE    /* classe/membro fora do classpath: so o efeito na pilha */
+} ResolvedKind;
+
+/*
+ * Implementacao nativa: args[0 .. arg_slots) (com 'this' se houver);
+ * grava ret_slots valores em ret. Retorna 0 ou negativo em erro.
+ */
+typedef int (*NativeMethod)(const Slot *args, Slot *ret);
+
+typedef struct resolved_entry {
+    u1 kind;                /* ResolvedKind; publicado por ultimo */
+    u1 type;                /* Fieldref: 1o char do descritor; Methodref: do retorno */
+    u1 ret_slots;           /* Methodref: 0, 1 ou 2 */
+    u1 is_static;           /* Methodref/Fieldref: alvo e ACC_STATIC */
+    u2 arg_slots;           /* Methodref: slots dos argumentos, sem 'this' */
+    u2 field_slots;         /* Fieldref: 1 ou 2 (long/double) */
+    ClassFile *cls;         /* classe dona do membro (NULL se indisponivel) */
+    union {
+        MethodInfo *method;
+        NativeMethod native;
+        u4 offset;
+        Slot *static_slot;
+        ObjectRef string;
+        u4 value;
+    } u;
+} ResolvedEntry;
+
+/* Carregador de classes por nome interno (ex: class_path_load). */
+typedef ClassFile *(*ClassLookup)(void *ctx, const char *name);
+
+/* Define como o resolvedor encontra outras classes (NULL = so a propria). */
+void cp_cache_set_loader(ClassLookup lookup, void *ctx);
+
+/* Carrega uma classe pelo carregador configurado (NULL se indisponivel). */
+ClassFile *cp_cache_load_class(const char *name);
+
+/*
+ * Aloca cf->resolved e cf->layout (idempotente, seguro entre threads).
+ * Deve ser chamado antes de executar codigo da classe.
+ */
+ClassFileStatus cp_cache_prepare(ClassFile *cf);
+
+/* Libera o estado de execucao da classe (chamado por free_classfile). */
+void cp_cache_release(ClassFile *cf);
+
+/* Caminho lento: resolve e publica cf->resolved[index]. NULL se o indice for invalido. */
+const ResolvedEntry *cp_resolve_slow(ClassFile *cf, u2 index);
+
+/* Caminho rapido: uma leitura do vetor quando ja resolvido. */
+static inline const ResolvedEntry *cp_resolved(ClassFile *cf, u2 index) {
+    if (cf->resolved && index < cf->constant_pool_count) {
+        const ResolvedEntry *e = &cf->resolved[index];
+        if (__atomic_load_n(&e->kind, __ATOMIC_ACQUIRE) != RESOLVED_NONE) return e;
+    }
+    return cp_resolve_slow(cf, index);
+}
+
+/* Slots de instancia de um objeto da classe (inclui superclasses). */
+u4 cp_cache_instance_slots(ClassFile *cf);
+
+/*
+ * Code decodificado e verificado do metodo (cacheado por classe; NULL se
+ * abstrato/nativo/rejeitado), ja passado pelo peephole.h se ligado.
+ */
+const CodeAttribute *cp_cache_code(ClassFile *cf, const MethodInfo *method);
+
+/*
+ * Metodo (nome, descritor) em cf ou nas superclasses (despacho virtual).
+ * *owner recebe a classe onde foi encontrado.
+ */
+MethodInfo *cp_cache_find_virtual(ClassFile *cf, const char *name, const char *descriptor,
+                                  ClassFile **owner);
+
+/*
+ * Analise de hierarquia (CHA): true se alguma classe ja preparada redeclara
+ * method (de cf) numa subclasse. Sempre true para metodos de interface,
+ * cujas implementacoes nao estao na cadeia de superclasses. Sem
+ * sobrescrita, o despacho virtual de method so pode chegar nele.
+ */
+bool cp_cache_overridden(ClassFile *cf, const MethodInfo *method);
+
+/*
+ * Conta as sobrescritas registradas: muda sempre que uma classe
+ * preparada sobrescreve um metodo de outra ja preparada. Quem assumiu
+ * !cp_cache_overridden revalida quando o numero muda.
+ */
+unsigned cp_cache_hierarchy_version(void);
+
+/* Superclasse carregada (NULL se fora do classpath, ex: java/lang/Object). */
+ClassFile *cp_cache_super(ClassFile *cf);
+
+/*
+ * Inicializacao de classe: retorna 1 se o chamador deve executar <clinit>
+ * agora (primeira vez), 0 se ja foi iniciada ou esta em andamento.
+ */
+int cp_cache_begin_init(ClassFile *cf);
+
+/* Slots ocupados pelos argumentos de um descritor "(...)R" (sem 'this'). */
+u2 descriptor_arg_slots(const char *descriptor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CP_CACHE_H */
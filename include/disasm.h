@@ -3,6 +3,7 @@
 #ifndef DISASM_H
 #define DISASM_H
 #include "attributes.h"
+#include "out_sink.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -16,6 +17,106 @@ typedef struct class_file ClassFile;
 
 
 
+// --------------------------------------------------------------------------
+// API SEM ALOCACAO (arena + views)
+// --------------------------------------------------------------------------
+
+// Formato dos operandos de DisasmInsn.operand
+typedef enum {
+    DISASM_ARG_NONE = 0,
+    DISASM_ARG_INDEX,         // operand[0] = indice (cp ou local)
+    DISASM_ARG_BRANCH,        // operand[0] = offset, operand[1] = alvo
+    DISASM_ARG_IINC,          // operand[0] = local, operand[1] = constante
+    DISASM_ARG_WIDE,          // wide: operand[0] = opcode modificado, [1] = local, [2] = constante (iinc)
+    DISASM_ARG_TABLESWITCH,   // operand[0..2] = default, low, high
+    DISASM_ARG_LOOKUPSWITCH,  // operand[0..1] = default, npairs
+} DisasmArgKind;
+
+// Conteudo de DisasmInsn.res
+typedef enum {
+    DISASM_RES_NONE = 0,
+    DISASM_RES_MEMBER,        // view[0..2] = classe, nome, descritor
+    DISASM_RES_TEXT,          // view[0] = nome de classe / texto
+    DISASM_RES_STRING,        // view[0] = conteudo de CONSTANT_String (impresso entre aspas)
+    DISASM_RES_INT,
+    DISASM_RES_FLOAT,
+    DISASM_RES_LONG,
+    DISASM_RES_DOUBLE,
+    DISASM_RES_ERR_REF,       // referencia invalida (indice em operand[0])
+    DISASM_RES_ERR_CLASS,     // classe invalida (indice em operand[0])
+} DisasmResolvedKind;
+
+/**
+ * @brief Instrucao decodificada. Nada e alocado por instrucao: o mnemonico
+ * aponta para a tabela estatica de opcodes e as views para as strings do
+ * constant pool (validas enquanto o ClassFile existir).
+ */
+typedef struct {
+    uint32_t pc;
+    uint32_t length;
+    uint8_t opcode;
+    uint8_t arg_kind;         // DisasmArgKind
+    uint8_t res_kind;         // DisasmResolvedKind
+    const char *mnemonic;
+    int32_t operand[3];
+    union {
+        const char *view[3];
+        int32_t i;
+        float f;
+        int64_t l;
+        double d;
+    } res;
+} DisasmInsn;
+
+/**
+ * @brief Memoria reaproveitada entre metodos: cresce ate o maior metodo
+ * visto e depois nao aloca mais.
+ */
+typedef struct {
+    void *base;
+    size_t capacity;
+    size_t used;
+} DisasmArena;
+
+typedef struct {
+    DisasmInsn *insns;        // dentro da arena; invalido apos o proximo disasm_decode
+    uint32_t count;
+} DisasmMethod;
+
+typedef void (*DisasmTextWriter)(OutSink *out, const char *text);
+
+void disasm_arena_init(DisasmArena *arena);
+void disasm_arena_free(DisasmArena *arena);
+
+/**
+ * @brief Decodifica o Code de um metodo na arena (reinicia a arena).
+ *
+ * Instrucoes truncadas no fim do codigo encerram a listagem.
+ *
+ * @return true em sucesso, false em erro de alocacao de memoria.
+ */
+bool disasm_decode(const ClassFile *cf, const CodeAttribute *code_attr, DisasmArena *arena, DisasmMethod *out);
+
+/**
+ * @brief Formata os operandos (Ex: "#5", "12 (to 40)") em buf; retorna como snprintf.
+ */
+int disasm_format_args(const DisasmInsn *insn, char *buf, size_t size);
+
+/**
+ * @brief true se a instrucao tem informacao resolvida nao vazia.
+ */
+bool disasm_has_resolved(const DisasmInsn *insn);
+
+/**
+ * @brief Escreve a informacao resolvida em pedacos via write (que pode escapar o texto).
+ */
+void disasm_write_resolved(OutSink *out, const DisasmInsn *insn, DisasmTextWriter write);
+
+
+// --------------------------------------------------------------------------
+// API ANTIGA (strings alocadas; implementada sobre disasm_decode)
+// --------------------------------------------------------------------------
+
 /**
  * @brief Representa uma instrucao de bytecode apos o desassembleamento.
  */
@@ -0,0 +1,24 @@
+#ifndef DOT_H
+#define DOT_H
+
+#include "base.h"       // Para Status
+#include "classfile.h"  // Para a definição de ClassFile
+#include "cli.h"        // Para a estrutura CliOptions
+#include "out_sink.h"   // Saida bufferizada
+
+/**
+ * @brief Gera o grafo de fluxo de controle da classe no formato DOT (Graphviz).
+ *
+ * Um "digraph" por classe, com um "subgraph cluster_mN" por metodo com Code.
+ * Cada no e um bloco basico ("B3 [10, 24)" seguido das instrucoes, omitidas
+ * com --no-code); arestas de excecao sao tracejadas, cabecalhos de laco ficam
+ * em negrito e blocos inalcancaveis pontilhados.
+ *
+ * @param out Destino da saida (o chamador faz o close).
+ * @param cf Um ponteiro para a estrutura ClassFile preenchida.
+ * @param options As flags parseadas da linha de comando.
+ * @return Status (primeiro erro de escrita do sink, se houver)
+ */
+Status dot_classfile(OutSink *out, ClassFile *cf, const CliOptions *options);
+
+#endif // DOT_H
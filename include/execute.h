@@ -32,6 +32,38 @@ extern OpcodeHandler opcode_handlers[256];
  */
 void init_opcode_handlers();
 
+struct jit_call_site;
+
+/** @brief Limite de frames aninhados (StackOverflowError). */
+#define EXECUTE_MAX_DEPTH 1024
+
+/**
+ * @brief Contador de frames em execução (para o JIT, que monta frames
+ * sem passar por executar_metodo).
+ */
+int *execute_depth_counter(void);
+
+/**
+ * @brief Continua no interpretador um Frame devolvido pelo JIT
+ * (JIT_INTERPRET), a partir de frame->pc.
+ *
+ * @return 1 (return) ou negativo em erro.
+ */
+int execute_resume_frame(Frame *frame, const CliOptions *options);
+
+/**
+ * @brief Chamada direta a partir do código do JIT (jit.h).
+ *
+ * Como invocar(), mas com o alvo guardado no sítio de chamada (resolvido
+ * aqui na primeira chamada) e o Frame do chamado na pilha nativa:
+ * desempilha site->nslots de caller->stack_top e empilha os ret_slots do
+ * retorno. Sítio sem alvo na própria classe usa o manipulador do
+ * invokestatic.
+ *
+ * @return 0, ou negativo em erro.
+ */
+int execute_jit_call(Frame *caller, const CliOptions *options, struct jit_call_site *site);
+
 /**
  * @brief Executa o método principal (main) da classe carregada.
  *
@@ -33,6 +33,50 @@ typedef struct {
 // Tipo para Referência de Objeto (Endereço na Heap)
 typedef Object* ObjectRef;
 
+// --- Referências em Slots ---
+//
+// Slot e StackValue têm 32 bits. Em 32 bits a referência é o próprio
+// endereço; em 64 bits ele não cabe, e o slot guarda um handle: índice
+// numa tabela de endereços (0 = null). O handle de cada alocação fica nos
+// 4 bytes antes dela. A tabela é em pedaços que nunca mudam de lugar:
+// jvm_heap_deref não trava.
+#if UINTPTR_MAX > 0xFFFFFFFFu
+#define JVM_HEAP_HANDLES 1
+#define JVM_HEAP_PEDACO_BITS 16
+
+extern Object **jvm_heap_pedacos[1u << (32 - JVM_HEAP_PEDACO_BITS)];
+
+/**
+ * @brief Valor de slot de uma referência da heap
+ * @param obj_ref Referência (NULL vira 0)
+ * @return O handle da alocação
+ */
+static inline StackValue jvm_heap_ref(ObjectRef obj_ref) {
+    return obj_ref ? ((const StackValue *)(const void *)obj_ref)[-1] : 0;
+}
+
+/**
+ * @brief Referência guardada num slot
+ * @param ref Valor do slot (handle)
+ * @return A referência, ou NULL para 0
+ */
+static inline ObjectRef jvm_heap_deref(StackValue ref) {
+    if (!ref) return NULL;
+    Object **pedaco = __atomic_load_n(&jvm_heap_pedacos[ref >> JVM_HEAP_PEDACO_BITS], __ATOMIC_ACQUIRE);
+    return pedaco[ref & ((1u << JVM_HEAP_PEDACO_BITS) - 1)];
+}
+#else
+static inline StackValue jvm_heap_ref(ObjectRef obj_ref) { return (StackValue)(uintptr_t)obj_ref; }
+static inline ObjectRef jvm_heap_deref(StackValue ref) { return (ObjectRef)(uintptr_t)ref; }
+#endif
+
+// Struct StringObject: java/lang/String de um ldc (class_info == NULL, sem campos)
+typedef struct {
+    Object header;
+    u4 length;          // Bytes em chars (UTF-8 modificado, sem o '\0')
+    char chars[];       // Terminado em '\0'
+} StringObject;
+
 // --- Funções de Alocação (new, newarray) ---
 
 /**
@@ -51,6 +95,21 @@ ObjectRef jvm_heap_new_object(ClassFile *class_info, size_t field_count);
  */
 ObjectRef jvm_heap_new_array(u1 type, u4 length);
 
+/**
+ * @brief Aloca uma string imutável (ldc de CONSTANT_String)
+ * @param chars Texto (copiado)
+ * @param length Número de bytes de chars
+ * @return Referência para a string alocada
+ */
+ObjectRef jvm_heap_new_string(const char *chars, u4 length);
+
+/**
+ * @brief Texto de uma referência criada por jvm_heap_new_string
+ * @param obj_ref Referência da string
+ * @return Texto terminado em '\0' ou NULL se não for string
+ */
+const char *jvm_heap_string_chars(ObjectRef obj_ref);
+
 // --- Funções de Acesso (getfield, putfield) ---
 
 /**
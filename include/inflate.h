@@ -0,0 +1,31 @@
+#ifndef INFLATE_H
+#define INFLATE_H
+
+#include "base.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Descompressor DEFLATE (RFC 1951) embutido
+ *
+ * Suficiente para as entradas de jar/zip (metodo 8): fluxo cru, sem
+ * cabecalho zlib/gzip, com o tamanho de saida conhecido de antemao
+ * (vem do diretorio central). Nao depende da zlib.
+ * ----------------------------------------------------------- */
+
+/*
+ * Descomprime src[0 .. src_len) em dst[0 .. dst_len).
+ * Retorna OK e o numero de bytes gerados em *out_len; ERR_BOUNDS se a
+ * saida nao couber em dst; ERR_EOF se o fluxo terminar antes do bloco
+ * final ou for invalido.
+ */
+Status inflate_raw(const u1 *src, size_t src_len, u1 *dst, size_t dst_len, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INFLATE_H */
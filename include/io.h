@@ -8,6 +8,7 @@ typedef struct {
     u1* data;
     u4 size;
     u4 offset;
+    u1 borrowed; // 1: data aponta para memoria alheia (ex: entrada de jar mapeada); buffer_free nao libera
 } Buffer;
 
 Status buffer_from_file(const char* path, Buffer* buffer);
@@ -0,0 +1,147 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "attributes.h"
+#include "cli.h"
+#include "jvm.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * JIT de base (templates) para x86-64 (--jit)
+ *
+ * Cada instrucao do metodo vira um trecho fixo de codigo de maquina,
+ * gravado no cache de codigo (code_cache.h). A pilha de operandos continua no
+ * Frame: como o verificador garante a mesma profundidade em todos os
+ * caminhos, o slot de cada operando e um deslocamento fixo a partir de
+ * operand_stack, e as variaveis locais idem a partir de local_vars.
+ *
+ * Aritmetica inteira, iinc, if*, goto, tableswitch e return sao
+ * emitidos direto, e invokestatic para a propria classe vira uma chamada
+ * direta (JitCallSite) com o Frame do chamado na pilha nativa. O resto (ldc, get/put*, invoke*, new, newarray...)
+ * chama o manipulador do interpretador (opcode_handlers) com pc e
+ * stack_top sincronizados no Frame; se depois dele o pc ou o topo nao
+ * forem os esperados, o codigo devolve JIT_INTERPRET e o interpretador
+ * continua o metodo de onde o Frame parou.
+ *
+ * Camadas: com --jit, os metodos comecam no interpretador. Cada metodo
+ * conta as invocacoes (jit_on_invoke) e cada laco os saltos para tras
+ * (jit_on_backedge, por cabecalho); no limite o metodo e compilado. Um
+ * laco quente num metodo que nunca mais sera chamado (o main) entra no
+ * codigo compilado no meio da execucao (OSR): cada cabecalho de laco tem
+ * uma entrada propria que so refaz o prologo, ja que locais e pilha
+ * continuam no Frame.
+ *
+ * Codigo compilado tem a mesma assinatura de um OpcodeHandler e retorna
+ * 1 (return, valor no topo da pilha do Frame), negativo em erro ou
+ * JIT_INTERPRET. Em outras arquiteturas nada e compilado.
+ *
+ * Compilacao em segundo plano: o metodo que passa do limite entra numa
+ * fila ordenada pelo calor (invocacoes + saltos, atualizado enquanto
+ * espera) e o interpretador segue com ele; compiladoras (--jit-threads)
+ * geram o codigo e o publicam atomicamente. A thread que executa so pega
+ * o codigo novo na proxima invocacao ou no proximo salto para tras (OSR),
+ * nunca espera a compilacao. A compilacao so le a classe (nenhuma
+ * resolucao nem carga de classe); com 0 threads, compila na propria
+ * thread que executa, no momento da promocao.
+ *
+ * Cache de codigo: tem um limite (--code-cache). Quando um metodo nao
+ * cabe, a thread que executa despeja os compilados usados ha mais tempo
+ * que nao estao em execucao (jit_execute conta as ativacoes); o metodo
+ * despejado volta ao interpretador com os contadores zerados e pode ser
+ * compilado de novo se esquentar outra vez.
+ *
+ * As demais funcoes sao chamadas so pela thread que executa (como o
+ * interpretador).
+ * ----------------------------------------------------------- */
+
+#define JIT_INTERPRET 2
+
+/* Limites padrao das camadas (--jit-threshold / --osr-threshold) */
+#define JIT_DEFAULT_INVOKE_THRESHOLD   1000
+#define JIT_DEFAULT_BACKEDGE_THRESHOLD 10000
+
+typedef int (*JitFunction)(Frame *frame, const CliOptions *options);
+
+/*
+ * invokestatic para a propria classe (ja em inicializacao), chamado sem
+ * passar pelo manipulador (execute_jit_call). Na recursao, method/code
+ * vem da compilacao; nos outros, a primeira chamada resolve o alvo (ou
+ * marca generic, e o sitio passa a usar o manipulador do interpretador).
+ */
+typedef struct jit_call_site {
+    ClassFile *cls;
+    u2 cp_index;                /* Methodref do invokestatic */
+    const u1 *pc;               /* a instrucao, para o caminho generico */
+    MethodInfo *method;         /* NULL ate resolver */
+    const CodeAttribute *code;
+    u2 nslots;                  /* argumentos (do descritor) */
+    u1 ret_slots;
+    bool generic;               /* alvo fora da classe ou sem Code */
+} JitCallSite;
+
+typedef struct {
+    unsigned methods;           /* compilados */
+    unsigned failed;            /* nao compilaveis */
+    unsigned osr_entries;       /* entradas OSR usadas */
+    size_t code_bytes;
+    unsigned queued;            /* pedidos que passaram pela fila */
+    unsigned pending;           /* ainda na fila */
+    double queue_wait_avg_ms;   /* da promocao ao inicio da compilacao */
+    double queue_wait_max_ms;
+    double compile_avg_ms;
+    unsigned evicted;           /* metodos despejados do cache de codigo */
+    size_t cache_used;          /* bytes em uso no cache (arredondados) */
+    size_t cache_capacity;
+    unsigned cache_segments;
+} JitStats;
+
+typedef struct {
+    unsigned invoke_threshold;  /* --jit-threshold (0 = padrao) */
+    unsigned backedge_threshold;/* --osr-threshold (0 = padrao) */
+    int threads;                /* --jit-threads (0: compila na thread que executa) */
+    size_t code_cache_bytes;    /* --code-cache (0 = CODE_CACHE_DEFAULT_CAPACITY) */
+    bool perf_map;              /* --perf-map: /tmp/perf-<pid>.map */
+} JitConfig;
+
+/* true se o JIT suporta a arquitetura em que o programa foi compilado. */
+bool jit_available(void);
+
+/* Limites, compiladoras e cache de codigo. Chamar antes de executar. */
+void jit_configure(const JitConfig *config);
+
+/*
+ * Conta uma invocacao interpretada de method (code: o Code verificado,
+ * cp_cache_code). Devolve o codigo compilado assim que estiver publicado;
+ * NULL enquanto o metodo esta frio, na fila ou se nao e compilavel.
+ */
+JitFunction jit_on_invoke(ClassFile *cf, const MethodInfo *method, const CodeAttribute *code);
+
+/*
+ * Conta um salto para tras do interpretador, com frame->pc ja no alvo
+ * (cabecalho do laco). Quando o laco esquenta (ou o metodo ja esta
+ * compilado), devolve a entrada OSR desse cabecalho: chamada com o mesmo
+ * Frame, continua o metodo em codigo nativo e retorna como o codigo
+ * compilado. NULL: continuar interpretando.
+ */
+JitFunction jit_on_backedge(const Frame *frame);
+
+/*
+ * Executa o codigo compilado (entrada normal ou OSR) de frame->method_info.
+ * Enquanto ele roda, o metodo nao pode ser despejado do cache.
+ */
+int jit_execute(JitFunction fn, Frame *frame, const CliOptions *options);
+
+void jit_stats(JitStats *out);
+
+/* Encerra as compiladoras (descarta a fila) e libera todo o codigo gerado. */
+void jit_release_all(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JIT_H */
@@ -4,15 +4,33 @@
 #include "base.h"       // Para definições de Status
 #include "classfile.h"  // Para a definição de ClassFile
 #include "cli.h"        // (NOVO) Para a estrutura CliOptions
+#include "out_sink.h"   // Saida bufferizada
 
 /**
  * @brief Gera uma representação JSON da estrutura ClassFile,
  * respeitando as flags de CLI.
  *
+ * @param out Destino da saida (sink de arquivo ou de memoria; o chamador faz o close).
+ * @param cf Um ponteiro para a estrutura ClassFile preenchida.
+ * @param options As flags parseadas da linha de comando.
+ * @return Status (primeiro erro de escrita do sink, se houver)
+ */
+Status json_classfile(OutSink *out, ClassFile *cf, const CliOptions *options);
+
+/**
+ * @brief JSON Lines: registros compactos de uma linha, terminados em '\n'.
+ *
+ * Mesmo esquema de json_classfile, sem espacos, com o caminho de origem:
+ *   {"record":"class","path":...,"header":{...},"class_info":{...},...}
+ * ou, com options->jsonl_per_method, um registro por metodo:
+ *   {"record":"method","path":...,"class":...,"index":N,"method":{"name":...,"code_attribute":{...}}}
+ *
+ * @param out Destino da saida.
+ * @param path Caminho de origem da classe (arquivo, "app.jar!/..." ou nome no arquivo).
  * @param cf Um ponteiro para a estrutura ClassFile preenchida.
  * @param options As flags parseadas da linha de comando.
  * @return Status
  */
-Status json_classfile(ClassFile *cf, const CliOptions *options);
+Status json_line_classfile(OutSink *out, const char *path, ClassFile *cf, const CliOptions *options);
 
 #endif // JSON_H
\ No newline at end of file
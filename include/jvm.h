@@ -34,6 +34,7 @@ typedef struct frame {
     ClassFile *class_file;      // Ponteiro para a estrutura ClassFile
     MethodInfo *method_info;    // Ponteiro para a estrutura MethodInfo
     u1 *pc;                     // Program Counter: ponteiro para o próximo bytecode a ser executado
+    u1 *code;                   // Início do bytecode do método (base do alinhamento de switch)
 
     Slot *local_vars;           // Ponteiro para o início do vetor de Variáveis Locais
     Slot *operand_stack;        // Ponteiro para o início do vetor da Pilha de Operandos
@@ -0,0 +1,53 @@
+#ifndef MEMBER_INDEX_H
+#define MEMBER_INDEX_H
+
+#include "classfile.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Indice (nome, descritor) -> membro de uma classe
+ *
+ * Tabela hash de enderecamento aberto (sondagem linear), construida
+ * uma unica vez apos o parse. Substitui a varredura linear de
+ * methods[]/fields[] com dois strcmp por entrada.
+ * ----------------------------------------------------------- */
+
+#define MEMBER_SLOT_EMPTY 0xFFFFu
+
+/* Uma posicao da tabela: hash completo + indice em methods[]/fields[] */
+typedef struct {
+    u4 hash;
+    u2 member;      /* MEMBER_SLOT_EMPTY se livre */
+} MemberSlot;
+
+typedef struct member_index {
+    u4 method_mask;             /* capacidade - 1 (potencia de 2) */
+    MemberSlot *method_slots;
+    u4 field_mask;
+    MemberSlot *field_slots;
+} MemberIndex;
+
+/* Hash FNV-1a de "nome" + '\0' + "descritor". */
+u4 member_hash(const char *name, const char *descriptor);
+
+/* Constroi cf->members a partir de methods[]/fields[] (idempotente). */
+ClassFileStatus member_index_build(ClassFile *cf);
+
+/* Libera cf->members (seguro com NULL). */
+void member_index_free(ClassFile *cf);
+
+/*
+ * Buscas O(1). Se a classe nao tiver indice (ex.: ClassFile montado a mao),
+ * caem na varredura linear. Retornam NULL se o membro nao existir.
+ */
+MethodInfo *member_index_find_method(const ClassFile *cf, const char *name, const char *descriptor);
+FieldInfo  *member_index_find_field(const ClassFile *cf, const char *name, const char *descriptor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMBER_INDEX_H */
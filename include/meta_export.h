@@ -0,0 +1,42 @@
+#ifndef META_EXPORT_H
+#define META_EXPORT_H
+
+#include "base.h"
+#include "classfile.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Gravacao da exportacao de metadados (.jvbm)
+ *
+ * O formato e o leitor estao em meta_reader.h. O gravador copia tudo o
+ * que precisa de cada classe (strings internadas, bytecode), entao a
+ * classe pode ser liberada logo depois de meta_writer_add: a memoria
+ * cresce com a exportacao, nao com as classes analisadas.
+ * ----------------------------------------------------------- */
+
+typedef struct meta_writer MetaWriter;
+
+/* NULL em falta de memoria. */
+MetaWriter *meta_writer_new(void);
+
+/* Acrescenta a classe (path = origem, gravada no registro). */
+Status meta_writer_add(MetaWriter *w, const ClassFile *cf, const char *path);
+
+/*
+ * Grava o arquivo (tmp + rename: leitores com a versao antiga mapeada
+ * nao sao afetados). out_size pode ser NULL.
+ */
+Status meta_writer_finish(MetaWriter *w, const char *path, size_t *out_size);
+
+/* Libera o gravador (seguro com NULL). */
+void meta_writer_free(MetaWriter *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* META_EXPORT_H */
@@ -0,0 +1,155 @@
+#ifndef META_READER_H
+#define META_READER_H
+
+#include "base.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Exportacao de metadados (.jvbm): formato e leitor
+ *
+ * Formato binario versionado para indexadores: classes, interfaces,
+ * campos, metodos (com o bytecode), referencias do constant pool e uma
+ * tabela de strings. Tudo little-endian, registros de tamanho fixo, sem
+ * ponteiros: o leitor mapeia o arquivo (mmap) e acessa qualquer registro
+ * por indice, sem parse. O leitor e auto-contido (so libc/POSIX): um
+ * indexador pode linkar apenas meta_reader.c.
+ *
+ * Layout (offsets absolutos a partir do inicio do arquivo):
+ *
+ *   Cabecalho (META_HEADER_SIZE bytes)
+ *     0  magic "JVBCMETA"         8  u4 versao (META_VERSION)
+ *     12 u4 flags (0)             16 u8 tamanho do arquivo
+ *     24 u4 classes  28 u4 interfaces  32 u4 campos  36 u4 metodos
+ *     40 u4 referencias           44 u4 strings distintas (estatistica)
+ *     48 u8 offset de cada secao, na ordem de MetaSection
+ *
+ *   Strings: bytes terminados em '\0'; uma string e o offset dela dentro
+ *   da secao (0 = ""). Cada texto aparece uma vez.
+ *
+ *   Classe (META_CLASS_SIZE):  u4 nome, super, source_file, caminho de
+ *     origem; u4 primeira interface, primeiro campo, primeiro metodo,
+ *     primeira referencia, numero de referencias; u2 interfaces, campos,
+ *     metodos, access_flags, major, minor.
+ *   Interface: u4 string (nome interno).
+ *   Campo (META_FIELD_SIZE):   u4 classe, nome, descritor; u2 flags, 0.
+ *   Metodo (META_METHOD_SIZE): u4 classe, nome, descritor, code_length;
+ *     u8 offset na secao de codigo; u4 instrucoes; u2 flags, max_stack,
+ *     max_locals; 6 bytes 0. Sem Code: code_length = 0.
+ *   Referencia (META_REF_SIZE): u1 tag, 0; u2 indice no CP; u4 dono
+ *     (classe), nome (ou o texto de String), descritor. Por classe, em
+ *     ordem crescente de indice: Class, String, Fieldref, Methodref,
+ *     InterfaceMethodref, MethodType e InvokeDynamic (constantes numericas
+ *     de ldc nao entram).
+ *   Codigo: bytecode cru (ordem da JVM) de cada metodo.
+ *   Nomes: u4 classe[], ordenado pelo nome interno (busca binaria).
+ * ----------------------------------------------------------- */
+
+#define META_MAGIC        "JVBCMETA"
+#define META_VERSION      1u
+#define META_HEADER_SIZE  112u
+#define META_CLASS_SIZE   48u
+#define META_FIELD_SIZE   16u
+#define META_METHOD_SIZE  40u
+#define META_REF_SIZE     16u
+
+typedef enum {
+    META_SEC_STRINGS = 0,
+    META_SEC_CLASSES,
+    META_SEC_INTERFACES,
+    META_SEC_FIELDS,
+    META_SEC_METHODS,
+    META_SEC_REFS,
+    META_SEC_CODE,
+    META_SEC_NAMES,
+    META_SECTION_COUNT
+} MetaSection;
+
+typedef struct meta_file MetaFile;
+
+typedef struct {
+    const char *name;           /* nome interno, ex: "java/lang/String" */
+    const char *super_name;     /* "" para java/lang/Object */
+    const char *source_file;    /* "" se ausente */
+    const char *path;           /* origem na exportacao */
+    uint16_t access_flags, major_version, minor_version;
+    uint32_t first_interface, interface_count;
+    uint32_t first_field, field_count;
+    uint32_t first_method, method_count;
+    uint32_t first_ref, ref_count;
+} MetaClass;
+
+typedef struct {
+    uint32_t class_index;
+    const char *name;
+    const char *descriptor;
+    uint16_t access_flags;
+} MetaField;
+
+typedef struct {
+    uint32_t class_index;
+    const char *name;
+    const char *descriptor;
+    uint16_t access_flags, max_stack, max_locals;
+    const uint8_t *code;        /* aponta para o mapeamento; NULL sem Code */
+    uint32_t code_length;
+    uint32_t insn_count;
+} MetaMethod;
+
+typedef struct {
+    uint8_t tag;                /* CONSTANT_* */
+    uint16_t cp_index;
+    const char *owner;          /* classe (Class e refs de membro); "" nos demais */
+    const char *name;           /* membro, ou o texto de String */
+    const char *descriptor;
+} MetaRef;
+
+typedef struct {
+    uint32_t pc;
+    uint32_t length;
+    uint8_t opcode;
+    uint16_t cp_index;          /* operando de CP (ldc*, get/put*, invoke*, new...); 0 se nao tem */
+} MetaInsn;
+
+/* Mapeia e valida cabecalho e secoes. NULL em erro (codigo em *out_status). */
+MetaFile *meta_open(const char *path, Status *out_status);
+
+/* Desfaz o mapeamento (seguro com NULL). */
+void meta_close(MetaFile *mf);
+
+uint32_t meta_class_count(const MetaFile *mf);
+uint32_t meta_field_count(const MetaFile *mf);
+uint32_t meta_method_count(const MetaFile *mf);
+
+/* Registros por indice global; false se o indice estiver fora da faixa. */
+bool meta_class(const MetaFile *mf, uint32_t i, MetaClass *out);
+bool meta_field(const MetaFile *mf, uint32_t i, MetaField *out);
+bool meta_method(const MetaFile *mf, uint32_t i, MetaMethod *out);
+bool meta_ref(const MetaFile *mf, uint32_t i, MetaRef *out);
+const char *meta_interface(const MetaFile *mf, uint32_t i);   /* "" fora da faixa */
+
+/* Indice da classe pelo nome interno (busca binaria); -1 se ausente. */
+int64_t meta_find_class(const MetaFile *mf, const char *name);
+
+/* Referencia de uma classe pelo indice no CP (busca binaria). */
+bool meta_find_ref(const MetaFile *mf, const MetaClass *cls, uint16_t cp_index, MetaRef *out);
+
+/*
+ * Decodifica a instrucao em *pc e avanca *pc. false no fim do codigo ou
+ * se a instrucao for invalida/truncada.
+ */
+bool meta_next_insn(const MetaMethod *m, uint32_t *pc, MetaInsn *out);
+
+/* Tamanho da instrucao em pc (0 se invalida ou truncada). */
+uint32_t meta_insn_length(const uint8_t *code, uint32_t code_length, uint32_t pc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* META_READER_H */
@@ -0,0 +1,25 @@
+#ifndef NATIVES_H
+#define NATIVES_H
+
+#include "cp_cache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Metodos da biblioteca padrao implementados em C
+ *
+ * O interpretador nao carrega o JDK: chamadas a classes fora do
+ * classpath (java/io/PrintStream, java/lang/Math...) sao atendidas por
+ * esta tabela. Metodos de instancia recebem 'this' em args[0].
+ * ----------------------------------------------------------- */
+
+/* Implementacao de (classe, nome, descritor) ou NULL se nao houver. */
+NativeMethod native_lookup(const char *class_name, const char *name, const char *descriptor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NATIVES_H */
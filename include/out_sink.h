@@ -0,0 +1,102 @@
+#ifndef OUT_SINK_H
+#define OUT_SINK_H
+
+#include "base.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Saida bufferizada (pretty/json)
+ *
+ * Um buffer grande em espaco de usuario, sem o lock nem o parser de
+ * formato do stdio por token: inteiros, hexa, padding e escape JSON sao
+ * formatados a mao direto no buffer. Destinos:
+ *   - arquivo (stdout ou FILE* aberto): despeja com fwrite quando enche;
+ *   - memoria: o buffer cresce e pode ser tomado com out_sink_take().
+ * Erros de escrita/alocacao ficam registrados e aparecem no close.
+ * ----------------------------------------------------------- */
+
+#define OUT_SINK_BUFFER (64 * 1024)
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+    FILE *file;         /* destino; NULL = memoria */
+    Status status;      /* primeiro erro (OK se nenhum) */
+} OutSink;
+
+/* Prepara a escrita em f (buffer de OUT_SINK_BUFFER bytes). */
+Status out_sink_open_file(OutSink *s, FILE *f);
+
+/* Prepara a escrita em memoria. */
+Status out_sink_open_memory(OutSink *s);
+
+/* Arquivo: despeja o buffer (sem fflush do FILE). Memoria: nada. */
+Status out_sink_flush(OutSink *s);
+
+/* Despeja, libera o buffer e retorna o primeiro erro da vida do sink. */
+Status out_sink_close(OutSink *s);
+
+/* Descarta o que ainda nao foi despejado (mantem o buffer; rascunhos reaproveitados). */
+void out_sink_clear(OutSink *s);
+
+/* Memoria: entrega o buffer (malloc, nao terminado em '\0') e esvazia o sink. */
+char *out_sink_take(OutSink *s, size_t *len);
+
+/* Garante espaco para n bytes (despeja ou cresce); false em erro. */
+bool out_sink_reserve(OutSink *s, size_t n);
+
+static inline void out_put(OutSink *s, const char *p, size_t n) {
+    if (n > s->cap - s->len && !out_sink_reserve(s, n)) return;
+    memcpy(s->buf + s->len, p, n);
+    s->len += n;
+}
+
+static inline void out_char(OutSink *s, char c) {
+    if (s->len == s->cap && !out_sink_reserve(s, 1)) return;
+    s->buf[s->len++] = c;
+}
+
+static inline void out_str(OutSink *s, const char *str) {
+    out_put(s, str, strlen(str));
+}
+
+/* str alinhada a esquerda em 'width' colunas (como "%-Ns"). */
+void out_str_padded(OutSink *s, const char *str, size_t width);
+
+/* Decimal ("%u", "%d", "%lld"); out_u32_zero completa com zeros ("%0Nu"). */
+void out_u32(OutSink *s, uint32_t v);
+void out_i32(OutSink *s, int32_t v);
+void out_i64(OutSink *s, int64_t v);
+void out_u32_zero(OutSink *s, uint32_t v, int width);
+
+/* Hexa maiusculo com pelo menos 'digits' digitos ("%0NX"; 0 = "%X"). */
+void out_hex(OutSink *s, uint32_t v, int digits);
+
+/* Texto escapado para dentro de uma string JSON (sem as aspas). */
+void out_json_escaped(OutSink *s, const char *str);
+
+/* Formatacao printf para o que nao tem atalho (ex.: %g, %f). */
+void out_fmt(OutSink *s, const char *fmt, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+/* Formatadores para buffers comuns (>= 21 bytes); retornam o comprimento, sem '\0'. */
+size_t out_format_u64(char *dst, uint64_t v);
+size_t out_format_i64(char *dst, int64_t v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OUT_SINK_H */
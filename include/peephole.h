@@ -0,0 +1,74 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include "attributes.h"
+#include "classfile.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Otimizador peephole do bytecode (na carga, para -run)
+ *
+ * cp_cache_code passa aqui o Code ja verificado, antes de publica-lo;
+ * o interpretador, a IR de registradores e o JIT veem so o resultado.
+ * Padroes, sempre em janelas sem alvo de desvio depois da 1a instrucao:
+ *
+ *   constantes    iconst/bipush/sipush/ldc; iconst...; iadd  -> iconst/bipush/sipush
+ *                 (tambem isub, imul, idiv/irem com divisor != 0, ineg,
+ *                 shifts e logicas; so se o resultado cabe num sipush)
+ *   store/load    xstore n; xload n com n morto depois  -> nada (o valor fica na pilha)
+ *   store morto   push; xstore n  -> nada;  xstore n  -> pop/pop2
+ *   saltos        desvio para goto -> direto ao alvo final; goto para a seguinte sai
+ *   laco contado  corpo: ...; iinc i k; goto H   com   H: iload i; <limite>; if<cc> saida
+ *                 -> corpo: ...; iinc i k; iload i; <limite>; if<!cc> apos_H
+ *                 (o teste vai para o fim do corpo: um goto a menos por volta)
+ *
+ * "morto" vem de uma analise de vivacidade das locais sobre o CFG.
+ *
+ * O codigo e recompactado: desvios e switches sao recodificados (com o
+ * padding novo), a LineNumberTable e a LocalVariableTable sao remapeadas e
+ * os demais sub-atributos (StackMapTable) saem; o verificador infere os
+ * estados. O resultado e verificado de novo e so entra se aceito; senao,
+ * ou se algum deslocamento nao cabe, fica o original. Metodos com
+ * exception_table nao sao tocados.
+ * ----------------------------------------------------------- */
+
+typedef struct {
+    u4 insns_before;            /* instrucoes do original */
+    u4 insns_after;             /* instrucoes do otimizado (ou do original, se mantido) */
+    u4 folded;                  /* operacoes com constantes dobradas */
+    u4 store_loads;             /* pares store; load removidos */
+    u4 dead_stores;             /* stores mortos removidos ou trocados por pop */
+    u4 jumps;                   /* desvios encurtados e gotos removidos */
+    u4 loops;                   /* lacos postos em forma contada */
+    u4 methods;                 /* metodos otimizados (peephole_totals) */
+} PeepholeStats;
+
+typedef struct {
+    bool disabled;              /* --no-peephole (e -debug, que mostra os pcs originais) */
+    bool stats;                 /* --peephole-stats: uma linha por metodo em stderr */
+} PeepholeConfig;
+
+/* Chamar antes de executar. */
+void peephole_configure(const PeepholeConfig *config);
+
+bool peephole_enabled(void);
+
+/*
+ * Otimiza code (verificado) no lugar. Chamado com o mutex do cp_cache:
+ * nao e reentrante. OK tambem quando nada muda; ERR_MEMORY em falha de
+ * alocacao (code intacto).
+ */
+Status peephole_optimize(const ClassFile *cf, const MethodInfo *method, CodeAttribute *code);
+
+/* Soma de todos os metodos otimizados ate aqui. */
+void peephole_totals(PeepholeStats *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PEEPHOLE_H */
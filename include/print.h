@@ -4,15 +4,17 @@
 #include "base.h"       // Para Status
 #include "classfile.h"  // PARA A DEFINIÇÃO COMPLETA de ClassFile
 #include "cli.h"        // (NOVO) Para a estrutura CliOptions
+#include "out_sink.h"   // Saida bufferizada
 
 /**
  * @brief Imprime o ClassFile de forma legivel, 
  * respeitando as flags de CLI.
  *
+ * @param out Destino da saida (sink de arquivo ou de memoria; o chamador faz o close).
  * @param cf Estrutura ClassFile completa.
  * @param options As flags parseadas da linha de comando (ex: --no-code).
- * @return Status
+ * @return Status (primeiro erro de escrita do sink, se houver)
  */
-Status print_classfile(ClassFile *cf, const CliOptions *options);
+Status print_classfile(OutSink *out, ClassFile *cf, const CliOptions *options);
 
 #endif // PRINT_H
\ No newline at end of file
@@ -0,0 +1,130 @@
+#ifndef REF_INDEX_H
+#define REF_INDEX_H
+
+#include "base.h"
+#include "classfile.h"
+#include "out_sink.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Indice de referencias entre classes (.jvbi)
+ *
+ * Responde "quem chama X.y(desc)", "quem le/escreve o campo Z" e "quem
+ * usa a classe W" sem re-analisar nada. A construcao desmonta cada
+ * metodo (disasm_decode) e registra todo uso de Methodref,
+ * InterfaceMethodref, Fieldref e Class como (classe, metodo, pc,
+ * opcode). A consulta mapeia o arquivo (mmap).
+ *
+ * Layout (little-endian; offsets absolutos):
+ *
+ *   Cabecalho (REF_INDEX_HEADER_SIZE bytes)
+ *     0  magic "JVBCRIDX"      8  u4 versao     12 u4 flags (0)
+ *     16 u8 tamanho do arquivo
+ *     24 u4 chaves   28 u4 usos   32 u4 classes indexadas   36 u4 mascara
+ *     40 u8 offsets: strings, chaves, usos, diretorio
+ *
+ *   Strings: bytes terminados em '\0', referenciados pelo offset (0 = "").
+ *   Chave (REF_INDEX_KEY_SIZE): u1 tipo, 0, u2 0; u4 dono, nome,
+ *     descritor; u4 primeiro uso, numero de usos. Ordenadas por
+ *     (dono, nome, descritor): consultas por prefixo sao busca binaria.
+ *   Uso (REF_INDEX_SITE_SIZE): u4 classe, metodo, descritor do metodo,
+ *     pc; u1 opcode, 3 bytes 0. Agrupados por chave, na ordem de entrada.
+ *   Diretorio: u4[mascara + 1] = chave + 1 (0 = livre), enderecado pelo
+ *     hash FNV-1a de "dono\0nome\0descritor"; busca exata em O(1).
+ * ----------------------------------------------------------- */
+
+#define REF_INDEX_MAGIC        "JVBCRIDX"
+#define REF_INDEX_VERSION      1u
+#define REF_INDEX_HEADER_SIZE  72u
+#define REF_INDEX_KEY_SIZE     24u
+#define REF_INDEX_SITE_SIZE    20u
+
+typedef enum {
+    REF_INDEX_CLASS = 1,     /* new, anewarray, checkcast, instanceof, multianewarray */
+    REF_INDEX_FIELD = 2,     /* get/put field/static */
+    REF_INDEX_METHOD = 3     /* invokevirtual/special/static/interface */
+} RefIndexKind;
+
+/* ============================================================
+ * Construcao
+ * ============================================================ */
+typedef struct ref_index_builder RefIndexBuilder;
+
+/* NULL em falta de memoria. */
+RefIndexBuilder *ref_index_builder_new(void);
+
+/* Registra os usos dos metodos da classe (copia o que precisa; cf pode ser liberada depois). */
+Status ref_index_builder_add(RefIndexBuilder *b, const ClassFile *cf);
+
+/*
+ * Os dois passos de ref_index_builder_add. ref_index_fragment desmonta a
+ * classe e serializa os usos em out (sem estado compartilhado: pode rodar
+ * em paralelo); o fragmento pode ser guardado (cache por conteudo) e
+ * acrescentado depois, na ordem das entradas. ERR_BOUNDS se malformado.
+ */
+Status ref_index_fragment(const ClassFile *cf, OutSink *out);
+Status ref_index_builder_add_fragment(RefIndexBuilder *b, const char *data, size_t len);
+
+/* Ordena, monta o diretorio e grava (tmp + rename). out_size pode ser NULL. */
+Status ref_index_builder_finish(RefIndexBuilder *b, const char *path, size_t *out_size);
+
+/* Seguro com NULL. */
+void ref_index_builder_free(RefIndexBuilder *b);
+
+/* ============================================================
+ * Consulta
+ * ============================================================ */
+typedef struct ref_index RefIndex;
+
+typedef struct {
+    RefIndexKind kind;
+    const char *owner;          /* classe referenciada */
+    const char *name;           /* "" em REF_INDEX_CLASS */
+    const char *descriptor;     /* "" em REF_INDEX_CLASS */
+    uint32_t first_site, site_count;
+} RefIndexKey;
+
+typedef struct {
+    const char *class_name;     /* classe onde o uso aparece */
+    const char *method;
+    const char *method_descriptor;
+    uint32_t pc;
+    uint8_t opcode;
+} RefIndexSite;
+
+/* Mapeia e valida. NULL em erro (codigo em *out_status). */
+RefIndex *ref_index_open(const char *path, Status *out_status);
+
+/* Seguro com NULL. */
+void ref_index_close(RefIndex *idx);
+
+uint32_t ref_index_key_count(const RefIndex *idx);
+uint32_t ref_index_site_count(const RefIndex *idx);
+
+/* Registros por indice; false fora da faixa. */
+bool ref_index_key(const RefIndex *idx, uint32_t i, RefIndexKey *out);
+bool ref_index_site(const RefIndex *idx, uint32_t i, RefIndexSite *out);
+
+/* Chave exata (diretorio hash); -1 se ausente. */
+int64_t ref_index_find(const RefIndex *idx, const char *owner, const char *name, const char *descriptor);
+
+/*
+ * Faixa de chaves [*first, *first + retorno) com esse dono e, se name
+ * nao for NULL, esse nome (busca binaria). Retorna quantas.
+ */
+uint32_t ref_index_range(const RefIndex *idx, const char *owner, const char *name, uint32_t *first);
+
+/* Mnemonico dos opcodes indexados ("?" nos demais). */
+const char *ref_index_opcode_name(uint8_t opcode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REF_INDEX_H */
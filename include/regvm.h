@@ -0,0 +1,248 @@
+#ifndef REGVM_H
+#define REGVM_H
+
+#include "attributes.h"
+#include "cli.h"
+#include "jvm.h"
+#include "vectorize.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * IR de registradores e interpretador de registradores (--regvm)
+ *
+ * Traducao: sobre o CFG (cfg.h) e as instrucoes decodificadas (disasm.h),
+ * cada instrucao da pilha vira uma instrucao de tres enderecos cujos
+ * registradores sao os proprios slots do Frame: as locais sao r0 ..
+ * r(max_locals-1) e o operando na profundidade d e r(max_locals+d). A
+ * profundidade de cada pc vem do verificador. Assim iload_1; iload_2;
+ * iadd; istore_3 comeca como quatro instrucoes (mov, mov, add, mov).
+ *
+ * Otimizacao, por bloco basico: propagacao de copias e de constantes
+ * (os operandos passam a ler direto da local ou da constante, com add,
+ * mul, div, rem e comparacoes com imediato), movimentos para a pilha que
+ * ninguem mais le sao removidos, e o resultado de uma operacao seguida de
+ * istore e gravado direto na local. O exemplo acima vira add r3, r1, r2.
+ * Nas fronteiras de bloco (e em volta das instrucoes genericas) a pilha
+ * esta sempre nos seus slots, como o interpretador de pilha a deixaria.
+ *
+ * Execucao: as instrucoes da IR sao despachadas por um switch, lendo e
+ * gravando frame->local_vars. getfield/putfield de 1 slot sao da IR; o
+ * que ela nao modela (get/putstatic, invoke* nao inlinados, new, ldc de
+ * String, tableswitch...) e uma instrucao generica que chama
+ * o manipulador do interpretador (opcode_handlers) com pc e stack_top
+ * sincronizados; dai a execucao segue na entrada da IR do novo pc. Sem
+ * entrada (ou com a pilha diferente da prevista), regvm_execute devolve
+ * REGVM_INTERPRET e o interpretador de pilha continua do Frame. A
+ * divisao por zero e o acesso a campo de null tambem voltam para ele,
+ * que reporta o erro. Com inlinados, os registradores ficam numa copia
+ * local, gravada de volta no Frame sempre que o interpretador assume.
+ *
+ * Inlining: na traducao, invokestatic (da propria classe), invokespecial
+ * e invokevirtual de metodos pequenos (ate inline_size bytes de bytecode,
+ * REGVM_INLINE_DEPTH niveis, REGVM_INLINE_BUDGET bytes por metodo) sao
+ * substituidos pelo corpo do chamado, com locais e pilha dele em
+ * registradores alem dos do Frame. Privados, final e construtores so
+ * precisam do receptor nao nulo, assim como os invokevirtual de metodos
+ * que nenhuma classe carregada sobrescreve (analise de hierarquia,
+ * cp_cache_overridden); os demais sao protegidos por RV_GUARD (receptor
+ * da classe dona do metodo resolvido). Se a guarda de uma chamada do
+ * proprio metodo falha, a chamada segue pelo manipulador do
+ * interpretador, fora da linha. O corpo inlinado nao tem instrucoes
+ * genericas; RegMethod.sites guarda de onde veio cada trecho e
+ * regvm_origin leva qualquer instrucao de volta ao pc (e a linha) no
+ * bytecode do chamado e de cada chamador (com --verbose, cada
+ * desotimizacao mostra essa cadeia). Chamados com exception_table
+ * nao sao inlinados: as faixas dos handlers nao tem como ficar na IR.
+ *
+ * Desotimizacao: a guarda que falha dentro de um corpo inlinado, a
+ * divisao por zero e o acesso a campo de null em qualquer nivel saem da
+ * IR pelos metadados dos sites. Para cada metodo inlinado ativo e criado
+ * um Frame do interpretador (locais e pilha copiados dos registradores
+ * dele, pc na instrucao ou na chamada que esta em andamento); o mais
+ * interno continua no interpretador de pilha ate o return, o valor vai
+ * para a pilha do Frame de fora, que continua depois da chamada, e assim
+ * ate o Frame do proprio metodo, devolvido com REGVM_INTERPRET. Nesses
+ * pontos todos os registradores dos inlinados estao vivos. A guarda do
+ * proprio metodo e a desotimizacao mais simples: so a chamada vai para o
+ * interpretador e a IR continua no pc seguinte. Com deopt_stress
+ * (--deopt-stress), toda guarda falha, passe ou nao.
+ *
+ * Dependencias: cada metodo inlinado pela analise de hierarquia fica em
+ * RegMethod.deps. Quando uma classe carregada depois o sobrescreve
+ * (cp_cache_hierarchy_version muda), a traducao e invalidada: a proxima
+ * entrada traduz de novo, e a ativacao que ainda a executa volta ao
+ * interpretador de pilha na proxima instrucao generica, que e o unico
+ * ponto em que uma classe pode ser carregada.
+ *
+ * Vetorizacao: no metodo do Frame, o cabecalho de cada laco que
+ * vec_find_loops reconhece comeca com RV_VLOOP, que so quem entra no
+ * laco pela frente executa: com os limites provados, o laco inteiro roda
+ * num kernel SIMD e a IR desvia para a saida; senao segue o laco escalar.
+ *
+ * Com --jit, os saltos para tras da IR contam para o OSR (jit.h) como os
+ * do interpretador de pilha.
+ *
+ * A IR fica publica para outras passagens (RegMethod). As traducoes ficam
+ * numa tabela por MethodInfo; so a thread que executa usa este modulo.
+ * ----------------------------------------------------------- */
+
+#define REGVM_INTERPRET 2
+#define REGVM_NONE UINT32_MAX
+
+/* Inlining: tamanho do chamado (--inline-size), niveis e total por metodo */
+#define REGVM_DEFAULT_INLINE_SIZE 35
+#define REGVM_INLINE_DEPTH 3
+#define REGVM_INLINE_BUDGET 325
+
+/* Condicoes na ordem dos opcodes if<cond>: eq, ne, lt, ge, gt, le */
+typedef enum {
+    RV_NOP = 0,
+    RV_MOV,                     /* a = b */
+    RV_CONST,                   /* a = k */
+    RV_ADD, RV_SUB, RV_MUL,     /* a = b op c */
+    RV_DIV, RV_REM,             /* a = b op c; c == 0 desotimiza */
+    RV_NEG,                     /* a = -b */
+    RV_ADDK, RV_MULK,           /* a = b op k */
+    RV_DIVK, RV_REMK,           /* a = b op k (k fora de 0 e -1) */
+    RV_GETFIELD,                /* a = campo k do objeto b; nulo desotimiza */
+    RV_PUTFIELD,                /* campo k do objeto b = c; idem */
+    RV_GUARD,                   /* b nulo ou (k >= 0) classe != classes[k]: desvia (sem alvo, desotimiza) */
+    RV_VLOOP,                   /* vec_run(vloops[k]): executado, desvia para a saida do laco */
+    RV_IFEQ, RV_IFNE, RV_IFLT, RV_IFGE, RV_IFGT, RV_IFLE,                   /* b ? 0 */
+    RV_IFCMPEQ, RV_IFCMPNE, RV_IFCMPLT, RV_IFCMPGE, RV_IFCMPGT, RV_IFCMPLE,  /* b ? c */
+    RV_IFKEQ, RV_IFKNE, RV_IFKLT, RV_IFKGE, RV_IFKGT, RV_IFKLE,             /* b ? k */
+    RV_GOTO,
+    RV_RET,                     /* retorna b (1 slot) */
+    RV_RETV,                    /* retorna void */
+    RV_STACK                    /* manipulador do interpretador para opcode */
+} RegOp;
+
+typedef struct {
+    u1 op;                      /* RegOp */
+    u1 opcode;                  /* instrucao de origem */
+    u2 a, b, c;                 /* registradores: destino, fontes */
+    u2 depth;                   /* pilha (do metodo de site) antes da instrucao de origem */
+    u2 depth_after;             /* e depois dela */
+    u2 site;                    /* RegMethod.sites: 0 = o proprio metodo */
+    int32_t k;                  /* imediato */
+    u4 target;                  /* desvios: indice na IR */
+    u4 target_pc;               /* e o pc do alvo */
+    u4 pc;                      /* pc da instrucao de origem (no metodo de site) */
+} RegInsn;
+
+/* Metodo inlinado (sites[0] e o proprio metodo traduzido) */
+typedef struct {
+    ClassFile *cls;
+    const MethodInfo *method;
+    u4 call_pc;                 /* pc da chamada no metodo de parent */
+    u2 parent;
+    u2 base;                    /* registrador da local 0; a pilha comeca em base + max_locals */
+    const CodeAttribute *code;
+    u2 call_depth;              /* pilha de parent na chamada, com os argumentos */
+    u2 arg_slots;               /* argumentos, com o this */
+    u1 ret_slots;
+    u2 frame_depth;             /* pilha do Frame enquanto a chamada mais externa roda */
+} RegInlineSite;
+
+/* Um nivel da origem de uma instrucao da IR (regvm_origin) */
+typedef struct {
+    ClassFile *cls;
+    const MethodInfo *method;
+    u4 pc;                      /* no bytecode de method */
+    int32_t line;               /* LineNumberTable de method; -1 sem tabela */
+} RegOrigin;
+
+/* Metodo suposto sem sobrescrita na traducao */
+typedef struct {
+    ClassFile *cls;
+    const MethodInfo *method;
+} RegChaDep;
+
+typedef struct {
+    RegInsn *insns;
+    u4 count;
+    u4 *entry;                  /* por pc: indice na IR, ou REGVM_NONE */
+    int32_t *depth;             /* por pc: profundidade da pilha (verificador); -1 fora */
+    u4 code_length;
+    u2 nlocals;
+    u2 frame_regs;              /* max_locals + max_stack: registradores no Frame */
+    u2 nregs;                   /* com os dos metodos inlinados */
+    RegInlineSite *sites;
+    u2 nsites;
+    ClassFile **classes;        /* classes das guardas */
+    u2 nclasses;
+    RegChaDep *deps;
+    u2 ndeps;
+    unsigned hierarchy_version; /* cp_cache_hierarchy_version em que deps foi checado */
+    bool invalid;               /* alguma dependencia foi sobrescrita */
+    u4 bytecodes;               /* instrucoes alcancaveis traduzidas */
+    u4 propagated;              /* operandos trocados pela origem da copia ou constante */
+    u4 removed;                 /* instrucoes eliminadas */
+    u4 inlined;                 /* chamadas substituidas pelo corpo */
+    u4 devirtualized;           /* das inlinadas, virtuais sem guarda de classe (CHA) */
+    VecLoop *vloops;            /* lacos vetorizaveis (vectorize.h) */
+    u2 nvloops;
+} RegMethod;
+
+typedef struct {
+    unsigned methods;           /* traduzidos */
+    unsigned failed;            /* nao traduziveis (rejeitados, grandes demais) */
+    uint64_t bytecodes;         /* instrucoes de origem */
+    uint64_t insns;             /* instrucoes da IR */
+    uint64_t propagated;
+    uint64_t removed;
+    uint64_t inlined;
+    uint64_t devirtualized;
+    unsigned invalidated;       /* traducoes descartadas por dependencia sobrescrita */
+    uint64_t deoptimized;       /* saidas da IR por guarda ou armadilha */
+    uint64_t deopt_frames;      /* Frames refeitos para metodos inlinados */
+    unsigned vectorized;        /* lacos com kernel */
+    uint64_t vector_runs;       /* lacos executados pelo kernel */
+    uint64_t dispatches;        /* instrucoes da IR executadas */
+} RegVmStats;
+
+typedef struct {
+    unsigned inline_size;       /* --inline-size (0 = padrao) */
+    bool no_inline;             /* --no-inline */
+    bool deopt_stress;          /* --deopt-stress: toda guarda desotimiza */
+    bool no_vectorize;          /* --no-vectorize */
+} RegVmConfig;
+
+/* Inlining e desotimizacao. Chamar antes de executar. */
+void regvm_configure(const RegVmConfig *config);
+
+/* Traduz e otimiza o Code de method. NULL se o verificador rejeita ou sem memoria. */
+RegMethod *regvm_translate(ClassFile *cf, const MethodInfo *method, const CodeAttribute *code);
+
+void regvm_free(RegMethod *m);
+
+/*
+ * De onde veio a instrucao insn de m: out[0] e o metodo que a contem
+ * (o inlinado mais interno), com pc e linha no bytecode dele; os
+ * seguintes sao as chamadas que o inlinaram, ate o metodo traduzido.
+ * Grava ate cap niveis e devolve quantos.
+ */
+u2 regvm_origin(const RegMethod *m, u4 insn, RegOrigin *out, u2 cap);
+
+/*
+ * Executa frame->method_info pela IR (traduzida na primeira vez) a partir
+ * de frame->pc. 1 (return, valor no topo da pilha do Frame), negativo em
+ * erro ou REGVM_INTERPRET (continuar no interpretador de pilha).
+ */
+int regvm_execute(Frame *frame, const CliOptions *options);
+
+void regvm_stats(RegVmStats *out);
+
+/* Libera todas as traducoes e zera as estatisticas. */
+void regvm_release_all(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REGVM_H */
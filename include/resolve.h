@@ -24,6 +24,7 @@ typedef struct class_file ClassFile; // O tipo principal da Pessoa B
  * @param cf Estrutura ClassFile completa.
  * @param index O indice u2 lido do bytecode (Ex: 26).
  * @return String alocada dinamicamente (deve ser liberada pelo chamador).
+ *         Sem copia: resolve_ref().
  */
 char* resolve_ref_to_string(const ClassFile *cf, uint16_t index);
 
@@ -57,4 +58,26 @@ char* resolve_literal_to_string(const ClassFile *cf, uint16_t index);
 char* resolve_class_name_to_string(const ClassFile *cf, uint16_t index);
 
 
+// =======================================================
+// VERSOES MEMORIZADAS (sem alocacao por chamada)
+// =======================================================
+
+/*
+ * Mesmo texto das funcoes *_to_string acima, mas formatado uma unica vez
+ * por indice do CP e guardado na propria classe (cf->names): as chamadas
+ * seguintes so leem um vetor. O ponteiro e emprestado e vale enquanto a
+ * classe existir (liberado por free_classfile). Nomes (Utf8 e Class) nem
+ * sao copiados: apontam direto para o constant pool.
+ *
+ * Seguras entre threads (mesma publicacao do cp_cache: trava na escrita,
+ * leitura com acquire).
+ */
+const char* resolve_ref(const ClassFile *cf, uint16_t index);
+const char* resolve_literal(const ClassFile *cf, uint16_t index);
+const char* resolve_class_name(const ClassFile *cf, uint16_t index);
+
+/* Libera os textos memorizados da classe (chamada por free_classfile). */
+void resolve_memo_release(ClassFile *cf);
+
+
 #endif // RESOLVE_H
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Pool fixo de threads trabalhadoras (pthreads)
+ *
+ * Modelo "parallel for": thread_pool_for() distribui os indices
+ * [0, count) entre as trabalhadoras e a propria thread chamadora,
+ * cada uma pegando o proximo indice livre com um contador atomico.
+ * A chamada so retorna quando todos os indices foram processados.
+ * ----------------------------------------------------------- */
+
+typedef struct thread_pool ThreadPool;
+
+/* Tarefa: chamada uma vez para cada indice. */
+typedef void (*ThreadPoolTask)(void *ctx, size_t index);
+
+/* Numero de CPUs online (>= 1). */
+int thread_pool_cpu_count(void);
+
+/*
+ * Cria um pool com 'threads' trabalhadoras no total (incluindo a chamadora).
+ * threads <= 0 usa thread_pool_cpu_count(). Retorna NULL em falha.
+ */
+ThreadPool *thread_pool_create(int threads);
+
+/* Numero total de threads que executam tarefas (>= 1). */
+int thread_pool_size(const ThreadPool *pool);
+
+/* Executa task(ctx, i) para i em [0, count) e espera terminar. */
+void thread_pool_for(ThreadPool *pool, size_t count, ThreadPoolTask task, void *ctx);
+
+/* Encerra as trabalhadoras e libera o pool (seguro com NULL). */
+void thread_pool_destroy(ThreadPool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THREAD_POOL_H */
@@ -0,0 +1,110 @@
+#ifndef VECTORIZE_H
+#define VECTORIZE_H
+
+#include "attributes.h"
+#include "cfg.h"
+#include "disasm.h"
+#include "jvm.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Vetorizacao de lacos contados sobre int[] (--regvm)
+ *
+ * Reconhecimento: sobre o CFG (cfg.h), um laco natural de dois blocos na
+ * forma que o javac gera para for (i...; i < limite; i++):
+ *
+ *     cabecalho: iload i; <limite>; if_icmpge saida
+ *     corpo:     <idioma>; iinc i 1; goto cabecalho
+ *
+ * ou o laco de um bloco so que o peephole (peephole.h) deixa dela:
+ *
+ *     corpo:     <idioma>; iinc i 1; iload i; <limite>; if_icmplt corpo
+ *
+ * com limite numa local, constante ou a.length, e o corpo num destes
+ * idiomas (locais distintas do indice):
+ *
+ *     VEC_SUM   s += a[i]
+ *     VEC_ADD   d[i] = a[i] + b[i]   (VEC_SUB: a[i] - b[i])
+ *     VEC_FILL  d[i] = v   (local ou constante)
+ *     VEC_COPY  d[i] = a[i]
+ *
+ * Execucao: vec_run prova os limites uma vez, na entrada do laco (arrays
+ * nao nulos, 0 <= i e limite <= length de cada um); provados, o laco
+ * inteiro roda num kernel e as locais ficam como o laco escalar as
+ * deixaria (i = limite, s somado). Senao nada e feito e o laco escalar
+ * segue, reportando o erro na iteracao certa. Os elementos de mesmo
+ * indice nao dependem uns dos outros, entao arrays iguais (d == a) nao
+ * mudam o resultado.
+ *
+ * Kernels: escalar, SSE2 (4 ints) e AVX2 (8 ints), todos com o epilogo
+ * escalar para o que sobra. O conjunto e escolhido uma vez pelo cpuid
+ * (__builtin_cpu_supports), limitado por vec_configure (--simd); fora
+ * de x86 so o escalar existe. A copia usa memmove.
+ * ----------------------------------------------------------- */
+
+typedef enum {
+    VEC_SUM = 0,
+    VEC_ADD,
+    VEC_SUB,
+    VEC_FILL,
+    VEC_COPY
+} VecKind;
+
+typedef enum {
+    VEC_LIMIT_LOCAL = 0,        /* i < local */
+    VEC_LIMIT_CONST,            /* i < k */
+    VEC_LIMIT_LENGTH            /* i < array.length */
+} VecLimitKind;
+
+typedef enum {
+    VEC_ISA_AUTO = 0,           /* o melhor que o processador tem */
+    VEC_ISA_SCALAR,
+    VEC_ISA_SSE2,
+    VEC_ISA_AVX2
+} VecIsa;
+
+typedef struct {
+    u4 head_pc;                 /* iload do indice no cabecalho (1a do corpo, na forma contada) */
+    u4 exit_pc;                 /* alvo do if_icmpge (apos o if_icmplt) */
+    u1 kind;                    /* VecKind */
+    u1 limit_kind;              /* VecLimitKind */
+    bool value_const;           /* VEC_FILL: valor em value_k */
+    u2 index;                   /* locais: indice, */
+    u2 limit;                   /* limite (ou o array de a.length), */
+    u2 acc;                     /* acumulador (VEC_SUM) ou valor (VEC_FILL), */
+    u2 dst, src1, src2;         /* arrays (VEC_SUM le src1) */
+    int32_t limit_k;
+    int32_t value_k;
+} VecLoop;
+
+/* Conjunto maximo de instrucoes dos kernels (--simd). Chamar antes de executar. */
+void vec_configure(VecIsa max);
+
+/* Conjunto em uso (cpuid e vec_configure), nunca VEC_ISA_AUTO. */
+VecIsa vec_isa(void);
+
+/* "scalar", "sse2" ou "avx2". */
+const char *vec_isa_name(VecIsa isa);
+
+/*
+ * Lacos vetorizaveis do metodo (instrucoes em dm, grafo em cfg), em
+ * ordem de cabecalho; grava ate cap em out e devolve quantos achou.
+ */
+u4 vec_find_loops(const CodeAttribute *code, const DisasmMethod *dm, const Cfg *cfg, VecLoop *out, u4 cap);
+
+/*
+ * Executa o laco inteiro com as locais em locals, se os limites forem
+ * provados. false: nada foi feito, seguir pelo laco escalar.
+ */
+bool vec_run(const VecLoop *loop, Slot *locals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VECTORIZE_H */
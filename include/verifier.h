@@ -0,0 +1,61 @@
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include "base.h"
+#include "classfile.h"
+#include "attributes.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Verificador de bytecode (fluxo de dados)
+ *
+ * Prova, para cada instrucao alcancavel de um metodo:
+ *   - limites: instrucoes inteiras dentro do codigo, alvos de salto,
+ *     switch e handlers caindo no inicio de uma instrucao, nada passa
+ *     do fim do codigo;
+ *   - pilha de operandos: sem underflow, sem passar de max_stack, mesma
+ *     profundidade em todos os caminhos que chegam a uma instrucao;
+ *   - tipos: int/float/long/double/referencia em cada slot da pilha e
+ *     de variavel local (indices < max_locals), operandos conferidos
+ *     com os descritores de campos, metodos e do retorno.
+ *
+ * Com StackMapTable (class >= 50) os quadros declarados sao usados como
+ * estado nos alvos e o estado inferido precisa ser atribuivel a eles; sem
+ * ele os estados sao inferidos por ponto fixo (merge nos alvos).
+ *
+ * Nao modela inicializacao de objetos (new/<init>) nem a hierarquia de
+ * classes: referencias sao um tipo so. jsr/ret sao rejeitados.
+ *
+ * Um metodo aceito pode rodar sem nenhuma checagem de pilha em tempo de
+ * execucao (execute.c); um rejeitado nunca ganha Frame.
+ * ----------------------------------------------------------- */
+
+typedef struct {
+    u4 pc;                  /* instrucao onde a prova falhou */
+    char message[128];
+} VerifyError;
+
+/*
+ * Verifica o Code de method. OK se aceito; ERR_BOUNDS se rejeitado
+ * (motivo em *err, se nao for NULL); ERR_MEMORY em falha de alocacao.
+ */
+Status verify_method(const ClassFile *cf, const MethodInfo *method, const CodeAttribute *code,
+                     VerifyError *err);
+
+/*
+ * Como verify_method; se aceito, depth[pc] (code_length entradas) recebe
+ * a profundidade da pilha no inicio de cada instrucao alcancavel e -1 nas
+ * demais posicoes.
+ */
+Status verify_method_depths(const ClassFile *cf, const MethodInfo *method, const CodeAttribute *code,
+                            int32_t *depth, VerifyError *err);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VERIFIER_H */
@@ -0,0 +1,53 @@
+#ifndef ZIP_SOURCE_H
+#define ZIP_SOURCE_H
+
+#include "base.h"
+#include "io.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* -----------------------------------------------------------
+ * Leitor de jar/zip embutido
+ *
+ * zip_open() mapeia o arquivo somente-leitura e percorre o diretorio
+ * central uma unica vez, montando um indice hash nome -> entrada; buscas
+ * por classe sao O(1), sem varrer diretorios. Os dados de uma entrada so
+ * sao tocados quando ela e pedida: entradas armazenadas (metodo 0) saem
+ * sem copia, apontando para o mapeamento; entradas comprimidas (metodo 8)
+ * sao descomprimidas sob demanda (inflate.h) e conferidas pelo CRC-32.
+ *
+ * Nao suporta ZIP64, arquivos divididos nem entradas criptografadas.
+ * Leituras concorrentes do mesmo ZipArchive sao seguras.
+ * ----------------------------------------------------------- */
+
+typedef struct zip_source ZipArchive;
+
+/* Mapeia e indexa o arquivo. NULL em erro (codigo em *out_status). */
+ZipArchive *zip_open(const char *path, Status *out_status);
+
+/* Desfaz o mapeamento: buffers emprestados de zip_read_entry ficam invalidos. */
+void zip_close(ZipArchive *zip);
+
+size_t zip_entry_count(const ZipArchive *zip);
+
+/* Nome da i-esima entrada, na ordem do diretorio central. */
+const char *zip_entry_name(const ZipArchive *zip, size_t i);
+
+/* Indice da entrada com esse nome (ex: "pkg/Main.class") ou -1. */
+long zip_find(const ZipArchive *zip, const char *name);
+
+/*
+ * Le a i-esima entrada em *out. Entrada armazenada: out->borrowed = 1 e
+ * out->data aponta para o mapeamento (valido ate zip_close). Comprimida:
+ * out->data e alocado. Em ambos os casos buffer_free() e o correto.
+ */
+Status zip_read_entry(const ZipArchive *zip, size_t i, Buffer *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZIP_SOURCE_H */
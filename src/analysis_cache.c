@@ -0,0 +1,332 @@
+#define _POSIX_C_SOURCE 200809L  /* utimensat, dirent */
+#include "analysis_cache.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char ENTRADA_MAGIC[8] = { 'J', 'V', 'B', 'C', 'C', 'H', '0', '1' };
+#define ENTRADA_CABECALHO 24u   /* magic, u8 chave, u8 tamanho do payload */
+
+struct analysis_cache {
+    char *dir;
+    uint64_t max_bytes;
+    uint64_t total;             /* estimativa do tamanho em disco (arquivo "tamanho") */
+    uint64_t hits, misses, evicted;
+    unsigned long seq;          /* nomes temporarios distintos entre threads */
+    pthread_mutex_t lock;
+};
+
+/* ============================================================
+ * Hash (64 bits, 8 bytes por passo)
+ * ============================================================ */
+#define K1 0x9E3779B185EBCA87ull
+#define K2 0xC2B2AE3D27D4EB4Full
+#define K3 0x165667B19E3779F9ull
+
+static uint64_t rotl(uint64_t v, int r) {
+    return (v << r) | (v >> (64 - r));
+}
+
+static uint64_t misturar(uint64_t v) {
+    v ^= v >> 33;
+    v *= 0xFF51AFD7ED558CCDull;
+    v ^= v >> 33;
+    v *= 0xC4CEB9FE1A85EC53ull;
+    v ^= v >> 33;
+    return v;
+}
+
+uint64_t analysis_cache_hash(const void *data, size_t len, uint64_t seed) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t h = seed ^ ((uint64_t)len * K1);
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        h ^= rotl(w * K2, 31) * K1;
+        h = rotl(h, 27) * K1 + K3;
+    }
+    uint64_t resto = 0;
+    for (size_t k = 0; i + k < len; k++) resto |= (uint64_t)p[i + k] << (8 * k);
+    h ^= rotl(resto * K2, 31) * K1;
+    return misturar(h);
+}
+
+uint64_t analysis_cache_seed(const char *description) {
+    return analysis_cache_hash(description, strlen(description), ANALYSIS_CACHE_FORMAT);
+}
+
+/* ============================================================
+ * Caminhos
+ * ============================================================ */
+static const char HEXA[] = "0123456789abcdef";
+
+/* "<dir>/<2 hexa>" em buf (subdiretorio da chave) */
+static void caminho_sub(const AnalysisCache *c, uint64_t key, char *buf, size_t cap) {
+    snprintf(buf, cap, "%s/%c%c", c->dir, HEXA[(key >> 60) & 0xF], HEXA[(key >> 56) & 0xF]);
+}
+
+static void caminho_entrada(const AnalysisCache *c, uint64_t key, char *buf, size_t cap) {
+    char nome[17];
+    for (int i = 0; i < 16; i++) nome[i] = HEXA[(key >> (60 - 4 * i)) & 0xF];
+    nome[16] = '\0';
+    snprintf(buf, cap, "%s/%c%c/%s", c->dir, nome[0], nome[1], nome);
+}
+
+static size_t tamanho_caminho(const AnalysisCache *c) {
+    return strlen(c->dir) + 64;
+}
+
+static bool criar_diretorio(const char *path) {
+    if (mkdir(path, 0777) == 0 || errno == EEXIST) {
+        struct stat sb;
+        return stat(path, &sb) == 0 && S_ISDIR(sb.st_mode);
+    }
+    return false;
+}
+
+/* ============================================================
+ * Tamanho total (estimativa persistida entre execucoes)
+ * ============================================================ */
+static uint64_t ler_total(const AnalysisCache *c) {
+    size_t cap = tamanho_caminho(c);
+    char *path = (char *)malloc(cap);
+    unsigned long long total = 0;
+    if (!path) return 0;
+    snprintf(path, cap, "%s/tamanho", c->dir);
+    FILE *f = fopen(path, "r");
+    if (f) {
+        if (fscanf(f, "%llu", &total) != 1) total = 0;
+        fclose(f);
+    }
+    free(path);
+    return total;
+}
+
+static void gravar_total(const AnalysisCache *c) {
+    size_t cap = tamanho_caminho(c);
+    char *path = (char *)malloc(cap);
+    if (!path) return;
+    snprintf(path, cap, "%s/tamanho", c->dir);
+    FILE *f = fopen(path, "w");
+    if (f) {
+        fprintf(f, "%llu\n", (unsigned long long)c->total);
+        fclose(f);
+    }
+    free(path);
+}
+
+/* ============================================================
+ * Remocao LRU
+ * ============================================================ */
+typedef struct {
+    char *path;
+    time_t mtime;
+    uint64_t size;
+} Entrada;
+
+static int comparar_mtime(const void *a, const void *b) {
+    const Entrada *x = (const Entrada *)a, *y = (const Entrada *)b;
+    return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+static bool eh_hexa(const char *s, size_t n) {
+    if (strlen(s) != n) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (!strchr(HEXA, s[i])) return false;
+    }
+    return true;
+}
+
+/* Lista as entradas (recalcula o total real) e apaga as mais antigas ate 90% do limite */
+static void aplicar_limite(AnalysisCache *c) {
+    Entrada *v = NULL;
+    size_t n = 0, cap = 0;
+    uint64_t total = 0;
+    size_t lp = strlen(c->dir);
+
+    DIR *raiz = opendir(c->dir);
+    if (!raiz) return;
+    struct dirent *d;
+    while ((d = readdir(raiz)) != NULL) {
+        if (!eh_hexa(d->d_name, 2)) continue;
+        char *sub = (char *)malloc(lp + 4);
+        if (!sub) break;
+        snprintf(sub, lp + 4, "%s/%s", c->dir, d->d_name);
+        DIR *dd = opendir(sub);
+        struct dirent *e;
+        while (dd && (e = readdir(dd)) != NULL) {
+            if (!eh_hexa(e->d_name, 16)) continue;
+            if (n == cap) {
+                size_t nova = cap ? cap * 2 : 1024;
+                Entrada *nv = (Entrada *)realloc(v, nova * sizeof(Entrada));
+                if (!nv) break;
+                v = nv;
+                cap = nova;
+            }
+            char *path = (char *)malloc(lp + 21);
+            struct stat sb;
+            if (!path) break;
+            snprintf(path, lp + 21, "%s/%s", sub, e->d_name);
+            if (stat(path, &sb) != 0) {
+                free(path);
+                continue;
+            }
+            v[n].path = path;
+            v[n].mtime = sb.st_mtime;
+            v[n].size = (uint64_t)sb.st_size;
+            total += v[n].size;
+            n++;
+        }
+        if (dd) closedir(dd);
+        free(sub);
+    }
+    closedir(raiz);
+
+    if (total > c->max_bytes) {
+        uint64_t alvo = c->max_bytes / 10 * 9;
+        qsort(v, n, sizeof(Entrada), comparar_mtime);
+        for (size_t i = 0; i < n && total > alvo; i++) {
+            if (remove(v[i].path) == 0) {
+                total -= v[i].size;
+                c->evicted++;
+            }
+        }
+    }
+    for (size_t i = 0; i < n; i++) free(v[i].path);
+    free(v);
+    c->total = total;
+}
+
+/* ============================================================
+ * API publica
+ * ============================================================ */
+AnalysisCache *analysis_cache_open(const char *dir, uint64_t max_bytes, Status *out_status) {
+    Status st = ERR_MEMORY;
+    AnalysisCache *c = (AnalysisCache *)calloc(1, sizeof(AnalysisCache));
+    if (c) c->dir = (char *)malloc(strlen(dir) + 1);
+    if (c && c->dir) {
+        strcpy(c->dir, dir);
+        c->max_bytes = max_bytes ? max_bytes : ANALYSIS_CACHE_DEFAULT_MAX;
+        st = criar_diretorio(dir) ? OK : ERR_FILE;
+        if (st == OK && pthread_mutex_init(&c->lock, NULL) != 0) st = ERR_MEMORY;
+    }
+    if (st != OK) {
+        if (c) free(c->dir);
+        free(c);
+        c = NULL;
+    } else {
+        c->total = ler_total(c);
+    }
+    if (out_status) *out_status = st;
+    return c;
+}
+
+void analysis_cache_trim(AnalysisCache *c) {
+    if (c->total > c->max_bytes) aplicar_limite(c);
+}
+
+void analysis_cache_close(AnalysisCache *c) {
+    if (!c) return;
+    analysis_cache_trim(c);
+    gravar_total(c);
+    pthread_mutex_destroy(&c->lock);
+    free(c->dir);
+    free(c);
+}
+
+static void contar(AnalysisCache *c, uint64_t *contador) {
+    pthread_mutex_lock(&c->lock);
+    (*contador)++;
+    pthread_mutex_unlock(&c->lock);
+}
+
+static uint64_t le64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void grava64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+bool analysis_cache_get(AnalysisCache *c, uint64_t key, char **out_data, size_t *out_len) {
+    char path[4096];
+    if (tamanho_caminho(c) > sizeof path) return false;
+    caminho_entrada(c, key, path, sizeof path);
+
+    bool ok = false;
+    char *data = NULL;
+    FILE *f = fopen(path, "rb");
+    if (f) {
+        unsigned char cab[ENTRADA_CABECALHO];
+        struct stat sb;
+        if (fread(cab, 1, sizeof cab, f) == sizeof cab && memcmp(cab, ENTRADA_MAGIC, 8) == 0 &&
+            le64(cab + 8) == key && fstat(fileno(f), &sb) == 0 &&
+            (uint64_t)sb.st_size == ENTRADA_CABECALHO + le64(cab + 16) && le64(cab + 16) < (size_t)-1) {
+            size_t len = (size_t)le64(cab + 16);
+            data = (char *)malloc(len ? len : 1);
+            if (data && fread(data, 1, len, f) == len) {
+                *out_data = data;
+                *out_len = len;
+                ok = true;
+            }
+        }
+        fclose(f);
+    }
+    if (ok) {
+        utimensat(AT_FDCWD, path, NULL, 0);   /* LRU: marca o uso */
+        contar(c, &c->hits);
+    } else {
+        free(data);
+        contar(c, &c->misses);
+    }
+    return ok;
+}
+
+Status analysis_cache_put(AnalysisCache *c, uint64_t key, const void *data, size_t len) {
+    char path[4096], tmp[4096 + 48];
+    if (tamanho_caminho(c) > sizeof path) return ERR_BOUNDS;
+    caminho_sub(c, key, path, sizeof path);
+    if (!criar_diretorio(path)) return ERR_FILE;
+    caminho_entrada(c, key, path, sizeof path);
+
+    pthread_mutex_lock(&c->lock);
+    unsigned long seq = c->seq++;
+    pthread_mutex_unlock(&c->lock);
+    snprintf(tmp, sizeof tmp, "%s.%ld.%lu.tmp", path, (long)getpid(), seq);
+
+    unsigned char cab[ENTRADA_CABECALHO];
+    memcpy(cab, ENTRADA_MAGIC, 8);
+    grava64(cab + 8, key);
+    grava64(cab + 16, len);
+
+    Status st = OK;
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return ERR_FILE;
+    if (fwrite(cab, 1, sizeof cab, f) != sizeof cab || (len && fwrite(data, 1, len, f) != len)) st = ERR_FILE;
+    if (fclose(f) != 0) st = ERR_FILE;
+    if (st == OK && rename(tmp, path) != 0) st = ERR_FILE;
+    if (st != OK) {
+        remove(tmp);
+        return st;
+    }
+
+    pthread_mutex_lock(&c->lock);
+    c->total += ENTRADA_CABECALHO + len;
+    pthread_mutex_unlock(&c->lock);
+    return OK;
+}
+
+void analysis_cache_stats(const AnalysisCache *c, uint64_t *hits, uint64_t *misses, uint64_t *evicted) {
+    if (hits) *hits = c->hits;
+    if (misses) *misses = c->misses;
+    if (evicted) *evicted = c->evicted;
+}
@@ -91,7 +91,8 @@ static Status parse_code_attributes(const ClassFile *cf, Buffer *buf, CodeAttrib
         return OK;
     }
     
-    code->attributes = malloc(sizeof(AttributeInfo) * code->attributes_count);
+    // calloc: numa falha no meio, os info ainda não lidos ficam NULL para o free
+    code->attributes = calloc(code->attributes_count, sizeof(AttributeInfo));
     if (!code->attributes) return ERR_MEMORY;
     
     for (u2 i = 0; i < code->attributes_count; i++) {
@@ -111,7 +112,7 @@ static Status parse_code_attributes(const ClassFile *cf, Buffer *buf, CodeAttrib
             const char *attr_name = cp_utf8(cf->constant_pool, cf->constant_pool_count, attr->attribute_name_index);
             
             if (strcmp(attr_name, "LineNumberTable") == 0) {
-                Buffer attr_buf = {attr->info, attr->attribute_length, 0};
+                Buffer attr_buf = {attr->info, attr->attribute_length, 0, 1};
                 status = read_bytes(buf, attr->info, attr->attribute_length);
                 if (status != OK) return status;
                 
@@ -122,7 +123,7 @@ static Status parse_code_attributes(const ClassFile *cf, Buffer *buf, CodeAttrib
                 }
             }
             else if (strcmp(attr_name, "LocalVariableTable") == 0) {
-                Buffer attr_buf = {attr->info, attr->attribute_length, 0};
+                Buffer attr_buf = {attr->info, attr->attribute_length, 0, 1};
                 status = read_bytes(buf, attr->info, attr->attribute_length);
                 if (status != OK) return status;
                 
@@ -155,7 +156,7 @@ Status parse_code_attribute(const ClassFile *cf, const AttributeInfo *attr, Code
         return ERR_BOUNDS;
     }
     
-    Buffer buf = {attr->info, attr->attribute_length, 0};
+    Buffer buf = {attr->info, attr->attribute_length, 0, 1};
     Status status;
     
     status = read_u2(&buf, &out->max_stack);
@@ -179,21 +180,13 @@ Status parse_code_attribute(const ClassFile *cf, const AttributeInfo *attr, Code
     if (!out->code) return ERR_MEMORY;
     
     status = read_bytes(&buf, out->code, out->code_length);
+    if (status == OK) status = parse_exception_table(&buf, out);
+    if (status == OK) status = parse_code_attributes(cf, &buf, out);
     if (status != OK) {
-        free(out->code);
-        return status;
-    }
-    
-    status = parse_exception_table(&buf, out);
-    if (status != OK) {
-        free(out->code);
-        return status;
-    }
-    
-    status = parse_code_attributes(cf, &buf, out);
-    if (status != OK) {
-        free(out->code);
-        if (out->exception_table) free(out->exception_table);
+        // Libera o que foi alocado e zera os ponteiros: o chamador pode
+        // chamar free_code_attribute de novo sem liberar duas vezes
+        free_code_attribute(out);
+        memset(out, 0, sizeof(CodeAttribute));
         return status;
     }
     
@@ -0,0 +1,309 @@
+#define _POSIX_C_SOURCE 200809L  /* getline, clock_gettime */
+#include "batch.h"
+#include "analysis_cache.h"
+#include "class_loader.h"
+#include "dot.h"
+#include "json.h"
+#include "print.h"
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Classes por janela: limita a memoria dos buffers de saida pendentes */
+#define JANELA_LOTE 1024
+
+/* Saida formatada de um item da lista */
+typedef struct {
+    char *texto;
+    size_t tamanho;
+    Status status;              /* OK, ou erro de formatacao */
+} SaidaItem;
+
+typedef struct {
+    ClassList *list;
+    SaidaItem *saidas;          /* indexado a partir de 'inicio' */
+    size_t inicio;
+    const CliOptions *options;
+    int direto;                 /* uma thread so: formata direto no stdout, sem buffer */
+    OutSink saida;              /* sink do stdout (modo direto) */
+    AnalysisCache *cache;       /* --cache (NULL = sem cache) */
+    uint64_t semente;           /* modo de saida e flags: parte da chave do cache */
+
+    /* --unordered: escrita direta, serializada */
+    pthread_mutex_t trava;
+    size_t escritos;
+    int falhas;
+} Lote;
+
+static double agora(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* ============================================================
+ * Entradas
+ * ============================================================ */
+
+/* "@lista": um caminho por linha */
+static Status coletar_lista(ClassList *list, const char *arquivo, int *erros) {
+    FILE *f = fopen(arquivo, "r");
+    if (!f) return ERR_FILE;
+
+    char *linha = NULL;
+    size_t cap = 0;
+    ssize_t n;
+    while ((n = getline(&linha, &cap, f)) >= 0) {
+        while (n > 0 && (linha[n - 1] == '\n' || linha[n - 1] == '\r' || linha[n - 1] == ' ' || linha[n - 1] == '\t')) {
+            linha[--n] = '\0';
+        }
+        char *p = linha;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '\0' || *p == '#') continue;
+
+        Status st = class_list_collect(list, p);
+        if (st != OK) {
+            fprintf(stderr, "Erro (IO): Nao foi possivel listar '%s' (de %s). Codigo: %d\n", p, arquivo, st);
+            (*erros)++;
+        }
+    }
+    free(linha);
+    fclose(f);
+    return OK;
+}
+
+static int coletar_entradas(ClassList *list, const CliOptions *options) {
+    int erros = 0;
+    for (int i = 0; i < options->input_count; i++) {
+        const char *entrada = options->inputs[i];
+        Status st = entrada[0] == '@' ? coletar_lista(list, entrada + 1, &erros)
+                                      : class_list_collect(list, entrada);
+        if (st != OK) {
+            fprintf(stderr, "Erro (IO): Nao foi possivel listar '%s'. Codigo: %d\n", entrada, st);
+            erros++;
+        }
+    }
+    return erros;
+}
+
+/* ============================================================
+ * Trabalho por classe
+ * ============================================================ */
+
+/* Tudo o que muda o texto de uma classe entra na semente da chave do cache */
+static uint64_t cache_semente(const CliOptions *options) {
+    char descricao[64];
+    snprintf(descricao, sizeof descricao, "saida modo=%d codigo=%d metodos=%d cfg=%d", (int)options->output_mode,
+             (int)options->disassemble_code, (int)options->jsonl_per_method, (int)options->print_cfg);
+    return analysis_cache_seed(descricao);
+}
+
+static void relatar_falha(const LoadedClass *lc, Status render) {
+    if (lc->io_status != OK) {
+        fprintf(stderr, "Erro (IO): Nao foi possivel ler o arquivo '%s'. Codigo: %d\n",
+                lc->path, lc->io_status);
+    } else if (lc->cf_status != CF_STATUS_OK) {
+        fprintf(stderr, "Erro (Parser): Falha ao analisar '%s'. Codigo: %d\n", lc->path, lc->cf_status);
+    } else if (render != OK) {
+        fprintf(stderr, "Erro (Impressao): Falha ao gerar a saida de '%s'.\n", lc->path);
+    }
+}
+
+/* Formata a classe ja analisada em out (sem o cabecalho do modo pretty) */
+static Status renderizar(OutSink *out, const LoadedClass *lc, const CliOptions *options) {
+    if (options->output_mode == OUTPUT_MODE_JSONL) return json_line_classfile(out, lc->path, lc->cf, options);
+    if (options->output_mode == OUTPUT_MODE_DOT) return dot_classfile(out, lc->cf, options);
+    return options->output_mode == OUTPUT_MODE_JSON ? json_classfile(out, lc->cf, options)
+                                                    : print_classfile(out, lc->cf, options);
+}
+
+/* "==> caminho <==" do modo pretty (no modo direto, separado da classe anterior) */
+static void escrever_cabecalho(const Lote *lote, const LoadedClass *lc, OutSink *out, int primeiro) {
+    if (lote->options->output_mode != OUTPUT_MODE_PRETTY) return;
+    if (lote->direto && !primeiro) out_char(out, '\n');
+    out_str(out, "==> ");
+    out_str(out, lc->path);
+    out_str(out, " <==\n");
+}
+
+/*
+ * Com cache: le os bytes, procura a saida pelo hash do conteudo e so faz
+ * parse e formatacao na falta (guardando o resultado). Sem cache, formata
+ * direto em out.
+ */
+static Status gerar_corpo(Lote *lote, LoadedClass *lc, OutSink *out, int primeiro) {
+    const CliOptions *options = lote->options;
+    Buffer bytes;
+    if (!class_loader_read_item(lc, &bytes)) return OK;
+    if (!lote->cache) {
+        if (!class_loader_parse_buffer(lc, &bytes)) return OK;
+        escrever_cabecalho(lote, lc, out, primeiro);
+        Status st = renderizar(out, lc, options);
+        class_loader_release_item(lc);
+        return st;
+    }
+
+    uint64_t chave = analysis_cache_hash(bytes.data, bytes.size, lote->semente);
+    /* JSONL grava o caminho nos registros: entra na chave */
+    if (options->output_mode == OUTPUT_MODE_JSONL) chave = analysis_cache_hash(lc->path, strlen(lc->path), chave);
+    char *corpo;
+    size_t tamanho;
+    if (analysis_cache_get(lote->cache, chave, &corpo, &tamanho)) {
+        buffer_free(&bytes);
+        escrever_cabecalho(lote, lc, out, primeiro);
+        out_put(out, corpo, tamanho);
+        free(corpo);
+        return OK;
+    }
+    if (!class_loader_parse_buffer(lc, &bytes)) return OK;
+
+    OutSink novo;
+    Status st = out_sink_open_memory(&novo);
+    if (st == OK) st = renderizar(&novo, lc, options);
+    if (st == OK) {
+        analysis_cache_put(lote->cache, chave, novo.buf, novo.len);
+        escrever_cabecalho(lote, lc, out, primeiro);
+        out_put(out, novo.buf, novo.len);
+    }
+    out_sink_close(&novo);
+    class_loader_release_item(lc);
+    return st;
+}
+
+/*
+ * Le, analisa e formata a classe num sink em memoria (ou no sink do
+ * stdout, com 'primeiro' decidindo o separador do modo pretty).
+ */
+static void formatar(Lote *lote, LoadedClass *lc, SaidaItem *s, int primeiro) {
+    s->status = OK;
+    const CliOptions *options = lote->options;
+    if (options->output_mode == OUTPUT_MODE_READER) {
+        class_loader_parse_item(lc);
+        class_loader_release_item(lc);
+        return;
+    }
+
+    OutSink memoria;
+    OutSink *out = &lote->saida;
+    if (!lote->direto) {
+        out = &memoria;
+        s->status = out_sink_open_memory(out);
+        if (s->status != OK) return;
+    }
+    s->status = gerar_corpo(lote, lc, out, primeiro);
+    if (!lote->direto) {
+        if (s->status == OK && lc->io_status == OK && lc->cf_status == CF_STATUS_OK) {
+            s->texto = out_sink_take(out, &s->tamanho);
+        }
+        out_sink_close(out);
+    }
+}
+
+/* Escreve um item ja formatado; 'primeiro' omite o separador do modo pretty */
+static int escrever(const Lote *lote, const LoadedClass *lc, SaidaItem *s, int primeiro) {
+    int falhou = lc->io_status != OK || lc->cf_status != CF_STATUS_OK || s->status != OK;
+    if (falhou) relatar_falha(lc, s->status);
+    if (s->texto && s->status == OK) {
+        if (!primeiro && lote->options->output_mode == OUTPUT_MODE_PRETTY) fputc('\n', stdout);
+        fwrite(s->texto, 1, s->tamanho, stdout);
+    }
+    free(s->texto);
+    s->texto = NULL;
+    return falhou;
+}
+
+static void tarefa(void *ctx, size_t i) {
+    Lote *lote = (Lote *)ctx;
+    LoadedClass *lc = &lote->list->items[lote->inicio + i];
+    SaidaItem *s = &lote->saidas[i];
+    formatar(lote, lc, s, lote->inicio + i == 0);
+
+    if (lote->options->unordered && !lote->direto) {
+        pthread_mutex_lock(&lote->trava);
+        lote->falhas += escrever(lote, lc, s, lote->escritos == 0);
+        lote->escritos++;
+        pthread_mutex_unlock(&lote->trava);
+    }
+}
+
+/* ============================================================
+ * API publica
+ * ============================================================ */
+int batch_run(const CliOptions *options) {
+    double t0 = agora();
+    ClassList list;
+    memset(&list, 0, sizeof list);
+    int erros = coletar_entradas(&list, options);
+
+    ThreadPool *pool = thread_pool_create(options->threads);
+    Lote lote;
+    memset(&lote, 0, sizeof lote);
+    lote.list = &list;
+    lote.options = options;
+    lote.saidas = (SaidaItem *)calloc(JANELA_LOTE, sizeof(SaidaItem));
+    if (!pool || !lote.saidas || pthread_mutex_init(&lote.trava, NULL) != 0) {
+        fprintf(stderr, "Erro: Falha ao criar o pool de threads.\n");
+        thread_pool_destroy(pool);
+        free(lote.saidas);
+        class_list_free(&list);
+        return 1;
+    }
+    if (options->cache_dir && options->output_mode != OUTPUT_MODE_READER) {
+        Status st;
+        lote.cache = analysis_cache_open(options->cache_dir, (uint64_t)options->cache_max_mb << 20, &st);
+        if (!lote.cache) {
+            fprintf(stderr, "Aviso: Cache '%s' indisponivel (codigo %d); seguindo sem cache.\n", options->cache_dir, st);
+        }
+        lote.semente = cache_semente(options);
+    }
+    lote.direto = thread_pool_size(pool) == 1;
+    if (lote.direto && out_sink_open_file(&lote.saida, stdout) != OK) {
+        fprintf(stderr, "Erro: Falha ao alocar o buffer de saida.\n");
+        lote.direto = 0;
+    }
+    if (options->verbose) {
+        fprintf(stderr, "[DEBUG] %lu classes em %d entradas (%.3f ms para listar, %d threads)\n",
+                (unsigned long)list.count, options->input_count, (agora() - t0) * 1e3,
+                thread_pool_size(pool));
+    }
+
+    for (lote.inicio = 0; lote.inicio < list.count; lote.inicio += JANELA_LOTE) {
+        size_t n = list.count - lote.inicio;
+        if (n > JANELA_LOTE) n = JANELA_LOTE;
+        memset(lote.saidas, 0, n * sizeof(SaidaItem));
+
+        thread_pool_for(pool, n, tarefa, &lote);
+
+        if (!options->unordered || lote.direto) {
+            for (size_t i = 0; i < n; i++) {
+                lote.falhas += escrever(&lote, &list.items[lote.inicio + i], &lote.saidas[i], lote.escritos == 0);
+                lote.escritos++;
+            }
+        }
+        if (lote.direto) out_sink_flush(&lote.saida);
+        fflush(stdout);
+    }
+    if (lote.direto && out_sink_close(&lote.saida) != OK) lote.falhas++;
+
+    if (options->verbose) {
+        fprintf(stderr, "[DEBUG] Lote concluido em %.3f ms (%d falhas)\n", (agora() - t0) * 1e3, lote.falhas);
+    }
+    if (lote.cache) {
+        analysis_cache_trim(lote.cache);
+        if (options->verbose) {
+            uint64_t acertos, faltas, removidas;
+            analysis_cache_stats(lote.cache, &acertos, &faltas, &removidas);
+            fprintf(stderr, "[DEBUG] Cache: %llu acertos, %llu faltas, %llu entradas removidas\n",
+                    (unsigned long long)acertos, (unsigned long long)faltas, (unsigned long long)removidas);
+        }
+        analysis_cache_close(lote.cache);
+    }
+    pthread_mutex_destroy(&lote.trava);
+    thread_pool_destroy(pool);
+    free(lote.saidas);
+    class_list_free(&list);
+    return (erros || lote.falhas) ? 1 : 0;
+}
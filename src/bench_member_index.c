@@ -0,0 +1,115 @@
+#include "classfile.h"
+#include "member_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Microbenchmark do indice de membros.
+ *
+ * Monta uma classe sintetica com N metodos (m0..mN-1, descritor "(I)I")
+ * e compara a varredura linear antiga com o indice hash.
+ *
+ * Uso: bench_member_index_runner [num_metodos] [num_buscas]
+ */
+
+static char *dup_str(const char *s) {
+    size_t n = strlen(s) + 1;
+    char *out = (char *)malloc(n);
+    if (out) memcpy(out, s, n);
+    return out;
+}
+
+/* CP: #1 = descritor "(I)I", #2..#N+1 = nomes dos metodos */
+static int montar_classe(ClassFile *cf, u2 num_metodos) {
+    memset(cf, 0, sizeof *cf);
+    cf->magic = 0xCAFEBABE;
+    cf->constant_pool_count = (u2)(num_metodos + 2);
+    cf->constant_pool = (CpInfo *)calloc(cf->constant_pool_count, sizeof(CpInfo));
+    cf->methods_count = num_metodos;
+    cf->methods = (MethodInfo *)calloc(num_metodos, sizeof(MethodInfo));
+    if (!cf->constant_pool || !cf->methods) return 0;
+
+    cf->constant_pool[1].tag = CONSTANT_Utf8;
+    cf->constant_pool[1].Utf8.bytes = dup_str("(I)I");
+    cf->constant_pool[1].Utf8.length = 4;
+
+    for (u2 i = 0; i < num_metodos; ++i) {
+        char nome[32];
+        sprintf(nome, "m%u", (unsigned)i);
+        CpInfo *e = &cf->constant_pool[i + 2];
+        e->tag = CONSTANT_Utf8;
+        e->Utf8.bytes = dup_str(nome);
+        e->Utf8.length = (u2)strlen(nome);
+
+        cf->methods[i].access_flags = 0x0009;
+        cf->methods[i].name_index = (u2)(i + 2);
+        cf->methods[i].descriptor_index = 1;
+    }
+    return 1;
+}
+
+static double segundos(clock_t ini, clock_t fim) {
+    return (double)(fim - ini) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[]) {
+    u2 num_metodos = (u2)(argc > 1 ? atoi(argv[1]) : 5000);
+    long num_buscas = argc > 2 ? atol(argv[2]) : 50000;
+    if (num_metodos == 0 || num_buscas <= 0) {
+        fprintf(stderr, "Uso: %s [num_metodos] [num_buscas]\n", argv[0]);
+        return 1;
+    }
+
+    ClassFile cf;
+    if (!montar_classe(&cf, num_metodos)) {
+        fprintf(stderr, "Erro: falha de alocacao\n");
+        return 1;
+    }
+
+    /* nomes consultados, em ordem pseudo-aleatoria */
+    char (*nomes)[32] = malloc(sizeof(*nomes) * 1024);
+    if (!nomes) return 1;
+    u4 semente = 12345;
+    for (int i = 0; i < 1024; ++i) {
+        semente = semente * 1103515245u + 12345u;
+        sprintf(nomes[i], "m%u", (unsigned)((semente >> 8) % num_metodos));
+    }
+
+    /* 1. varredura linear (sem indice) */
+    long achados = 0;
+    clock_t t0 = clock();
+    for (long i = 0; i < num_buscas; ++i) {
+        achados += member_index_find_method(&cf, nomes[i & 1023], "(I)I") != NULL;
+    }
+    clock_t t1 = clock();
+
+    /* 2. indice hash */
+    clock_t t2 = clock();
+    if (member_index_build(&cf) != CF_STATUS_OK) {
+        fprintf(stderr, "Erro: falha ao construir o indice\n");
+        return 1;
+    }
+    clock_t t3 = clock();
+    for (long i = 0; i < num_buscas; ++i) {
+        achados += member_index_find_method(&cf, nomes[i & 1023], "(I)I") != NULL;
+    }
+    clock_t t4 = clock();
+
+    if (achados != 2 * num_buscas) {
+        fprintf(stderr, "FALHOU: %ld de %ld buscas encontraram o metodo\n", achados, 2 * num_buscas);
+        return 1;
+    }
+
+    double linear = segundos(t0, t1), construcao = segundos(t2, t3), indexada = segundos(t3, t4);
+    printf("Classe sintetica: %u metodos, %ld buscas\n", (unsigned)num_metodos, num_buscas);
+    printf("  linear : %8.3f s  (%8.1f ns/busca)\n", linear, linear * 1e9 / num_buscas);
+    printf("  indice : %8.3f s  (%8.1f ns/busca)  construcao: %.3f ms\n",
+           indexada, indexada * 1e9 / num_buscas, construcao * 1e3);
+    if (indexada > 0) printf("  speedup: %.1fx\n", linear / indexada);
+
+    free(nomes);
+    free_classfile(&cf);
+    return 0;
+}
@@ -0,0 +1,465 @@
+#include "cfg.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Vetores de Cfg.mem: os publicos e os de trabalho */
+enum {
+    M_BLOCOS,
+    M_ARESTAS,
+    M_PREDS,
+    M_ORDEM,
+    M_LACOS,
+    M_INSN_DO_PC,       /* pc -> indice da instrucao (CFG_NONE se nao inicia instrucao) */
+    M_BLOCO_DA_INSN,    /* primeiro: 1 se lider; depois: bloco da instrucao */
+    M_BRUTAS,           /* arestas antes de ordenar/deduplicar */
+    M_MARCA,
+    M_PILHA,
+    M_CONTA,
+    M_AUX
+};
+
+void cfg_init(Cfg *cfg) {
+    memset(cfg, 0, sizeof *cfg);
+}
+
+void cfg_free(Cfg *cfg) {
+    for (size_t i = 0; i < sizeof cfg->mem / sizeof cfg->mem[0]; i++) free(cfg->mem[i]);
+    cfg_init(cfg);
+}
+
+/* Garante n elementos no vetor i (preserva o conteudo; so cresce) */
+static void *garantir(Cfg *cfg, int i, size_t n, size_t elem) {
+    size_t bytes = (n ? n : 1) * elem;
+    if (bytes > cfg->cap[i]) {
+        size_t nova = cfg->cap[i] ? cfg->cap[i] : 256;
+        while (nova < bytes) nova *= 2;
+        void *p = realloc(cfg->mem[i], nova);
+        if (!p) return NULL;
+        cfg->mem[i] = p;
+        cfg->cap[i] = nova;
+    }
+    return cfg->mem[i];
+}
+
+/* ============================================================
+ * Classificacao das instrucoes
+ * ============================================================ */
+static int eh_condicional(uint8_t op) {
+    return (op >= 0x99 && op <= 0xA6) || op == 0xC6 || op == 0xC7;   /* if*, ifnull, ifnonnull */
+}
+
+static int eh_jsr(uint8_t op) {
+    return op == 0xA8 || op == 0xC9;
+}
+
+/* return*, athrow, ret (tambem com wide): sem sucessores */
+static int sem_sucessor(const DisasmInsn *x) {
+    uint8_t op = x->opcode;
+    if (op == 0xC4) return x->arg_kind == DISASM_ARG_WIDE && x->operand[0] == 0xA9;
+    return (op >= 0xAC && op <= 0xB1) || op == 0xBF || op == 0xA9;
+}
+
+static int eh_switch(const DisasmInsn *x) {
+    return x->arg_kind == DISASM_ARG_TABLESWITCH || x->arg_kind == DISASM_ARG_LOOKUPSWITCH;
+}
+
+/* A instrucao seguinte a esta sempre inicia bloco */
+static int encerra_bloco(const DisasmInsn *x) {
+    return x->arg_kind == DISASM_ARG_BRANCH || eh_switch(x) || sem_sucessor(x);
+}
+
+static int32_t le32(const uint8_t *p) {
+    return (int32_t)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]);
+}
+
+/* Alvos do switch (k = 0: default); disasm_decode ja validou a tabela */
+static uint32_t switch_alvos(const DisasmInsn *x) {
+    if (x->arg_kind == DISASM_ARG_TABLESWITCH) return (uint32_t)(x->operand[2] - x->operand[1]) + 2;
+    return (uint32_t)x->operand[1] + 1;
+}
+
+static int64_t switch_alvo(const DisasmInsn *x, const uint8_t *code, uint32_t k) {
+    uint32_t inicio = x->pc + 1 + (4 - ((x->pc + 1) % 4)) % 4;
+    int32_t offset;
+    if (k == 0) offset = x->operand[0];
+    else if (x->arg_kind == DISASM_ARG_TABLESWITCH) offset = le32(code + inicio + 12 + 4 * (k - 1));
+    else offset = le32(code + inicio + 8 + 8 * (k - 1) + 4);
+    return (int64_t)x->pc + offset;
+}
+
+/* Indice da instrucao que comeca em pc; CFG_NONE fora do codigo ou no meio de uma instrucao */
+static uint32_t insn_em(const uint32_t *insn_do_pc, uint32_t fim, int64_t pc) {
+    return (pc >= 0 && pc < (int64_t)fim) ? insn_do_pc[pc] : CFG_NONE;
+}
+
+/* ============================================================
+ * Arestas
+ * ============================================================ */
+typedef struct {
+    Cfg *cfg;
+    size_t n;
+    const uint32_t *insn_do_pc;
+    const uint32_t *bloco_da_insn;
+    uint32_t fim;
+} Brutas;
+
+static int anotar(Brutas *br, uint32_t from, int64_t alvo_pc, uint8_t kind) {
+    uint32_t i = insn_em(br->insn_do_pc, br->fim, alvo_pc);
+    if (i == CFG_NONE) return 1;    /* alvo invalido: ignorado */
+    CfgEdge *e = (CfgEdge *)garantir(br->cfg, M_BRUTAS, br->n + 1, sizeof(CfgEdge));
+    if (!e) return 0;
+    e[br->n].from = from;
+    e[br->n].to = br->bloco_da_insn[i];
+    e[br->n].kind = kind;
+    br->n++;
+    return 1;
+}
+
+static int arestas_brutas(Brutas *br, const DisasmMethod *m, const CodeAttribute *code) {
+    Cfg *cfg = br->cfg;
+    CfgBlock *b = cfg->blocks;
+    for (uint32_t k = 0; k < cfg->block_count; k++) {
+        const DisasmInsn *x = &m->insns[b[k].first_insn + b[k].insn_count - 1];
+        int segue = k + 1 < cfg->block_count;
+        if (x->arg_kind == DISASM_ARG_BRANCH) {
+            if (!anotar(br, k, x->operand[1], CFG_EDGE_BRANCH)) return 0;
+            segue = segue && (eh_condicional(x->opcode) || eh_jsr(x->opcode));
+        } else if (eh_switch(x)) {
+            uint32_t n = switch_alvos(x);
+            for (uint32_t j = 0; j < n; j++) {
+                if (!anotar(br, k, switch_alvo(x, code->code, j), CFG_EDGE_SWITCH)) return 0;
+            }
+            segue = 0;
+        } else if (sem_sucessor(x)) {
+            segue = 0;
+        }
+        if (segue && !anotar(br, k, b[k + 1].start_pc, CFG_EDGE_FALLTHROUGH)) return 0;
+    }
+
+    /* cada bloco da faixa protegida pode desviar para o handler */
+    for (u2 t = 0; t < code->exception_table_length; t++) {
+        const ExceptionTableEntry *e = &code->exception_table[t];
+        uint32_t ini = insn_em(br->insn_do_pc, br->fim, e->start_pc);
+        if (ini == CFG_NONE) continue;
+        for (uint32_t k = br->bloco_da_insn[ini]; k < cfg->block_count && b[k].start_pc < e->end_pc; k++) {
+            if (!anotar(br, k, e->handler_pc, CFG_EDGE_EXCEPTION)) return 0;
+        }
+    }
+    return 1;
+}
+
+/* Ordena as arestas brutas por origem (estavel), tira repeticoes e monta succ/pred */
+static int montar_listas(Cfg *cfg, size_t n_brutas) {
+    uint32_t nb = cfg->block_count;
+    const CfgEdge *brutas = (const CfgEdge *)cfg->mem[M_BRUTAS];
+    uint32_t *conta = (uint32_t *)garantir(cfg, M_CONTA, (size_t)nb + 1, sizeof(uint32_t));
+    uint32_t *marca = (uint32_t *)garantir(cfg, M_MARCA, nb, sizeof(uint32_t));
+    CfgEdge *arestas = (CfgEdge *)garantir(cfg, M_ARESTAS, n_brutas, sizeof(CfgEdge));
+    if (!conta || !marca || !arestas) return 0;
+    cfg->edges = arestas;
+
+    memset(conta, 0, ((size_t)nb + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < n_brutas; i++) conta[brutas[i].from + 1]++;
+    for (uint32_t k = 0; k < nb; k++) conta[k + 1] += conta[k];
+    for (size_t i = 0; i < n_brutas; i++) arestas[conta[brutas[i].from]++] = brutas[i];
+    /* agora conta[k] = fim das arestas de k */
+
+    uint32_t w = 0, ini = 0;
+    for (uint32_t k = 0; k < nb; k++) marca[k] = CFG_NONE;
+    for (uint32_t k = 0; k < nb; k++) {
+        cfg->blocks[k].succ_first = w;
+        for (uint32_t i = ini; i < conta[k]; i++) {
+            if (marca[arestas[i].to] == k) continue;   /* mesmo destino (switch, faixas) */
+            marca[arestas[i].to] = k;
+            arestas[w++] = arestas[i];
+        }
+        cfg->blocks[k].succ_count = w - cfg->blocks[k].succ_first;
+        ini = conta[k];
+    }
+    cfg->edge_count = w;
+
+    uint32_t *preds = (uint32_t *)garantir(cfg, M_PREDS, w, sizeof(uint32_t));
+    if (!preds) return 0;
+    cfg->preds = preds;
+    memset(conta, 0, ((size_t)nb + 1) * sizeof(uint32_t));
+    for (uint32_t i = 0; i < w; i++) conta[arestas[i].to + 1]++;
+    for (uint32_t k = 0; k < nb; k++) {
+        conta[k + 1] += conta[k];
+        cfg->blocks[k].pred_first = conta[k];
+        cfg->blocks[k].pred_count = conta[k + 1] - conta[k];
+    }
+    for (uint32_t i = 0; i < w; i++) preds[conta[arestas[i].to]++] = i;
+    return 1;
+}
+
+/* ============================================================
+ * Ordem e dominadores
+ * ============================================================ */
+
+/* DFS iterativa a partir do bloco 0: marca os alcancaveis e grava a pos-ordem reversa */
+static int ordenar(Cfg *cfg) {
+    uint32_t nb = cfg->block_count;
+    CfgBlock *b = cfg->blocks;
+    uint32_t *pilha = (uint32_t *)garantir(cfg, M_PILHA, nb, sizeof(uint32_t));
+    uint32_t *prox = (uint32_t *)garantir(cfg, M_AUX, nb, sizeof(uint32_t));
+    uint32_t *ordem = (uint32_t *)garantir(cfg, M_ORDEM, nb, sizeof(uint32_t));
+    if (!pilha || !prox || !ordem) return 0;
+    cfg->order = ordem;
+
+    uint32_t topo = 0, n = 0;
+    b[0].flags |= CFG_BLOCK_REACHABLE;
+    prox[0] = 0;
+    pilha[topo++] = 0;
+    while (topo > 0) {
+        uint32_t v = pilha[topo - 1];
+        if (prox[v] < b[v].succ_count) {
+            uint32_t w = cfg->edges[b[v].succ_first + prox[v]++].to;
+            if (!(b[w].flags & CFG_BLOCK_REACHABLE)) {
+                b[w].flags |= CFG_BLOCK_REACHABLE;
+                prox[w] = 0;
+                pilha[topo++] = w;
+            }
+        } else {
+            ordem[n++] = v;
+            topo--;
+        }
+    }
+    for (uint32_t i = 0; i < n / 2; i++) {
+        uint32_t t = ordem[i];
+        ordem[i] = ordem[n - 1 - i];
+        ordem[n - 1 - i] = t;
+    }
+    for (uint32_t i = 0; i < n; i++) b[ordem[i]].rpo = i;
+    cfg->reachable_count = n;
+    return 1;
+}
+
+static uint32_t intersectar(const CfgBlock *b, uint32_t x, uint32_t y) {
+    while (x != y) {
+        while (b[x].rpo > b[y].rpo) x = b[x].idom;
+        while (b[y].rpo > b[x].rpo) y = b[y].idom;
+    }
+    return x;
+}
+
+/* Cooper, Harvey e Kennedy: ponto fixo em pos-ordem reversa (poucas passadas em grafos de bytecode) */
+static void dominadores(Cfg *cfg) {
+    CfgBlock *b = cfg->blocks;
+    b[0].idom = 0;
+    int mudou = 1;
+    while (mudou) {
+        mudou = 0;
+        for (uint32_t i = 1; i < cfg->reachable_count; i++) {
+            uint32_t v = cfg->order[i];
+            uint32_t novo = CFG_NONE;
+            for (uint32_t j = 0; j < b[v].pred_count; j++) {
+                uint32_t u = cfg->edges[cfg->preds[b[v].pred_first + j]].from;
+                if (b[u].idom == CFG_NONE) continue;    /* ainda nao processado ou inalcancavel */
+                novo = novo == CFG_NONE ? u : intersectar(b, u, novo);
+            }
+            if (novo != b[v].idom) {
+                b[v].idom = novo;
+                mudou = 1;
+            }
+        }
+    }
+    b[0].idom = CFG_NONE;
+}
+
+/* Numeracao pre/pos da arvore de dominadores: dominancia em O(1) */
+static int numerar_arvore(Cfg *cfg) {
+    uint32_t nb = cfg->block_count;
+    CfgBlock *b = cfg->blocks;
+    uint32_t *conta = (uint32_t *)garantir(cfg, M_CONTA, (size_t)nb + 1, sizeof(uint32_t));
+    uint32_t *filhos = (uint32_t *)garantir(cfg, M_AUX, nb, sizeof(uint32_t));
+    uint32_t *cursor = (uint32_t *)garantir(cfg, M_MARCA, nb, sizeof(uint32_t));
+    uint32_t *pilha = (uint32_t *)garantir(cfg, M_PILHA, nb, sizeof(uint32_t));
+    if (!conta || !filhos || !cursor || !pilha) return 0;
+
+    memset(conta, 0, ((size_t)nb + 1) * sizeof(uint32_t));
+    for (uint32_t v = 0; v < nb; v++) {
+        if (b[v].idom != CFG_NONE) conta[b[v].idom + 1]++;
+    }
+    for (uint32_t v = 0; v < nb; v++) conta[v + 1] += conta[v];
+    for (uint32_t v = 0; v < nb; v++) cursor[v] = conta[v];
+    for (uint32_t v = 0; v < nb; v++) {
+        if (b[v].idom != CFG_NONE) filhos[cursor[b[v].idom]++] = v;
+    }
+    for (uint32_t v = 0; v < nb; v++) cursor[v] = conta[v];
+
+    uint32_t topo = 0, t = 0;
+    b[0].dom_pre = t++;
+    pilha[topo++] = 0;
+    while (topo > 0) {
+        uint32_t v = pilha[topo - 1];
+        if (cursor[v] < conta[v + 1]) {
+            uint32_t c = filhos[cursor[v]++];
+            b[c].dom_pre = t++;
+            pilha[topo++] = c;
+        } else {
+            b[v].dom_post = t++;
+            topo--;
+        }
+    }
+    return 1;
+}
+
+bool cfg_dominates(const Cfg *cfg, uint32_t a, uint32_t b) {
+    if (a >= cfg->block_count || b >= cfg->block_count) return false;
+    const CfgBlock *x = &cfg->blocks[a], *y = &cfg->blocks[b];
+    if (!(x->flags & CFG_BLOCK_REACHABLE) || !(y->flags & CFG_BLOCK_REACHABLE)) return false;
+    return x->dom_pre <= y->dom_pre && y->dom_post <= x->dom_post;
+}
+
+/* ============================================================
+ * Lacos naturais
+ * ============================================================ */
+
+/* Cabecalhos em pos-ordem reversa: o laco externo e visto antes do interno */
+static int lacos(Cfg *cfg) {
+    uint32_t nb = cfg->block_count;
+    CfgBlock *b = cfg->blocks;
+    uint32_t *marca = (uint32_t *)garantir(cfg, M_MARCA, nb, sizeof(uint32_t));
+    uint32_t *pilha = (uint32_t *)garantir(cfg, M_PILHA, nb, sizeof(uint32_t));
+    if (!marca || !pilha) return 0;
+    for (uint32_t k = 0; k < nb; k++) marca[k] = CFG_NONE;
+
+    for (uint32_t i = 0; i < cfg->reachable_count; i++) {
+        uint32_t h = cfg->order[i];
+        uint32_t l = cfg->loop_count;
+        uint32_t topo = 0;
+        int volta = 0;
+        marca[h] = l;
+        for (uint32_t j = 0; j < b[h].pred_count; j++) {
+            uint32_t u = cfg->edges[cfg->preds[b[h].pred_first + j]].from;
+            if (!(b[u].flags & CFG_BLOCK_REACHABLE)) continue;
+            if (cfg_dominates(cfg, h, u)) {
+                volta = 1;
+                if (marca[u] != l) {
+                    marca[u] = l;
+                    pilha[topo++] = u;
+                }
+            } else if (b[u].rpo >= b[h].rpo) {
+                cfg->irreducible = true;    /* aresta de retorno sem cabecalho dominante */
+            }
+        }
+        if (!volta) {
+            marca[h] = CFG_NONE;
+            continue;
+        }
+
+        CfgLoop *v = (CfgLoop *)garantir(cfg, M_LACOS, (size_t)l + 1, sizeof(CfgLoop));
+        if (!v) return 0;
+        cfg->loops = v;
+        CfgLoop *laco = &v[l];
+        laco->header = h;
+        laco->parent = b[h].loop;
+        laco->depth = (uint16_t)(laco->parent == CFG_NONE ? 1 : v[laco->parent].depth + 1);
+        laco->block_count = 1;
+        b[h].loop = l;
+        b[h].loop_depth = laco->depth;
+        b[h].flags |= CFG_BLOCK_LOOP_HEADER;
+
+        /* corpo: quem alcanca uma aresta de volta sem passar por h */
+        while (topo > 0) {
+            uint32_t x = pilha[--topo];
+            b[x].loop = l;
+            b[x].loop_depth = laco->depth;
+            laco->block_count++;
+            for (uint32_t j = 0; j < b[x].pred_count; j++) {
+                uint32_t u = cfg->edges[cfg->preds[b[x].pred_first + j]].from;
+                if ((b[u].flags & CFG_BLOCK_REACHABLE) && marca[u] != l) {
+                    marca[u] = l;
+                    pilha[topo++] = u;
+                }
+            }
+        }
+        cfg->loop_count++;
+    }
+    return 1;
+}
+
+/* ============================================================
+ * API publica
+ * ============================================================ */
+Status cfg_build(Cfg *cfg, const DisasmMethod *m, const CodeAttribute *code) {
+    cfg->block_count = cfg->edge_count = cfg->reachable_count = cfg->loop_count = 0;
+    cfg->irreducible = false;
+    uint32_t n = m->count;
+    if (n == 0) return OK;
+
+    const DisasmInsn *ins = m->insns;
+    uint32_t fim = ins[n - 1].pc + ins[n - 1].length;   /* fim do codigo decodificado */
+    uint32_t *insn_do_pc = (uint32_t *)garantir(cfg, M_INSN_DO_PC, fim, sizeof(uint32_t));
+    uint32_t *bloco_da_insn = (uint32_t *)garantir(cfg, M_BLOCO_DA_INSN, n, sizeof(uint32_t));
+    if (!insn_do_pc || !bloco_da_insn) return ERR_MEMORY;
+    memset(insn_do_pc, 0xFF, (size_t)fim * sizeof(uint32_t));
+    memset(bloco_da_insn, 0, (size_t)n * sizeof(uint32_t));
+    for (uint32_t i = 0; i < n; i++) insn_do_pc[ins[i].pc] = i;
+
+    /* 1. Lideres (bloco_da_insn = 1) */
+    uint32_t *lider = bloco_da_insn;
+    uint32_t j;
+    lider[0] = 1;
+    for (uint32_t i = 0; i < n; i++) {
+        const DisasmInsn *x = &ins[i];
+        if (x->arg_kind == DISASM_ARG_BRANCH) {
+            if ((j = insn_em(insn_do_pc, fim, x->operand[1])) != CFG_NONE) lider[j] = 1;
+        } else if (eh_switch(x)) {
+            uint32_t alvos = switch_alvos(x);
+            for (uint32_t k = 0; k < alvos; k++) {
+                if ((j = insn_em(insn_do_pc, fim, switch_alvo(x, code->code, k))) != CFG_NONE) lider[j] = 1;
+            }
+        }
+        if (encerra_bloco(x) && i + 1 < n) lider[i + 1] = 1;
+    }
+    for (u2 t = 0; t < code->exception_table_length; t++) {
+        const ExceptionTableEntry *e = &code->exception_table[t];
+        if ((j = insn_em(insn_do_pc, fim, e->start_pc)) != CFG_NONE) lider[j] = 1;
+        if ((j = insn_em(insn_do_pc, fim, e->end_pc)) != CFG_NONE) lider[j] = 1;
+        if ((j = insn_em(insn_do_pc, fim, e->handler_pc)) != CFG_NONE) lider[j] = 1;
+    }
+
+    /* 2. Blocos */
+    uint32_t nb = 0;
+    for (uint32_t i = 0; i < n; i++) nb += lider[i];
+    CfgBlock *b = (CfgBlock *)garantir(cfg, M_BLOCOS, nb, sizeof(CfgBlock));
+    if (!b) return ERR_MEMORY;
+    cfg->blocks = b;
+    cfg->block_count = nb;
+    uint32_t atual = CFG_NONE;
+    for (uint32_t i = 0; i < n; i++) {
+        if (lider[i]) {
+            CfgBlock *novo = &b[++atual];
+            memset(novo, 0, sizeof *novo);
+            novo->start_pc = ins[i].pc;
+            novo->first_insn = i;
+            novo->idom = novo->rpo = novo->loop = CFG_NONE;
+        }
+        bloco_da_insn[i] = atual;
+        b[atual].insn_count++;
+        b[atual].end_pc = ins[i].pc + ins[i].length;
+    }
+    for (u2 t = 0; t < code->exception_table_length; t++) {
+        if ((j = insn_em(insn_do_pc, fim, code->exception_table[t].handler_pc)) != CFG_NONE) {
+            b[bloco_da_insn[j]].flags |= CFG_BLOCK_HANDLER;
+        }
+    }
+
+    /* 3. Arestas, 4. ordem, dominadores e lacos */
+    Brutas br = { cfg, 0, insn_do_pc, bloco_da_insn, fim };
+    if (!arestas_brutas(&br, m, code) || !montar_listas(cfg, br.n) || !ordenar(cfg)) return ERR_MEMORY;
+    dominadores(cfg);
+    if (!numerar_arvore(cfg) || !lacos(cfg)) return ERR_MEMORY;
+    return OK;
+}
+
+const char *cfg_edge_kind_name(uint8_t kind) {
+    switch (kind) {
+        case CFG_EDGE_FALLTHROUGH: return "fallthrough";
+        case CFG_EDGE_BRANCH: return "branch";
+        case CFG_EDGE_SWITCH: return "switch";
+        case CFG_EDGE_EXCEPTION: return "exception";
+        default: return "?";
+    }
+}
@@ -0,0 +1,750 @@
+#define _POSIX_C_SOURCE 200809L
+#include "class_archive.h"
+#include "class_registry.h"
+#include "member_index.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ============================================================
+ * Formato em disco (todos os offsets sao relativos ao inicio do arquivo;
+ * offset 0 = vetor vazio)
+ * ============================================================ */
+static const char ARQUIVO_MAGIC[8] = { 'J', 'V', 'B', 'C', 'D', 'S', '0', '1' };
+#define ARQUIVO_VERSAO      1u
+#define ARQUIVO_ORDEM_BYTES 0x01020304u
+
+typedef struct {
+    char magic[8];
+    u4 version;
+    u4 byte_order;      /* ARQUIVO_ORDEM_BYTES na ordem nativa de quem gravou */
+    u4 slot_size;       /* sizeof(MemberSlot) de quem gravou */
+    u4 file_size;
+    u4 class_count;
+    u4 classes;         /* ArqClasse[class_count], ordenado por nome */
+    u4 table;           /* u4[table_mask + 1]: ordinal + 1 (0 = livre) */
+    u4 table_mask;
+    u4 symbol_count;    /* estatistica: simbolos internados */
+    u4 symbol_bytes;
+} ArqCabecalho;
+
+typedef struct {
+    u4 name;            /* simbolo com o nome interno */
+    u4 name_hash;
+    u4 cp;              /* ArqCp[cp_count] */
+    u4 interfaces;      /* u2[interfaces_count] */
+    u4 fields;          /* ArqMembro[fields_count] */
+    u4 methods;         /* ArqMembro[methods_count] */
+    u4 attributes;      /* ArqAtributo[attributes_count] */
+    u4 method_mask, method_slots;   /* MemberSlot[mask + 1] */
+    u4 field_mask, field_slots;
+    u2 minor_version, major_version;
+    u2 cp_count;
+    u2 access_flags, this_class, super_class;
+    u2 interfaces_count, fields_count, methods_count, attributes_count;
+} ArqClasse;
+
+/*
+ * Entrada do constant pool. Significado de a/b/c por tag:
+ *   Utf8: a = length, b = simbolo | Integer/Float: b = bytes
+ *   Long/Double: b = high, c = low | Class: a = name_index
+ *   String: a = string_index | *ref: a = class, b = name_and_type
+ *   NameAndType: a = name, b = descriptor | MethodHandle: a = index, b = kind
+ *   MethodType: a = descriptor | InvokeDynamic: a = bootstrap, b = name_and_type
+ */
+typedef struct {
+    u1 tag;
+    u1 pad;
+    u2 a;
+    u4 b;
+    u4 c;
+} ArqCp;
+
+typedef struct {
+    u2 access_flags, name_index, descriptor_index, attributes_count;
+    u4 attributes;      /* ArqAtributo[attributes_count] */
+} ArqMembro;
+
+typedef struct {
+    u2 name_index;
+    u2 pad;
+    u4 length;
+    u4 info;            /* payload cru */
+} ArqAtributo;
+
+struct class_archive {
+    const u1 *base;
+    size_t size;
+    const ArqCabecalho *hdr;
+    const ArqClasse *classes;
+    const u4 *table;
+
+    pthread_mutex_t lock;   /* protege loaded[] */
+    ClassFile **loaded;     /* materializadas sob demanda */
+};
+
+static u4 hash_bytes(const u1 *p, size_t n) {
+    u4 h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static u4 hash_nome(const char *s) {
+    return hash_bytes((const u1 *)s, strlen(s));
+}
+
+/* ============================================================
+ * Gravacao
+ * ============================================================ */
+typedef struct {
+    u1 *data;
+    size_t size, cap;
+    int erro;
+} Saida;
+
+#define EM(s, off, T) ((T *)((s)->data + (off)))
+
+/* Reserva n bytes zerados alinhados; pode realocar data (use offsets). */
+static u4 reservar(Saida *s, size_t n, size_t alinh) {
+    if (s->erro) return 0;
+    size_t off = (s->size + alinh - 1) & ~(alinh - 1);
+    if (off + n > 0xFFFFFFFFu) { s->erro = 1; return 0; }
+    if (off + n > s->cap) {
+        size_t nova = s->cap ? s->cap : 65536;
+        while (nova < off + n) nova *= 2;
+        u1 *data = (u1 *)realloc(s->data, nova);
+        if (!data) { s->erro = 1; return 0; }
+        s->data = data;
+        s->cap = nova;
+    }
+    memset(s->data + s->size, 0, off + n - s->size);
+    s->size = off + n;
+    return (u4)off;
+}
+
+typedef struct {
+    u4 hash;
+    u4 off;
+    u2 len;
+    u2 usado;
+} Simbolo;
+
+typedef struct {
+    Simbolo *e;
+    u4 cap, count;
+    u4 bytes;
+} TabelaSimbolos;
+
+static int crescer_simbolos(TabelaSimbolos *t) {
+    u4 nova = t->cap ? t->cap * 2 : 1024;
+    Simbolo *e = (Simbolo *)calloc(nova, sizeof(Simbolo));
+    if (!e) return 0;
+    for (u4 i = 0; i < t->cap; ++i) {
+        if (!t->e[i].usado) continue;
+        u4 pos = t->e[i].hash & (nova - 1);
+        while (e[pos].usado) pos = (pos + 1) & (nova - 1);
+        e[pos] = t->e[i];
+    }
+    free(t->e);
+    t->e = e;
+    t->cap = nova;
+    return 1;
+}
+
+/* Devolve o offset do simbolo (bytes + '\0'), gravando-o so na primeira vez. */
+static u4 internar(Saida *s, TabelaSimbolos *t, const char *bytes, u2 len) {
+    if (s->erro) return 0;
+    if ((t->count + 1) * 2 > t->cap && !crescer_simbolos(t)) { s->erro = 1; return 0; }
+
+    u4 h = hash_bytes((const u1 *)bytes, len);
+    u4 mask = t->cap - 1;
+    u4 pos = h & mask;
+    for (; t->e[pos].usado; pos = (pos + 1) & mask) {
+        Simbolo *e = &t->e[pos];
+        if (e->hash == h && e->len == len && memcmp(s->data + e->off, bytes, len) == 0) return e->off;
+    }
+
+    u4 off = reservar(s, (size_t)len + 1, 1);
+    if (s->erro) return 0;
+    memcpy(s->data + off, bytes, len);
+
+    t->e[pos].hash = h;
+    t->e[pos].off = off;
+    t->e[pos].len = len;
+    t->e[pos].usado = 1;
+    t->count++;
+    t->bytes += (u4)len + 1;
+    return off;
+}
+
+static u4 gravar_atributos(Saida *s, const AttributeInfo *attrs, u2 count) {
+    if (count == 0) return 0;
+    u4 arr = reservar(s, (size_t)count * sizeof(ArqAtributo), 4);
+    for (u2 i = 0; i < count && !s->erro; ++i) {
+        u4 len = attrs[i].info ? attrs[i].attribute_length : 0;
+        u4 info = 0;
+        if (len) {
+            info = reservar(s, len, 4);
+            if (s->erro) break;
+            memcpy(s->data + info, attrs[i].info, len);
+        }
+        ArqAtributo *a = &EM(s, arr, ArqAtributo)[i];
+        a->name_index = attrs[i].attribute_name_index;
+        a->length = len;
+        a->info = info;
+    }
+    return arr;
+}
+
+static u4 gravar_membros(Saida *s, const FieldInfo *members, u2 count) {
+    if (count == 0) return 0;
+    u4 arr = reservar(s, (size_t)count * sizeof(ArqMembro), 4);
+    for (u2 i = 0; i < count && !s->erro; ++i) {
+        u4 attrs = gravar_atributos(s, members[i].attributes, members[i].attributes_count);
+        if (s->erro) break;
+        ArqMembro *m = &EM(s, arr, ArqMembro)[i];
+        m->access_flags = members[i].access_flags;
+        m->name_index = members[i].name_index;
+        m->descriptor_index = members[i].descriptor_index;
+        m->attributes_count = members[i].attributes_count;
+        m->attributes = attrs;
+    }
+    return arr;
+}
+
+static u4 gravar_slots(Saida *s, const MemberSlot *slots, u4 mask) {
+    size_t n = ((size_t)mask + 1) * sizeof(MemberSlot);
+    u4 off = reservar(s, n, 4);
+    if (!s->erro) memcpy(s->data + off, slots, n);
+    return off;
+}
+
+static u4 gravar_cp(Saida *s, TabelaSimbolos *t, const ClassFile *cf) {
+    if (cf->constant_pool_count == 0) return 0;
+    u4 arr = reservar(s, (size_t)cf->constant_pool_count * sizeof(ArqCp), 4);
+
+    for (u2 i = 1; i < cf->constant_pool_count && !s->erro; ++i) {
+        const CpInfo *c = &cf->constant_pool[i];
+        ArqCp e;
+        memset(&e, 0, sizeof e);
+        e.tag = c->tag;
+
+        switch (c->tag) {
+        case CONSTANT_Utf8:
+            e.a = c->Utf8.length;
+            e.b = internar(s, t, c->Utf8.bytes ? c->Utf8.bytes : "", c->Utf8.bytes ? c->Utf8.length : 0);
+            break;
+        case CONSTANT_Integer:
+        case CONSTANT_Float:
+            e.b = c->Num.bytes;
+            break;
+        case CONSTANT_Long:
+        case CONSTANT_Double:
+            e.b = c->LongDouble.high_bytes;
+            e.c = c->LongDouble.low_bytes;
+            break;
+        case CONSTANT_Class:
+            e.a = c->Class.name_index;
+            break;
+        case CONSTANT_String:
+            e.a = c->String.string_index;
+            break;
+        case CONSTANT_Fieldref:
+        case CONSTANT_Methodref:
+        case CONSTANT_InterfaceMethodref:
+            e.a = c->Ref.class_index;
+            e.b = c->Ref.name_and_type_index;
+            break;
+        case CONSTANT_NameAndType:
+            e.a = c->NameAndType.name_index;
+            e.b = c->NameAndType.descriptor_index;
+            break;
+        case CONSTANT_MethodHandle:
+            e.a = c->MethodHandle.reference_index;
+            e.b = c->MethodHandle.reference_kind;
+            break;
+        case CONSTANT_MethodType:
+            e.a = c->MethodType.descriptor_index;
+            break;
+        case CONSTANT_InvokeDynamic:
+            e.a = c->InvokeDynamic.bootstrap_method_attr_index;
+            e.b = c->InvokeDynamic.name_and_type_index;
+            break;
+        default:
+            break;
+        }
+        if (!s->erro) EM(s, arr, ArqCp)[i] = e;
+    }
+    return arr;
+}
+
+static void gravar_classe(Saida *s, TabelaSimbolos *t, ClassFile *cf, u4 rec_off) {
+    if (member_index_build(cf) != CF_STATUS_OK) { s->erro = 1; return; }
+
+    ArqClasse r;
+    memset(&r, 0, sizeof r);
+    r.minor_version = cf->minor_version;
+    r.major_version = cf->major_version;
+    r.cp_count = cf->constant_pool_count;
+    r.access_flags = cf->access_flags;
+    r.this_class = cf->this_class;
+    r.super_class = cf->super_class;
+    r.interfaces_count = cf->interfaces_count;
+    r.fields_count = cf->fields_count;
+    r.methods_count = cf->methods_count;
+    r.attributes_count = cf->attributes_count;
+
+    const char *nome = classfile_this_name(cf);
+    r.name = internar(s, t, nome, (u2)strlen(nome));
+    r.name_hash = hash_nome(nome);
+    r.cp = gravar_cp(s, t, cf);
+
+    if (cf->interfaces_count) {
+        r.interfaces = reservar(s, (size_t)cf->interfaces_count * sizeof(u2), 2);
+        if (!s->erro) memcpy(s->data + r.interfaces, cf->interfaces, (size_t)cf->interfaces_count * sizeof(u2));
+    }
+
+    r.fields = gravar_membros(s, cf->fields, cf->fields_count);
+    r.methods = gravar_membros(s, cf->methods, cf->methods_count);
+    r.attributes = gravar_atributos(s, cf->attributes, cf->attributes_count);
+
+    r.method_mask = cf->members->method_mask;
+    r.method_slots = gravar_slots(s, cf->members->method_slots, r.method_mask);
+    r.field_mask = cf->members->field_mask;
+    r.field_slots = gravar_slots(s, cf->members->field_slots, r.field_mask);
+
+    if (!s->erro) *EM(s, rec_off, ArqClasse) = r;
+}
+
+typedef struct {
+    const char *nome;
+    size_t ordem;       /* posicao na entrada: desempate estavel */
+    ClassFile *cf;
+} ItemDump;
+
+static int comparar_item(const void *a, const void *b) {
+    const ItemDump *x = (const ItemDump *)a, *y = (const ItemDump *)b;
+    int c = strcmp(x->nome, y->nome);
+    if (c) return c;
+    return x->ordem < y->ordem ? -1 : x->ordem > y->ordem;
+}
+
+static Status escrever_arquivo(const char *path, const u1 *data, size_t size) {
+    size_t lp = strlen(path);
+    char *tmp = (char *)malloc(lp + 5);
+    if (!tmp) return ERR_MEMORY;
+    memcpy(tmp, path, lp);
+    memcpy(tmp + lp, ".tmp", 5);
+
+    Status st = OK;
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        st = ERR_FILE;
+    } else {
+        if (fwrite(data, 1, size, f) != size) st = ERR_FILE;
+        if (fclose(f) != 0) st = ERR_FILE;
+        /* rename atomico: leitores com o arquivo antigo mapeado nao sao afetados */
+        if (st == OK && rename(tmp, path) != 0) st = ERR_FILE;
+        if (st != OK) remove(tmp);
+    }
+    free(tmp);
+    return st;
+}
+
+Status class_archive_dump(const char *path, ClassFile *const *classes, size_t count,
+                          size_t *out_size) {
+    if (!path || (count && !classes)) return ERR_FILE;
+
+    ItemDump *itens = (ItemDump *)malloc((count ? count : 1) * sizeof(ItemDump));
+    if (!itens) return ERR_MEMORY;
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!classes[i]) continue;
+        itens[n].nome = classfile_this_name(classes[i]);
+        itens[n].ordem = i;
+        itens[n].cf = classes[i];
+        n++;
+    }
+    qsort(itens, n, sizeof(ItemDump), comparar_item);
+
+    /* nomes repetidos: fica o primeiro da entrada */
+    size_t unicos = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (unicos && strcmp(itens[unicos - 1].nome, itens[i].nome) == 0) continue;
+        itens[unicos++] = itens[i];
+    }
+
+    Saida s;
+    memset(&s, 0, sizeof s);
+    TabelaSimbolos t;
+    memset(&t, 0, sizeof t);
+
+    reservar(&s, sizeof(ArqCabecalho), 8);
+    u4 classes_off = reservar(&s, unicos * sizeof(ArqClasse), 8);
+    for (size_t i = 0; i < unicos && !s.erro; ++i) {
+        gravar_classe(&s, &t, itens[i].cf, classes_off + (u4)(i * sizeof(ArqClasse)));
+    }
+
+    /* diretorio hash nome -> ordinal (carga maxima de 50%) */
+    u4 cap = 4;
+    while (cap < unicos * 2) cap <<= 1;
+    u4 table_off = reservar(&s, (size_t)cap * sizeof(u4), 4);
+    for (size_t i = 0; i < unicos && !s.erro; ++i) {
+        u4 *table = EM(&s, table_off, u4);
+        u4 pos = EM(&s, classes_off, ArqClasse)[i].name_hash & (cap - 1);
+        while (table[pos]) pos = (pos + 1) & (cap - 1);
+        table[pos] = (u4)i + 1;
+    }
+
+    Status st = s.erro ? ERR_MEMORY : OK;
+    if (st == OK) {
+        ArqCabecalho *h = EM(&s, 0, ArqCabecalho);
+        memcpy(h->magic, ARQUIVO_MAGIC, sizeof h->magic);
+        h->version = ARQUIVO_VERSAO;
+        h->byte_order = ARQUIVO_ORDEM_BYTES;
+        h->slot_size = (u4)sizeof(MemberSlot);
+        h->file_size = (u4)s.size;
+        h->class_count = (u4)unicos;
+        h->classes = classes_off;
+        h->table = table_off;
+        h->table_mask = cap - 1;
+        h->symbol_count = t.count;
+        h->symbol_bytes = t.bytes;
+
+        st = escrever_arquivo(path, s.data, s.size);
+        if (st == OK && out_size) *out_size = s.size;
+    }
+
+    free(t.e);
+    free(s.data);
+    free(itens);
+    return st;
+}
+
+/* ============================================================
+ * Leitura
+ * ============================================================ */
+
+/* [off, off + n) cabe no arquivo? */
+static int faixa_ok(const ClassArchive *ar, u4 off, size_t n) {
+    return (size_t)off <= ar->size && n <= ar->size - off;
+}
+
+/* Simbolo de tamanho conhecido; NULL se sair do arquivo ou nao terminar em '\0'. */
+static const char *simbolo(const ClassArchive *ar, u4 off, u2 len) {
+    if (!faixa_ok(ar, off, (size_t)len + 1) || ar->base[off + len] != '\0') return NULL;
+    return (const char *)ar->base + off;
+}
+
+static const char *simbolo_cstr(const ClassArchive *ar, u4 off) {
+    if (off >= ar->size || !memchr(ar->base + off, '\0', ar->size - off)) return NULL;
+    return (const char *)ar->base + off;
+}
+
+static size_t alinhar(size_t n) {
+    return (n + 15) & ~(size_t)15;
+}
+
+static int montar_atributos(const ClassArchive *ar, u4 off, u2 count, AttributeInfo *dst) {
+    if (count == 0) return 1;
+    if (!faixa_ok(ar, off, (size_t)count * sizeof(ArqAtributo))) return 0;
+    const ArqAtributo *src = (const ArqAtributo *)(ar->base + off);
+    for (u2 i = 0; i < count; ++i) {
+        if (src[i].length && !faixa_ok(ar, src[i].info, src[i].length)) return 0;
+        dst[i].attribute_name_index = src[i].name_index;
+        dst[i].attribute_length = src[i].length;
+        dst[i].info = src[i].length ? (u1 *)(ar->base + src[i].info) : NULL;
+    }
+    return 1;
+}
+
+/* Conta os atributos dos membros e valida a faixa dos vetores. */
+static int contar_atributos(const ClassArchive *ar, u4 off, u2 count, size_t *total) {
+    if (count == 0) return 1;
+    if (!faixa_ok(ar, off, (size_t)count * sizeof(ArqMembro))) return 0;
+    const ArqMembro *m = (const ArqMembro *)(ar->base + off);
+    for (u2 i = 0; i < count; ++i) *total += m[i].attributes_count;
+    return 1;
+}
+
+static int montar_membros(const ClassArchive *ar, u4 off, u2 count,
+                          FieldInfo *dst, AttributeInfo **attrs) {
+    const ArqMembro *src = (const ArqMembro *)(ar->base + off);
+    for (u2 i = 0; i < count; ++i) {
+        dst[i].access_flags = src[i].access_flags;
+        dst[i].name_index = src[i].name_index;
+        dst[i].descriptor_index = src[i].descriptor_index;
+        dst[i].attributes_count = src[i].attributes_count;
+        dst[i].attributes = src[i].attributes_count ? *attrs : NULL;
+        if (!montar_atributos(ar, src[i].attributes, src[i].attributes_count, *attrs)) return 0;
+        *attrs += src[i].attributes_count;
+    }
+    return 1;
+}
+
+/* Slots do indice apontam para o arquivo; valida que a sondagem termina. */
+static MemberSlot *slots_mapeados(const ClassArchive *ar, u4 off, u4 mask, u2 count) {
+    if (mask & (mask + 1)) return NULL;
+    size_t n = (size_t)mask + 1;
+    if (!faixa_ok(ar, off, n * sizeof(MemberSlot))) return NULL;
+    const MemberSlot *slots = (const MemberSlot *)(ar->base + off);
+    int livre = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (slots[i].member == MEMBER_SLOT_EMPTY) livre = 1;
+        else if (slots[i].member >= count) return NULL;
+    }
+    return livre ? (MemberSlot *)slots : NULL;
+}
+
+static int montar_cp(const ClassArchive *ar, const ArqClasse *r, CpInfo *cp) {
+    if (r->cp_count == 0) return 1;
+    if (!faixa_ok(ar, r->cp, (size_t)r->cp_count * sizeof(ArqCp))) return 0;
+    const ArqCp *src = (const ArqCp *)(ar->base + r->cp);
+
+    for (u2 i = 1; i < r->cp_count; ++i) {
+        const ArqCp *e = &src[i];
+        cp[i].tag = e->tag;
+        switch (e->tag) {
+        case CONSTANT_None:
+            break;
+        case CONSTANT_Utf8: {
+            const char *bytes = simbolo(ar, e->b, e->a);
+            if (!bytes) return 0;
+            cp[i].Utf8.length = e->a;
+            cp[i].Utf8.bytes = (char *)bytes;
+        } break;
+        case CONSTANT_Integer:
+        case CONSTANT_Float:
+            cp[i].Num.bytes = e->b;
+            break;
+        case CONSTANT_Long:
+        case CONSTANT_Double:
+            cp[i].LongDouble.high_bytes = e->b;
+            cp[i].LongDouble.low_bytes = e->c;
+            break;
+        case CONSTANT_Class:
+            cp[i].Class.name_index = e->a;
+            break;
+        case CONSTANT_String:
+            cp[i].String.string_index = e->a;
+            break;
+        case CONSTANT_Fieldref:
+        case CONSTANT_Methodref:
+        case CONSTANT_InterfaceMethodref:
+            cp[i].Ref.class_index = e->a;
+            cp[i].Ref.name_and_type_index = (u2)e->b;
+            break;
+        case CONSTANT_NameAndType:
+            cp[i].NameAndType.name_index = e->a;
+            cp[i].NameAndType.descriptor_index = (u2)e->b;
+            break;
+        case CONSTANT_MethodHandle:
+            cp[i].MethodHandle.reference_index = e->a;
+            cp[i].MethodHandle.reference_kind = (u1)e->b;
+            break;
+        case CONSTANT_MethodType:
+            cp[i].MethodType.descriptor_index = e->a;
+            break;
+        case CONSTANT_InvokeDynamic:
+            cp[i].InvokeDynamic.bootstrap_method_attr_index = e->a;
+            cp[i].InvokeDynamic.name_and_type_index = (u2)e->b;
+            break;
+        default:
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Monta o ClassFile num bloco unico:
+ * [ClassFile | CpInfo[] | FieldInfo[] | MethodInfo[] | AttributeInfo[] | MemberIndex]
+ */
+static ClassFile *materializar(const ClassArchive *ar, const ArqClasse *r) {
+    size_t total_attrs = r->attributes_count;
+    if (!contar_atributos(ar, r->fields, r->fields_count, &total_attrs) ||
+        !contar_atributos(ar, r->methods, r->methods_count, &total_attrs)) {
+        return NULL;
+    }
+    if (r->interfaces_count && !faixa_ok(ar, r->interfaces, (size_t)r->interfaces_count * sizeof(u2))) {
+        return NULL;
+    }
+
+    MemberSlot *method_slots = slots_mapeados(ar, r->method_slots, r->method_mask, r->methods_count);
+    MemberSlot *field_slots = slots_mapeados(ar, r->field_slots, r->field_mask, r->fields_count);
+    if (!method_slots || !field_slots) return NULL;
+
+    size_t t_cf = alinhar(sizeof(ClassFile));
+    size_t t_cp = alinhar((size_t)r->cp_count * sizeof(CpInfo));
+    size_t t_fields = alinhar((size_t)r->fields_count * sizeof(FieldInfo));
+    size_t t_methods = alinhar((size_t)r->methods_count * sizeof(MethodInfo));
+    size_t t_attrs = alinhar(total_attrs * sizeof(AttributeInfo));
+
+    u1 *bloco = (u1 *)calloc(1, t_cf + t_cp + t_fields + t_methods + t_attrs + sizeof(MemberIndex));
+    if (!bloco) return NULL;
+
+    ClassFile *cf = (ClassFile *)bloco;
+    u1 *p = bloco + t_cf;
+    cf->constant_pool = r->cp_count ? (CpInfo *)p : NULL;
+    p += t_cp;
+    cf->fields = r->fields_count ? (FieldInfo *)p : NULL;
+    p += t_fields;
+    cf->methods = r->methods_count ? (MethodInfo *)p : NULL;
+    p += t_methods;
+    AttributeInfo *attrs = (AttributeInfo *)p;
+    p += t_attrs;
+    MemberIndex *idx = (MemberIndex *)p;
+
+    cf->magic = 0xCAFEBABE;
+    cf->minor_version = r->minor_version;
+    cf->major_version = r->major_version;
+    cf->constant_pool_count = r->cp_count;
+    cf->access_flags = r->access_flags;
+    cf->this_class = r->this_class;
+    cf->super_class = r->super_class;
+    cf->interfaces_count = r->interfaces_count;
+    cf->interfaces = r->interfaces_count ? (u2 *)(ar->base + r->interfaces) : NULL;
+    cf->fields_count = r->fields_count;
+    cf->methods_count = r->methods_count;
+    cf->attributes_count = r->attributes_count;
+
+    int ok = montar_cp(ar, r, cf->constant_pool);
+    if (ok) {
+        cf->attributes = r->attributes_count ? attrs : NULL;
+        ok = montar_atributos(ar, r->attributes, r->attributes_count, attrs);
+        attrs += r->attributes_count;
+    }
+    if (ok) ok = montar_membros(ar, r->fields, r->fields_count, cf->fields, &attrs);
+    if (ok) ok = montar_membros(ar, r->methods, r->methods_count, cf->methods, &attrs);
+    if (!ok) {
+        free(bloco);
+        return NULL;
+    }
+
+    idx->method_mask = r->method_mask;
+    idx->method_slots = method_slots;
+    idx->field_mask = r->field_mask;
+    idx->field_slots = field_slots;
+    cf->members = idx;
+    cf->mapped = 1;
+    return cf;
+}
+
+static int cabecalho_ok(const ArqCabecalho *h, size_t size) {
+    if (memcmp(h->magic, ARQUIVO_MAGIC, sizeof h->magic) != 0) return 0;
+    if (h->version != ARQUIVO_VERSAO || h->byte_order != ARQUIVO_ORDEM_BYTES) return 0;
+    if (h->slot_size != sizeof(MemberSlot) || h->file_size != size) return 0;
+    if (h->table_mask & (h->table_mask + 1)) return 0;
+    if ((size_t)h->table_mask + 1 <= h->class_count) return 0;
+    if (h->classes > size || (size_t)h->class_count * sizeof(ArqClasse) > size - h->classes) return 0;
+    if (h->table > size || ((size_t)h->table_mask + 1) * sizeof(u4) > size - h->table) return 0;
+    if ((h->classes | h->table) & 3) return 0;
+    return 1;
+}
+
+ClassArchive *class_archive_open(const char *path, Status *out_status) {
+    Status st = OK;
+    ClassArchive *ar = NULL;
+    void *map = MAP_FAILED;
+    size_t size = 0;
+
+    int fd = path ? open(path, O_RDONLY) : -1;
+    if (fd < 0) { st = ERR_FILE; goto fim; }
+
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || (size_t)sb.st_size < sizeof(ArqCabecalho) ||
+        (unsigned long long)sb.st_size > 0xFFFFFFFFull) {
+        st = ERR_FILE;
+        goto fim;
+    }
+    size = (size_t)sb.st_size;
+
+    /* MAP_SHARED + somente leitura: paginas vindas do page cache, comuns a todos os processos */
+    map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) { st = ERR_FILE; goto fim; }
+
+    const ArqCabecalho *h = (const ArqCabecalho *)map;
+    if (!cabecalho_ok(h, size)) { st = ERR_FILE; goto fim; }
+
+    ar = (ClassArchive *)calloc(1, sizeof(ClassArchive));
+    if (ar) ar->loaded = (ClassFile **)calloc(h->class_count ? h->class_count : 1, sizeof(ClassFile *));
+    if (!ar || !ar->loaded) {
+        free(ar);
+        ar = NULL;
+        st = ERR_MEMORY;
+        goto fim;
+    }
+
+    ar->base = (const u1 *)map;
+    ar->size = size;
+    ar->hdr = h;
+    ar->classes = (const ArqClasse *)(ar->base + h->classes);
+    ar->table = (const u4 *)(ar->base + h->table);
+    pthread_mutex_init(&ar->lock, NULL);
+
+fim:
+    if (fd >= 0) close(fd);
+    if (!ar && map != MAP_FAILED) munmap(map, size);
+    if (out_status) *out_status = st;
+    return ar;
+}
+
+void class_archive_close(ClassArchive *ar) {
+    if (!ar) return;
+    for (u4 i = 0; i < ar->hdr->class_count; ++i) {
+        if (!ar->loaded[i]) continue;
+        free_classfile(ar->loaded[i]);  /* so o estado de execucao (cp_cache) */
+        free(ar->loaded[i]);
+    }
+    free(ar->loaded);
+    pthread_mutex_destroy(&ar->lock);
+    munmap((void *)ar->base, ar->size);
+    free(ar);
+}
+
+size_t class_archive_count(const ClassArchive *ar) {
+    return ar ? ar->hdr->class_count : 0;
+}
+
+const char *class_archive_name(const ClassArchive *ar, size_t i) {
+    if (!ar || i >= ar->hdr->class_count) return "";
+    const char *nome = simbolo_cstr(ar, ar->classes[i].name);
+    return nome ? nome : "";
+}
+
+ClassFile *class_archive_get(ClassArchive *ar, size_t i) {
+    if (!ar || i >= ar->hdr->class_count) return NULL;
+
+    pthread_mutex_lock(&ar->lock);
+    if (!ar->loaded[i]) ar->loaded[i] = materializar(ar, &ar->classes[i]);
+    ClassFile *cf = ar->loaded[i];
+    pthread_mutex_unlock(&ar->lock);
+    return cf;
+}
+
+ClassFile *class_archive_find(ClassArchive *ar, const char *name) {
+    if (!ar || !name) return NULL;
+
+    u4 h = hash_nome(name);
+    u4 mask = ar->hdr->table_mask;
+    u4 pos = h & mask;
+    for (u4 tentativas = 0; tentativas <= mask; ++tentativas, pos = (pos + 1) & mask) {
+        u4 v = ar->table[pos];
+        if (v == 0) break;
+        if (v > ar->hdr->class_count) return NULL;
+
+        const ArqClasse *r = &ar->classes[v - 1];
+        const char *nome = simbolo_cstr(ar, r->name);
+        if (r->name_hash == h && nome && strcmp(nome, name) == 0) return class_archive_get(ar, v - 1);
+    }
+    return NULL;
+}
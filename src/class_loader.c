@@ -0,0 +1,420 @@
+#define _POSIX_C_SOURCE 200809L
+#include "class_loader.h"
+#include "io.h"
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* ============================================================
+ * Helpers internos
+ * ============================================================ */
+static char *juntar_caminho(const char *dir, const char *nome) {
+    size_t ld = strlen(dir), ln = strlen(nome);
+    int barra = ld > 0 && dir[ld - 1] != '/';
+    char *out = (char *)malloc(ld + barra + ln + 1);
+    if (!out) return NULL;
+    memcpy(out, dir, ld);
+    if (barra) out[ld] = '/';
+    memcpy(out + ld + barra, nome, ln + 1);
+    return out;
+}
+
+static bool termina_com(const char *s, const char *sufixo) {
+    size_t ls = strlen(s), lx = strlen(sufixo);
+    return ls >= lx && strcmp(s + ls - lx, sufixo) == 0;
+}
+
+static Status adicionar(ClassList *list, char *path) {
+    if (list->count == list->capacity) {
+        size_t nova = list->capacity ? list->capacity * 2 : 64;
+        LoadedClass *items = (LoadedClass *)realloc(list->items, nova * sizeof(LoadedClass));
+        if (!items) return ERR_MEMORY;
+        list->items = items;
+        list->capacity = nova;
+    }
+    LoadedClass *lc = &list->items[list->count++];
+    memset(lc, 0, sizeof *lc);
+    lc->path = path;
+    return OK;
+}
+
+static ZipArchive *guardar_zip(ClassList *list, const char *path, Status *st) {
+    ZipArchive **zips = (ZipArchive **)realloc(list->zips, (list->zip_count + 1) * sizeof(ZipArchive *));
+    if (!zips) { *st = ERR_MEMORY; return NULL; }
+    list->zips = zips;
+
+    ZipArchive *zip = zip_open(path, st);
+    if (zip) list->zips[list->zip_count++] = zip;
+    return zip;
+}
+
+/* Separa "app.jar!/pkg/A.class" em jar e entrada; NULL se nao for desse formato. */
+static char *separar_entrada_jar(const char *path, const char **entrada) {
+    const char *sep = strstr(path, "!/");
+    if (!sep) return NULL;
+    size_t n = (size_t)(sep - path);
+    char *jar = (char *)malloc(n + 1);
+    if (!jar) return NULL;
+    memcpy(jar, path, n);
+    jar[n] = '\0';
+    *entrada = sep + 2;
+    return jar;
+}
+
+static Status adicionar_entrada_jar(ClassList *list, const char *jar, const ZipArchive *zip, size_t i) {
+    const char *nome = zip_entry_name(zip, i);
+    size_t lj = strlen(jar), ln = strlen(nome);
+    char *full = (char *)malloc(lj + 2 + ln + 1);
+    if (!full) return ERR_MEMORY;
+    memcpy(full, jar, lj);
+    memcpy(full + lj, "!/", 2);
+    memcpy(full + lj + 2, nome, ln + 1);
+
+    Status st = adicionar(list, full);
+    if (st != OK) {
+        free(full);
+        return st;
+    }
+    list->items[list->count - 1].zip = zip;
+    list->items[list->count - 1].entry = i;
+    return OK;
+}
+
+static Status coletar_jar(ClassList *list, const char *jar) {
+    Status st;
+    const ZipArchive *zip = guardar_zip(list, jar, &st);
+    if (!zip) return st;
+
+    for (size_t i = 0; i < zip_entry_count(zip) && st == OK; ++i) {
+        if (termina_com(zip_entry_name(zip, i), ".class")) st = adicionar_entrada_jar(list, jar, zip, i);
+    }
+    return st;
+}
+
+/* Uma unica entrada, localizada pelo indice do jar */
+static Status coletar_entrada_jar(ClassList *list, const char *path) {
+    const char *entrada = NULL;
+    char *jar = separar_entrada_jar(path, &entrada);
+    if (!jar) return ERR_MEMORY;
+
+    Status st;
+    const ZipArchive *zip = guardar_zip(list, jar, &st);
+    if (zip) {
+        long i = zip_find(zip, entrada);
+        st = i < 0 ? ERR_FILE : adicionar_entrada_jar(list, jar, zip, (size_t)i);
+    }
+    free(jar);
+    return st;
+}
+
+static Status coletar_dir(ClassList *list, const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) return ERR_FILE;
+
+    Status st = OK;
+    struct dirent *ent;
+    while (st == OK && (ent = readdir(d)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) continue;
+
+        char *full = juntar_caminho(dir, ent->d_name);
+        if (!full) { st = ERR_MEMORY; break; }
+
+        struct stat sb;
+        if (stat(full, &sb) != 0) {
+            free(full);
+            continue;
+        }
+        if (S_ISDIR(sb.st_mode)) {
+            st = coletar_dir(list, full);
+            free(full);
+        } else if (S_ISREG(sb.st_mode) && termina_com(full, ".class")) {
+            st = adicionar(list, full);
+            if (st != OK) free(full);
+        } else {
+            free(full);
+        }
+    }
+    closedir(d);
+    return st;
+}
+
+static int comparar_caminho(const void *a, const void *b) {
+    return strcmp(((const LoadedClass *)a)->path, ((const LoadedClass *)b)->path);
+}
+
+typedef struct {
+    ClassList *list;
+    ClassRegistry *reg;
+} LoadContext;
+
+/* Tarefa do pool: le + parse + publica um item. */
+static void carregar_item(void *ctx, size_t i) {
+    LoadContext *lctx = (LoadContext *)ctx;
+    LoadedClass *lc = &lctx->list->items[i];
+
+    if (class_loader_parse_item(lc) && lctx->reg) {
+        lc->published = class_registry_publish(lctx->reg, lc->cf) == lc->cf;
+    }
+}
+
+/* ============================================================
+ * API pública
+ * ============================================================ */
+bool class_source_is_dir(const char *path) {
+    struct stat sb;
+    return path && stat(path, &sb) == 0 && S_ISDIR(sb.st_mode);
+}
+
+bool class_source_is_jar(const char *path) {
+    return path && (termina_com(path, ".jar") || termina_com(path, ".zip")) && !class_source_is_dir(path);
+}
+
+Status class_source_read(const char *path, Buffer *out) {
+    if (!path || !out) return ERR_FILE;
+    memset(out, 0, sizeof *out);
+
+    const char *entrada = NULL;
+    char *jar = separar_entrada_jar(path, &entrada);
+    if (!jar) return buffer_from_file(path, out);
+
+    Status st;
+    ZipArchive *zip = zip_open(jar, &st);
+    free(jar);
+    if (!zip) return st;
+
+    long i = zip_find(zip, entrada);
+    st = i < 0 ? ERR_FILE : zip_read_entry(zip, (size_t)i, out);
+    if (st == OK && out->borrowed) {
+        /* o jar sera fechado aqui: o emprestimo vira copia */
+        u1 *copia = (u1 *)malloc(out->size ? out->size : 1);
+        if (copia) memcpy(copia, out->data, out->size);
+        out->data = copia;
+        out->borrowed = 0;
+        if (!copia) st = ERR_MEMORY;
+    }
+    zip_close(zip);
+    return st;
+}
+
+Status class_list_collect(ClassList *list, const char *path) {
+    if (!list || !path) return ERR_FILE;
+
+    size_t inicio = list->count;
+    Status st;
+    if (class_source_is_dir(path)) {
+        st = coletar_dir(list, path);
+    } else if (class_source_is_jar(path)) {
+        st = coletar_jar(list, path);
+    } else if (strstr(path, "!/")) {
+        st = coletar_entrada_jar(list, path);
+    } else {
+        size_t n = strlen(path) + 1;
+        char *copia = (char *)malloc(n);
+        if (!copia) return ERR_MEMORY;
+        memcpy(copia, path, n);
+        st = adicionar(list, copia);
+        if (st != OK) free(copia);
+    }
+
+    /* readdir nao garante ordem: ordena so o trecho recem-acrescentado */
+    if (list->count - inicio > 1) {
+        qsort(list->items + inicio, list->count - inicio, sizeof(LoadedClass), comparar_caminho);
+    }
+    return st;
+}
+
+bool class_loader_read_item(LoadedClass *lc, Buffer *out) {
+    memset(out, 0, sizeof *out);
+    /* entrada armazenada de jar: buffer emprestado do mapeamento, sem copia */
+    lc->io_status = lc->zip ? zip_read_entry(lc->zip, lc->entry, out)
+                            : buffer_from_file(lc->path, out);
+    return lc->io_status == OK;
+}
+
+bool class_loader_parse_buffer(LoadedClass *lc, Buffer *buffer) {
+    ClassFile *cf = (ClassFile *)calloc(1, sizeof(ClassFile));
+    if (!cf) {
+        buffer_free(buffer);
+        lc->cf_status = CF_STATUS_ERR_ALLOC;
+        return false;
+    }
+
+    lc->cf_status = parse_classfile(cf, buffer);
+    buffer_free(buffer);
+    if (lc->cf_status != CF_STATUS_OK) {
+        free_classfile(cf);
+        free(cf);
+        return false;
+    }
+
+    lc->cf = cf;
+    return true;
+}
+
+bool class_loader_parse_item(LoadedClass *lc) {
+    Buffer buffer;
+    return class_loader_read_item(lc, &buffer) && class_loader_parse_buffer(lc, &buffer);
+}
+
+void class_loader_release_item(LoadedClass *lc) {
+    if (lc->cf && !lc->published) {
+        free_classfile(lc->cf);
+        free(lc->cf);
+    }
+    lc->cf = NULL;
+}
+
+size_t class_loader_parse_all(ClassList *list, ThreadPool *pool, ClassRegistry *reg) {
+    if (!list || list->count == 0) return 0;
+
+    LoadContext ctx = { list, reg };
+    thread_pool_for(pool, list->count, carregar_item, &ctx);
+
+    size_t falhas = 0;
+    for (size_t i = 0; i < list->count; ++i) {
+        if (!list->items[i].cf) falhas++;
+    }
+    return falhas;
+}
+
+void class_list_free(ClassList *list) {
+    if (!list) return;
+    for (size_t i = 0; i < list->count; ++i) {
+        LoadedClass *lc = &list->items[i];
+        class_loader_release_item(lc);
+        free(lc->path);
+    }
+    free(list->items);
+    for (size_t i = 0; i < list->zip_count; ++i) zip_close(list->zips[i]);
+    free(list->zips);
+    memset(list, 0, sizeof *list);
+}
+
+/* ============================================================
+ * Classpath
+ * ============================================================ */
+typedef struct {
+    char *dir;                  /* diretorio raiz, ou NULL */
+    ZipArchive *zip;            /* jar aberto, ou NULL */
+} EntradaClassPath;
+
+struct class_path {
+    ClassRegistry *reg;
+    ClassArchive *archive;
+    EntradaClassPath *entries;
+    size_t count;
+};
+
+ClassPath *class_path_new(ClassRegistry *reg) {
+    if (!reg) return NULL;
+    ClassPath *cp = (ClassPath *)calloc(1, sizeof(ClassPath));
+    if (cp) cp->reg = reg;
+    return cp;
+}
+
+static Status adicionar_entrada(ClassPath *cp, const char *path, size_t n) {
+    char *copia = (char *)malloc(n + 1);
+    if (!copia) return ERR_MEMORY;
+    memcpy(copia, path, n);
+    copia[n] = '\0';
+
+    EntradaClassPath e = { NULL, NULL };
+    Status st = OK;
+    if (class_source_is_jar(copia)) {
+        e.zip = zip_open(copia, &st);
+        free(copia);
+    } else if (class_source_is_dir(copia)) {
+        e.dir = copia;
+    } else {
+        free(copia);    /* entrada inexistente: ignorada, como na JVM */
+        return OK;
+    }
+    if (!e.dir && !e.zip) return st;
+
+    EntradaClassPath *entries = (EntradaClassPath *)realloc(cp->entries, (cp->count + 1) * sizeof *entries);
+    if (!entries) {
+        free(e.dir);
+        zip_close(e.zip);
+        return ERR_MEMORY;
+    }
+    cp->entries = entries;
+    cp->entries[cp->count++] = e;
+    return OK;
+}
+
+Status class_path_add(ClassPath *cp, const char *entries) {
+    if (!cp || !entries) return ERR_FILE;
+    Status st = OK;
+    const char *p = entries;
+    while (st == OK && *p) {
+        const char *fim = strchr(p, ':');
+        size_t n = fim ? (size_t)(fim - p) : strlen(p);
+        if (n) st = adicionar_entrada(cp, p, n);
+        p += n + (fim ? 1 : 0);
+    }
+    return st;
+}
+
+void class_path_set_archive(ClassPath *cp, ClassArchive *ar) {
+    if (cp) cp->archive = ar;
+}
+
+static Status ler_da_entrada(const EntradaClassPath *e, const char *arquivo, Buffer *out) {
+    if (e->zip) {
+        long i = zip_find(e->zip, arquivo);
+        return i < 0 ? ERR_FILE : zip_read_entry(e->zip, (size_t)i, out);
+    }
+    char *full = juntar_caminho(e->dir, arquivo);
+    if (!full) return ERR_MEMORY;
+    Status st = buffer_from_file(full, out);
+    free(full);
+    return st;
+}
+
+ClassFile *class_path_load(void *ctx, const char *name) {
+    ClassPath *cp = (ClassPath *)ctx;
+    if (!cp || !name || !name[0]) return NULL;
+
+    ClassFile *cf = class_registry_find(cp->reg, name);
+    if (cf) return cf;
+    if (cp->archive && (cf = class_archive_find(cp->archive, name)) != NULL) return cf;
+
+    size_t n = strlen(name);
+    char *arquivo = (char *)malloc(n + sizeof ".class");
+    if (!arquivo) return NULL;
+    memcpy(arquivo, name, n);
+    memcpy(arquivo + n, ".class", sizeof ".class");
+
+    for (size_t i = 0; i < cp->count && !cf; ++i) {
+        Buffer buffer;
+        memset(&buffer, 0, sizeof buffer);
+        if (ler_da_entrada(&cp->entries[i], arquivo, &buffer) != OK) continue;
+
+        ClassFile *novo = (ClassFile *)calloc(1, sizeof(ClassFile));
+        ClassFileStatus st = novo ? parse_classfile(novo, &buffer) : CF_STATUS_ERR_ALLOC;
+        buffer_free(&buffer);
+
+        /* o nome pedido tem de bater com this_class (ex: pkg errado no diretorio) */
+        if (st == CF_STATUS_OK && strcmp(classfile_this_name(novo), name) == 0) {
+            cf = class_registry_publish(cp->reg, novo);
+            if (cf == novo) continue;
+        }
+        if (novo) {
+            free_classfile(novo);
+            free(novo);
+        }
+    }
+    free(arquivo);
+    return cf;
+}
+
+void class_path_free(ClassPath *cp) {
+    if (!cp) return;
+    for (size_t i = 0; i < cp->count; ++i) {
+        free(cp->entries[i].dir);
+        zip_close(cp->entries[i].zip);
+    }
+    free(cp->entries);
+    free(cp);
+}
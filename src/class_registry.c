@@ -0,0 +1,168 @@
+#define _POSIX_C_SOURCE 200809L
+#include "class_registry.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REGISTRY_SHARDS 32          /* potencia de 2 */
+
+typedef struct {
+    u4 hash;
+    const char *name;               /* emprestado do CP da propria classe */
+    ClassFile *cf;                  /* NULL = posicao livre */
+} RegistryEntry;
+
+typedef struct {
+    pthread_rwlock_t lock;
+    RegistryEntry *entries;
+    u4 capacity;                    /* potencia de 2 (ou 0) */
+    u4 count;
+} RegistryShard;
+
+struct class_registry {
+    RegistryShard shards[REGISTRY_SHARDS];
+};
+
+static u4 hash_nome(const char *s) {
+    u4 h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)s; *p; ++p) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static RegistryShard *shard_de(ClassRegistry *reg, u4 h) {
+    /* bits altos escolhem o shard; bits baixos, a posicao na tabela */
+    return &reg->shards[(h >> 27) & (REGISTRY_SHARDS - 1)];
+}
+
+/* Procura no shard (lock ja adquirido). */
+static RegistryEntry *procurar(RegistryShard *sh, u4 h, const char *name) {
+    if (sh->capacity == 0) return NULL;
+    u4 mask = sh->capacity - 1;
+    for (u4 pos = h & mask; sh->entries[pos].cf; pos = (pos + 1) & mask) {
+        RegistryEntry *e = &sh->entries[pos];
+        if (e->hash == h && strcmp(e->name, name) == 0) return e;
+    }
+    return NULL;
+}
+
+static void inserir(RegistryEntry *entries, u4 capacity, const RegistryEntry *e) {
+    u4 mask = capacity - 1;
+    u4 pos = e->hash & mask;
+    while (entries[pos].cf) pos = (pos + 1) & mask;
+    entries[pos] = *e;
+}
+
+/* Dobra a tabela quando a carga passa de 50% (lock de escrita adquirido). */
+static int crescer(RegistryShard *sh) {
+    u4 nova_cap = sh->capacity ? sh->capacity * 2 : 16;
+    RegistryEntry *novas = (RegistryEntry *)calloc(nova_cap, sizeof(RegistryEntry));
+    if (!novas) return 0;
+    for (u4 i = 0; i < sh->capacity; ++i) {
+        if (sh->entries[i].cf) inserir(novas, nova_cap, &sh->entries[i]);
+    }
+    free(sh->entries);
+    sh->entries = novas;
+    sh->capacity = nova_cap;
+    return 1;
+}
+
+/* ============================================================
+ * API pública
+ * ============================================================ */
+const char *classfile_this_name(const ClassFile *cf) {
+    if (!cf) return "";
+    return cp_nome_classe(cf->constant_pool, cf->constant_pool_count, cf->this_class);
+}
+
+ClassRegistry *class_registry_new(void) {
+    ClassRegistry *reg = (ClassRegistry *)calloc(1, sizeof(ClassRegistry));
+    if (!reg) return NULL;
+    for (int i = 0; i < REGISTRY_SHARDS; ++i) {
+        pthread_rwlock_init(&reg->shards[i].lock, NULL);
+    }
+    return reg;
+}
+
+void class_registry_free(ClassRegistry *reg) {
+    if (!reg) return;
+    for (int i = 0; i < REGISTRY_SHARDS; ++i) {
+        RegistryShard *sh = &reg->shards[i];
+        for (u4 j = 0; j < sh->capacity; ++j) {
+            if (sh->entries[j].cf) {
+                free_classfile(sh->entries[j].cf);
+                free(sh->entries[j].cf);
+            }
+        }
+        free(sh->entries);
+        pthread_rwlock_destroy(&sh->lock);
+    }
+    free(reg);
+}
+
+ClassFile *class_registry_publish(ClassRegistry *reg, ClassFile *cf) {
+    if (!reg || !cf) return NULL;
+
+    RegistryEntry e;
+    e.name = classfile_this_name(cf);
+    e.hash = hash_nome(e.name);
+    e.cf = cf;
+
+    RegistryShard *sh = shard_de(reg, e.hash);
+    pthread_rwlock_wrlock(&sh->lock);
+
+    RegistryEntry *existente = procurar(sh, e.hash, e.name);
+    if (existente) {
+        ClassFile *outra = existente->cf;
+        pthread_rwlock_unlock(&sh->lock);
+        return outra;
+    }
+
+    if ((sh->count + 1) * 2 > sh->capacity && !crescer(sh)) {
+        pthread_rwlock_unlock(&sh->lock);
+        return NULL;
+    }
+    inserir(sh->entries, sh->capacity, &e);
+    sh->count++;
+
+    pthread_rwlock_unlock(&sh->lock);
+    return cf;
+}
+
+ClassFile *class_registry_find(ClassRegistry *reg, const char *name) {
+    if (!reg || !name) return NULL;
+
+    u4 h = hash_nome(name);
+    RegistryShard *sh = shard_de(reg, h);
+
+    pthread_rwlock_rdlock(&sh->lock);
+    RegistryEntry *e = procurar(sh, h, name);
+    ClassFile *cf = e ? e->cf : NULL;
+    pthread_rwlock_unlock(&sh->lock);
+    return cf;
+}
+
+size_t class_registry_count(ClassRegistry *reg) {
+    if (!reg) return 0;
+    size_t total = 0;
+    for (int i = 0; i < REGISTRY_SHARDS; ++i) {
+        pthread_rwlock_rdlock(&reg->shards[i].lock);
+        total += reg->shards[i].count;
+        pthread_rwlock_unlock(&reg->shards[i].lock);
+    }
+    return total;
+}
+
+void class_registry_for_each(ClassRegistry *reg, ClassRegistryVisitor visit, void *ctx) {
+    if (!reg || !visit) return;
+    for (int i = 0; i < REGISTRY_SHARDS; ++i) {
+        RegistryShard *sh = &reg->shards[i];
+        pthread_rwlock_rdlock(&sh->lock);
+        for (u4 j = 0; j < sh->capacity; ++j) {
+            if (sh->entries[j].cf) visit(ctx, sh->entries[j].cf);
+        }
+        pthread_rwlock_unlock(&sh->lock);
+    }
+}
@@ -3,6 +3,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include "io.h"
+#include "member_index.h"
+#include "cp_cache.h"
+#include "resolve.h"
 
 /* Definições de Tipo assumidas para tradução */
 // Mantendo PascalCase para tipos
@@ -39,6 +42,8 @@ static Status ler_membros(InfoCampo **out, u2 *count, Buffer *in);
  * API pública
  * ============================================================ */
 Status ler_classe(Classe *classe, Buffer *in) {
+    memset(classe, 0, sizeof *classe);
+
     Status res = ler_cabecalho(classe, in);
     if (res != OK) return res;
 
@@ -62,13 +67,21 @@ Status ler_classe(Classe *classe, Buffer *in) {
     res = ler_atributos(&classe->attributes, &classe->attributes_count, in);
     if (res != OK) return res;
 
-    return OK;
+    /* indice de membros: resolucao de metodo/campo em O(1) */
+    return member_index_build(classe);
 }
 
 
 void liberar_classe(Classe *classe) {
     if (!classe) return;
 
+    /* estado de execucao e sempre do processo, mesmo em classe mapeada */
+    cp_cache_release(classe);
+    resolve_memo_release(classe);
+
+    /* classes de um class_archive pertencem ao arquivo mapeado */
+    if (classe->mapped) return;
+
     /* CP: libera Utf8, ignora slots vazios (CONSTANT_None) */
     if (classe->constant_pool) {
         for (u2 i = 1; i < classe->constant_pool_count; ++i) {
@@ -110,6 +123,8 @@ void liberar_classe(Classe *classe) {
         free(classe->attributes);
     }
 
+    member_index_free(classe);
+
     /* zera  */
     memset(classe, 0, sizeof *classe);
 }
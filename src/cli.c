@@ -1,21 +1,54 @@
 #include "cli.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /**
  * @brief Imprime a mensagem de uso/ajuda do programa.
  */
 void print_cli_usage(const char *prog_name) {
-    fprintf(stderr, "Uso: %s [opcoes] <arquivo.class>\n\n", prog_name);
+    fprintf(stderr, "Uso: %s [opcoes] <arquivo.class | diretorio | app.jar[!/pkg/A.class]>\n", prog_name);
+    fprintf(stderr, "     %s [opcoes] <entrada> <entrada>... | @lista.txt   (lote)\n", prog_name);
+    fprintf(stderr, "     %s --use-archive <arquivo.jsa> [classe]\n", prog_name);
+    fprintf(stderr, "     %s index <arquivo.jvbi> <entrada>...     (indice de referencias)\n", prog_name);
+    fprintf(stderr, "     %s query <arquivo.jvbi> <Dono[.nome[desc]]>...\n\n", prog_name);
     fprintf(stderr, "Opcoes principais:\n");
     fprintf(stderr, "  --pretty         Formata a saida de forma legivel (padrao).\n");
     fprintf(stderr, "  --reader-mode    Funciona apenas como leitor (sem exibição).\n");
     fprintf(stderr, "  --json           Formata a saida como um objeto JSON.\n");
+    fprintf(stderr, "  --jsonl          JSON Lines: um registro compacto por classe, por linha.\n");
+    fprintf(stderr, "  --jsonl-methods  JSON Lines: um registro por metodo.\n");
     fprintf(stderr, "  --no-code        Oculta o disassembly do bytecode dos metodos.\n");
+    fprintf(stderr, "  --cfg            Pretty/JSON: inclui o grafo de fluxo de controle de cada metodo.\n");
+    fprintf(stderr, "  --dot            Formata o grafo de fluxo de controle dos metodos para o Graphviz.\n");
     fprintf(stderr, "  -run             Executa o metodo main da classe.\n");
     fprintf(stderr, "  -debug           Executa o metodo main com saida de depuracao.\n");
+    fprintf(stderr, "  --jit            -run: compila os metodos quentes para codigo nativo (x86-64).\n");
+    fprintf(stderr, "  --jit-threshold <n>   Invocacoes ate compilar um metodo (padrao: 1000).\n");
+    fprintf(stderr, "  --osr-threshold <n>   Saltos para tras ate um laco entrar no codigo compilado (padrao: 10000).\n");
+    fprintf(stderr, "  --jit-threads <n>     Threads que compilam em segundo plano (padrao: 1; 0 = compila na thread que executa).\n");
+    fprintf(stderr, "  --code-cache <KiB>    Limite do codigo gerado; cheio, despeja os metodos frios (padrao: 65536).\n");
+    fprintf(stderr, "  --perf-map       Escreve /tmp/perf-<pid>.map com os nomes do codigo gerado (perf).\n");
+    fprintf(stderr, "  --regvm          -run: traduz os metodos para registradores e os executa nessa forma.\n");
+    fprintf(stderr, "  --inline-size <n>     --regvm: maior metodo inlinado, em bytes de bytecode (padrao: 35).\n");
+    fprintf(stderr, "  --no-inline      --regvm: nao inlina as chamadas.\n");
+    fprintf(stderr, "  --deopt-stress   --regvm: toda guarda desotimiza (teste).\n");
+    fprintf(stderr, "  --no-vectorize   --regvm: nao troca lacos sobre int[] por kernels SIMD.\n");
+    fprintf(stderr, "  --simd <isa>     Kernels dos lacos vetorizados: avx2, sse2 ou scalar (padrao: o melhor do processador).\n");
+    fprintf(stderr, "  --no-peephole    -run: nao otimiza o bytecode na carga (constantes, stores mortos, saltos, lacos).\n");
+    fprintf(stderr, "  --peephole-stats -run: mostra quantas instrucoes o peephole tirou de cada metodo.\n");
     fprintf(stderr, "  --help, -h       Mostra esta mensagem de ajuda.\n");
     fprintf(stderr, "  --verbose        Mostra logs de depuracao no stderr.\n");
+    fprintf(stderr, "  --threads <n>    Threads do modo lote (padrao: CPUs online).\n");
+    fprintf(stderr, "  --unordered      Lote: escreve cada classe assim que fica pronta.\n");
+    fprintf(stderr, "  --dump-archive <arq>  Grava as classes analisadas num arquivo compartilhado.\n");
+    fprintf(stderr, "  --use-archive <arq>   Usa as classes do arquivo (mapeado, sem parse).\n");
+    fprintf(stderr, "  --export-meta <arq>   Exporta os metadados em formato binario para indexadores.\n");
+    fprintf(stderr, "  --cache <dir>         Lote/index: reaproveita o resultado de classes inalteradas.\n");
+    fprintf(stderr, "  --cache-max <MiB>     Limite do cache (padrao: 256); as entradas menos usadas saem.\n");
+    fprintf(stderr, "  --build-index <arq>   O mesmo que 'index <arq>': indexa os usos de metodos/campos/classes.\n");
+    fprintf(stderr, "  --query-index <arq>   O mesmo que 'query <arq>': lista os usos de cada consulta.\n");
+    fprintf(stderr, "  --classpath <dirs:jars>  Onde -run/-debug procuram outras classes.\n");
 
     
     /* Nota: O documento de divisao  tambem menciona --cp (constant pool), etc. 
@@ -29,8 +62,11 @@ void print_cli_usage(const char *prog_name) {
  */
 static void set_default_options(CliOptions *options) {
     options->input_file = NULL;
+    options->inputs = NULL;
+    options->input_count = 0;
     options->output_mode = OUTPUT_MODE_PRETTY; // "pretty" é o padrão
     options->is_reader_mode = false; // Modo exibidor é o padrão
+    options->jsonl_per_method = false;
     
 
     // Por padrão, imprimimos tudo
@@ -42,14 +78,39 @@ static void set_default_options(CliOptions *options) {
     options->print_methods = true;
     options->print_attributes = true;
     options->disassemble_code = true; // "no-code"  desativa isso
+    options->print_cfg = false;
 
     // Modo de execução padrão: nenhum
     options->execution_mode = MODE_NONE;
+    options->jit = false;
+    options->jit_threshold = 0;
+    options->osr_threshold = 0;
+    options->jit_threads = 1;
+    options->code_cache_kib = 0;
+    options->perf_map = false;
+    options->regvm = false;
+    options->inline_size = 0;
+    options->no_inline = false;
+    options->deopt_stress = false;
+    options->no_vectorize = false;
+    options->simd = 0;
+    options->no_peephole = false;
+    options->peephole_stats = false;
 
     options->show_help = false;
     options->error = false;
     options->error_message = NULL;
     options->verbose = false;
+    options->threads = 0; // 0 = numero de CPUs online
+    options->unordered = false;
+    options->dump_archive = NULL;
+    options->use_archive = NULL;
+    options->export_meta = NULL;
+    options->build_index = NULL;
+    options->query_index = NULL;
+    options->cache_dir = NULL;
+    options->cache_max_mb = 0;
+    options->classpath = NULL;
 }
 
 /**
@@ -62,12 +123,37 @@ void parse_cli_options(int argc, char *argv[], CliOptions *options) {
     
     const char *prog_name = argv[0];
 
+    // Entradas apontam para argv; no maximo argc - 1
+    options->inputs = (const char **)calloc(argc > 1 ? (size_t)argc - 1 : 1, sizeof(const char *));
+    if (!options->inputs) {
+        options->error = true;
+        options->error_message = "Erro: Falha de alocacao.";
+        return;
+    }
+
+    // Subcomandos "index <arq>" e "query <arq>": atalhos de --build-index/--query-index
+    int primeiro = 1;
+    if (argc > 2 && strcmp(argv[1], "index") == 0) {
+        options->build_index = argv[2];
+        primeiro = 3;
+    } else if (argc > 2 && strcmp(argv[1], "query") == 0) {
+        options->query_index = argv[2];
+        primeiro = 3;
+    }
+
     // Itera por todos os argumentos, exceto o nome do programa
-    for (int i = 1; i < argc; i++) {
+    for (int i = primeiro; i < argc; i++) {
         const char *arg = argv[i];
 
         if (strcmp(arg, "--json") == 0) {
             options->output_mode = OUTPUT_MODE_JSON;
+        } else if (strcmp(arg, "--jsonl") == 0 || strcmp(arg, "--jsonl-methods") == 0) {
+            options->output_mode = OUTPUT_MODE_JSONL;
+            options->jsonl_per_method = arg[7] == '-';
+        } else if (strcmp(arg, "--dot") == 0) {
+            options->output_mode = OUTPUT_MODE_DOT;
+        } else if (strcmp(arg, "--cfg") == 0) {
+            options->print_cfg = true;
         } else if (strcmp(arg, "--pretty") == 0) {
             options->output_mode = OUTPUT_MODE_PRETTY;
         } else if (strcmp(arg, "--reader-mode") == 0) {
@@ -75,26 +161,143 @@ void parse_cli_options(int argc, char *argv[], CliOptions *options) {
             options->output_mode = OUTPUT_MODE_READER; // O modo leitor não exibe nada
         } else if (strcmp(arg, "--no-code") == 0) {
             options->disassemble_code = false;
+        } else if (strcmp(arg, "--jit") == 0) {
+            options->jit = true;
+        } else if (strcmp(arg, "--jit-threshold") == 0 || strcmp(arg, "--osr-threshold") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+                options->error = true;
+                options->error_message = "Erro: --jit-threshold/--osr-threshold requerem um numero positivo.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            unsigned n = (unsigned)atoi(argv[++i]);
+            if (arg[2] == 'j') options->jit_threshold = n;
+            else options->osr_threshold = n;
+        } else if (strcmp(arg, "--jit-threads") == 0) {
+            if (i + 1 >= argc || argv[i + 1][0] < '0' || argv[i + 1][0] > '9') {
+                options->error = true;
+                options->error_message = "Erro: --jit-threads requer um numero (0 ou mais).";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            options->jit_threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--code-cache") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+                options->error = true;
+                options->error_message = "Erro: --code-cache requer um tamanho positivo em KiB.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            options->code_cache_kib = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(arg, "--perf-map") == 0) {
+            options->perf_map = true;
+        } else if (strcmp(arg, "--regvm") == 0) {
+            options->regvm = true;
+        } else if (strcmp(arg, "--inline-size") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+                options->error = true;
+                options->error_message = "Erro: --inline-size requer um numero positivo.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            options->inline_size = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(arg, "--no-inline") == 0) {
+            options->no_inline = true;
+        } else if (strcmp(arg, "--deopt-stress") == 0) {
+            options->deopt_stress = true;
+        } else if (strcmp(arg, "--no-vectorize") == 0) {
+            options->no_vectorize = true;
+        } else if (strcmp(arg, "--no-peephole") == 0) {
+            options->no_peephole = true;
+        } else if (strcmp(arg, "--peephole-stats") == 0) {
+            options->peephole_stats = true;
+        } else if (strcmp(arg, "--simd") == 0) {
+            const char *isa = i + 1 < argc ? argv[i + 1] : "";
+            options->simd = strcmp(isa, "scalar") == 0 ? 1
+                          : strcmp(isa, "sse2") == 0   ? 2
+                          : strcmp(isa, "avx2") == 0   ? 3 : 0;
+            if (!options->simd) {
+                options->error = true;
+                options->error_message = "Erro: --simd requer avx2, sse2 ou scalar.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            i++;
         } else if (strcmp(arg, "-run") == 0) {
             options->execution_mode = MODE_EXECUTE;
         } else if (strcmp(arg, "-debug") == 0) {
             options->execution_mode = MODE_DEBUG;
         } else if (strcmp(arg, "--verbose") == 0) {
             options->verbose = true;
+        } else if (strcmp(arg, "--threads") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+                options->error = true;
+                options->error_message = "Erro: --threads requer um numero positivo.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            options->threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--unordered") == 0) {
+            options->unordered = true;
+        } else if (strcmp(arg, "--dump-archive") == 0 || strcmp(arg, "--use-archive") == 0) {
+            if (i + 1 >= argc) {
+                options->error = true;
+                options->error_message = "Erro: --dump-archive/--use-archive requerem um caminho.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            if (arg[2] == 'd') options->dump_archive = argv[++i];
+            else options->use_archive = argv[++i];
+        } else if (strcmp(arg, "--export-meta") == 0) {
+            if (i + 1 >= argc) {
+                options->error = true;
+                options->error_message = "Erro: --export-meta requer um caminho.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            options->export_meta = argv[++i];
+        } else if (strcmp(arg, "--build-index") == 0 || strcmp(arg, "--query-index") == 0) {
+            if (i + 1 >= argc) {
+                options->error = true;
+                options->error_message = "Erro: --build-index/--query-index requerem um caminho.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            if (arg[2] == 'b') options->build_index = argv[++i];
+            else options->query_index = argv[++i];
+        } else if (strcmp(arg, "--cache") == 0) {
+            if (i + 1 >= argc) {
+                options->error = true;
+                options->error_message = "Erro: --cache requer um diretorio.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            options->cache_dir = argv[++i];
+        } else if (strcmp(arg, "--cache-max") == 0) {
+            if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+                options->error = true;
+                options->error_message = "Erro: --cache-max requer um tamanho positivo (MiB).";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            options->cache_max_mb = atoi(argv[++i]);
+        } else if (strcmp(arg, "--classpath") == 0 || strcmp(arg, "-classpath") == 0) {
+            if (i + 1 >= argc) {
+                options->error = true;
+                options->error_message = "Erro: --classpath requer uma lista de diretorios/jars.";
+                fprintf(stderr, "%s\n", options->error_message);
+                return;
+            }
+            options->classpath = argv[++i];
         } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
             options->show_help = true;
         } else if (arg[0] == '-') {
             // Flag desconhecida
             fprintf(stderr, "Aviso: Flag '%s' desconhecida ou nao implementada.\n", arg);
         } else {
-            // Nao é uma flag, deve ser o arquivo de entrada
-            if (options->input_file != NULL) {
-                options->error = true;
-                options->error_message = "Erro: Multiplos arquivos de entrada nao sao suportados.";
-                print_cli_usage(prog_name);
-                return;
-            }
-            options->input_file = arg;
+            // Nao é uma flag: arquivo de entrada (varios = modo lote)
+            options->inputs[options->input_count++] = arg;
+            if (options->input_file == NULL) options->input_file = arg;
         }
     }
 
@@ -104,9 +307,41 @@ void parse_cli_options(int argc, char *argv[], CliOptions *options) {
         return; // Nao processa mais nada se for --help
     }
 
-    if (options->input_file == NULL && !options->error) {
+    if ((options->dump_archive != NULL) + (options->use_archive != NULL) + (options->export_meta != NULL) +
+        (options->build_index != NULL) + (options->query_index != NULL) > 1) {
+        options->error = true;
+        options->error_message = "Erro: --dump-archive, --use-archive, --export-meta, index e query sao exclusivos.";
+        fprintf(stderr, "%s\n", options->error_message);
+        return;
+    }
+
+    if (options->input_count > 1 && (options->execution_mode != MODE_NONE || options->use_archive)) {
+        options->error = true;
+        options->error_message = "Erro: Multiplas entradas so valem para visualizacao (sem -run/-debug/--use-archive).";
+        fprintf(stderr, "%s\n", options->error_message);
+        return;
+    }
+
+    if (options->query_index && options->input_count == 0) {
+        options->error = true;
+        options->error_message = "Erro: query requer ao menos uma consulta (ex: java/lang/String.length()I).";
+        fprintf(stderr, "%s\n", options->error_message);
+        return;
+    }
+
+    // Com --use-archive a classe e opcional (sem ela, lista o arquivo inteiro)
+    if (options->input_file == NULL && options->use_archive == NULL && !options->error) {
         options->error = true;
         options->error_message = "Erro: Nenhum arquivo .class fornecido.";
         print_cli_usage(prog_name);
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Libera o que parse_cli_options alocou (lista de entradas).
+ */
+void free_cli_options(CliOptions *options) {
+    free((void *)options->inputs);
+    options->inputs = NULL;
+    options->input_count = 0;
+}
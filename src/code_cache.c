@@ -0,0 +1,288 @@
+#define _GNU_SOURCE             /* MAP_ANONYMOUS, syscall */
+#include "code_cache.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001u
+#endif
+
+/* Granularidade dos blocos com vista de escrita separada */
+#define GRANULO_DUPLO 64u
+
+typedef struct {
+    size_t off, len;
+    bool livre;
+} Bloco;
+
+typedef struct {
+    uint8_t *exec;              /* vista de leitura/execucao */
+    uint8_t *escrita;           /* vista de escrita (NULL sem memfd) */
+    size_t tam;
+    Bloco *blocos;              /* ordenados por off, cobrem [0, tam) */
+    size_t nblocos, cap;
+} Segmento;
+
+struct code_cache {
+    pthread_mutex_t trava;
+    size_t capacidade, mapeado, usado;
+    size_t granulo;
+    bool duplo;                 /* segmentos com duas vistas (memfd) */
+    Segmento *segs;
+    unsigned nsegs, cap_segs;
+    unsigned nblocos;
+    FILE *perf;
+};
+
+static size_t arredondar(size_t n, size_t g) {
+    return (n + g - 1) / g * g;
+}
+
+static size_t pagina(void) {
+    long p = sysconf(_SC_PAGESIZE);
+    return p > 0 ? (size_t)p : 4096;
+}
+
+/* ============================================================
+ * Segmentos
+ * ============================================================ */
+
+/* memfd mapeado duas vezes; false se o sistema nao permite */
+static bool mapear_duplo(Segmento *s, size_t tam) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    int fd = (int)syscall(SYS_memfd_create, "jit-code", MFD_CLOEXEC);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)tam) != 0) {
+        close(fd);
+        return false;
+    }
+    void *exec = mmap(NULL, tam, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+    void *escrita = mmap(NULL, tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (exec == MAP_FAILED || escrita == MAP_FAILED) {
+        if (exec != MAP_FAILED) munmap(exec, tam);
+        if (escrita != MAP_FAILED) munmap(escrita, tam);
+        return false;
+    }
+    s->exec = (uint8_t *)exec;
+    s->escrita = (uint8_t *)escrita;
+    return true;
+#else
+    (void)s;
+    (void)tam;
+    return false;
+#endif
+}
+
+static bool mapear_simples(Segmento *s, size_t tam) {
+    void *exec = mmap(NULL, tam, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (exec == MAP_FAILED) return false;
+    s->exec = (uint8_t *)exec;
+    s->escrita = NULL;
+    return true;
+}
+
+static void desmapear(Segmento *s) {
+    munmap(s->exec, s->tam);
+    if (s->escrita) munmap(s->escrita, s->tam);
+    free(s->blocos);
+}
+
+/* Segmento novo de tam bytes (multiplo de pagina), um bloco livre so */
+static Segmento *novo_segmento(CodeCache *c, size_t tam) {
+    if (c->nsegs == c->cap_segs) {
+        unsigned cap = c->cap_segs ? c->cap_segs * 2 : 8;
+        Segmento *v = (Segmento *)realloc(c->segs, cap * sizeof(Segmento));
+        if (!v) return NULL;
+        c->segs = v;
+        c->cap_segs = cap;
+    }
+    Segmento s;
+    memset(&s, 0, sizeof s);
+    s.tam = tam;
+    s.blocos = (Bloco *)malloc(4 * sizeof(Bloco));
+    if (!s.blocos) return NULL;
+    s.cap = 4;
+    s.nblocos = 1;
+    s.blocos[0].off = 0;
+    s.blocos[0].len = tam;
+    s.blocos[0].livre = true;
+    if (!(c->duplo ? mapear_duplo(&s, tam) : mapear_simples(&s, tam))) {
+        free(s.blocos);
+        return NULL;
+    }
+    c->segs[c->nsegs] = s;
+    c->mapeado += tam;
+    return &c->segs[c->nsegs++];
+}
+
+/* Primeiro bloco livre com n bytes no segmento; divide o excedente */
+static Bloco *reservar(Segmento *s, size_t n) {
+    for (size_t i = 0; i < s->nblocos; i++) {
+        Bloco *b = &s->blocos[i];
+        if (!b->livre || b->len < n) continue;
+        if (b->len > n) {
+            if (s->nblocos == s->cap) {
+                Bloco *v = (Bloco *)realloc(s->blocos, s->cap * 2 * sizeof(Bloco));
+                if (!v) return NULL;
+                s->blocos = v;
+                s->cap *= 2;
+                b = &s->blocos[i];
+            }
+            memmove(&s->blocos[i + 2], &s->blocos[i + 1], (s->nblocos - i - 1) * sizeof(Bloco));
+            s->blocos[i + 1].off = b->off + n;
+            s->blocos[i + 1].len = b->len - n;
+            s->blocos[i + 1].livre = true;
+            s->nblocos++;
+            b->len = n;
+        }
+        b->livre = false;
+        return b;
+    }
+    return NULL;
+}
+
+/* ============================================================
+ * API
+ * ============================================================ */
+CodeCache *code_cache_new(size_t capacity, bool perf_map) {
+    CodeCache *c = (CodeCache *)calloc(1, sizeof(CodeCache));
+    if (!c) return NULL;
+    pthread_mutex_init(&c->trava, NULL);
+    c->capacidade = capacity ? capacity : CODE_CACHE_DEFAULT_CAPACITY;
+
+    /* O primeiro segmento decide o modo: duas vistas se o sistema deixar */
+    size_t tam = arredondar(c->capacidade < CODE_CACHE_SEGMENT ? c->capacidade : CODE_CACHE_SEGMENT, pagina());
+    c->duplo = true;
+    c->granulo = GRANULO_DUPLO;
+    if (!novo_segmento(c, tam)) {
+        c->duplo = false;
+        c->granulo = pagina();
+        if (!novo_segmento(c, tam)) {
+            code_cache_free(c);
+            return NULL;
+        }
+    }
+
+    if (perf_map) {
+        char caminho[64];
+        snprintf(caminho, sizeof caminho, "/tmp/perf-%ld.map", (long)getpid());
+        c->perf = fopen(caminho, "a");
+    }
+    return c;
+}
+
+void *code_cache_install(CodeCache *c, const void *code, size_t len, const char *name) {
+    if (!c || len == 0) return NULL;
+    size_t n = arredondar(len, c->granulo);
+
+    pthread_mutex_lock(&c->trava);
+    Segmento *s = NULL;
+    Bloco *b = NULL;
+    if (c->usado + n <= c->capacidade) {
+        for (unsigned i = 0; i < c->nsegs && !b; i++) {
+            s = &c->segs[i];
+            b = reservar(s, n);
+        }
+        /* segmento novo so enquanto o mapeado nao chegou ao limite */
+        if (!b && c->mapeado < c->capacidade) {
+            size_t resto = c->capacidade - c->mapeado;
+            size_t tam = resto < CODE_CACHE_SEGMENT ? resto : CODE_CACHE_SEGMENT;
+            tam = arredondar(n > tam ? n : tam, pagina());
+            if ((s = novo_segmento(c, tam)) != NULL) b = reservar(s, n);
+        }
+    }
+    if (!b) {
+        pthread_mutex_unlock(&c->trava);
+        return NULL;
+    }
+
+    uint8_t *destino = s->exec + b->off;
+    if (s->escrita) {
+        memcpy(s->escrita + b->off, code, len);
+    } else if (mprotect(destino, n, PROT_READ | PROT_WRITE) == 0) {
+        memcpy(destino, code, len);
+        mprotect(destino, n, PROT_READ | PROT_EXEC);
+    } else {
+        b->livre = true;        /* o bloco continua livre (vizinhos reunidos na proxima liberacao) */
+        pthread_mutex_unlock(&c->trava);
+        return NULL;
+    }
+    c->usado += n;
+    c->nblocos++;
+    if (c->perf && name) {
+        fprintf(c->perf, "%lx %zx %s\n", (unsigned long)(uintptr_t)destino, len, name);
+        fflush(c->perf);
+    }
+    pthread_mutex_unlock(&c->trava);
+    return destino;
+}
+
+void code_cache_release(CodeCache *c, void *code) {
+    if (!c || !code) return;
+    uint8_t *p = (uint8_t *)code;
+    pthread_mutex_lock(&c->trava);
+    for (unsigned i = 0; i < c->nsegs; i++) {
+        Segmento *s = &c->segs[i];
+        if (p < s->exec || p >= s->exec + s->tam) continue;
+
+        size_t off = (size_t)(p - s->exec), lo = 0, hi = s->nblocos;
+        while (lo < hi) {
+            size_t m = (lo + hi) / 2;
+            if (s->blocos[m].off < off) lo = m + 1;
+            else hi = m;
+        }
+        if (lo == s->nblocos || s->blocos[lo].off != off || s->blocos[lo].livre) break;
+        c->usado -= s->blocos[lo].len;
+        c->nblocos--;
+        s->blocos[lo].livre = true;
+        /* reune com o proximo e com o anterior */
+        if (lo + 1 < s->nblocos && s->blocos[lo + 1].livre) {
+            s->blocos[lo].len += s->blocos[lo + 1].len;
+            memmove(&s->blocos[lo + 1], &s->blocos[lo + 2], (s->nblocos - lo - 2) * sizeof(Bloco));
+            s->nblocos--;
+        }
+        if (lo > 0 && s->blocos[lo - 1].livre) {
+            s->blocos[lo - 1].len += s->blocos[lo].len;
+            memmove(&s->blocos[lo], &s->blocos[lo + 1], (s->nblocos - lo - 1) * sizeof(Bloco));
+            s->nblocos--;
+        }
+        /* segmento vazio volta ao sistema (fica sempre ao menos um) */
+        if (s->nblocos == 1 && c->nsegs > 1) {
+            c->mapeado -= s->tam;
+            desmapear(s);
+            c->segs[i] = c->segs[--c->nsegs];
+        }
+        break;
+    }
+    pthread_mutex_unlock(&c->trava);
+}
+
+void code_cache_stats(CodeCache *c, CodeCacheStats *out) {
+    memset(out, 0, sizeof *out);
+    if (!c) return;
+    pthread_mutex_lock(&c->trava);
+    out->capacity = c->capacidade;
+    out->mapped = c->mapeado;
+    out->used = c->usado;
+    out->segments = c->nsegs;
+    out->blocks = c->nblocos;
+    pthread_mutex_unlock(&c->trava);
+}
+
+void code_cache_free(CodeCache *c) {
+    if (!c) return;
+    for (unsigned i = 0; i < c->nsegs; i++) desmapear(&c->segs[i]);
+    free(c->segs);
+    if (c->perf) fclose(c->perf);
+    pthread_mutex_destroy(&c->trava);
+    free(c);
+}
@@ -0,0 +1,456 @@
+#define _POSIX_C_SOURCE 200809L
+#include "cp_cache.h"
+#include "class_registry.h"
+#include "member_index.h"
+#include "natives.h"
+#include "peephole.h"
+#include "verifier.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ACC_STATIC 0x0008
+#define ACC_NATIVE 0x0100
+#define ACC_INTERFACE 0x0200
+#define ACC_ABSTRACT 0x0400
+
+/* Limite de profundidade da hierarquia (protege contra ciclos em classes malformadas) */
+#define MAX_HIERARQUIA 64
+
+/* Estado de execucao por classe */
+typedef struct class_layout {
+    ClassFile *super;           /* NULL = fora do classpath */
+    u4 instance_slots;          /* inclui os das superclasses */
+    u4 static_slots;
+    u2 *field_offsets;          /* por fields[i]: offset de instancia ou indice em statics */
+    Slot *statics;
+    CodeAttribute **code;       /* por methods[i], decodificado sob demanda */
+    u1 *sobrescrito;            /* por methods[i]: alguma subclasse carregada redeclara o metodo */
+    u1 init_state;              /* 0 = nao iniciada, 1 = <clinit> em andamento/feito */
+} ClassLayout;
+
+/* Marca em layout->code de um metodo rejeitado pelo verificador */
+static CodeAttribute CODE_REJEITADO;
+
+/* Sobrescritas registradas ate agora (cp_cache_hierarchy_version) */
+static unsigned hierarquia_versao;
+
+/* ============================================================
+ * Sincronizacao e carregador
+ * ============================================================ */
+
+/* Recursivo: resolver um campo pode carregar e preparar outra classe */
+static pthread_mutex_t trava;
+static pthread_once_t trava_once = PTHREAD_ONCE_INIT;
+
+static void criar_trava(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&trava, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+static void travar(void) {
+    pthread_once(&trava_once, criar_trava);
+    pthread_mutex_lock(&trava);
+}
+
+static void destravar(void) {
+    pthread_mutex_unlock(&trava);
+}
+
+static ClassLookup carregador;
+static void *carregador_ctx;
+
+void cp_cache_set_loader(ClassLookup lookup, void *ctx) {
+    travar();
+    carregador = lookup;
+    carregador_ctx = ctx;
+    destravar();
+}
+
+ClassFile *cp_cache_load_class(const char *name) {
+    if (!name || !name[0] || !carregador) return NULL;
+    return carregador(carregador_ctx, name);
+}
+
+/* A propria classe nao depende do carregador (ex: execucao sem classpath) */
+static ClassFile *carregar(ClassFile *de, const char *name) {
+    if (strcmp(classfile_this_name(de), name) == 0) return de;
+    return cp_cache_load_class(name);
+}
+
+/* ============================================================
+ * Descritores
+ * ============================================================ */
+u2 descriptor_arg_slots(const char *descriptor) {
+    if (!descriptor || *descriptor != '(') return 0;
+    u2 slots = 0;
+    const char *p = descriptor + 1;
+    while (*p && *p != ')') {
+        if (*p == 'J' || *p == 'D') {
+            slots += 2;
+            p++;
+            continue;
+        }
+        while (*p == '[') p++;
+        if (*p == 'L') {
+            while (*p && *p != ';') p++;
+        }
+        if (*p) p++;
+        slots++;
+    }
+    return slots;
+}
+
+static char tipo_retorno(const char *descriptor) {
+    const char *r = descriptor ? strchr(descriptor, ')') : NULL;
+    return r && r[1] ? r[1] : 'V';
+}
+
+static u1 slots_do_tipo(char t) {
+    if (t == 'V') return 0;
+    return (t == 'J' || t == 'D') ? 2 : 1;
+}
+
+/* ============================================================
+ * Layout da classe
+ * ============================================================ */
+static ClassFileStatus preparar(ClassFile *cf, int profundidade);
+
+/*
+ * Analise de hierarquia: cada metodo de cf (exceto construtores e
+ * <clinit>) marca o de mesmo nome e descritor em todas as superclasses,
+ * que ja estao preparadas. Chamado com a trava, ao preparar cf.
+ */
+static void registrar_sobrescritas(ClassFile *cf) {
+    for (u2 i = 0; i < cf->methods_count; ++i) {
+        const char *nome = cp_utf8(cf->constant_pool, cf->constant_pool_count, cf->methods[i].name_index);
+        const char *desc = cp_utf8(cf->constant_pool, cf->constant_pool_count, cf->methods[i].descriptor_index);
+        if (nome[0] == '<') continue;
+        ClassFile *super = cf->layout->super;
+        for (int n = 0; super && n < MAX_HIERARQUIA; ++n, super = super->layout->super) {
+            const MethodInfo *m = member_index_find_method(super, nome, desc);
+            if (!m || super->layout->sobrescrito[m - super->methods]) continue;
+            __atomic_store_n(&super->layout->sobrescrito[m - super->methods], 1, __ATOMIC_RELEASE);
+            __atomic_add_fetch(&hierarquia_versao, 1, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+static ClassFileStatus montar_layout(ClassFile *cf, int profundidade) {
+    ClassLayout *l = (ClassLayout *)calloc(1, sizeof(ClassLayout));
+    ResolvedEntry *resolved = (ResolvedEntry *)calloc(cf->constant_pool_count ? cf->constant_pool_count : 1,
+                                                      sizeof(ResolvedEntry));
+    if (l) {
+        l->field_offsets = (u2 *)calloc(cf->fields_count ? cf->fields_count : 1, sizeof(u2));
+        l->code = (CodeAttribute **)calloc(cf->methods_count ? cf->methods_count : 1, sizeof(CodeAttribute *));
+        l->sobrescrito = (u1 *)calloc(cf->methods_count ? cf->methods_count : 1, 1);
+    }
+    if (!l || !resolved || !l->field_offsets || !l->code || !l->sobrescrito) {
+        if (l) {
+            free(l->field_offsets);
+            free(l->code);
+            free(l->sobrescrito);
+        }
+        free(l);
+        free(resolved);
+        return CF_STATUS_ERR_ALLOC;
+    }
+
+    /* superclasse primeiro: os campos dela vem antes no objeto */
+    const char *super_name = cp_nome_classe(cf->constant_pool, cf->constant_pool_count, cf->super_class);
+    if (super_name[0] && profundidade < MAX_HIERARQUIA) {
+        ClassFile *super = carregar(cf, super_name);
+        if (super && super != cf && preparar(super, profundidade + 1) == CF_STATUS_OK) {
+            l->super = super;
+            l->instance_slots = super->layout->instance_slots;
+        }
+    }
+
+    for (u2 i = 0; i < cf->fields_count; ++i) {
+        const FieldInfo *f = &cf->fields[i];
+        const char *desc = cp_utf8(cf->constant_pool, cf->constant_pool_count, f->descriptor_index);
+        u1 n = slots_do_tipo(desc[0]) ? slots_do_tipo(desc[0]) : 1;
+        if (f->access_flags & ACC_STATIC) {
+            l->field_offsets[i] = (u2)l->static_slots;
+            l->static_slots += n;
+        } else {
+            l->field_offsets[i] = (u2)l->instance_slots;
+            l->instance_slots += n;
+        }
+    }
+
+    if (l->static_slots) {
+        l->statics = (Slot *)calloc(l->static_slots, sizeof(Slot));
+        if (!l->statics) {
+            free(l->field_offsets);
+            free(l->code);
+            free(l->sobrescrito);
+            free(l);
+            free(resolved);
+            return CF_STATUS_ERR_ALLOC;
+        }
+    }
+
+    cf->resolved = resolved;
+    __atomic_store_n(&cf->layout, l, __ATOMIC_RELEASE);
+    registrar_sobrescritas(cf);
+    return CF_STATUS_OK;
+}
+
+static ClassFileStatus preparar(ClassFile *cf, int profundidade) {
+    if (!cf) return CF_STATUS_ERR_ALLOC;
+    if (__atomic_load_n(&cf->layout, __ATOMIC_ACQUIRE)) return CF_STATUS_OK;
+
+    travar();
+    ClassFileStatus st = cf->layout ? CF_STATUS_OK : montar_layout(cf, profundidade);
+    destravar();
+    return st;
+}
+
+ClassFileStatus cp_cache_prepare(ClassFile *cf) {
+    return preparar(cf, 0);
+}
+
+void cp_cache_release(ClassFile *cf) {
+    if (!cf || !cf->layout) return;
+
+    ClassLayout *l = cf->layout;
+    for (u2 i = 0; i < cf->methods_count; ++i) {
+        if (l->code[i] && l->code[i] != &CODE_REJEITADO) {
+            free_code_attribute(l->code[i]);
+            free(l->code[i]);
+        }
+    }
+    for (u2 i = 1; i < cf->constant_pool_count; ++i) {
+        if (cf->resolved[i].kind == RESOLVED_STRING) jvm_heap_free_object(cf->resolved[i].u.string);
+    }
+    free(l->code);
+    free(l->sobrescrito);
+    free(l->field_offsets);
+    free(l->statics);
+    free(l);
+    free(cf->resolved);
+    cf->layout = NULL;
+    cf->resolved = NULL;
+}
+
+u4 cp_cache_instance_slots(ClassFile *cf) {
+    if (cp_cache_prepare(cf) != CF_STATUS_OK) return 0;
+    return cf->layout->instance_slots;
+}
+
+ClassFile *cp_cache_super(ClassFile *cf) {
+    if (cp_cache_prepare(cf) != CF_STATUS_OK) return NULL;
+    return cf->layout->super;
+}
+
+int cp_cache_begin_init(ClassFile *cf) {
+    if (cp_cache_prepare(cf) != CF_STATUS_OK) return 0;
+    if (__atomic_load_n(&cf->layout->init_state, __ATOMIC_ACQUIRE)) return 0;
+
+    travar();
+    int primeira = cf->layout->init_state == 0;
+    if (primeira) __atomic_store_n(&cf->layout->init_state, 1, __ATOMIC_RELEASE);
+    destravar();
+    return primeira;
+}
+
+const CodeAttribute *cp_cache_code(ClassFile *cf, const MethodInfo *method) {
+    if (!method || cp_cache_prepare(cf) != CF_STATUS_OK) return NULL;
+    if (method < cf->methods || method >= cf->methods + cf->methods_count) return NULL;
+
+    size_t i = (size_t)(method - cf->methods);
+    CodeAttribute *code = __atomic_load_n(&cf->layout->code[i], __ATOMIC_ACQUIRE);
+    if (code) return code == &CODE_REJEITADO ? NULL : code;
+
+    travar();
+    code = cf->layout->code[i];
+    for (u2 a = 0; !code && a < method->attributes_count; ++a) {
+        const char *nome = cp_utf8(cf->constant_pool, cf->constant_pool_count,
+                                   method->attributes[a].attribute_name_index);
+        if (strcmp(nome, "Code") != 0) continue;
+
+        CodeAttribute *novo = (CodeAttribute *)calloc(1, sizeof(CodeAttribute));
+        if (!novo) break;
+        if (parse_code_attribute(cf, &method->attributes[a], novo) != OK) {
+            free(novo);                 /* o parse ja liberou o que alocou */
+            break;
+        }
+
+        /* so codigo verificado chega ao interpretador (que nao checa a pilha) */
+        VerifyError err;
+        if (verify_method(cf, method, novo, &err) != OK) {
+            fprintf(stderr, "VerifyError: %s.%s%s pc=%u: %s\n", classfile_this_name(cf),
+                    cp_utf8(cf->constant_pool, cf->constant_pool_count, method->name_index),
+                    cp_utf8(cf->constant_pool, cf->constant_pool_count, method->descriptor_index),
+                    err.pc, err.message[0] ? err.message : "sem memoria");
+            free_code_attribute(novo);
+            free(novo);
+            novo = &CODE_REJEITADO;
+        } else if (peephole_enabled()) {
+            peephole_optimize(cf, method, novo);     /* falhando, fica o verificado */
+        }
+        code = novo;
+        __atomic_store_n(&cf->layout->code[i], code, __ATOMIC_RELEASE);
+    }
+    destravar();
+    return code == &CODE_REJEITADO ? NULL : code;
+}
+
+bool cp_cache_overridden(ClassFile *cf, const MethodInfo *method) {
+    if (!method || (cf->access_flags & ACC_INTERFACE) || cp_cache_prepare(cf) != CF_STATUS_OK) return true;
+    if (method < cf->methods || method >= cf->methods + cf->methods_count) return true;
+    return __atomic_load_n(&cf->layout->sobrescrito[method - cf->methods], __ATOMIC_ACQUIRE) != 0;
+}
+
+unsigned cp_cache_hierarchy_version(void) {
+    return __atomic_load_n(&hierarquia_versao, __ATOMIC_ACQUIRE);
+}
+
+MethodInfo *cp_cache_find_virtual(ClassFile *cf, const char *name, const char *descriptor,
+                                  ClassFile **owner) {
+    for (int n = 0; cf && n < MAX_HIERARQUIA; ++n) {
+        MethodInfo *m = member_index_find_method(cf, name, descriptor);
+        if (m) {
+            if (owner) *owner = cf;
+            return m;
+        }
+        cf = cp_cache_super(cf);
+    }
+    return NULL;
+}
+
+/* ============================================================
+ * Resolucao
+ * ============================================================ */
+static void resolver_classe(ClassFile *cf, u2 index, ResolvedEntry *r) {
+    const char *nome = cp_nome_classe(cf->constant_pool, cf->constant_pool_count, index);
+    ClassFile *cls = nome[0] == '[' ? NULL : carregar(cf, nome);
+    if (cls && cp_cache_prepare(cls) == CF_STATUS_OK) {
+        r->kind = RESOLVED_CLASS;
+        r->cls = cls;
+    } else {
+        r->kind = RESOLVED_UNAVAILABLE;
+    }
+}
+
+static void resolver_metodo(ClassFile *cf, u2 index, ResolvedEntry *r) {
+    const char *cls_name, *name, *desc;
+    cp_referencia_metodo(cf->constant_pool, cf->constant_pool_count, index, &cls_name, &name, &desc);
+
+    r->type = (u1)tipo_retorno(desc);
+    r->ret_slots = slots_do_tipo((char)r->type);
+    r->arg_slots = descriptor_arg_slots(desc);
+
+    ClassFile *alvo = carregar(cf, cls_name);
+    if (alvo && cp_cache_prepare(alvo) == CF_STATUS_OK) {
+        ClassFile *dono = NULL;
+        MethodInfo *m = cp_cache_find_virtual(alvo, name, desc, &dono);
+        if (m && !(m->access_flags & (ACC_NATIVE | ACC_ABSTRACT))) {
+            r->kind = RESOLVED_METHOD;
+            r->cls = dono;
+            r->is_static = (m->access_flags & ACC_STATIC) != 0;
+            r->u.method = m;
+            return;
+        }
+        if (m) {
+            /* abstrato (despacho pelo receptor) ou nativo: guarda o dono */
+            r->cls = dono;
+            r->is_static = (m->access_flags & ACC_STATIC) != 0;
+            r->u.method = m;
+        }
+    }
+
+    NativeMethod native = native_lookup(cls_name, name, desc);
+    if (native) {
+        r->kind = RESOLVED_NATIVE;
+        r->u.native = native;
+        return;
+    }
+    r->kind = r->u.method ? RESOLVED_METHOD : RESOLVED_UNAVAILABLE;
+}
+
+static void resolver_campo(ClassFile *cf, u2 index, ResolvedEntry *r) {
+    const char *cls_name, *name, *desc;
+    cp_referencia_metodo(cf->constant_pool, cf->constant_pool_count, index, &cls_name, &name, &desc);
+
+    r->type = (u1)desc[0];
+    r->field_slots = slots_do_tipo(desc[0]) ? slots_do_tipo(desc[0]) : 1;
+    r->kind = RESOLVED_UNAVAILABLE;
+
+    ClassFile *c = carregar(cf, cls_name);
+    for (int n = 0; c && n < MAX_HIERARQUIA; ++n) {
+        if (cp_cache_prepare(c) != CF_STATUS_OK) return;
+        FieldInfo *f = member_index_find_field(c, name, desc);
+        if (f) {
+            u2 off = c->layout->field_offsets[f - c->fields];
+            r->cls = c;
+            if (f->access_flags & ACC_STATIC) {
+                r->kind = RESOLVED_STATIC;
+                r->is_static = 1;
+                r->u.static_slot = &c->layout->statics[off];
+            } else {
+                r->kind = RESOLVED_FIELD;
+                r->u.offset = off;
+            }
+            return;
+        }
+        c = c->layout->super;
+    }
+}
+
+static void resolver(ClassFile *cf, u2 index, ResolvedEntry *r) {
+    const CpInfo *c = &cf->constant_pool[index];
+    switch (c->tag) {
+    case CONSTANT_Class:
+        resolver_classe(cf, index, r);
+        break;
+    case CONSTANT_Methodref:
+    case CONSTANT_InterfaceMethodref:
+        resolver_metodo(cf, index, r);
+        break;
+    case CONSTANT_Fieldref:
+        resolver_campo(cf, index, r);
+        break;
+    case CONSTANT_String: {
+        u2 si = c->String.string_index;
+        const char *texto = cp_utf8(cf->constant_pool, cf->constant_pool_count, si);
+        r->u.string = jvm_heap_new_string(texto, (u4)strlen(texto));
+        r->kind = r->u.string ? RESOLVED_STRING : RESOLVED_UNAVAILABLE;
+    } break;
+    case CONSTANT_Integer:
+    case CONSTANT_Float:
+        r->kind = RESOLVED_CONSTANT;
+        r->type = c->tag == CONSTANT_Integer ? 'I' : 'F';
+        r->u.value = c->Num.bytes;
+        break;
+    default:
+        r->kind = RESOLVED_UNAVAILABLE;
+        break;
+    }
+}
+
+const ResolvedEntry *cp_resolve_slow(ClassFile *cf, u2 index) {
+    if (!cf || index == 0 || index >= cf->constant_pool_count) return NULL;
+    if (cp_cache_prepare(cf) != CF_STATUS_OK) return NULL;
+
+    ResolvedEntry *e = &cf->resolved[index];
+    travar();
+    if (e->kind == RESOLVED_NONE) {
+        ResolvedEntry r;
+        memset(&r, 0, sizeof r);
+        resolver(cf, index, &r);
+
+        /* publica: todos os campos antes, 'kind' por ultimo */
+        u1 kind = r.kind;
+        r.kind = RESOLVED_NONE;
+        *e = r;
+        __atomic_store_n(&e->kind, kind, __ATOMIC_RELEASE);
+    }
+    destravar();
+    return e;
+}
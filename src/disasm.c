@@ -1,13 +1,12 @@
 // src/disasm.c
+#define _POSIX_C_SOURCE 200809L  /* strdup (API antiga) */
 
 #include "disasm.h"
-#include "resolve.h"
 #include "classfile.h" // Para acesso a ClassFile e CodeAttribute
 #include "attributes.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h> // Para tratamento de floats/doubles (se necessário)
 
 
 // --- STUBS DE IO  ---
@@ -341,180 +340,387 @@ static const OpcodeInfo opcode_table[256] = {
 
 
 
+/* ============================================================
+ * Arena
+ * ============================================================ */
+void disasm_arena_init(DisasmArena *arena) {
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+void disasm_arena_free(DisasmArena *arena) {
+    free(arena->base);
+    disasm_arena_init(arena);
+}
+
+/* Esvazia a arena e garante 'bytes' livres; so aloca quando o maior metodo cresce */
+static void *arena_reservar(DisasmArena *arena, size_t bytes) {
+    arena->used = 0;
+    if (bytes > arena->capacity) {
+        size_t nova = arena->capacity ? arena->capacity * 2 : 4096;
+        while (nova < bytes) nova *= 2;
+        void *bloco = malloc(nova);
+        if (!bloco) return NULL;
+        free(arena->base);
+        arena->base = bloco;
+        arena->capacity = nova;
+    }
+    arena->used = bytes;
+    return arena->base;
+}
+
+/* ============================================================
+ * Resolucao sem copia: views para o constant pool
+ * ============================================================ */
+static void resolver_membro(const ClassFile *cf, uint16_t idx, DisasmInsn *insn) {
+    const char *classe, *nome, *desc;
+    cp_referencia_metodo(cf->constant_pool, cf->constant_pool_count, idx, &classe, &nome, &desc);
+    if (classe[0] == '\0' || nome[0] == '\0') {
+        insn->res_kind = DISASM_RES_ERR_REF;
+        return;
+    }
+    insn->res_kind = DISASM_RES_MEMBER;
+    insn->res.view[0] = classe;
+    insn->res.view[1] = nome;
+    insn->res.view[2] = desc;
+}
+
+static void resolver_classe(const ClassFile *cf, uint16_t idx, DisasmInsn *insn) {
+    const char *nome = cp_nome_classe(cf->constant_pool, cf->constant_pool_count, idx);
+    if (nome[0] == '\0') {
+        insn->res_kind = DISASM_RES_ERR_CLASS;
+        return;
+    }
+    insn->res_kind = DISASM_RES_TEXT;
+    insn->res.view[0] = nome;
+}
+
+static void resolver_literal(const ClassFile *cf, uint16_t idx, DisasmInsn *insn) {
+    const CpInfo *cp = cf->constant_pool;
+    u2 n = cf->constant_pool_count;
+    insn->res_kind = DISASM_RES_TEXT;
+    insn->res.view[0] = "<?>";
+    if (idx == 0 || idx >= n) return;
+
+    switch (cp[idx].tag) {
+        case CONSTANT_String:
+            insn->res_kind = DISASM_RES_STRING;
+            insn->res.view[0] = cp_utf8(cp, n, cp[idx].String.string_index);
+            break;
+        case CONSTANT_Integer:
+            insn->res_kind = DISASM_RES_INT;
+            insn->res.i = (int32_t)cp[idx].Num.bytes;
+            break;
+        case CONSTANT_Float:
+            insn->res_kind = DISASM_RES_FLOAT;
+            memcpy(&insn->res.f, &cp[idx].Num.bytes, 4);   // IEEE-754
+            break;
+        case CONSTANT_Long:
+        case CONSTANT_Double: {
+            uint64_t bits = ((uint64_t)cp[idx].LongDouble.high_bytes << 32) | (uint64_t)cp[idx].LongDouble.low_bytes;
+            if (cp[idx].tag == CONSTANT_Long) {
+                insn->res_kind = DISASM_RES_LONG;
+                insn->res.l = (int64_t)bits;
+            } else {
+                insn->res_kind = DISASM_RES_DOUBLE;
+                memcpy(&insn->res.d, &bits, 8);
+            }
+            break;
+        }
+        case CONSTANT_Class:
+            insn->res.view[0] = cp_utf8(cp, n, cp[idx].Class.name_index);
+            break;
+        case CONSTANT_Utf8:
+            insn->res.view[0] = cp_utf8(cp, n, idx);
+            break;
+        default:
+            break;
+    }
+}
+
+/* ============================================================
+ * Decodificacao
+ * ============================================================ */
+
 /**
- * @brief Desmonta o Bytecode de um metodo.
+ * @brief Decodifica o Bytecode de um metodo para a arena (sem malloc em regime).
  */
-bool disassemble_method(ClassFile *cf, CodeAttribute *code_attr, DisasmOutput *output) {
-    if (!code_attr || code_attr->code_length == 0) {
-        output->instructions = NULL;
-        output->count = 0;
-        return true;
-    }
+bool disasm_decode(const ClassFile *cf, const CodeAttribute *code_attr, DisasmArena *arena, DisasmMethod *out) {
+    out->insns = NULL;
+    out->count = 0;
+    if (!code_attr || code_attr->code_length == 0) return true;
 
-    uint8_t *code = (uint8_t *)code_attr->code; // Array de bytes do Bytecode
+    const uint8_t *code = code_attr->code;
     uint32_t code_len = code_attr->code_length;
-    uint32_t pc = 0;
-    uint32_t max_instructions = code_len; // Estimativa maxima
-    
-    // Aloca a lista de instrucoes
-    output->instructions = (DisasmInstruction *)calloc(max_instructions, sizeof(DisasmInstruction));
-    if (!output->instructions) return false;
-
-    uint32_t inst_count = 0;
-
-    // Loop de Desassembleamento
-    while (pc < code_len && inst_count < max_instructions) {
-        DisasmInstruction *current_inst = &output->instructions[inst_count];
-        current_inst->pc = pc;
+
+    // No maximo uma instrucao por byte
+    DisasmInsn *insns = (DisasmInsn *)arena_reservar(arena, (size_t)code_len * sizeof(DisasmInsn));
+    if (!insns) return false;
+
+    uint32_t pc = 0, count = 0;
+    while (pc < code_len) {
+        DisasmInsn *insn = &insns[count];
         uint8_t opcode = code[pc];
-        
         const OpcodeInfo *info = &opcode_table[opcode];
-        current_inst->mnemonic = strdup(info->mnemonic ? info->mnemonic : "unknown_opcode");
-        
-        uint32_t next_pc = pc + 1; // Proximo PC padrao
-        char args_buffer[128] = {0};
-        char *resolved_info = NULL;
-        uint16_t arg_u2 = 0;
-        uint8_t arg_u1 = 0;
-        
-        // --- LÓGICA DE TRATAMENTO DE ARGUMENTOS ---
-        
-        // Determina o comprimento e a leitura do argumento
-        if (info->arg_type == NO_ARGS) {
-            current_inst->length = 1;
-        } else if (info->fixed_length > 0) {
-            current_inst->length = info->fixed_length;
-        } else {
-            // Se o tamanho for variavel (SWITCHES, WIDE), ele sera ajustado abaixo
-            current_inst->length = 1; 
+
+        insn->pc = pc;
+        insn->opcode = opcode;
+        insn->mnemonic = info->mnemonic ? info->mnemonic : "unknown_opcode";
+        insn->arg_kind = DISASM_ARG_NONE;
+        insn->res_kind = DISASM_RES_NONE;
+        insn->length = 1;
+
+        // Bytes que o formato exige alem do opcode (switches: calculado abaixo)
+        uint32_t precisa = 0;
+        switch (info->arg_type) {
+            case U1_ARG: precisa = 1; break;
+            case U2_ARG: case OFFSET_U2: precisa = 2; break;
+            case OFFSET_U4: precisa = 4; break;
+            case WIDE_ARG: precisa = opcode == 0x84 ? 2 : 1; break;
+            default: break;
         }
+        if (precisa > code_len - pc - 1) break;   // instrucao truncada
 
         switch (info->arg_type) {
             case NO_ARGS:
                 break;
-            
+
             case U1_ARG:
-                arg_u1 = code[pc + 1];
-                sprintf(args_buffer, "#%d", arg_u1);
-                next_pc = pc + 2;
-                current_inst->length = 2;
+                insn->arg_kind = DISASM_ARG_INDEX;
+                insn->operand[0] = code[pc + 1];
+                insn->length = 2;
                 // Opcodes ldc (0x12) usam U1_ARG
-                if (opcode == 0x12) {
-                    resolved_info = resolve_literal_to_string(cf, arg_u1);
-                }
+                if (opcode == 0x12) resolver_literal(cf, code[pc + 1], insn);
                 break;
-                
+
             case U2_ARG: {
-                arg_u2 = io_read_u2_from_array(code, pc + 1);
-                sprintf(args_buffer, "#%d", arg_u2);
-                next_pc = pc + 3;
-                current_inst->length = 3;
-
-                if (opcode == 0x13) {               // ldc_w
-                    resolved_info = resolve_literal_to_string(cf, arg_u2);
-                } else if (opcode == 0x14) {        // ldc2_w (Long/Double)
-                    resolved_info = resolve_literal_to_string(cf, arg_u2);
-                } else if (opcode == 0xBB ||        // new
-                        opcode == 0xBD ||        // anewarray
-                        opcode == 0xC0 ||        // checkcast
-                        opcode == 0xC1 ||        // instanceof
-                        opcode == 0xC5) {        // multianewarray (u2 index + u1 dims)
-                    // estes usam CONSTANT_Class
-                    char *cls = resolve_class_name_to_string(cf, arg_u2);
-                    resolved_info = cls ? cls : strdup("");
+                uint16_t idx = io_read_u2_from_array(code, pc + 1);
+                insn->arg_kind = DISASM_ARG_INDEX;
+                insn->operand[0] = idx;
+                insn->length = 3;
+
+                if (opcode == 0x13 || opcode == 0x14) {     // ldc_w, ldc2_w
+                    resolver_literal(cf, idx, insn);
+                } else if (opcode == 0xBB || opcode == 0xBD || opcode == 0xC0 ||
+                           opcode == 0xC1 || opcode == 0xC5) {
+                    // new, anewarray, checkcast, instanceof, multianewarray: CONSTANT_Class
+                    resolver_classe(cf, idx, insn);
                 } else if (opcode >= 0xB2 && opcode <= 0xB8) {
                     // get/putfield/static, invoke*
-                    resolved_info = resolve_ref_to_string(cf, arg_u2);
-                } else {
-                    resolved_info = strdup(""); // neutro
+                    resolver_membro(cf, idx, insn);
                 }
                 break;
             }
 
-
-
-            case OFFSET_U2: {
-                int16_t offset = (int16_t)io_read_u2_from_array(code, pc + 1);
-                int32_t target_pc = (int32_t)pc + 3 + offset;  // relativo à próxima instrução
-                sprintf(args_buffer, "%d (to %d)", offset, target_pc);   // ← agora tudo decimal
-                next_pc = pc + 3;
-                current_inst->length = 3;
-                break;
-            }
-
+            case OFFSET_U2:
             case OFFSET_U4: {
-                int32_t offset = (int32_t)io_read_u4_from_array(code, pc + 1);
-                int64_t target_pc = (int64_t)pc + 5 + offset;
-                sprintf(args_buffer, "%d (to %d)", offset, (int32_t)target_pc);   // ← decimal
-                next_pc = pc + 5;
-                current_inst->length = 5;
+                int32_t offset = info->arg_type == OFFSET_U2 ? (int16_t)io_read_u2_from_array(code, pc + 1)
+                                                             : (int32_t)io_read_u4_from_array(code, pc + 1);
+                insn->length = info->arg_type == OFFSET_U2 ? 3 : 5;
+                insn->arg_kind = DISASM_ARG_BRANCH;
+                insn->operand[0] = offset;
+                insn->operand[1] = (int32_t)((int64_t)pc + offset);  // relativo ao proprio salto (JVMS 6.5)
                 break;
             }
 
-
-            
-            case WIDE_ARG: { // iinc e o opcode wide em si
+            case WIDE_ARG:
                 if (opcode == 0x84) { // iinc <local_index> <const_val>
-                    uint8_t index = code[pc + 1];
-                    int8_t constant = (int8_t)code[pc + 2];
-                    sprintf(args_buffer, "%d, %d", index, constant);
-                    next_pc = pc + 3;
-                    current_inst->length = 3;
-                } else if (opcode == 0xC4) { // wide (muda o proximo opcode)
-                    // Lógica para 'wide' é complexa, aqui tratamos apenas como um salto simples
-                    sprintf(args_buffer, " (prefix)");
-                    next_pc = pc + 1;
-                    current_inst->length = 1;
+                    insn->arg_kind = DISASM_ARG_IINC;
+                    insn->operand[0] = code[pc + 1];
+                    insn->operand[1] = (int8_t)code[pc + 2];
+                    insn->length = 3;
+                } else if (opcode == 0xC4) { // wide <opcode> <indice u2> [<const s2> se iinc]
+                    uint8_t modificado = code[pc + 1];
+                    uint32_t tamanho = modificado == 0x84 ? 6 : 4;
+                    if (tamanho > code_len - pc) goto truncado;
+                    insn->arg_kind = DISASM_ARG_WIDE;
+                    insn->operand[0] = modificado;
+                    insn->operand[1] = io_read_u2_from_array(code, pc + 2);
+                    insn->operand[2] = modificado == 0x84 ? (int16_t)io_read_u2_from_array(code, pc + 4) : 0;
+                    insn->length = tamanho;
                 }
                 break;
-            }
 
-            case TABLE_SWITCH: 
-            case LOOKUP_SWITCH: { // Lógica complexa de Switch (Sprint 3)
-                // 1. Calcular o PADDING para alinhar com 4 bytes
-                uint32_t pad = (4 - ((pc + 1) % 4)) % 4; 
-                uint32_t start_offset = pc + 1 + pad; // Onde default_offset comeca
-
-                // 2. Leitura do default_offset (4 bytes)
-                int32_t default_offset = (int32_t)io_read_u4_from_array(code, start_offset);
-                uint32_t current_offset = start_offset + 4;
-                
-                // 3. Leitura dos parametros e calculo do tamanho total
+            case TABLE_SWITCH:
+            case LOOKUP_SWITCH: {
+                // Padding para alinhar com 4 bytes (relativo ao inicio do codigo)
+                uint32_t inicio = pc + 1 + (4 - ((pc + 1) % 4)) % 4;
+                if (inicio > code_len || code_len - inicio < 12) goto truncado;
+
+                int32_t default_offset = (int32_t)io_read_u4_from_array(code, inicio);
+                int32_t a = (int32_t)io_read_u4_from_array(code, inicio + 4);
+                int32_t b = (int32_t)io_read_u4_from_array(code, inicio + 8);
+                uint64_t fim;
                 if (info->arg_type == TABLE_SWITCH) {
-                    int32_t low = (int32_t)io_read_u4_from_array(code, current_offset);
-                    int32_t high = (int32_t)io_read_u4_from_array(code, current_offset + 4);
-                    uint32_t size = (high - low) + 1;
-                    current_offset += 8 + (size * 4); // low + high + (size * offset)
-                    
-                    sprintf(args_buffer, " [default: %d, range: %d to %d]", default_offset, low, high);
-                } else { // LOOKUP_SWITCH
-                    int32_t npairs = (int32_t)io_read_u4_from_array(code, current_offset);
-                    current_offset += 4 + (npairs * 8); // npairs + (count * 8 bytes)
-
-                    sprintf(args_buffer, " [default: %d, npairs: %d]", default_offset, npairs);
+                    insn->arg_kind = DISASM_ARG_TABLESWITCH;
+                    fim = (uint64_t)inicio + 12 + 4 * (uint64_t)(uint32_t)(b - a + 1);
+                } else {
+                    insn->arg_kind = DISASM_ARG_LOOKUPSWITCH;
+                    fim = (uint64_t)inicio + 8 + 8 * (uint64_t)(uint32_t)a;
                 }
-                
-                current_inst->length = current_offset - pc; // Comprimento total
-                next_pc = current_offset;
+                if (fim > code_len) goto truncado;
+
+                insn->operand[0] = default_offset;
+                insn->operand[1] = a;     // low | npairs
+                insn->operand[2] = b;     // high
+                insn->length = (uint32_t)fim - pc;
                 break;
             }
-            
-            // ... (default e tratamento de opcodes desconhecidos) ...
         }
 
-        // --- FINALIZAÇÃO E PRÓXIMA INSTRUÇÃO ---
-        
-        current_inst->args_str = strdup(args_buffer);
-        current_inst->resolved_info = resolved_info ? resolved_info : strdup("");
-        
-        pc = next_pc; // Avanca para a proxima instrucao
-        inst_count++;
+        pc += insn->length;
+        count++;
+    }
+truncado:
+    out->insns = insns;
+    out->count = count;
+    return true;
+}
+
+/* ============================================================
+ * Formatacao
+ * ============================================================ */
+/* Concatena texto e inteiros sem passar pelo parser de formato do printf */
+static char *juntar(char *p, const char *texto) {
+    size_t n = strlen(texto);
+    memcpy(p, texto, n);
+    return p + n;
+}
+
+static char *juntar_int(char *p, int32_t v) {
+    return p + out_format_i64(p, v);
+}
+
+int disasm_format_args(const DisasmInsn *insn, char *buf, size_t size) {
+    char tmp[96];
+    char *p = tmp;
+    const int32_t *op = insn->operand;
+    switch (insn->arg_kind) {
+        case DISASM_ARG_INDEX:
+            p = juntar_int(juntar(p, "#"), op[0]);
+            break;
+        case DISASM_ARG_BRANCH:
+            p = juntar(juntar_int(juntar(juntar_int(p, op[0]), " (to "), op[1]), ")");
+            break;
+        case DISASM_ARG_IINC:
+            p = juntar_int(juntar(juntar_int(p, op[0]), ", "), op[1]);
+            break;
+        case DISASM_ARG_WIDE: {
+            const char *m = opcode_table[(uint8_t)op[0]].mnemonic;
+            p = juntar_int(juntar(juntar(p, m ? m : "unknown_opcode"), " "), op[1]);
+            if ((uint8_t)op[0] == 0x84) p = juntar_int(juntar(p, ", "), op[2]);
+            break;
+        }
+        case DISASM_ARG_TABLESWITCH:
+            p = juntar(juntar_int(juntar(juntar_int(juntar(juntar_int(juntar(p, " [default: "), op[0]),
+                                                           ", range: "), op[1]), " to "), op[2]), "]");
+            break;
+        case DISASM_ARG_LOOKUPSWITCH:
+            p = juntar(juntar_int(juntar(juntar_int(juntar(p, " [default: "), op[0]), ", npairs: "), op[1]), "]");
+            break;
+        default:
+            break;
     }
+    size_t n = (size_t)(p - tmp);
+    if (size > 0) {
+        size_t k = n < size ? n : size - 1;
+        memcpy(buf, tmp, k);
+        buf[k] = '\0';
+    }
+    return (int)n;
+}
 
-    output->count = inst_count;
+bool disasm_has_resolved(const DisasmInsn *insn) {
+    if (insn->res_kind == DISASM_RES_NONE) return false;
+    if (insn->res_kind == DISASM_RES_TEXT) return insn->res.view[0][0] != '\0';
     return true;
 }
-// Bloco 3: Funções de Limpeza (Se necessário)
+
+void disasm_write_resolved(OutSink *out, const DisasmInsn *insn, DisasmTextWriter write) {
+    char num[64];
+    switch (insn->res_kind) {
+        case DISASM_RES_MEMBER:
+            write(out, insn->res.view[0]);
+            write(out, ".");
+            write(out, insn->res.view[1]);
+            write(out, ":");
+            write(out, insn->res.view[2]);
+            return;
+        case DISASM_RES_TEXT:
+            write(out, insn->res.view[0]);
+            return;
+        case DISASM_RES_STRING:
+            write(out, "\"");
+            write(out, insn->res.view[0]);
+            write(out, "\"");
+            return;
+        case DISASM_RES_INT: num[out_format_i64(num, insn->res.i)] = '\0'; break;
+        case DISASM_RES_LONG: num[out_format_i64(num, insn->res.l)] = '\0'; break;
+        case DISASM_RES_FLOAT: snprintf(num, sizeof num, "%g", insn->res.f); break;
+        case DISASM_RES_DOUBLE: snprintf(num, sizeof num, "%f", insn->res.d); break;
+        case DISASM_RES_ERR_REF: snprintf(num, sizeof num, "ERRO_REF #%d", insn->operand[0]); break;
+        case DISASM_RES_ERR_CLASS: snprintf(num, sizeof num, "CLASSE_NAO_ENCONTRADA #%d", insn->operand[0]); break;
+        default: return;
+    }
+    write(out, num);
+}
+
+/* ============================================================
+ * API antiga (strings alocadas), sobre disasm_decode
+ * ============================================================ */
+static char *resolvido_alocado(const DisasmInsn *insn) {
+    OutSink out;
+    if (out_sink_open_memory(&out) != OK) return NULL;
+    disasm_write_resolved(&out, insn, out_str);
+    out_char(&out, '\0');
+    if (out.status != OK) {
+        out_sink_close(&out);
+        return NULL;
+    }
+    size_t tamanho;
+    return out_sink_take(&out, &tamanho);
+}
+
+/**
+ * @brief Desmonta o Bytecode de um metodo.
+ */
+bool disassemble_method(ClassFile *cf, CodeAttribute *code_attr, DisasmOutput *output) {
+    output->instructions = NULL;
+    output->count = 0;
+
+    DisasmArena arena;
+    DisasmMethod m;
+    disasm_arena_init(&arena);
+    if (!disasm_decode(cf, code_attr, &arena, &m)) return false;
+    if (m.count == 0) {
+        disasm_arena_free(&arena);
+        return true;
+    }
+
+    output->instructions = (DisasmInstruction *)calloc(m.count, sizeof(DisasmInstruction));
+    if (!output->instructions) {
+        disasm_arena_free(&arena);
+        return false;
+    }
+    output->count = m.count;
+
+    bool ok = true;
+    for (uint32_t i = 0; i < m.count; i++) {
+        DisasmInstruction *inst = &output->instructions[i];
+        char args[128];
+        disasm_format_args(&m.insns[i], args, sizeof args);
+        inst->pc = m.insns[i].pc;
+        inst->length = (uint8_t)m.insns[i].length;
+        inst->mnemonic = strdup(m.insns[i].mnemonic);
+        inst->args_str = strdup(args);
+        inst->resolved_info = resolvido_alocado(&m.insns[i]);
+        ok = ok && inst->mnemonic && inst->args_str && inst->resolved_info;
+    }
+    disasm_arena_free(&arena);
+    if (!ok) free_disasm_output(output);
+    return ok;
+}
 
 /**
  * @brief Libera a memória alocada pela estrutura DisasmOutput.
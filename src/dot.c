@@ -0,0 +1,135 @@
+/* --- src/dot.c --- */
+/*
+ * Saida DOT (Graphviz) do grafo de fluxo de controle dos metodos (--dot).
+ */
+
+#include "dot.h"
+#include "attributes.h"
+#include "cfg.h"
+#include "disasm.h"
+#include "resolve.h"
+#include <string.h>
+
+/* Texto dentro de um rotulo entre aspas: escapa '"' e '\' */
+static void dot_escape(OutSink *out, const char *str) {
+    const char *inicio = str;
+    for (const char *p = str; *p; p++) {
+        if (*p != '"' && *p != '\\') continue;
+        out_put(out, inicio, (size_t)(p - inicio));
+        out_char(out, '\\');
+        out_char(out, *p);
+        inicio = p + 1;
+    }
+    out_str(out, inicio);
+}
+
+/* Identificador do no: m<metodo>_b<bloco> */
+static void dot_no(OutSink *out, u2 metodo, uint32_t bloco) {
+    out_char(out, 'm');
+    out_u32(out, metodo);
+    out_str(out, "_b");
+    out_u32(out, bloco);
+}
+
+static const AttributeInfo *atributo_code(const ClassFile *cf, const MethodInfo *m) {
+    for (u2 i = 0; i < m->attributes_count; i++) {
+        const char *nome = cp_utf8(cf->constant_pool, cf->constant_pool_count, m->attributes[i].attribute_name_index);
+        if (nome && strcmp(nome, "Code") == 0) return &m->attributes[i];
+    }
+    return NULL;
+}
+
+/* Rotulo do bloco: "B3 [10, 24)" e, sem --no-code, uma linha por instrucao */
+static void dot_rotulo(OutSink *out, const Cfg *cfg, const DisasmMethod *dm, uint32_t k, bool codigo) {
+    const CfgBlock *b = &cfg->blocks[k];
+    char args[64];
+    out_str(out, "label=\"B");
+    out_u32(out, k);
+    out_str(out, " [");
+    out_u32(out, b->start_pc);
+    out_str(out, ", ");
+    out_u32(out, b->end_pc);
+    out_str(out, ")\\l");
+    for (uint32_t i = 0; codigo && i < b->insn_count; i++) {
+        const DisasmInsn *insn = &dm->insns[b->first_insn + i];
+        out_u32(out, insn->pc);
+        out_str(out, ": ");
+        out_str(out, insn->mnemonic);
+        if (disasm_format_args(insn, args, sizeof args) > 0) {
+            out_char(out, ' ');
+            dot_escape(out, args);
+        }
+        if (disasm_has_resolved(insn)) {
+            out_str(out, " // ");
+            disasm_write_resolved(out, insn, dot_escape);
+        }
+        out_str(out, "\\l");
+    }
+    out_char(out, '"');
+}
+
+static void dot_metodo(OutSink *out, ClassFile *cf, u2 indice, const CliOptions *options, DisasmArena *arena,
+                       Cfg *cfg) {
+    const MethodInfo *m = &cf->methods[indice];
+    const AttributeInfo *raw = atributo_code(cf, m);
+    if (!raw) return;   // abstrato/nativo: sem grafo
+
+    CodeAttribute code;
+    memset(&code, 0, sizeof code);
+    DisasmMethod dm;
+    if (parse_code_attribute(cf, raw, &code) != OK) return;   // nada alocado
+    if (!disasm_decode(cf, &code, arena, &dm) || cfg_build(cfg, &dm, &code) != OK) {
+        free_code_attribute(&code);
+        return;
+    }
+
+    out_str(out, "  subgraph cluster_m");
+    out_u32(out, indice);
+    out_str(out, " {\n    label=\"");
+    dot_escape(out, resolve_literal(cf, m->name_index));
+    dot_escape(out, resolve_literal(cf, m->descriptor_index));
+    out_str(out, "\";\n");
+
+    for (uint32_t k = 0; k < cfg->block_count; k++) {
+        const CfgBlock *b = &cfg->blocks[k];
+        out_str(out, "    ");
+        dot_no(out, indice, k);
+        out_str(out, " [");
+        dot_rotulo(out, cfg, &dm, k, options->disassemble_code);
+        if (b->flags & CFG_BLOCK_LOOP_HEADER) out_str(out, ", style=bold");
+        else if (!(b->flags & CFG_BLOCK_REACHABLE)) out_str(out, ", style=dotted");
+        if (b->flags & CFG_BLOCK_HANDLER) out_str(out, ", peripheries=2");
+        out_str(out, "];\n");
+    }
+    for (uint32_t e = 0; e < cfg->edge_count; e++) {
+        const CfgEdge *a = &cfg->edges[e];
+        out_str(out, "    ");
+        dot_no(out, indice, a->from);
+        out_str(out, " -> ");
+        dot_no(out, indice, a->to);
+        if (a->kind == CFG_EDGE_EXCEPTION) out_str(out, " [style=dashed]");
+        else if (a->kind == CFG_EDGE_BRANCH || a->kind == CFG_EDGE_SWITCH) out_str(out, " [color=blue]");
+        out_str(out, ";\n");
+    }
+    out_str(out, "  }\n");
+    free_code_attribute(&code);
+}
+
+Status dot_classfile(OutSink *out, ClassFile *cf, const CliOptions *options) {
+    out_str(out, "digraph \"");
+    dot_escape(out, resolve_class_name(cf, cf->this_class));
+    out_str(out, "\" {\n  node [shape=box, fontname=\"monospace\"];\n");
+
+    if (options->print_methods) {
+        DisasmArena arena;      // reaproveitados entre os metodos da classe
+        Cfg cfg;
+        disasm_arena_init(&arena);
+        cfg_init(&cfg);
+        for (u2 i = 0; i < cf->methods_count; i++) dot_metodo(out, cf, i, options, &arena, &cfg);
+        disasm_arena_free(&arena);
+        cfg_free(&cfg);
+    }
+
+    out_str(out, "}\n");
+    return out->status;
+}
@@ -5,6 +5,13 @@
 #include "attributes.h"
 #include "resolve.h"
 #include "heap_manager.h"
+#include "member_index.h"
+#include "cp_cache.h"
+#include "class_registry.h"
+#include "jit.h"
+#include "regvm.h"
+#include "vectorize.h"
+#include "peephole.h"
 
 // Declaração da função do classfile.c
 extern const char *cp_utf8(const CpInfo *cp, u2 cp_count, u2 idx);
@@ -17,26 +24,125 @@ extern const char *cp_utf8(const CpInfo *cp, u2 cp_count, u2 idx);
 
 /**
  * @brief Busca um método no ClassFile pelo nome e descritor.
+ *
+ * Usa o indice hash da classe (member_index.h): O(1) em vez de
+ * varrer methods[] com dois strcmp por entrada.
  */
 static MethodInfo* find_method(ClassFile *class_file, const char *name, const char *descriptor) {
-    for (u2 i = 0; i < class_file->methods_count; i++) {
-        MethodInfo *method = &class_file->methods[i];
-        
-        // Obtém nome e descritor do método
-        const char *method_name = cp_utf8(class_file->constant_pool, 
-                                         class_file->constant_pool_count, 
-                                         method->name_index);
-        const char *method_desc = cp_utf8(class_file->constant_pool, 
-                                         class_file->constant_pool_count, 
-                                         method->descriptor_index);
-        
-        if (method_name && method_desc && 
-            strcmp(method_name, name) == 0 && 
-            strcmp(method_desc, descriptor) == 0) {
-            return method;
+    return member_index_find_method(class_file, name, descriptor);
+}
+
+/*
+ * ====================================================================
+ * INVOCAÇÃO DE MÉTODOS
+ * ====================================================================
+ * Operandos de CP (invoke*, get/putfield, get/putstatic, new, ldc) sao
+ * resolvidos uma vez pelo cp_cache (cp_cache.h); nas execucoes seguintes
+ * a instrucao so le cf->resolved[index].
+ */
+
+// Limite de frames aninhados (StackOverflowError)
+#define MAX_PROFUNDIDADE EXECUTE_MAX_DEPTH
+
+static int profundidade_chamadas = 0;
+static long instrucoes_executadas = 0;
+static int execucao_interrompida = 0;   // proteção do modo debug contra loops
+
+static u2 ler_indice(const Frame *frame) {
+    return (u2)((*(frame->pc + 1) << 8) | *(frame->pc + 2));
+}
+
+static int executar_metodo(ClassFile *cf, MethodInfo *method, const Slot *args, u2 nargs,
+                           Frame *caller, const CliOptions *options, Slot *ret, u1 ret_slots);
+
+/**
+ * @brief Executa <clinit> da classe (e das superclasses) na primeira vez.
+ */
+static int inicializar_classe(ClassFile *cls, Frame *caller, const CliOptions *options) {
+    if (!cls || !cp_cache_begin_init(cls)) return 0;
+
+    ClassFile *super = cp_cache_super(cls);
+    if (super && inicializar_classe(super, caller, options) < 0) return -1;
+
+    MethodInfo *clinit = find_method(cls, "<clinit>", "()V");
+    if (!clinit) return 0;
+    if (options->execution_mode == MODE_DEBUG) {
+        printf("[DEBUG] <clinit> de %s\n", classfile_this_name(cls));
+    }
+    int status = executar_metodo(cls, clinit, NULL, 0, caller, options, NULL, 0);
+    return status < 0 ? status : 0;
+}
+
+/**
+ * @brief Desempilha argumentos (nslots, com 'this') e chama o alvo resolvido.
+ *
+ * Alvo fora do classpath e sem implementação nativa: só o efeito na pilha
+ * (argumentos consumidos, retorno zero).
+ */
+static int invocar(Frame *frame, const CliOptions *options, const ResolvedEntry *e,
+                   ClassFile *cls, MethodInfo *method, u2 nslots) {
+    // Código verificado: a pilha tem os nslots do descritor
+    frame->stack_top -= nslots;
+
+    Slot ret[2] = { 0, 0 };
+    int status = 0;
+    if (e->kind == RESOLVED_NATIVE) {
+        status = e->u.native(frame->stack_top, ret);
+    } else if (method) {
+        status = executar_metodo(cls, method, frame->stack_top, nslots, frame, options, ret, e->ret_slots);
+    }
+    if (status < 0) return status;
+
+    for (u1 i = 0; i < e->ret_slots; i++) {
+        *frame->stack_top = ret[i];
+        frame->stack_top++;
+    }
+    frame->pc += (*frame->pc == 0xB9) ? 5 : 3;
+    return 0;
+}
+
+static const char *descrever_resolucao(const ResolvedEntry *e) {
+    switch (e->kind) {
+    case RESOLVED_METHOD: return "bytecode";
+    case RESOLVED_NATIVE: return "nativo";
+    default: return "indisponível - só efeito na pilha";
+    }
+}
+
+/**
+ * @brief invokevirtual/invokeinterface: despacho pela classe real do receptor.
+ */
+static int invocar_virtual(Frame *frame, const CliOptions *options, const char *nome_op) {
+    u2 index = ler_indice(frame);
+    const ResolvedEntry *e = cp_resolved(frame->class_file, index);
+    if (!e) {
+        fprintf(stderr, "Erro: %s com índice de CP inválido #%d\n", nome_op, index);
+        return -1;
+    }
+    if (options->execution_mode == MODE_DEBUG) {
+        printf("[DEBUG] %s #%d (%s)\n", nome_op, index, descrever_resolucao(e));
+    }
+
+    u2 nslots = (u2)(e->arg_slots + 1);
+    ClassFile *cls = e->cls;
+    MethodInfo *method = e->kind == RESOLVED_METHOD ? e->u.method : NULL;
+    if (method) {
+        ObjectRef receptor = jvm_heap_deref(*(frame->stack_top - nslots));
+        if (!receptor) {
+            fprintf(stderr, "Erro: NullPointerException em %s\n", nome_op);
+            return -1;
+        }
+        // Sem sobrescrita entre as classes carregadas (CHA): o alvo é o resolvido
+        ClassFile *real = receptor->class_info;
+        if (real && real != cls && cp_cache_overridden(cls, method)) {
+            const char *nome = cp_utf8(cls->constant_pool, cls->constant_pool_count, method->name_index);
+            const char *desc = cp_utf8(cls->constant_pool, cls->constant_pool_count, method->descriptor_index);
+            MethodInfo *alvo = cp_cache_find_virtual(real, nome, desc, &cls);
+            if (alvo) method = alvo;
+            else cls = e->cls;
         }
     }
-    return NULL;
+    return invocar(frame, options, e, cls, method, nslots);
 }
 
 /*
@@ -158,14 +264,22 @@ static int handle_sipush(Frame *frame, const CliOptions *options) {
     return 0;
 }
 
-// 0x12: LDC - Empilha constante do pool (simplificado)
+// 0x12: LDC - Empilha constante do pool (int, float ou String)
 static int handle_ldc(Frame *frame, const CliOptions *options) {
     u1 index = *(frame->pc + 1);
+    const ResolvedEntry *e = cp_resolved(frame->class_file, index);
+
+    Slot value = 0;
+    if (e && e->kind == RESOLVED_STRING) {
+        value = jvm_heap_ref(e->u.string);
+    } else if (e && e->kind == RESOLVED_CONSTANT) {
+        value = e->u.value;
+    }
     if (options->execution_mode == MODE_DEBUG) {
-        printf("[DEBUG] LDC #%d (stub - empilha 0)\n", index);
+        printf("[DEBUG] LDC #%d\n", index);
     }
-    // Simplificação: empilha 0
-    *frame->stack_top = 0;
+
+    *frame->stack_top = value;
     frame->stack_top++;
     frame->pc += 2;
     return 0;
@@ -216,6 +330,51 @@ static int handle_iload_3(Frame *frame, const CliOptions *options) {
     return 0;
 }
 
+// 0x19: ALOAD - Carrega referência de variável local (com índice)
+static int handle_aload(Frame *frame, const CliOptions *options) {
+    u1 index = *(frame->pc + 1);
+    if (options->execution_mode == MODE_DEBUG) {
+        printf("[DEBUG] ALOAD %d\n", index);
+    }
+    *frame->stack_top = frame->local_vars[index];
+    frame->stack_top++;
+    frame->pc += 2;
+    return 0;
+}
+
+// 0x2A-0x2D: ALOAD_<n> - Carrega referência de variável local
+static int handle_aload_0(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] ALOAD_0\n");
+    *frame->stack_top = frame->local_vars[0];
+    frame->stack_top++;
+    frame->pc += 1;
+    return 0;
+}
+
+static int handle_aload_1(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] ALOAD_1\n");
+    *frame->stack_top = frame->local_vars[1];
+    frame->stack_top++;
+    frame->pc += 1;
+    return 0;
+}
+
+static int handle_aload_2(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] ALOAD_2\n");
+    *frame->stack_top = frame->local_vars[2];
+    frame->stack_top++;
+    frame->pc += 1;
+    return 0;
+}
+
+static int handle_aload_3(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] ALOAD_3\n");
+    *frame->stack_top = frame->local_vars[3];
+    frame->stack_top++;
+    frame->pc += 1;
+    return 0;
+}
+
 // 0x36: ISTORE - Armazena int em variável local (com índice)
 static int handle_istore(Frame *frame, const CliOptions *options) {
     u1 index = *(frame->pc + 1);
@@ -261,6 +420,51 @@ static int handle_istore_3(Frame *frame, const CliOptions *options) {
     return 0;
 }
 
+// 0x3A: ASTORE - Armazena referência em variável local (com índice)
+static int handle_astore(Frame *frame, const CliOptions *options) {
+    u1 index = *(frame->pc + 1);
+    if (options->execution_mode == MODE_DEBUG) {
+        printf("[DEBUG] ASTORE %d\n", index);
+    }
+    frame->stack_top--;
+    frame->local_vars[index] = *frame->stack_top;
+    frame->pc += 2;
+    return 0;
+}
+
+// 0x4B-0x4E: ASTORE_<n> - Armazena referência em variável local
+static int handle_astore_0(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] ASTORE_0\n");
+    frame->stack_top--;
+    frame->local_vars[0] = *frame->stack_top;
+    frame->pc += 1;
+    return 0;
+}
+
+static int handle_astore_1(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] ASTORE_1\n");
+    frame->stack_top--;
+    frame->local_vars[1] = *frame->stack_top;
+    frame->pc += 1;
+    return 0;
+}
+
+static int handle_astore_2(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] ASTORE_2\n");
+    frame->stack_top--;
+    frame->local_vars[2] = *frame->stack_top;
+    frame->pc += 1;
+    return 0;
+}
+
+static int handle_astore_3(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] ASTORE_3\n");
+    frame->stack_top--;
+    frame->local_vars[3] = *frame->stack_top;
+    frame->pc += 1;
+    return 0;
+}
+
 // 0x57: POP - Remove topo da pilha
 static int handle_pop(Frame *frame, const CliOptions *options) {
     if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] POP\n");
@@ -331,7 +535,8 @@ static int handle_idiv(Frame *frame, const CliOptions *options) {
         return -1;
     }
     
-    *frame->stack_top = (Slot)(value1 / value2);
+    // INT_MIN / -1 transborda (SIGFPE no idiv do x86); em Java dá INT_MIN
+    *frame->stack_top = value2 == -1 ? 0u - (Slot)value1 : (Slot)(value1 / value2);
     frame->stack_top++;
     frame->pc += 1;
     return 0;
@@ -350,7 +555,8 @@ static int handle_irem(Frame *frame, const CliOptions *options) {
         return -1;
     }
     
-    *frame->stack_top = (Slot)(value1 % value2);
+    // INT_MIN % -1: idem, resto 0
+    *frame->stack_top = value2 == -1 ? 0u : (Slot)(value1 % value2);
     frame->stack_top++;
     frame->pc += 1;
     return 0;
@@ -361,7 +567,7 @@ static int handle_ineg(Frame *frame, const CliOptions *options) {
     if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] INEG\n");
     frame->stack_top--;
     int32_t value = (int32_t)*frame->stack_top;
-    *frame->stack_top = (Slot)(-value);
+    *frame->stack_top = 0u - (Slot)value;
     frame->stack_top++;
     frame->pc += 1;
     return 0;
@@ -585,9 +791,9 @@ static int handle_goto(Frame *frame, const CliOptions *options) {
 
 // 0xAC: IRETURN - Retorna int
 static int handle_ireturn(Frame *frame, const CliOptions *options) {
+    // O valor fica no topo: executar_metodo o repassa ao chamador
     if (options->execution_mode == MODE_DEBUG) {
-        frame->stack_top--;
-        int32_t return_value = (int32_t)*frame->stack_top;
+        int32_t return_value = (int32_t)*(frame->stack_top - 1);
         printf("[DEBUG] IRETURN %d\n", return_value);
     }
     return 1; // Sinaliza return
@@ -601,64 +807,88 @@ static int handle_return(Frame *frame, const CliOptions *options) {
     return 1; // Sinaliza return
 }
 
-// 0xB2: GETSTATIC - Obtém campo estático (simplificado)
+// 0xB2: GETSTATIC - Obtém campo estático
 static int handle_getstatic(Frame *frame, const CliOptions *options) {
-    u2 index = (u2)((*(frame->pc + 1) << 8) | *(frame->pc + 2));
+    u2 index = ler_indice(frame);
+    const ResolvedEntry *e = cp_resolved(frame->class_file, index);
+    if (!e) {
+        fprintf(stderr, "Erro: GETSTATIC com índice de CP inválido #%d\n", index);
+        return -1;
+    }
     if (options->execution_mode == MODE_DEBUG) {
-        printf("[DEBUG] GETSTATIC #%d (stub)\n", index);
+        printf("[DEBUG] GETSTATIC #%d%s\n", index, e->kind == RESOLVED_STATIC ? "" : " (indisponível - empilha 0)");
+    }
+
+    if (e->kind == RESOLVED_STATIC && inicializar_classe(e->cls, frame, options) < 0) return -1;
+    for (u2 i = 0; i < e->field_slots; i++) {
+        *frame->stack_top = (e->kind == RESOLVED_STATIC) ? e->u.static_slot[i] : 0;
+        frame->stack_top++;
     }
-    // Simplificação: empilha 0
-    *frame->stack_top = 0;
-    frame->stack_top++;
     frame->pc += 3;
     return 0;
 }
 
-// 0xB3: PUTSTATIC - Define campo estático (simplificado)
+// 0xB3: PUTSTATIC - Define campo estático
 static int handle_putstatic(Frame *frame, const CliOptions *options) {
-    u2 index = (u2)((*(frame->pc + 1) << 8) | *(frame->pc + 2));
+    u2 index = ler_indice(frame);
+    const ResolvedEntry *e = cp_resolved(frame->class_file, index);
+    if (!e) {
+        fprintf(stderr, "Erro: PUTSTATIC com índice de CP inválido #%d\n", index);
+        return -1;
+    }
     if (options->execution_mode == MODE_DEBUG) {
-        printf("[DEBUG] PUTSTATIC #%d (stub)\n", index);
+        printf("[DEBUG] PUTSTATIC #%d%s\n", index, e->kind == RESOLVED_STATIC ? "" : " (indisponível - descarta)");
+    }
+
+    if (e->kind == RESOLVED_STATIC && inicializar_classe(e->cls, frame, options) < 0) return -1;
+    frame->stack_top -= e->field_slots;
+    if (e->kind == RESOLVED_STATIC) {
+        for (u2 i = 0; i < e->field_slots; i++) e->u.static_slot[i] = frame->stack_top[i];
     }
-    // Simplificação: remove topo da pilha
-    frame->stack_top--;
     frame->pc += 3;
     return 0;
 }
 
-// 0xB6: INVOKEVIRTUAL - Invoca método de instância (simplificado)
+// 0xB6: INVOKEVIRTUAL - Invoca método de instância
 static int handle_invokevirtual(Frame *frame, const CliOptions *options) {
-    u2 index = (u2)((*(frame->pc + 1) << 8) | *(frame->pc + 2));
-    if (options->execution_mode == MODE_DEBUG) {
-        printf("[DEBUG] INVOKEVIRTUAL #%d (stub - método não executado)\n", index);
-    }
-    // Simplificação: remove referência do objeto
-    frame->stack_top--;
-    frame->pc += 3;
-    return 0;
+    return invocar_virtual(frame, options, "INVOKEVIRTUAL");
 }
 
-// 0xB7: INVOKESPECIAL - Invoca método de inicialização (simplificado)
+// 0xB9: INVOKEINTERFACE - Invoca método de interface
+static int handle_invokeinterface(Frame *frame, const CliOptions *options) {
+    return invocar_virtual(frame, options, "INVOKEINTERFACE");
+}
+
+// 0xB7: INVOKESPECIAL - Construtores, métodos privados e super.metodo()
 static int handle_invokespecial(Frame *frame, const CliOptions *options) {
-    u2 index = (u2)((*(frame->pc + 1) << 8) | *(frame->pc + 2));
+    u2 index = ler_indice(frame);
+    const ResolvedEntry *e = cp_resolved(frame->class_file, index);
+    if (!e) {
+        fprintf(stderr, "Erro: INVOKESPECIAL com índice de CP inválido #%d\n", index);
+        return -1;
+    }
     if (options->execution_mode == MODE_DEBUG) {
-        printf("[DEBUG] INVOKESPECIAL #%d (stub - construtor/método não executado)\n", index);
+        printf("[DEBUG] INVOKESPECIAL #%d (%s)\n", index, descrever_resolucao(e));
     }
-    // Simplificação: remove referência do objeto
-    frame->stack_top--;
-    frame->pc += 3;
-    return 0;
+    // Sem despacho virtual: o alvo é exatamente o resolvido
+    MethodInfo *method = e->kind == RESOLVED_METHOD ? e->u.method : NULL;
+    return invocar(frame, options, e, e->cls, method, (u2)(e->arg_slots + 1));
 }
 
-// 0xB8: INVOKESTATIC - Invoca método estático (simplificado)
+// 0xB8: INVOKESTATIC - Invoca método estático
 static int handle_invokestatic(Frame *frame, const CliOptions *options) {
-    u2 index = (u2)((*(frame->pc + 1) << 8) | *(frame->pc + 2));
+    u2 index = ler_indice(frame);
+    const ResolvedEntry *e = cp_resolved(frame->class_file, index);
+    if (!e) {
+        fprintf(stderr, "Erro: INVOKESTATIC com índice de CP inválido #%d\n", index);
+        return -1;
+    }
     if (options->execution_mode == MODE_DEBUG) {
-        printf("[DEBUG] INVOKESTATIC #%d (stub - método não executado)\n", index);
+        printf("[DEBUG] INVOKESTATIC #%d (%s)\n", index, descrever_resolucao(e));
     }
-    // Simplificação: não executa o método
-    frame->pc += 3;
-    return 0;
+    MethodInfo *method = e->kind == RESOLVED_METHOD ? e->u.method : NULL;
+    if (method && inicializar_classe(e->cls, frame, options) < 0) return -1;
+    return invocar(frame, options, e, e->cls, method, e->arg_slots);
 }
 
 // 0xAA: TABLESWITCH - Switch com tabela de saltos
@@ -666,8 +896,8 @@ static int handle_tableswitch(Frame *frame, const CliOptions *options) {
     u1 *start_pc = frame->pc;
     frame->pc++; // Pula o opcode
     
-    // Alinhamento: padding para múltiplo de 4
-    while (((frame->pc - start_pc) % 4) != 0) {
+    // Alinhamento: padding até múltiplo de 4 a partir do início do bytecode
+    while (((frame->pc - frame->code) % 4) != 0) {
         frame->pc++;
     }
     
@@ -739,11 +969,20 @@ static int handle_new(Frame *frame, const CliOptions *options) {
         printf("[DEBUG] NEW #%d\n", index);
     }
     
-    // Simplificação: cria objeto com 10 campos (ajustar conforme necessário)
-    ObjectRef obj = jvm_heap_new_object(frame->class_file, 10);
+    // Classe resolvida: layout real (inclui campos das superclasses).
+    // Fora do classpath: 10 campos, como antes.
+    ClassFile *cls = frame->class_file;
+    size_t field_count = 10;
+    const ResolvedEntry *e = cp_resolved(frame->class_file, index);
+    if (e && e->kind == RESOLVED_CLASS) {
+        if (inicializar_classe(e->cls, frame, options) < 0) return -1;
+        cls = e->cls;
+        field_count = cp_cache_instance_slots(cls);
+    }
+    ObjectRef obj = jvm_heap_new_object(cls, field_count);
     
     // Empilha a referência do objeto
-    *frame->stack_top = (StackValue)(uintptr_t)obj;
+    *frame->stack_top = jvm_heap_ref(obj);
     frame->stack_top++;
     
     frame->pc += 3;
@@ -771,20 +1010,75 @@ static int handle_newarray(Frame *frame, const CliOptions *options) {
     ObjectRef array = jvm_heap_new_array(atype, (u4)count);
     
     // Empilha a referência do array
-    *frame->stack_top = (StackValue)(uintptr_t)array;
+    *frame->stack_top = jvm_heap_ref(array);
     frame->stack_top++;
     
     frame->pc += 2;
     return 0;
 }
 
+/**
+ * @brief Array de inteiros (newarray) e índice conferidos para iaload/iastore.
+ *
+ * @return Os elementos, ou NULL depois de reportar o erro.
+ */
+static StackValue *elemento_array(Slot ref, int32_t indice, const char *nome_op) {
+    Array *array = (Array *)(void *)jvm_heap_deref(ref);
+    if (!array) {
+        fprintf(stderr, "Erro: NullPointerException em %s\n", nome_op);
+        return NULL;
+    }
+    if (indice < 0 || (u4)indice >= array->length) {
+        fprintf(stderr, "Erro: ArrayIndexOutOfBoundsException em %s: índice %d, tamanho %u\n", nome_op, indice,
+                array->length);
+        return NULL;
+    }
+    return &array->data[indice];
+}
+
+// 0x2E: IALOAD - Lê um elemento de int[]
+static int handle_iaload(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] IALOAD\n");
+    frame->stack_top -= 2;
+    StackValue *elemento = elemento_array(frame->stack_top[0], (int32_t)frame->stack_top[1], "IALOAD");
+    if (!elemento) return -1;
+    *frame->stack_top = *elemento;
+    frame->stack_top++;
+    frame->pc += 1;
+    return 0;
+}
+
+// 0x4F: IASTORE - Grava um elemento de int[]
+static int handle_iastore(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] IASTORE\n");
+    frame->stack_top -= 3;
+    StackValue *elemento = elemento_array(frame->stack_top[0], (int32_t)frame->stack_top[1], "IASTORE");
+    if (!elemento) return -1;
+    *elemento = frame->stack_top[2];
+    frame->pc += 1;
+    return 0;
+}
+
+// 0xBE: ARRAYLENGTH - Tamanho do array
+static int handle_arraylength(Frame *frame, const CliOptions *options) {
+    if (options->execution_mode == MODE_DEBUG) printf("[DEBUG] ARRAYLENGTH\n");
+    Array *array = (Array *)(void *)jvm_heap_deref(*(frame->stack_top - 1));
+    if (!array) {
+        fprintf(stderr, "Erro: NullPointerException em ARRAYLENGTH\n");
+        return -1;
+    }
+    *(frame->stack_top - 1) = array->length;
+    frame->pc += 1;
+    return 0;
+}
+
 // 0xB4: GETFIELD - Obtém campo de objeto
 static int handle_getfield(Frame *frame, const CliOptions *options) {
     u2 index = (u2)((*(frame->pc + 1) << 8) | *(frame->pc + 2));
     
     // Desempilha a referência do objeto
     frame->stack_top--;
-    ObjectRef obj = (ObjectRef)(uintptr_t)*frame->stack_top;
+    ObjectRef obj = jvm_heap_deref(*frame->stack_top);
     
     if (options->execution_mode == MODE_DEBUG) {
         printf("[DEBUG] GETFIELD #%d\n", index);
@@ -795,13 +1089,17 @@ static int handle_getfield(Frame *frame, const CliOptions *options) {
         return -1;
     }
     
-    // Simplificação: usa index % 10 como offset
-    u4 offset = index % 10;
-    StackValue value = jvm_heap_getfield(obj, offset);
-    
-    // Empilha o valor
-    *frame->stack_top = value;
-    frame->stack_top++;
+    // Offset resolvido; campo fora do classpath: index % 10 (objeto de 10 campos)
+    const ResolvedEntry *e = cp_resolved(frame->class_file, index);
+    if (e && e->kind == RESOLVED_FIELD) {
+        for (u2 i = 0; i < e->field_slots; i++) {
+            *frame->stack_top = jvm_heap_getfield(obj, e->u.offset + i);
+            frame->stack_top++;
+        }
+    } else {
+        *frame->stack_top = jvm_heap_getfield(obj, index % 10);
+        frame->stack_top++;
+    }
     
     frame->pc += 3;
     return 0;
@@ -817,7 +1115,7 @@ static int handle_putfield(Frame *frame, const CliOptions *options) {
     
     // Desempilha a referência do objeto
     frame->stack_top--;
-    ObjectRef obj = (ObjectRef)(uintptr_t)*frame->stack_top;
+    ObjectRef obj = jvm_heap_deref(*frame->stack_top);
     
     if (options->execution_mode == MODE_DEBUG) {
         printf("[DEBUG] PUTFIELD #%d\n", index);
@@ -828,8 +1126,9 @@ static int handle_putfield(Frame *frame, const CliOptions *options) {
         return -1;
     }
     
-    // Simplificação: usa index % 10 como offset
-    u4 offset = index % 10;
+    // Offset resolvido; campo fora do classpath: index % 10 (objeto de 10 campos)
+    const ResolvedEntry *e = cp_resolved(frame->class_file, index);
+    u4 offset = (e && e->kind == RESOLVED_FIELD) ? e->u.offset : index % 10;
     jvm_heap_putfield(obj, offset, value);
     
     frame->pc += 3;
@@ -839,8 +1138,7 @@ static int handle_putfield(Frame *frame, const CliOptions *options) {
 // 0xB0: ARETURN - Retorna referência de objeto
 static int handle_areturn(Frame *frame, const CliOptions *options) {
     if (options->execution_mode == MODE_DEBUG) {
-        frame->stack_top--;
-        ObjectRef return_value = (ObjectRef)(uintptr_t)*frame->stack_top;
+        ObjectRef return_value = jvm_heap_deref(*(frame->stack_top - 1));
         printf("[DEBUG] ARETURN (object reference: %p)\n", (void*)return_value);
     }
     return 1; // Sinaliza return
@@ -885,11 +1183,23 @@ void init_opcode_handlers() {
     opcode_handlers[0x1B] = handle_iload_1;
     opcode_handlers[0x1C] = handle_iload_2;
     opcode_handlers[0x1D] = handle_iload_3;
+    opcode_handlers[0x19] = handle_aload;
+    opcode_handlers[0x2A] = handle_aload_0;
+    opcode_handlers[0x2B] = handle_aload_1;
+    opcode_handlers[0x2C] = handle_aload_2;
+    opcode_handlers[0x2D] = handle_aload_3;
+    opcode_handlers[0x2E] = handle_iaload;
     opcode_handlers[0x36] = handle_istore;
     opcode_handlers[0x3B] = handle_istore_0;
     opcode_handlers[0x3C] = handle_istore_1;
     opcode_handlers[0x3D] = handle_istore_2;
     opcode_handlers[0x3E] = handle_istore_3;
+    opcode_handlers[0x3A] = handle_astore;
+    opcode_handlers[0x4B] = handle_astore_0;
+    opcode_handlers[0x4C] = handle_astore_1;
+    opcode_handlers[0x4D] = handle_astore_2;
+    opcode_handlers[0x4E] = handle_astore_3;
+    opcode_handlers[0x4F] = handle_iastore;
     opcode_handlers[0x57] = handle_pop;
     opcode_handlers[0x59] = handle_dup;
     opcode_handlers[0x60] = handle_iadd;
@@ -923,8 +1233,10 @@ void init_opcode_handlers() {
     opcode_handlers[0xB6] = handle_invokevirtual;
     opcode_handlers[0xB7] = handle_invokespecial;
     opcode_handlers[0xB8] = handle_invokestatic;
+    opcode_handlers[0xB9] = handle_invokeinterface;
     opcode_handlers[0xBB] = handle_new;
     opcode_handlers[0xBC] = handle_newarray;
+    opcode_handlers[0xBE] = handle_arraylength;
 }
 
 /*
@@ -933,15 +1245,188 @@ void init_opcode_handlers() {
  * ====================================================================
  */
 
+/**
+ * @brief Executa o Frame já preparado a partir de frame->pc.
+ *
+ * Com nativo (--jit), o código compilado roda primeiro; se ele devolver
+ * JIT_INTERPRET, o laço de despacho continua de onde o Frame parou. Com
+ * --regvm, o método roda no interpretador de registradores (regvm.h) até
+ * ele devolver REGVM_INTERPRET. Com --jit, cada salto para trás
+ * interpretado conta para o OSR do laço.
+ */
+static int executar_frame(Frame *frame, const CliOptions *options, JitFunction nativo) {
+    const bool osr = options->jit && options->execution_mode != MODE_DEBUG;
+    profundidade_chamadas++;
+    int status = 0;
+    if (nativo) {
+        status = jit_execute(nativo, frame, options);
+        if (status == JIT_INTERPRET) status = 0;
+    }
+    if (status == 0 && options->regvm && options->execution_mode != MODE_DEBUG) {
+        status = regvm_execute(frame, options);
+        if (status == REGVM_INTERPRET) status = 0;
+    }
+    // Sem checagem de pc/pilha por instrução: o verificador já provou os limites
+    while (status == 0 && !execucao_interrompida) {
+        // Lê o opcode atual
+        u1 opcode = *frame->pc;
+
+        if (options->execution_mode == MODE_DEBUG) {
+            printf("[DEBUG] [PC=%ld] Opcode: 0x%02X | Stack depth: %ld\n",
+                   (long)(frame->pc - frame->code),
+                   opcode,
+                   (long)(frame->stack_top - frame->operand_stack));
+        }
+
+        // Obtém o handler da Dispatch Table e executa
+        const u1 *antes = frame->pc;
+        status = opcode_handlers[opcode](frame, options);
+        instrucoes_executadas++;
+
+        // Salto para trás: laço quente continua no código compilado (OSR)
+        if (osr && status == 0 && frame->pc <= antes) {
+            JitFunction entrada = jit_on_backedge(frame);
+            if (entrada) {
+                status = jit_execute(entrada, frame, options);
+                if (status == JIT_INTERPRET) status = 0;
+            }
+        }
+
+        // Proteção contra loops infinitos em modo debug
+        if (options->execution_mode == MODE_DEBUG && instrucoes_executadas > 100000) {
+            fprintf(stderr, "\n[DEBUG] AVISO: Executadas mais de 100.000 instruções. Possível loop infinito.\n");
+            execucao_interrompida = 1;
+        }
+    }
+    profundidade_chamadas--;
+    return status;
+}
+
+/**
+ * @brief Executa um método em um Frame novo (um nível da Call Stack).
+ *
+ * Os argumentos (com 'this', se houver) viram as primeiras variáveis
+ * locais. No return, os ret_slots do topo da pilha são copiados em ret.
+ *
+ * @return 1 (return), 0 (fim do código) ou negativo em erro.
+ */
+static int executar_metodo(ClassFile *cf, MethodInfo *method, const Slot *args, u2 nargs,
+                           Frame *caller, const CliOptions *options, Slot *ret, u1 ret_slots) {
+    const CodeAttribute *code_attr = cp_cache_code(cf, method);
+    if (!code_attr) {
+        fprintf(stderr, "Erro: sem Code ou rejeitado pelo verificador: %s.%s\n", classfile_this_name(cf),
+                cp_utf8(cf->constant_pool, cf->constant_pool_count, method->name_index));
+        return -1;
+    }
+    if (profundidade_chamadas >= MAX_PROFUNDIDADE) {
+        fprintf(stderr, "Erro: StackOverflowError (mais de %d frames).\n", MAX_PROFUNDIDADE);
+        return -1;
+    }
+
+    Frame *frame = frame_new(cf, method, code_attr->max_locals, code_attr->max_stack);
+    if (!frame) {
+        fprintf(stderr, "Erro: Falha ao criar o Frame de Execução.\n");
+        return -1;
+    }
+    if (nargs > code_attr->max_locals) nargs = code_attr->max_locals;
+    if (nargs) memcpy(frame->local_vars, args, nargs * sizeof(Slot));
+    frame->next = caller;
+    frame->code = code_attr->code;
+    frame->pc = code_attr->code;
+
+    int status = executar_frame(frame, options,
+                                options->jit && options->execution_mode != MODE_DEBUG
+                                    ? jit_on_invoke(cf, method, code_attr) : NULL);
+
+    // Valor de retorno: topo da pilha do método chamado
+    if (status == 1 && ret && frame->stack_top - frame->operand_stack >= ret_slots) {
+        memcpy(ret, frame->stack_top - ret_slots, ret_slots * sizeof(Slot));
+    }
+
+    frame_free(frame);
+    return status;
+}
+
+int *execute_depth_counter(void) {
+    return &profundidade_chamadas;
+}
+
+int execute_resume_frame(Frame *frame, const CliOptions *options) {
+    return executar_frame(frame, options, NULL);
+}
+
+/**
+ * @brief Chamada direta do código do JIT (ver execute.h).
+ */
+int execute_jit_call(Frame *caller, const CliOptions *options, JitCallSite *site) {
+    if (!site->method && !site->generic) {
+        // Primeira chamada: resolve o alvo (a compilacao nao resolve nada)
+        const ResolvedEntry *e = cp_resolved(site->cls, site->cp_index);
+        const CodeAttribute *code = e && e->kind == RESOLVED_METHOD && e->cls == site->cls
+                                        ? cp_cache_code(site->cls, e->u.method) : NULL;
+        if (code) {
+            site->method = e->u.method;
+            site->code = code;
+        } else {
+            site->generic = true;
+        }
+    }
+    if (site->generic) {
+        caller->pc = (u1 *)site->pc;
+        return handle_invokestatic(caller, options);
+    }
+    if (profundidade_chamadas >= MAX_PROFUNDIDADE) {
+        fprintf(stderr, "Erro: StackOverflowError (mais de %d frames).\n", MAX_PROFUNDIDADE);
+        return -1;
+    }
+    // Sem cache do alvo no sitio: o codigo dele pode ter sido despejado
+    JitFunction fn = jit_on_invoke(site->cls, site->method, site->code);
+
+    // Frame na pilha nativa (sem calloc/free por chamada). So as locais
+    // alem dos argumentos sao zeradas: a pilha de operandos nunca e lida
+    // antes de escrita (verificador).
+    const CodeAttribute *code_attr = site->code;
+    size_t nslots_frame = (size_t)code_attr->max_locals + code_attr->max_stack;
+    size_t palavras = (sizeof(Frame) + nslots_frame * sizeof(Slot) + sizeof(void *) - 1) / sizeof(void *);
+    void *mem[palavras];
+    Frame *frame = (Frame *)mem;
+    frame->class_file = site->cls;
+    frame->method_info = site->method;
+    frame->local_vars = frame->slots_data;
+    frame->operand_stack = frame->slots_data + code_attr->max_locals;
+    frame->stack_top = frame->operand_stack;
+    frame->next = caller;
+    frame->code = code_attr->code;
+    frame->pc = code_attr->code;
+
+    u2 nargs = site->nslots;
+    caller->stack_top -= nargs;
+    if (nargs > code_attr->max_locals) nargs = code_attr->max_locals;
+    memcpy(frame->local_vars, caller->stack_top, nargs * sizeof(Slot));
+    memset(frame->local_vars + nargs, 0, (code_attr->max_locals - nargs) * sizeof(Slot));
+
+    int status = executar_frame(frame, options, fn);
+    if (status < 0) return status;
+
+    Slot ret[2] = { 0, 0 };
+    if (status == 1 && frame->stack_top - frame->operand_stack >= site->ret_slots) {
+        memcpy(ret, frame->stack_top - site->ret_slots, site->ret_slots * sizeof(Slot));
+    }
+    for (u1 i = 0; i < site->ret_slots; i++) {
+        *caller->stack_top = ret[i];
+        caller->stack_top++;
+    }
+    return 0;
+}
+
 /**
  * @brief Executa o método main da classe carregada.
  * 
  * Esta função implementa o interpretador principal da JVM:
  * 1. Busca o método main
- * 2. Obtém o Code Attribute
- * 3. Cria o Frame de execução
- * 4. Loop de execução usando a Dispatch Table
- * 5. Limpeza de memória
+ * 2. Prepara a classe (cache de resolução, layout, Code decodificado)
+ * 3. Executa <clinit> e main, cada invocação em seu próprio Frame
+ * 4. Limpeza de memória
  */
 int execute_main_method(ClassFile *class_file, const CliOptions *options) {
     if (!class_file || !options) {
@@ -966,10 +1451,18 @@ int execute_main_method(ClassFile *class_file, const CliOptions *options) {
         printf("[DEBUG] Método 'main' encontrado.\n");
     }
 
-    // 2. Obter o Code Attribute do método
-    const CodeAttribute *code_attr = find_code_attribute(class_file, main_method);
+    // O peephole age quando o Code é decodificado; no -debug ficam os pcs originais.
+    PeepholeConfig pc = { options->no_peephole || options->execution_mode == MODE_DEBUG, options->peephole_stats };
+    peephole_configure(&pc);
+
+    // 2. Preparar a classe e obter o Code Attribute do main
+    if (cp_cache_prepare(class_file) != CF_STATUS_OK) {
+        fprintf(stderr, "Erro: Falha ao preparar a classe para execução.\n");
+        return 1;
+    }
+    const CodeAttribute *code_attr = cp_cache_code(class_file, main_method);
     if (!code_attr) {
-        fprintf(stderr, "Erro: Code Attribute não encontrado para o método main.\n");
+        fprintf(stderr, "Erro: método main sem Code ou rejeitado pelo verificador.\n");
         return 1;
     }
 
@@ -978,20 +1471,7 @@ int execute_main_method(ClassFile *class_file, const CliOptions *options) {
                code_attr->max_stack, code_attr->max_locals, code_attr->code_length);
     }
 
-    // 3. Criar o Frame de Execução
-    Frame *frame = frame_new(class_file, main_method, 
-                            code_attr->max_locals, code_attr->max_stack);
-    if (!frame) {
-        fprintf(stderr, "Erro: Falha ao criar o Frame de Execução.\n");
-        free_code_attribute((CodeAttribute*)code_attr);
-        return 1;
-    }
-
-    // 4. Inicializar o Program Counter
-    frame->pc = code_attr->code;
-    u1 *code_end = code_attr->code + code_attr->code_length;
-
-    // 5. Inicializar a Dispatch Table
+    // 3. Inicializar a Dispatch Table
     init_opcode_handlers();
 
     if (options->execution_mode == MODE_DEBUG) {
@@ -999,50 +1479,74 @@ int execute_main_method(ClassFile *class_file, const CliOptions *options) {
         printf("[DEBUG] Iniciando loop de execução...\n\n");
     }
 
-    // 6. Loop de Execução Principal
-    int status = 0;
-    int instruction_count = 0;
-    
-    while (status == 0 && frame->pc < code_end) {
-        // Lê o opcode atual
-        u1 opcode = *frame->pc;
-        
-        if (options->execution_mode == MODE_DEBUG) {
-            printf("[DEBUG] [PC=%ld] Opcode: 0x%02X | Stack depth: %ld\n",
-                   (long)(frame->pc - code_attr->code),
-                   opcode,
-                   (long)(frame->stack_top - frame->operand_stack));
+    // 4. <clinit> da classe principal e main(String[] args = null)
+    instrucoes_executadas = 0;
+    execucao_interrompida = 0;
+    if (options->jit) {
+        JitConfig jc = { options->jit_threshold, options->osr_threshold, options->jit_threads,
+                         (size_t)options->code_cache_kib * 1024u, options->perf_map };
+        jit_configure(&jc);
+    }
+    if (options->regvm) {
+        RegVmConfig rc = { options->inline_size, options->no_inline, options->deopt_stress, options->no_vectorize };
+        regvm_configure(&rc);
+        vec_configure((VecIsa)options->simd);
+    }
+    Slot args[1] = { 0 };
+    int status = inicializar_classe(class_file, NULL, options);
+    if (status >= 0) {
+        status = executar_metodo(class_file, main_method, args, 1, NULL, options, NULL, 0);
+    }
+    if (options->jit) {
+        if (options->verbose) {
+            JitStats st;
+            jit_stats(&st);
+            fprintf(stderr, "[jit] %u método(s) compilado(s), %u não compilável(is), %u entrada(s) OSR, "
+                    "%zu bytes de código\n", st.methods, st.failed, st.osr_entries, st.code_bytes);
+            fprintf(stderr, "[jit] fila: %u pedido(s), %u pendente(s); espera média %.3f ms (máx %.3f ms), "
+                    "compilação média %.3f ms\n", st.queued, st.pending, st.queue_wait_avg_ms,
+                    st.queue_wait_max_ms, st.compile_avg_ms);
+            fprintf(stderr, "[jit] cache de código: %zu de %zu bytes em %u segmento(s), %u método(s) despejado(s)\n",
+                    st.cache_used, st.cache_capacity, st.cache_segments, st.evicted);
         }
-
-        // Obtém o handler da Dispatch Table
-        OpcodeHandler handler = opcode_handlers[opcode];
-        
-        // Executa o handler
-        status = handler(frame, options);
-        
-        instruction_count++;
-        
-        // Proteção contra loops infinitos em modo debug
-        if (options->execution_mode == MODE_DEBUG && instruction_count > 100000) {
-            fprintf(stderr, "\n[DEBUG] AVISO: Executadas mais de 100.000 instruções. Possível loop infinito.\n");
-            break;
+        jit_release_all();
+    }
+    if (options->regvm) {
+        if (options->verbose) {
+            RegVmStats rs;
+            regvm_stats(&rs);
+            fprintf(stderr, "[regvm] %u método(s) traduzido(s), %u não traduzível(is); %llu bytecode(s) -> "
+                    "%llu instrução(ões), %llu operando(s) propagado(s), %llu removida(s), %llu chamada(s) inlinada(s) "
+                    "(%llu por CHA), %u invalidada(s), %llu desotimização(ões) (%llu frame(s) refeito(s)); "
+                    "%u laço(s) vetorizado(s) (%s, %llu execução(ões)); %llu despacho(s)\n", rs.methods, rs.failed,
+                    (unsigned long long)rs.bytecodes, (unsigned long long)rs.insns,
+                    (unsigned long long)rs.propagated, (unsigned long long)rs.removed,
+                    (unsigned long long)rs.inlined, (unsigned long long)rs.devirtualized, rs.invalidated,
+                    (unsigned long long)rs.deoptimized, (unsigned long long)rs.deopt_frames,
+                    rs.vectorized, vec_isa_name(vec_isa()), (unsigned long long)rs.vector_runs,
+                    (unsigned long long)rs.dispatches);
         }
+        regvm_release_all();
+    }
+    if (options->peephole_stats && peephole_enabled()) {
+        PeepholeStats ps;
+        peephole_totals(&ps);
+        fprintf(stderr, "[peephole] %u método(s) otimizado(s): %u -> %u instrução(ões); %u constante(s) "
+                "dobrada(s), %u par(es) store/load, %u store(s) morto(s), %u salto(s), %u laço(s) contado(s)\n",
+                ps.methods, ps.insns_before, ps.insns_after, ps.folded, ps.store_loads, ps.dead_stores,
+                ps.jumps, ps.loops);
     }
 
-    // 7. Verificação do resultado
+    // 5. Verificação do resultado
     if (status < 0) {
         fprintf(stderr, "\nErro: Execução falhou com código %d.\n", status);
     } else if (options->execution_mode == MODE_DEBUG) {
         printf("\n[DEBUG] ========== EXECUÇÃO CONCLUÍDA ==========\n");
-        printf("[DEBUG] Total de instruções executadas: %d\n", instruction_count);
+        printf("[DEBUG] Total de instruções executadas: %ld\n", instrucoes_executadas);
         printf("[DEBUG] Status final: %s\n", status == 1 ? "RETURN" : "FIM DO CÓDIGO");
     } else if (options->execution_mode == MODE_EXECUTE) {
         printf("\nExecução concluída com sucesso.\n");
     }
 
-    // 8. Limpeza
-    frame_free(frame);
-    free_code_attribute((CodeAttribute*)code_attr);
-
     return (status >= 0) ? 0 : 1;
 }
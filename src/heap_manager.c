@@ -4,6 +4,52 @@
 #include <string.h>
 #include "heap_manager.h"
 
+#ifdef JVM_HEAP_HANDLES
+#include <pthread.h>
+
+// Espaço antes de cada alocação: guarda o handle e mantém o alinhamento do malloc
+#define PREFIXO 16
+
+Object **jvm_heap_pedacos[1u << (32 - JVM_HEAP_PEDACO_BITS)];
+static u4 proximo_handle = 1;  // 0 é null
+static pthread_mutex_t trava_handles = PTHREAD_MUTEX_INITIALIZER;
+
+// Registra p na tabela e grava o handle antes dele
+static void *registrar(u1 *bloco) {
+    void *p = bloco + PREFIXO;
+    const u4 mascara = (1u << JVM_HEAP_PEDACO_BITS) - 1;
+    pthread_mutex_lock(&trava_handles);
+    u4 h = proximo_handle;
+    Object **pedaco = jvm_heap_pedacos[h >> JVM_HEAP_PEDACO_BITS];
+    if (h == 0 || (!pedaco && !(pedaco = (Object **)calloc(mascara + 1u, sizeof(Object *))))) {
+        pthread_mutex_unlock(&trava_handles);
+        fprintf(stderr, "Erro: Tabela de referências da heap esgotada\n");
+        exit(1);
+    }
+    pedaco[h & mascara] = (Object *)p;
+    __atomic_store_n(&jvm_heap_pedacos[h >> JVM_HEAP_PEDACO_BITS], pedaco, __ATOMIC_RELEASE);
+    proximo_handle = h + 1;
+    pthread_mutex_unlock(&trava_handles);
+    ((StackValue *)p)[-1] = h;
+    return p;
+}
+
+// malloc de um objeto da heap (NULL em falha)
+static void *alocar(size_t bytes) {
+    u1 *bloco = (u1 *)malloc(PREFIXO + bytes);
+    return bloco ? registrar(bloco) : NULL;
+}
+
+static void liberar(void *p) {
+    StackValue h = ((StackValue *)p)[-1];
+    jvm_heap_pedacos[h >> JVM_HEAP_PEDACO_BITS][h & ((1u << JVM_HEAP_PEDACO_BITS) - 1)] = NULL;
+    free((u1 *)p - PREFIXO);
+}
+#else
+#define alocar malloc
+#define liberar free
+#endif
+
 /**
  * @brief Aloca memória para um novo objeto na Heap
  */
@@ -17,7 +63,7 @@ ObjectRef jvm_heap_new_object(ClassFile *class_info, size_t field_count) {
     size_t total_field_bytes = field_count * sizeof(StackValue);
     
     // 2. Alocar a memória
-    ObjectRef new_obj = (ObjectRef)malloc(sizeof(Object) + total_field_bytes);
+    ObjectRef new_obj = (ObjectRef)alocar(sizeof(Object) + total_field_bytes);
     if (!new_obj) {
         fprintf(stderr, "Erro: Falha na alocação de memória para objeto\n");
         exit(1);
@@ -41,7 +87,7 @@ ObjectRef jvm_heap_new_array(u1 type, u4 length) {
     size_t data_bytes = length * sizeof(StackValue);
     
     // 2. Alocar a memória
-    Array *new_array = (Array*)malloc(sizeof(Array) + data_bytes);
+    Array *new_array = (Array*)alocar(sizeof(Array) + data_bytes);
     if (!new_array) {
         fprintf(stderr, "Erro: Falha na alocação de memória para array\n");
         exit(1);
@@ -59,6 +105,34 @@ ObjectRef jvm_heap_new_array(u1 type, u4 length) {
     return (ObjectRef)(void*)new_array;
 }
 
+/**
+ * @brief Aloca uma string imutável (ldc de CONSTANT_String)
+ */
+ObjectRef jvm_heap_new_string(const char *chars, u4 length) {
+    StringObject *s = (StringObject*)alocar(sizeof(StringObject) + length + 1);
+    if (!s) {
+        fprintf(stderr, "Erro: Falha na alocação de memória para string\n");
+        exit(1);
+    }
+
+    // Sem ClassFile: java/lang/String não vem do classpath
+    s->header.class_info = NULL;
+    s->header.fields = NULL;
+    s->length = length;
+    memcpy(s->chars, chars, length);
+    s->chars[length] = '\0';
+
+    return &s->header;
+}
+
+/**
+ * @brief Texto de uma referência criada por jvm_heap_new_string
+ */
+const char *jvm_heap_string_chars(ObjectRef obj_ref) {
+    if (!obj_ref || obj_ref->class_info || obj_ref->fields) return NULL;
+    return ((StringObject*)(void*)obj_ref)->chars;
+}
+
 /**
  * @brief Lê o valor de um campo de instância (getfield)
  */
@@ -92,7 +166,7 @@ void jvm_heap_free_object(ObjectRef obj_ref) {
     if (obj_ref == NULL) return;
     
     // Na nossa JVM simplificada sem GC, free() é suficiente
-    free(obj_ref);
+    liberar(obj_ref);
 }
 
 /**
@@ -0,0 +1,269 @@
+#include "inflate.h"
+#include <string.h>
+
+#define MAX_BITS   15
+#define MAX_LCODES 286
+#define MAX_DCODES 30
+#define FIX_LCODES 288
+
+/* Erros internos (negativos); >= 0 e simbolo/valor valido */
+#define FIM_ENTRADA  (-1)
+#define SAIDA_CHEIA  (-2)
+#define DADO_INVALIDO (-3)
+
+typedef struct {
+    const u1 *in;
+    size_t in_len, in_pos;
+    u4 bitbuf;
+    int bitcnt;
+
+    u1 *out;
+    size_t out_len, out_pos;
+} Inflador;
+
+/* Codigo de Huffman canonico: quantos codigos por tamanho + simbolos em ordem */
+typedef struct {
+    short count[MAX_BITS + 1];
+    short symbol[FIX_LCODES];
+} Huffman;
+
+/* Le 'need' bits (LSB primeiro). */
+static int bits(Inflador *s, int need) {
+    u4 val = s->bitbuf;
+    while (s->bitcnt < need) {
+        if (s->in_pos == s->in_len) return FIM_ENTRADA;
+        val |= (u4)s->in[s->in_pos++] << s->bitcnt;
+        s->bitcnt += 8;
+    }
+    s->bitbuf = val >> need;
+    s->bitcnt -= need;
+    return (int)(val & ((1u << need) - 1));
+}
+
+/* Bloco armazenado (tipo 0): copia direta apos alinhar no byte. */
+static int bloco_armazenado(Inflador *s) {
+    s->bitbuf = 0;
+    s->bitcnt = 0;
+
+    if (s->in_len - s->in_pos < 4) return FIM_ENTRADA;
+    unsigned len = s->in[s->in_pos] | (s->in[s->in_pos + 1] << 8);
+    unsigned nlen = s->in[s->in_pos + 2] | (s->in[s->in_pos + 3] << 8);
+    s->in_pos += 4;
+    if (len != (~nlen & 0xffffu)) return DADO_INVALIDO;
+
+    if (s->in_len - s->in_pos < len) return FIM_ENTRADA;
+    if (s->out_len - s->out_pos < len) return SAIDA_CHEIA;
+    memcpy(s->out + s->out_pos, s->in + s->in_pos, len);
+    s->in_pos += len;
+    s->out_pos += len;
+    return 0;
+}
+
+/* Decodifica um simbolo percorrendo o codigo canonico bit a bit. */
+static int decodificar(Inflador *s, const Huffman *h) {
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len <= MAX_BITS; len++) {
+        int b = bits(s, 1);
+        if (b < 0) return b;
+        code |= b;
+        int count = h->count[len];
+        if (code - count < first) return h->symbol[index + (code - first)];
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    return DADO_INVALIDO;
+}
+
+/*
+ * Monta a tabela a partir dos tamanhos de codigo. Retorna 0 se o codigo
+ * for completo, > 0 se incompleto e < 0 se tiver codigos demais.
+ */
+static int construir(Huffman *h, const short *length, int n) {
+    short offs[MAX_BITS + 1];
+
+    for (int len = 0; len <= MAX_BITS; len++) h->count[len] = 0;
+    for (int sym = 0; sym < n; sym++) h->count[length[sym]]++;
+    if (h->count[0] == n) return 0;
+
+    int left = 1;
+    for (int len = 1; len <= MAX_BITS; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) return left;
+    }
+
+    offs[1] = 0;
+    for (int len = 1; len < MAX_BITS; len++) offs[len + 1] = (short)(offs[len] + h->count[len]);
+    for (int sym = 0; sym < n; sym++) {
+        if (length[sym] != 0) h->symbol[offs[length[sym]]++] = (short)sym;
+    }
+    return left;
+}
+
+/* Decodifica literais/pares (tamanho, distancia) ate o simbolo 256. */
+static int codigos(Inflador *s, const Huffman *lencode, const Huffman *distcode) {
+    static const short lbase[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const short lext[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const short dbase[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+        8193, 12289, 16385, 24577 };
+    static const short dext[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    for (;;) {
+        int symbol = decodificar(s, lencode);
+        if (symbol < 0) return symbol;
+
+        if (symbol < 256) {
+            if (s->out_pos == s->out_len) return SAIDA_CHEIA;
+            s->out[s->out_pos++] = (u1)symbol;
+            continue;
+        }
+        if (symbol == 256) return 0;
+
+        symbol -= 257;
+        if (symbol >= 29) return DADO_INVALIDO;
+        int extra = bits(s, lext[symbol]);
+        if (extra < 0) return extra;
+        size_t len = (size_t)lbase[symbol] + (size_t)extra;
+
+        symbol = decodificar(s, distcode);
+        if (symbol < 0) return symbol;
+        if (symbol >= 30) return DADO_INVALIDO;
+        extra = bits(s, dext[symbol]);
+        if (extra < 0) return extra;
+        size_t dist = (size_t)dbase[symbol] + (size_t)extra;
+
+        if (dist > s->out_pos) return DADO_INVALIDO;
+        if (s->out_len - s->out_pos < len) return SAIDA_CHEIA;
+
+        /* copia byte a byte: origem e destino podem se sobrepor (dist < len) */
+        u1 *dst = s->out + s->out_pos;
+        const u1 *src = dst - dist;
+        for (size_t i = 0; i < len; i++) dst[i] = src[i];
+        s->out_pos += len;
+    }
+}
+
+/* Bloco com codigos fixos (tipo 1). */
+static int bloco_fixo(Inflador *s) {
+    Huffman lencode, distcode;
+    short lengths[FIX_LCODES];
+    int sym = 0;
+
+    for (; sym < 144; sym++) lengths[sym] = 8;
+    for (; sym < 256; sym++) lengths[sym] = 9;
+    for (; sym < 280; sym++) lengths[sym] = 7;
+    for (; sym < FIX_LCODES; sym++) lengths[sym] = 8;
+    construir(&lencode, lengths, FIX_LCODES);
+
+    for (sym = 0; sym < MAX_DCODES; sym++) lengths[sym] = 5;
+    construir(&distcode, lengths, MAX_DCODES);
+
+    return codigos(s, &lencode, &distcode);
+}
+
+/* Bloco com codigos dinamicos (tipo 2): le as tabelas do proprio fluxo. */
+static int bloco_dinamico(Inflador *s) {
+    static const short ordem[19] = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    short lengths[MAX_LCODES + MAX_DCODES];
+    Huffman lencode, distcode;
+
+    int nlen = bits(s, 5);
+    int ndist = bits(s, 5);
+    int ncode = bits(s, 4);
+    if (nlen < 0 || ndist < 0 || ncode < 0) return FIM_ENTRADA;
+    nlen += 257;
+    ndist += 1;
+    ncode += 4;
+    if (nlen > MAX_LCODES || ndist > MAX_DCODES) return DADO_INVALIDO;
+
+    int index = 0;
+    for (; index < ncode; index++) {
+        int v = bits(s, 3);
+        if (v < 0) return v;
+        lengths[ordem[index]] = (short)v;
+    }
+    for (; index < 19; index++) lengths[ordem[index]] = 0;
+
+    /* o codigo dos tamanhos precisa ser completo */
+    if (construir(&lencode, lengths, 19) != 0) return DADO_INVALIDO;
+
+    index = 0;
+    while (index < nlen + ndist) {
+        int symbol = decodificar(s, &lencode);
+        if (symbol < 0) return symbol;
+        if (symbol < 16) {
+            lengths[index++] = (short)symbol;
+            continue;
+        }
+
+        short len = 0;
+        int rep;
+        if (symbol == 16) {
+            if (index == 0) return DADO_INVALIDO;
+            len = lengths[index - 1];
+            rep = bits(s, 2);
+            if (rep < 0) return rep;
+            rep += 3;
+        } else if (symbol == 17) {
+            rep = bits(s, 3);
+            if (rep < 0) return rep;
+            rep += 3;
+        } else {
+            rep = bits(s, 7);
+            if (rep < 0) return rep;
+            rep += 11;
+        }
+        if (index + rep > nlen + ndist) return DADO_INVALIDO;
+        while (rep--) lengths[index++] = len;
+    }
+
+    /* sem codigo de fim de bloco nao ha como terminar */
+    if (lengths[256] == 0) return DADO_INVALIDO;
+
+    /* codigos incompletos so sao aceitos com um unico simbolo */
+    int err = construir(&lencode, lengths, nlen);
+    if (err && (err < 0 || nlen != lencode.count[0] + lencode.count[1])) return DADO_INVALIDO;
+    err = construir(&distcode, lengths + nlen, ndist);
+    if (err && (err < 0 || ndist != distcode.count[0] + distcode.count[1])) return DADO_INVALIDO;
+
+    return codigos(s, &lencode, &distcode);
+}
+
+/* ============================================================
+ * API pública
+ * ============================================================ */
+Status inflate_raw(const u1 *src, size_t src_len, u1 *dst, size_t dst_len, size_t *out_len) {
+    Inflador s;
+    memset(&s, 0, sizeof s);
+    s.in = src;
+    s.in_len = src_len;
+    s.out = dst;
+    s.out_len = dst_len;
+
+    int last, err = 0;
+    do {
+        last = bits(&s, 1);
+        int type = bits(&s, 2);
+        if (last < 0 || type < 0) { err = FIM_ENTRADA; break; }
+
+        if (type == 0) err = bloco_armazenado(&s);
+        else if (type == 1) err = bloco_fixo(&s);
+        else if (type == 2) err = bloco_dinamico(&s);
+        else err = DADO_INVALIDO;
+    } while (!last && err == 0);
+
+    if (out_len) *out_len = s.out_pos;
+    if (err == SAIDA_CHEIA) return ERR_BOUNDS;
+    return err == 0 ? OK : ERR_EOF;
+}
@@ -25,6 +25,7 @@ Status buffer_from_file(const char* path, Buffer* buffer) {
 
     buffer->size = (u4)file_size;
     buffer->offset = 0;
+    buffer->borrowed = 0;
 
     size_t bytes_read = fread(buffer->data, 1, file_size, fp);
     fclose(fp);
@@ -84,10 +85,11 @@ u4 buffer_tell(Buffer* buffer) {
 
 void buffer_free(Buffer* buffer) {
     if (buffer && buffer->data) {
-        free(buffer->data);
+        if (!buffer->borrowed) free(buffer->data);
         buffer->data = NULL;
         buffer->size = 0;
         buffer->offset = 0;
+        buffer->borrowed = 0;
     }
 }
 
@@ -0,0 +1,1283 @@
+#define _DEFAULT_SOURCE         /* clock_gettime */
+#include "jit.h"
+#include "class_registry.h"
+#include "classfile.h"
+#include "code_cache.h"
+#include "cp_cache.h"
+#include "disasm.h"
+#include "execute.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define JIT_X86_64 1
+#include <stdio.h>
+#endif
+
+/* ============================================================
+ * Tabela de metodos (MethodInfo* -> contadores e codigo)
+ *
+ * A tabela e os contadores so sao tocados pela thread que executa; as
+ * compiladoras recebem o Compilado (alocado a parte, endereco estavel)
+ * pela fila e publicam fn por ultimo, com __atomic_store_n (release).
+ * O despejo (cache cheio) tambem so roda na thread que executa, e so
+ * escolhe metodos PRONTO sem nenhuma ativacao na pilha nativa.
+ * ============================================================ */
+/* Sitio de chamada direta (endereco embutido no codigo gerado) */
+typedef struct sitio {
+    JitCallSite s;
+    struct sitio *prox;
+} Sitio;
+
+/* Contador de back-edges por cabecalho de laco (alvo do salto para tras) */
+typedef struct {
+    u4 pc;
+    unsigned saltos;
+} Laco;
+
+/* Entrada OSR: prologo + salto para o codigo do cabecalho */
+typedef struct {
+    u4 pc;
+    size_t offset;
+} EntradaOsr;
+
+/* SEM_ESPACO: compilou, mas o cache de codigo estava cheio */
+enum { FRIO = 0, NA_FILA, COMPILANDO, PRONTO, SEM_ESPACO };
+
+typedef struct {
+    const MethodInfo *method;
+    ClassFile *cf;
+    const CodeAttribute *code;
+    unsigned chamadas;          /* invocacoes interpretadas (ate promover) */
+    Laco *lacos;
+    size_t nlacos;
+    unsigned calor;             /* prioridade na fila: chamadas + saltos (atomico) */
+    int estado;                 /* FRIO..SEM_ESPACO (atomico) */
+    uint64_t enfileirado_ns;
+    JitFunction fn;             /* NULL: ainda nao compilado, ou nao compilavel */
+    EntradaOsr *osr;            /* ordenado por pc */
+    size_t nosr;
+    void *mem;                  /* bloco no cache de codigo */
+    size_t bytes;               /* codigo gerado (tambem quando nao coube) */
+    bool sem_espaco;
+    Sitio *sitios;
+    unsigned ativos;            /* execucoes na pilha nativa (jit_execute) */
+    uint64_t ultimo_uso;        /* relogio da ultima entrada, para o despejo */
+} Compilado;
+
+static void liberar_sitios(Sitio *s) {
+    while (s) {
+        Sitio *prox = s->prox;
+        free(s);
+        s = prox;
+    }
+}
+
+static Compilado **tabela;
+static size_t tabela_cap, tabela_n;
+
+static unsigned limite_chamadas = JIT_DEFAULT_INVOKE_THRESHOLD;
+static unsigned limite_saltos = JIT_DEFAULT_BACKEDGE_THRESHOLD;
+
+static CodeCache *cache;
+static uint64_t relogio;
+
+static size_t posicao(const MethodInfo *m, size_t cap) {
+    uintptr_t h = (uintptr_t)m;
+    h ^= h >> 17;
+    h *= 0x9E3779B1u;
+    return (size_t)(h ^ (h >> 15)) & (cap - 1);
+}
+
+static Compilado *procurar(const MethodInfo *m) {
+    if (!tabela) return NULL;
+    for (size_t i = posicao(m, tabela_cap);; i = (i + 1) & (tabela_cap - 1)) {
+        if (!tabela[i]) return NULL;
+        if (tabela[i]->method == m) return tabela[i];
+    }
+}
+
+static Compilado *inserir(const MethodInfo *m) {
+    if ((tabela_n + 1) * 2 > tabela_cap) {
+        size_t cap = tabela_cap ? tabela_cap * 2 : 64;
+        Compilado **nova = (Compilado **)calloc(cap, sizeof(Compilado *));
+        if (!nova) return NULL;
+        for (size_t i = 0; i < tabela_cap; i++) {
+            if (!tabela[i]) continue;
+            size_t j = posicao(tabela[i]->method, cap);
+            while (nova[j]) j = (j + 1) & (cap - 1);
+            nova[j] = tabela[i];
+        }
+        free(tabela);
+        tabela = nova;
+        tabela_cap = cap;
+    }
+    Compilado *c = (Compilado *)calloc(1, sizeof(Compilado));
+    if (!c) return NULL;
+    c->method = m;
+    size_t i = posicao(m, tabela_cap);
+    while (tabela[i]) i = (i + 1) & (tabela_cap - 1);
+    tabela[i] = c;
+    tabela_n++;
+    return c;
+}
+
+/* ============================================================
+ * Fila de compilacao e estatisticas (protegidas pela trava)
+ * ============================================================ */
+static pthread_mutex_t trava = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tem_pedido = PTHREAD_COND_INITIALIZER;
+static Compilado **fila;
+static size_t fila_n, fila_cap;
+static pthread_t *compiladoras;
+static int ncompiladoras;
+static bool encerrar;
+
+static unsigned total_metodos, total_falhas, total_osr, total_pedidos, total_despejos;
+static size_t total_bytes;
+static uint64_t espera_total_ns, espera_max_ns, compilacao_total_ns;
+
+static uint64_t agora_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+void jit_stats(JitStats *out) {
+    pthread_mutex_lock(&trava);
+    out->methods = total_metodos;
+    out->failed = total_falhas;
+    out->osr_entries = total_osr;
+    out->code_bytes = total_bytes;
+    out->queued = total_pedidos;
+    out->pending = (unsigned)fila_n;
+    out->queue_wait_avg_ms = total_pedidos ? espera_total_ns / 1e6 / total_pedidos : 0.0;
+    out->queue_wait_max_ms = espera_max_ns / 1e6;
+    unsigned compilados = total_metodos + total_falhas;
+    out->compile_avg_ms = compilados ? compilacao_total_ns / 1e6 / compilados : 0.0;
+    out->evicted = total_despejos;
+    pthread_mutex_unlock(&trava);
+    CodeCacheStats cs;
+    code_cache_stats(cache, &cs);
+    out->cache_capacity = cs.capacity;
+    out->cache_used = cs.used;
+    out->cache_segments = cs.segments;
+}
+
+#ifdef JIT_X86_64
+
+/* ============================================================
+ * Emissor x86-64
+ * ============================================================ */
+enum { RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+       R12 = 12, R13 = 13, R14 = 14, R15 = 15 };
+
+/* Registradores fixos do codigo gerado (preservados pelo chamador na ABI SysV) */
+#define R_FRAME   R12
+#define R_LOCAIS  R13
+#define R_PILHA   R14
+#define R_OPCOES  R15
+
+/* Condicoes de jcc */
+enum { CC_E = 0x4, CC_NE = 0x5, CC_A = 0x7, CC_S = 0x8, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF };
+
+typedef struct {
+    uint8_t *buf;
+    size_t len, cap;
+    int sem_memoria;
+} Emissor;
+
+/* Salto a resolver no fim: rel32 em pos (ou entrada de tableswitch relativa a base) */
+typedef struct {
+    size_t pos;
+    size_t base;                /* 0: rel32 comum (relativo a pos + 4) */
+    uint32_t alvo_pc;
+} Pendente;
+
+static void emitir(Emissor *e, const void *p, size_t n) {
+    if (e->len + n > e->cap) {
+        size_t cap = e->cap ? e->cap * 2 : 4096;
+        while (cap < e->len + n) cap *= 2;
+        uint8_t *novo = (uint8_t *)realloc(e->buf, cap);
+        if (!novo) {
+            e->sem_memoria = 1;
+            return;
+        }
+        e->buf = novo;
+        e->cap = cap;
+    }
+    memcpy(e->buf + e->len, p, n);
+    e->len += n;
+}
+
+static void byte(Emissor *e, uint8_t b) {
+    emitir(e, &b, 1);
+}
+
+static void dword(Emissor *e, uint32_t v) {
+    uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    emitir(e, b, 4);
+}
+
+static void qword(Emissor *e, uint64_t v) {
+    dword(e, (uint32_t)v);
+    dword(e, (uint32_t)(v >> 32));
+}
+
+static void gravar32(Emissor *e, size_t pos, int32_t v) {
+    if (e->sem_memoria) return;
+    uint32_t u = (uint32_t)v;
+    e->buf[pos] = (uint8_t)u;
+    e->buf[pos + 1] = (uint8_t)(u >> 8);
+    e->buf[pos + 2] = (uint8_t)(u >> 16);
+    e->buf[pos + 3] = (uint8_t)(u >> 24);
+}
+
+/* REX (w = operando de 64 bits); emitido so quando necessario */
+static void rex(Emissor *e, int w, int reg, int base) {
+    uint8_t r = (uint8_t)(0x40 | (w << 3) | ((reg >> 3) << 2) | (base >> 3));
+    if (r != 0x40) byte(e, r);
+}
+
+/* ModRM (+SIB) de [base + disp], sempre com deslocamento explicito */
+static void memoria(Emissor *e, int reg, int base, int32_t disp) {
+    int curto = disp >= -128 && disp <= 127;
+    byte(e, (uint8_t)((curto ? 0x40 : 0x80) | ((reg & 7) << 3) | (base & 7)));
+    if ((base & 7) == RSP) byte(e, 0x24);
+    if (curto) byte(e, (uint8_t)disp);
+    else dword(e, (uint32_t)disp);
+}
+
+/* op reg, [base + disp] (ou op [base + disp], reg, conforme o opcode) */
+static void op_mem(Emissor *e, int w, uint8_t op, int reg, int base, int32_t disp) {
+    rex(e, w, reg, base);
+    byte(e, op);
+    memoria(e, reg, base, disp);
+}
+
+/* op de dois bytes (0F xx) com operando de memoria */
+static void op2_mem(Emissor *e, uint8_t op, int reg, int base, int32_t disp) {
+    rex(e, 0, reg, base);
+    byte(e, 0x0F);
+    byte(e, op);
+    memoria(e, reg, base, disp);
+}
+
+/* mov dst, src (64 bits) */
+static void mov_rr(Emissor *e, int dst, int src) {
+    rex(e, 1, src, dst);
+    byte(e, 0x89);
+    byte(e, (uint8_t)(0xC0 | ((src & 7) << 3) | (dst & 7)));
+}
+
+/* mov reg, imm64 */
+static void mov_imm64(Emissor *e, int reg, uint64_t v) {
+    rex(e, 1, 0, reg);
+    byte(e, (uint8_t)(0xB8 | (reg & 7)));
+    qword(e, v);
+}
+
+/* mov dword [base + disp], imm32 */
+static void mov_mem_imm(Emissor *e, int base, int32_t disp, int32_t v) {
+    op_mem(e, 0, 0xC7, 0, base, disp);
+    dword(e, (uint32_t)v);
+}
+
+static void push(Emissor *e, int reg) {
+    rex(e, 0, 0, reg);
+    byte(e, (uint8_t)(0x50 | (reg & 7)));
+}
+
+static void pop(Emissor *e, int reg) {
+    rex(e, 0, 0, reg);
+    byte(e, (uint8_t)(0x58 | (reg & 7)));
+}
+
+/* jcc/jmp rel32 com alvo a preencher; devolve a posicao do deslocamento */
+static size_t jcc(Emissor *e, int cc) {
+    byte(e, 0x0F);
+    byte(e, (uint8_t)(0x80 | cc));
+    dword(e, 0);
+    return e->len - 4;
+}
+
+static size_t jmp(Emissor *e) {
+    byte(e, 0xE9);
+    dword(e, 0);
+    return e->len - 4;
+}
+
+/* Aponta o salto em pos para a posicao atual */
+static void ligar(Emissor *e, size_t pos) {
+    gravar32(e, pos, (int32_t)(e->len - (pos + 4)));
+}
+
+static void ligar_em(Emissor *e, size_t pos, size_t destino) {
+    gravar32(e, pos, (int32_t)((int64_t)destino - (int64_t)(pos + 4)));
+}
+
+/* ============================================================
+ * Analise: profundidade da pilha em cada instrucao
+ * ============================================================ */
+static int32_t le_s32(const u1 *p) {
+    return (int32_t)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]);
+}
+
+static int16_t le_s16(const u1 *p) {
+    return (int16_t)((p[0] << 8) | p[1]);
+}
+
+static u2 le_u2(const u1 *p) {
+    return (u2)((p[0] << 8) | p[1]);
+}
+
+static int slots_do_tipo(char c) {
+    return c == 'J' || c == 'D' ? 2 : c == 'V' ? 0 : 1;
+}
+
+/* Slots (desempilhados, empilhados) de get/put* e invoke* pelo descritor do CP */
+static int efeito_membro(const ClassFile *cf, u1 op, u2 idx, int *sai, int *entra) {
+    const char *classe = NULL, *nome = NULL, *desc = NULL;
+    cp_referencia_metodo(cf->constant_pool, cf->constant_pool_count, idx, &classe, &nome, &desc);
+    if (!desc || !desc[0]) return 0;
+    if (op >= 0xB2 && op <= 0xB5) {
+        int n = slots_do_tipo(desc[0]);
+        switch (op) {
+            case 0xB2: *sai = 0; *entra = n; break;           /* getstatic */
+            case 0xB3: *sai = n; *entra = 0; break;           /* putstatic */
+            case 0xB4: *sai = 1; *entra = n; break;           /* getfield */
+            default:   *sai = 1 + n; *entra = 0; break;       /* putfield */
+        }
+        return 1;
+    }
+    const char *ret = strchr(desc, ')');
+    if (desc[0] != '(' || !ret) return 0;
+    *sai = descriptor_arg_slots(desc) + (op == 0xB8 ? 0 : 1);
+    *entra = slots_do_tipo(ret[1]);
+    return 1;
+}
+
+/*
+ * Efeito de uma instrucao que segue para a proxima. 0 se o interpretador
+ * nao a implementa (o manipulador so reporta o erro) ou se ela desvia.
+ */
+static int efeito(const ClassFile *cf, const u1 *ins, int *sai, int *entra) {
+    u1 op = ins[0];
+    *sai = 0;
+    *entra = 0;
+    switch (op) {
+        case 0x00: return 1;                                    /* nop */
+        case 0x01: case 0x02: case 0x03: case 0x04: case 0x05:
+        case 0x06: case 0x07: case 0x08: case 0x10: case 0x11:
+        case 0x12: case 0x15: case 0x1A: case 0x1B: case 0x1C:
+        case 0x1D: case 0xBB:
+            *entra = 1;
+            return 1;
+        case 0x36: case 0x3B: case 0x3C: case 0x3D: case 0x3E:
+        case 0x57:
+            *sai = 1;
+            return 1;
+        case 0x59: *sai = 1; *entra = 2; return 1;              /* dup */
+        case 0x60: case 0x64: case 0x68: case 0x6C: case 0x70:
+            *sai = 2;
+            *entra = 1;
+            return 1;
+        case 0x74: case 0xBC: *sai = 1; *entra = 1; return 1;   /* ineg, newarray */
+        case 0x84: return 1;                                    /* iinc */
+        case 0xB2: case 0xB3: case 0xB4: case 0xB5:
+        case 0xB6: case 0xB7: case 0xB8: case 0xB9:
+            return efeito_membro(cf, op, le_u2(ins + 1), sai, entra);
+        default:
+            return 0;
+    }
+}
+
+static int eh_if_zero(u1 op) { return op >= 0x99 && op <= 0x9E; }
+static int eh_if_icmp(u1 op) { return op >= 0x9F && op <= 0xA4; }
+
+typedef struct {
+    const ClassFile *cf;
+    const CodeAttribute *code;
+    const DisasmMethod *dm;
+    uint32_t *insn_do_pc;       /* pc -> indice em dm->insns (UINT32_MAX fora do inicio) */
+    int32_t *prof;              /* por instrucao: profundidade na entrada; -1 se nao alcancada */
+    uint32_t *fila;
+    uint32_t nfila;
+    uint8_t *laco;              /* por instrucao: alvo de salto para tras (entrada OSR) */
+} Analise;
+
+static int visitar(Analise *a, int64_t pc, int32_t prof) {
+    if (pc < 0 || pc >= a->code->code_length || a->insn_do_pc[pc] == UINT32_MAX) return 0;
+    uint32_t i = a->insn_do_pc[pc];
+    if (a->prof[i] >= 0) return a->prof[i] == prof;    /* o verificador garante a mesma */
+    a->prof[i] = prof;
+    a->fila[a->nfila++] = i;
+    return 1;
+}
+
+/* Salto de origem para pc: se for para tras, pc e cabecalho de laco */
+static int saltar(Analise *a, uint32_t origem, int64_t pc, int32_t prof) {
+    if (!visitar(a, pc, prof)) return 0;
+    if (pc <= origem) a->laco[a->insn_do_pc[pc]] = 1;
+    return 1;
+}
+
+/* Inicio da tabela de um tableswitch (apos o alinhamento) */
+static const u1 *tabela_switch(const CodeAttribute *code, uint32_t pc) {
+    return code->code + pc + 1 + (4 - ((pc + 1) % 4)) % 4;
+}
+
+static int analisar(Analise *a) {
+    if (!visitar(a, 0, 0)) return 0;
+    while (a->nfila > 0) {
+        uint32_t i = a->fila[--a->nfila];
+        const DisasmInsn *x = &a->dm->insns[i];
+        const u1 *ins = a->code->code + x->pc;
+        int32_t p = a->prof[i];
+        int sai, entra, ok = 1;
+        if (eh_if_zero(x->opcode) || eh_if_icmp(x->opcode)) {
+            int n = eh_if_zero(x->opcode) ? 1 : 2;
+            ok = saltar(a, x->pc, (int64_t)x->pc + le_s16(ins + 1), p - n) && visitar(a, x->pc + x->length, p - n);
+        } else if (x->opcode == 0xA7) {
+            ok = saltar(a, x->pc, (int64_t)x->pc + le_s16(ins + 1), p);
+        } else if (x->opcode == 0xAA) {
+            const u1 *t = tabela_switch(a->code, x->pc);
+            int32_t lo = le_s32(t + 4), hi = le_s32(t + 8);
+            ok = saltar(a, x->pc, (int64_t)x->pc + le_s32(t), p - 1);
+            for (int64_t k = 0; ok && k <= (int64_t)hi - lo; k++) {
+                ok = saltar(a, x->pc, (int64_t)x->pc + le_s32(t + 12 + 4 * k), p - 1);
+            }
+        } else if (efeito(a->cf, ins, &sai, &entra)) {
+            ok = p >= sai && visitar(a, x->pc + x->length, p - sai + entra);
+        }
+        if (!ok) return 0;
+    }
+    return 1;
+}
+
+/* ============================================================
+ * Templates
+ * ============================================================ */
+typedef struct {
+    Emissor e;
+    ClassFile *cf;
+    const MethodInfo *method;
+    const CodeAttribute *code;
+    Sitio *sitios;
+    size_t *nativo;             /* por instrucao: offset no codigo gerado */
+    Pendente *pend;
+    size_t npend, cap_pend;
+    size_t saida;               /* epilogo */
+    size_t volta;               /* stub "devolve JIT_INTERPRET" */
+    Pendente *locais;           /* saltos para saida/volta (base 1 = saida, 2 = volta) */
+    size_t nlocais, cap_locais;
+    EntradaOsr *osr;
+    size_t nosr;
+} Gerador;
+
+static void anotar(Gerador *g, Pendente **v, size_t *n, size_t *cap, size_t pos, size_t base, uint32_t alvo) {
+    if (*n == *cap) {
+        size_t nova = *cap ? *cap * 2 : 64;
+        Pendente *p = (Pendente *)realloc(*v, nova * sizeof(Pendente));
+        if (!p) {
+            g->e.sem_memoria = 1;
+            return;
+        }
+        *v = p;
+        *cap = nova;
+    }
+    (*v)[*n].pos = pos;
+    (*v)[*n].base = base;
+    (*v)[*n].alvo_pc = alvo;
+    (*n)++;
+}
+
+static void salto_para_pc(Gerador *g, size_t pos, uint32_t alvo_pc) {
+    anotar(g, &g->pend, &g->npend, &g->cap_pend, pos, 0, alvo_pc);
+}
+
+#define PARA_SAIDA 1
+#define PARA_VOLTA 2
+
+static void salto_para(Gerador *g, size_t pos, int destino) {
+    anotar(g, &g->locais, &g->nlocais, &g->cap_locais, pos, (size_t)destino, 0);
+}
+
+static int32_t slot(int32_t prof) {
+    return prof * (int32_t)sizeof(Slot);
+}
+
+/* frame->stack_top = operand_stack + prof */
+static void sincronizar_topo(Gerador *g, int32_t prof) {
+    op_mem(&g->e, 1, 0x8D, RAX, R_PILHA, slot(prof));                         /* lea rax, [pilha + prof] */
+    op_mem(&g->e, 1, 0x89, RAX, R_FRAME, (int32_t)offsetof(Frame, stack_top)); /* mov [frame.stack_top], rax */
+}
+
+/* return: topo no Frame e status 1 */
+static void template_retorno(Gerador *g, int32_t prof) {
+    sincronizar_topo(g, prof);
+    byte(&g->e, 0xB8);                                  /* mov eax, 1 */
+    dword(&g->e, 1);
+    salto_para(g, jmp(&g->e), PARA_SAIDA);
+}
+
+/*
+ * Chamada ao manipulador do interpretador: pc e topo sincronizados, status
+ * diferente de 0 sai com ele; depois confere pc e topo (prof_depois < 0:
+ * instrucao sem continuacao conhecida, volta ao interpretador).
+ */
+static void template_runtime(Gerador *g, const DisasmInsn *x, int32_t prof, int32_t prof_depois) {
+    Emissor *e = &g->e;
+    mov_imm64(e, RAX, (uint64_t)(uintptr_t)(g->code->code + x->pc));
+    op_mem(e, 1, 0x89, RAX, R_FRAME, (int32_t)offsetof(Frame, pc));
+    sincronizar_topo(g, prof);
+    mov_rr(e, RDI, R_FRAME);
+    mov_rr(e, RSI, R_OPCOES);
+    mov_imm64(e, RAX, (uint64_t)(uintptr_t)opcode_handlers[x->opcode]);
+    byte(e, 0xFF);                                      /* call rax */
+    byte(e, 0xD0);
+    byte(e, 0x85);                                      /* test eax, eax */
+    byte(e, 0xC0);
+    salto_para(g, jcc(e, CC_NE), PARA_SAIDA);
+
+    if (prof_depois < 0) {
+        salto_para(g, jmp(e), PARA_VOLTA);
+        return;
+    }
+    mov_imm64(e, RAX, (uint64_t)(uintptr_t)(g->code->code + x->pc + x->length));
+    op_mem(e, 1, 0x39, RAX, R_FRAME, (int32_t)offsetof(Frame, pc));          /* cmp [frame.pc], rax */
+    salto_para(g, jcc(e, CC_NE), PARA_VOLTA);
+    op_mem(e, 1, 0x8D, RAX, R_PILHA, slot(prof_depois));
+    op_mem(e, 1, 0x39, RAX, R_FRAME, (int32_t)offsetof(Frame, stack_top));
+    salto_para(g, jcc(e, CC_NE), PARA_VOLTA);
+}
+
+static void carregar(Emissor *e, int reg, int base, int32_t disp) {
+    op_mem(e, 0, 0x8B, reg, base, disp);                /* mov r32, [base + disp] */
+}
+
+static void guardar(Emissor *e, int reg, int base, int32_t disp) {
+    op_mem(e, 0, 0x89, reg, base, disp);                /* mov [base + disp], r32 */
+}
+
+/* idiv/irem: divisor zero vai ao manipulador (mensagem e erro); -1 sem #DE */
+static void template_divisao(Gerador *g, const DisasmInsn *x, int32_t prof) {
+    Emissor *e = &g->e;
+    int resto = x->opcode == 0x70;
+    carregar(e, RCX, R_PILHA, slot(prof - 1));
+    byte(e, 0x85);                                      /* test ecx, ecx */
+    byte(e, 0xC9);
+    size_t nao_zero = jcc(e, CC_NE);
+    template_runtime(g, x, prof, -1);
+    ligar(e, nao_zero);
+    carregar(e, RAX, R_PILHA, slot(prof - 2));
+    byte(e, 0x83);                                      /* cmp ecx, -1 */
+    byte(e, 0xF9);
+    byte(e, 0xFF);
+    size_t normal = jcc(e, CC_NE);
+    if (resto) {
+        byte(e, 0x31);                                  /* xor eax, eax */
+        byte(e, 0xC0);
+    } else {
+        byte(e, 0xF7);                                  /* neg eax */
+        byte(e, 0xD8);
+    }
+    size_t fim = jmp(e);
+    ligar(e, normal);
+    byte(e, 0x99);                                      /* cdq */
+    byte(e, 0xF7);                                      /* idiv ecx */
+    byte(e, 0xF9);
+    if (resto) {
+        byte(e, 0x89);                                  /* mov eax, edx */
+        byte(e, 0xD0);
+    }
+    ligar(e, fim);
+    guardar(e, RAX, R_PILHA, slot(prof - 2));
+}
+
+static void template_tableswitch(Gerador *g, const DisasmInsn *x, int32_t prof) {
+    Emissor *e = &g->e;
+    const u1 *t = tabela_switch(g->code, x->pc);
+    int32_t lo = le_s32(t + 4), hi = le_s32(t + 8);
+    carregar(e, RAX, R_PILHA, slot(prof - 1));
+    byte(e, 0x2D);                                      /* sub eax, lo */
+    dword(e, (uint32_t)lo);
+    byte(e, 0x3D);                                      /* cmp eax, hi - lo */
+    dword(e, (uint32_t)hi - (uint32_t)lo);
+    salto_para_pc(g, jcc(e, CC_A), (uint32_t)((int64_t)x->pc + le_s32(t)));
+    static const uint8_t lea_rcx[] = { 0x48, 0x8D, 0x0D };             /* lea rcx, [rip + tabela] */
+    emitir(e, lea_rcx, sizeof lea_rcx);
+    dword(e, 0);
+    size_t rel = e->len - 4;
+    static const uint8_t salto[] = { 0x48, 0x63, 0x04, 0x81,           /* movsxd rax, [rcx + rax*4] */
+                                     0x48, 0x01, 0xC8,                 /* add rax, rcx */
+                                     0xFF, 0xE0 };                     /* jmp rax */
+    emitir(e, salto, sizeof salto);
+    ligar(e, rel);
+    size_t base = e->len;
+    for (int64_t k = 0; k <= (int64_t)hi - lo; k++) {
+        dword(e, 0);
+        anotar(g, &g->pend, &g->npend, &g->cap_pend, e->len - 4, base,
+               (uint32_t)((int64_t)x->pc + le_s32(t + 12 + 4 * k)));
+    }
+}
+
+/* execute_jit_call(frame, options, sitio) */
+static void template_chamada_sitio(Gerador *g, JitCallSite *sitio, int32_t prof) {
+    Emissor *e = &g->e;
+    sincronizar_topo(g, prof);
+    mov_rr(e, RDI, R_FRAME);
+    mov_rr(e, RSI, R_OPCOES);
+    mov_imm64(e, RDX, (uint64_t)(uintptr_t)sitio);
+    mov_imm64(e, RAX, (uint64_t)(uintptr_t)execute_jit_call);
+    byte(e, 0xFF);                                      /* call rax */
+    byte(e, 0xD0);
+    byte(e, 0x85);                                      /* test eax, eax */
+    byte(e, 0xC0);
+    salto_para(g, jcc(e, CC_NE), PARA_SAIDA);
+}
+
+/* add/sub rsp, imm32 */
+static void ajustar_rsp(Emissor *e, int sub, int32_t n) {
+    byte(e, 0x48);
+    byte(e, 0x81);
+    byte(e, sub ? 0xEC : 0xC4);
+    dword(e, (uint32_t)n);
+}
+
+/*
+ * Recursao (invokestatic do proprio metodo): o Frame do chamado e montado
+ * na pilha nativa e o codigo e chamado com call rel32 para o inicio do
+ * proprio buffer. Perto do limite de profundidade, usa o caminho do
+ * sitio (que reporta o StackOverflowError).
+ */
+static void template_chamada_propria(Gerador *g, JitCallSite *sitio, int32_t prof) {
+    Emissor *e = &g->e;
+    const CodeAttribute *code = sitio->code;
+    int32_t dados = (int32_t)offsetof(Frame, slots_data);
+    int32_t tamanho = dados + slot((int32_t)code->max_locals + code->max_stack);
+    tamanho = (tamanho + 15) & ~15;                     /* rsp continua alinhado em 16 */
+    int32_t args = prof - sitio->nslots;
+    uint64_t profundidade = (uint64_t)(uintptr_t)execute_depth_counter();
+
+    mov_imm64(e, RAX, profundidade);
+    op_mem(e, 0, 0x81, 7, RAX, 0);                      /* cmp dword [rax], limite */
+    dword(e, EXECUTE_MAX_DEPTH);
+    size_t lenta = jcc(e, CC_GE);
+
+    ajustar_rsp(e, 1, tamanho);
+    mov_imm64(e, RAX, (uint64_t)(uintptr_t)sitio->cls);
+    op_mem(e, 1, 0x89, RAX, RSP, (int32_t)offsetof(Frame, class_file));
+    mov_imm64(e, RAX, (uint64_t)(uintptr_t)sitio->method);
+    op_mem(e, 1, 0x89, RAX, RSP, (int32_t)offsetof(Frame, method_info));
+    mov_imm64(e, RAX, (uint64_t)(uintptr_t)code->code);
+    op_mem(e, 1, 0x89, RAX, RSP, (int32_t)offsetof(Frame, code));
+    op_mem(e, 1, 0x89, RAX, RSP, (int32_t)offsetof(Frame, pc));
+    op_mem(e, 1, 0x8D, RAX, RSP, dados);
+    op_mem(e, 1, 0x89, RAX, RSP, (int32_t)offsetof(Frame, local_vars));
+    op_mem(e, 1, 0x8D, RAX, RSP, dados + slot(code->max_locals));
+    op_mem(e, 1, 0x89, RAX, RSP, (int32_t)offsetof(Frame, operand_stack));
+    op_mem(e, 1, 0x89, RAX, RSP, (int32_t)offsetof(Frame, stack_top));
+    op_mem(e, 1, 0x89, R_FRAME, RSP, (int32_t)offsetof(Frame, next));
+    for (int32_t k = 0; k < code->max_locals; k++) {
+        if (k < sitio->nslots) {
+            carregar(e, RAX, R_PILHA, slot(args + k));
+            guardar(e, RAX, RSP, dados + slot(k));
+        } else {
+            mov_mem_imm(e, RSP, dados + slot(k), 0);
+        }
+    }
+
+    mov_imm64(e, RAX, profundidade);
+    op_mem(e, 0, 0xFF, 0, RAX, 0);                      /* inc dword [rax] */
+    mov_rr(e, RDI, RSP);
+    mov_rr(e, RSI, R_OPCOES);
+    byte(e, 0xE8);                                      /* call inicio */
+    dword(e, (uint32_t)-(int32_t)(e->len + 4));
+    mov_imm64(e, RCX, profundidade);
+    op_mem(e, 0, 0xFF, 1, RCX, 0);                      /* dec dword [rcx] */
+    byte(e, 0x83);                                      /* cmp eax, JIT_INTERPRET */
+    byte(e, 0xF8);
+    byte(e, JIT_INTERPRET);
+    size_t nativo = jcc(e, CC_NE);
+    mov_rr(e, RDI, RSP);
+    mov_rr(e, RSI, R_OPCOES);
+    mov_imm64(e, RAX, (uint64_t)(uintptr_t)execute_resume_frame);
+    byte(e, 0xFF);                                      /* call rax */
+    byte(e, 0xD0);
+    ligar(e, nativo);
+    byte(e, 0x85);                                      /* test eax, eax */
+    byte(e, 0xC0);
+    size_t erro = jcc(e, CC_S);
+
+    if (sitio->ret_slots) {
+        op_mem(e, 1, 0x8B, RCX, RSP, (int32_t)offsetof(Frame, stack_top));
+        for (int32_t k = 0; k < sitio->ret_slots; k++) {
+            carregar(e, RAX, RCX, slot(k - sitio->ret_slots));
+            guardar(e, RAX, R_PILHA, slot(args + k));
+        }
+    }
+    ajustar_rsp(e, 0, tamanho);
+    size_t fim = jmp(e);
+
+    ligar(e, erro);
+    ajustar_rsp(e, 0, tamanho);
+    salto_para(g, jmp(e), PARA_SAIDA);
+
+    ligar(e, lenta);
+    template_chamada_sitio(g, sitio, prof);
+    ligar(e, fim);
+}
+
+/*
+ * invokestatic para a propria classe (ja em inicializacao, nada a fazer
+ * no <clinit>). Decidido so pelos nomes do constant pool: a compilacao
+ * pode rodar fora da thread que executa, e resolver (cp_resolved) pode
+ * carregar classes. A recursao (mesmo nome e descritor do metodo, que e
+ * static) ja tem o alvo; os outros sitios resolvem na primeira chamada
+ * (execute_jit_call).
+ */
+static int template_chamada_direta(Gerador *g, const DisasmInsn *x, int32_t prof) {
+    ClassFile *cf = g->cf;
+    u2 idx = le_u2(g->code->code + x->pc + 1);
+    const char *classe = NULL, *nome = NULL, *desc = NULL;
+    cp_referencia_metodo(cf->constant_pool, cf->constant_pool_count, idx, &classe, &nome, &desc);
+    const char *propria = classfile_this_name(cf);
+    if (!classe || !nome || !desc || !propria || strcmp(classe, propria) != 0) return 0;
+    const char *ret = strchr(desc, ')');
+    if (desc[0] != '(' || !ret) return 0;
+
+    Sitio *s = (Sitio *)calloc(1, sizeof(Sitio));
+    if (!s) return 0;
+    s->s.cls = cf;
+    s->s.cp_index = idx;
+    s->s.pc = g->code->code + x->pc;
+    s->s.nslots = descriptor_arg_slots(desc);
+    s->s.ret_slots = (u1)slots_do_tipo(ret[1]);
+    s->prox = g->sitios;
+    g->sitios = s;
+
+    const char *meu_nome = cp_utf8(cf->constant_pool, cf->constant_pool_count, g->method->name_index);
+    const char *meu_desc = cp_utf8(cf->constant_pool, cf->constant_pool_count, g->method->descriptor_index);
+    if ((g->method->access_flags & 0x0008) && meu_nome && meu_desc &&
+        strcmp(nome, meu_nome) == 0 && strcmp(desc, meu_desc) == 0) {
+        s->s.method = (MethodInfo *)g->method;
+        s->s.code = g->code;
+        template_chamada_propria(g, &s->s, prof);
+    } else {
+        template_chamada_sitio(g, &s->s, prof);
+    }
+    return 1;
+}
+
+static int cc_do_if(u1 op) {
+    static const int cc[6] = { CC_E, CC_NE, CC_L, CC_GE, CC_G, CC_LE };
+    return cc[(op - 0x99) % 6];
+}
+
+static void gerar_instrucao(Gerador *g, const ClassFile *cf, const DisasmInsn *x, int32_t prof) {
+    Emissor *e = &g->e;
+    const u1 *ins = g->code->code + x->pc;
+    u1 op = x->opcode;
+    int sai, entra;
+
+    switch (op) {
+        case 0x00:                                          /* nop */
+            return;
+        case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07: case 0x08:
+            mov_mem_imm(e, R_PILHA, slot(prof), op == 0x01 ? 0 : op - 0x03);
+            return;
+        case 0x10:                                          /* bipush */
+            mov_mem_imm(e, R_PILHA, slot(prof), (int8_t)ins[1]);
+            return;
+        case 0x11:                                          /* sipush */
+            mov_mem_imm(e, R_PILHA, slot(prof), le_s16(ins + 1));
+            return;
+        case 0x15: case 0x1A: case 0x1B: case 0x1C: case 0x1D: /* iload */
+            carregar(e, RAX, R_LOCAIS, slot(op == 0x15 ? ins[1] : op - 0x1A));
+            guardar(e, RAX, R_PILHA, slot(prof));
+            return;
+        case 0x36: case 0x3B: case 0x3C: case 0x3D: case 0x3E: /* istore */
+            carregar(e, RAX, R_PILHA, slot(prof - 1));
+            guardar(e, RAX, R_LOCAIS, slot(op == 0x36 ? ins[1] : op - 0x3B));
+            return;
+        case 0x57:                                          /* pop */
+            return;
+        case 0x59:                                          /* dup */
+            carregar(e, RAX, R_PILHA, slot(prof - 1));
+            guardar(e, RAX, R_PILHA, slot(prof));
+            return;
+        case 0x60: case 0x64:                               /* iadd, isub */
+            carregar(e, RAX, R_PILHA, slot(prof - 2));
+            op_mem(e, 0, op == 0x60 ? 0x03 : 0x2B, RAX, R_PILHA, slot(prof - 1));
+            guardar(e, RAX, R_PILHA, slot(prof - 2));
+            return;
+        case 0x68:                                          /* imul */
+            carregar(e, RAX, R_PILHA, slot(prof - 2));
+            op2_mem(e, 0xAF, RAX, R_PILHA, slot(prof - 1));
+            guardar(e, RAX, R_PILHA, slot(prof - 2));
+            return;
+        case 0x6C: case 0x70:
+            template_divisao(g, x, prof);
+            return;
+        case 0x74:                                          /* ineg: neg dword [topo] */
+            op_mem(e, 0, 0xF7, 3, R_PILHA, slot(prof - 1));
+            return;
+        case 0x84:                                          /* iinc: add dword [local], imm8 */
+            op_mem(e, 0, 0x83, 0, R_LOCAIS, slot(ins[1]));
+            byte(e, ins[2]);
+            return;
+        case 0x99: case 0x9A: case 0x9B: case 0x9C: case 0x9D: case 0x9E:
+            carregar(e, RAX, R_PILHA, slot(prof - 1));
+            byte(e, 0x85);                                  /* test eax, eax */
+            byte(e, 0xC0);
+            salto_para_pc(g, jcc(e, cc_do_if(op)), (uint32_t)((int64_t)x->pc + le_s16(ins + 1)));
+            return;
+        case 0x9F: case 0xA0: case 0xA1: case 0xA2: case 0xA3: case 0xA4:
+            carregar(e, RAX, R_PILHA, slot(prof - 2));
+            op_mem(e, 0, 0x3B, RAX, R_PILHA, slot(prof - 1));  /* cmp eax, [b] */
+            salto_para_pc(g, jcc(e, cc_do_if(op)), (uint32_t)((int64_t)x->pc + le_s16(ins + 1)));
+            return;
+        case 0xA7:                                          /* goto */
+            salto_para_pc(g, jmp(e), (uint32_t)((int64_t)x->pc + le_s16(ins + 1)));
+            return;
+        case 0xAA:
+            template_tableswitch(g, x, prof);
+            return;
+        case 0xAC: case 0xB0: case 0xB1:                    /* ireturn, areturn, return */
+            template_retorno(g, prof);
+            return;
+        case 0xB8:                                          /* invokestatic */
+            if (template_chamada_direta(g, x, prof)) return;
+            /* fallthrough */
+        default:
+            if (efeito(cf, ins, &sai, &entra)) template_runtime(g, x, prof, prof - sai + entra);
+            else template_runtime(g, x, prof, -1);
+            return;
+    }
+}
+
+/* Prologo: salva os registradores fixos (pilha alinhada em 16 para as chamadas) */
+static void gerar_prologo(Emissor *e) {
+    push(e, RBX);
+    push(e, R12);
+    push(e, R13);
+    push(e, R14);
+    push(e, R15);
+    mov_rr(e, R_FRAME, RDI);
+    mov_rr(e, R_OPCOES, RSI);
+    op_mem(e, 1, 0x8B, R_LOCAIS, R_FRAME, (int32_t)offsetof(Frame, local_vars));
+    op_mem(e, 1, 0x8B, R_PILHA, R_FRAME, (int32_t)offsetof(Frame, operand_stack));
+}
+
+static void gerar_epilogo(Emissor *e) {
+    pop(e, R15);
+    pop(e, R14);
+    pop(e, R13);
+    pop(e, R12);
+    pop(e, RBX);
+    byte(e, 0xC3);                                      /* ret */
+}
+
+/* Gera o codigo em g->e; 0 se o metodo nao puder ser compilado */
+static int gerar(Gerador *g, const ClassFile *cf, const DisasmMethod *dm, const int32_t *prof,
+                 const uint32_t *insn_do_pc, const uint8_t *laco) {
+    gerar_prologo(&g->e);
+    for (uint32_t i = 0; i < dm->count; i++) {
+        g->nativo[i] = g->e.len;
+        if (prof[i] >= 0) gerar_instrucao(g, cf, &dm->insns[i], prof[i]);
+    }
+
+    g->volta = g->e.len;
+    byte(&g->e, 0xB8);                                  /* mov eax, JIT_INTERPRET */
+    dword(&g->e, JIT_INTERPRET);
+    g->saida = g->e.len;
+    gerar_epilogo(&g->e);
+
+    /* Entradas OSR: o Frame ja tem locais e pilha; so falta o prologo */
+    uint32_t nlacos = 0;
+    for (uint32_t i = 0; i < dm->count; i++) nlacos += laco[i] && prof[i] >= 0;
+    g->osr = (EntradaOsr *)malloc((nlacos ? nlacos : 1) * sizeof(EntradaOsr));
+    if (!g->osr) return 0;
+    for (uint32_t i = 0; i < dm->count; i++) {
+        if (!laco[i] || prof[i] < 0) continue;
+        g->osr[g->nosr].pc = dm->insns[i].pc;
+        g->osr[g->nosr].offset = g->e.len;
+        g->nosr++;
+        gerar_prologo(&g->e);
+        ligar_em(&g->e, jmp(&g->e), g->nativo[i]);
+    }
+    if (g->e.sem_memoria) return 0;
+
+    for (size_t k = 0; k < g->nlocais; k++) {
+        ligar_em(&g->e, g->locais[k].pos, g->locais[k].base == PARA_SAIDA ? g->saida : g->volta);
+    }
+    for (size_t k = 0; k < g->npend; k++) {
+        const Pendente *p = &g->pend[k];
+        uint32_t i = p->alvo_pc < g->code->code_length ? insn_do_pc[p->alvo_pc] : UINT32_MAX;
+        if (i == UINT32_MAX || prof[i] < 0) return 0;
+        if (p->base) gravar32(&g->e, p->pos, (int32_t)((int64_t)g->nativo[i] - (int64_t)p->base));
+        else ligar_em(&g->e, p->pos, g->nativo[i]);
+    }
+    return 1;
+}
+
+/* Nome do metodo no perf map: Classe.metodo(descritor) */
+static void nome_perf(const ClassFile *cf, const MethodInfo *m, char *buf, size_t cap) {
+    const char *classe = classfile_this_name(cf);
+    const char *nome = cp_utf8(cf->constant_pool, cf->constant_pool_count, m->name_index);
+    const char *desc = cp_utf8(cf->constant_pool, cf->constant_pool_count, m->descriptor_index);
+    snprintf(buf, cap, "%s.%s%s", classe ? classe : "?", nome ? nome : "?", desc ? desc : "");
+}
+
+/*
+ * Compila c (na thread que executa, ou numa compiladora). So le a classe:
+ * nada aqui resolve referencias ou carrega classes (ver
+ * template_chamada_direta).
+ */
+static void compilar(Compilado *c) {
+    ClassFile *cf = c->cf;
+    const MethodInfo *method = c->method;
+    const CodeAttribute *code = c->code;
+    DisasmArena arena;
+    DisasmMethod dm;
+    disasm_arena_init(&arena);
+    if (!disasm_decode(cf, code, &arena, &dm) || dm.count == 0) {
+        disasm_arena_free(&arena);
+        return;
+    }
+
+    Analise a = { cf, code, &dm, NULL, NULL, NULL, 0, NULL };
+    Gerador g;
+    memset(&g, 0, sizeof g);
+    g.cf = cf;
+    g.method = method;
+    g.code = code;
+    a.insn_do_pc = (uint32_t *)malloc((code->code_length ? code->code_length : 1) * sizeof(uint32_t));
+    a.prof = (int32_t *)malloc(dm.count * sizeof(int32_t));
+    a.fila = (uint32_t *)malloc(dm.count * sizeof(uint32_t));
+    a.laco = (uint8_t *)calloc(dm.count, 1);
+    g.nativo = (size_t *)malloc(dm.count * sizeof(size_t));
+
+    if (a.insn_do_pc && a.prof && a.fila && a.laco && g.nativo) {
+        memset(a.insn_do_pc, 0xFF, code->code_length * sizeof(uint32_t));
+        for (uint32_t i = 0; i < dm.count; i++) {
+            a.insn_do_pc[dm.insns[i].pc] = i;
+            a.prof[i] = -1;
+        }
+        CodeCacheStats cs;
+        code_cache_stats(cache, &cs);
+        if (analisar(&a) && gerar(&g, cf, &dm, a.prof, a.insn_do_pc, a.laco) && g.e.len <= cs.capacity) {
+            char nome[256];
+            nome_perf(cf, method, nome, sizeof nome);
+            c->bytes = g.e.len;
+            c->mem = code_cache_install(cache, g.e.buf, g.e.len, nome);
+            c->sem_espaco = !c->mem;
+            if (c->mem) {
+                c->sitios = g.sitios;
+                g.sitios = NULL;
+                c->osr = g.osr;
+                c->nosr = g.nosr;
+                g.osr = NULL;
+                /* publica por ultimo: quem ve fn ve tambem osr e mem */
+                __atomic_store_n(&c->fn, (JitFunction)(uintptr_t)c->mem, __ATOMIC_RELEASE);
+            }
+        }
+    }
+
+    free(a.insn_do_pc);
+    free(a.prof);
+    free(a.fila);
+    free(a.laco);
+    free(g.nativo);
+    free(g.osr);
+    free(g.e.buf);
+    free(g.pend);
+    free(g.locais);
+    liberar_sitios(g.sitios);
+    disasm_arena_free(&arena);
+}
+
+#endif /* JIT_X86_64 */
+
+/* ============================================================
+ * API publica
+ * ============================================================ */
+bool jit_available(void) {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+/* Conclusao de uma compilacao (com a trava) */
+static void registrar(Compilado *c, uint64_t inicio) {
+    compilacao_total_ns += agora_ns() - inicio;
+    if (c->fn) {
+        total_metodos++;
+        total_bytes += c->bytes;
+    } else if (!c->sem_espaco) {
+        total_falhas++;
+    }
+    __atomic_store_n(&c->estado, c->sem_espaco ? SEM_ESPACO : PRONTO, __ATOMIC_RELEASE);
+}
+
+/* Compiladora: sempre o pedido mais quente da fila */
+static void *compiladora(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&trava);
+    for (;;) {
+        while (!encerrar && fila_n == 0) pthread_cond_wait(&tem_pedido, &trava);
+        if (encerrar) break;
+        size_t melhor = 0;
+        for (size_t i = 1; i < fila_n; i++) {
+            if (__atomic_load_n(&fila[i]->calor, __ATOMIC_RELAXED) >
+                __atomic_load_n(&fila[melhor]->calor, __ATOMIC_RELAXED)) {
+                melhor = i;
+            }
+        }
+        Compilado *c = fila[melhor];
+        fila[melhor] = fila[--fila_n];
+        uint64_t inicio = agora_ns();
+        uint64_t espera = inicio - c->enfileirado_ns;
+        espera_total_ns += espera;
+        if (espera > espera_max_ns) espera_max_ns = espera;
+        __atomic_store_n(&c->estado, COMPILANDO, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&trava);
+
+#ifdef JIT_X86_64
+        compilar(c);
+#endif
+
+        pthread_mutex_lock(&trava);
+        registrar(c, inicio);
+    }
+    pthread_mutex_unlock(&trava);
+    return NULL;
+}
+
+void jit_configure(const JitConfig *config) {
+    limite_chamadas = config->invoke_threshold ? config->invoke_threshold : JIT_DEFAULT_INVOKE_THRESHOLD;
+    limite_saltos = config->backedge_threshold ? config->backedge_threshold : JIT_DEFAULT_BACKEDGE_THRESHOLD;
+    if (!jit_available()) return;
+    if (!cache) cache = code_cache_new(config->code_cache_bytes, config->perf_map);
+    int threads = config->threads;
+    if (threads <= 0 || compiladoras) return;
+
+    compiladoras = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
+    if (!compiladoras) return;      /* sem threads: compila na thread que executa */
+    encerrar = false;
+    while (ncompiladoras < threads &&
+           pthread_create(&compiladoras[ncompiladoras], NULL, compiladora, NULL) == 0) {
+        ncompiladoras++;
+    }
+    if (ncompiladoras == 0) {
+        free(compiladoras);
+        compiladoras = NULL;
+    }
+}
+
+/* Metodo passou do limite: fila das compiladoras, ou compila agora sem elas */
+static void promover(Compilado *c, ClassFile *cf, const CodeAttribute *code) {
+    c->cf = cf;
+    c->code = code;
+    if (ncompiladoras == 0) {
+        __atomic_store_n(&c->estado, COMPILANDO, __ATOMIC_RELAXED);
+        uint64_t inicio = agora_ns();
+#ifdef JIT_X86_64
+        compilar(c);
+#endif
+        pthread_mutex_lock(&trava);
+        registrar(c, inicio);
+        pthread_mutex_unlock(&trava);
+        return;
+    }
+
+    pthread_mutex_lock(&trava);
+    if (fila_n == fila_cap) {
+        size_t cap = fila_cap ? fila_cap * 2 : 16;
+        Compilado **nova = (Compilado **)realloc(fila, cap * sizeof(Compilado *));
+        if (!nova) {
+            pthread_mutex_unlock(&trava);   /* tenta de novo no proximo limite */
+            c->chamadas = 0;
+            return;
+        }
+        fila = nova;
+        fila_cap = cap;
+    }
+    c->enfileirado_ns = agora_ns();
+    __atomic_store_n(&c->estado, NA_FILA, __ATOMIC_RELAXED);
+    fila[fila_n++] = c;
+    total_pedidos++;
+    pthread_cond_signal(&tem_pedido);
+    pthread_mutex_unlock(&trava);
+}
+
+/* Volta ao interpretador frio: contadores zerados, como se nunca tivesse rodado */
+static void esfriar(Compilado *c) {
+    c->chamadas = 0;
+    for (size_t i = 0; i < c->nlacos; i++) c->lacos[i].saltos = 0;
+    __atomic_store_n(&c->calor, 0, __ATOMIC_RELAXED);
+    c->sem_espaco = false;
+    __atomic_store_n(&c->estado, FRIO, __ATOMIC_RELAXED);
+}
+
+/* Tira o codigo de c do cache (nenhuma ativacao dele na pilha nativa) */
+static void despejar(Compilado *c) {
+    __atomic_store_n(&c->fn, NULL, __ATOMIC_RELAXED);
+    code_cache_release(cache, c->mem);
+    c->mem = NULL;
+    liberar_sitios(c->sitios);
+    c->sitios = NULL;
+    free(c->osr);
+    c->osr = NULL;
+    c->nosr = 0;
+    esfriar(c);
+    pthread_mutex_lock(&trava);
+    total_despejos++;
+    pthread_mutex_unlock(&trava);
+}
+
+/*
+ * Despeja os compilados usados ha mais tempo (e fora da pilha nativa) ate
+ * somar n bytes. false se nao havia nada a despejar.
+ */
+static bool abrir_espaco(size_t n) {
+    size_t liberado = 0;
+    bool algum = false;
+    while (liberado < n) {
+        Compilado *vitima = NULL;
+        for (size_t i = 0; i < tabela_cap; i++) {
+            Compilado *c = tabela[i];
+            if (!c || __atomic_load_n(&c->estado, __ATOMIC_ACQUIRE) != PRONTO || !c->mem || c->ativos) continue;
+            if (!vitima || c->ultimo_uso < vitima->ultimo_uso) vitima = c;
+        }
+        if (!vitima) break;
+        liberado += vitima->bytes;
+        despejar(vitima);
+        algum = true;
+    }
+    return algum;
+}
+
+/*
+ * true se o metodo ainda conta para a promocao. Um metodo que nao coube no
+ * cache abre espaco e volta para a fila (ou esfria, se nada pode sair).
+ */
+static bool contando(Compilado *c) {
+    int estado = __atomic_load_n(&c->estado, __ATOMIC_ACQUIRE);
+    if (estado != SEM_ESPACO) return estado == FRIO;
+    bool abriu = abrir_espaco(c->bytes);
+    esfriar(c);
+    if (abriu) promover(c, c->cf, c->code);
+    return false;
+}
+
+/* Entrada do metodo (ja procurado ou inserido na tabela) */
+static Compilado *entrada(const MethodInfo *method) {
+    Compilado *c = procurar(method);
+    return c ? c : inserir(method);
+}
+
+JitFunction jit_on_invoke(ClassFile *cf, const MethodInfo *method, const CodeAttribute *code) {
+    if (!jit_available()) return NULL;
+    Compilado *c = entrada(method);
+    if (!c) return NULL;
+    JitFunction fn = __atomic_load_n(&c->fn, __ATOMIC_ACQUIRE);
+    if (fn) return fn;
+    __atomic_add_fetch(&c->calor, 1, __ATOMIC_RELAXED);
+    if (!contando(c)) return NULL;      /* na fila, ou falhou */
+    if (++c->chamadas < limite_chamadas) return NULL;
+    promover(c, cf, code);
+    return __atomic_load_n(&c->fn, __ATOMIC_ACQUIRE);
+}
+
+JitFunction jit_on_backedge(const Frame *frame) {
+    if (!jit_available()) return NULL;
+    Compilado *c = entrada(frame->method_info);
+    if (!c) return NULL;
+    u4 pc = (u4)(frame->pc - frame->code);
+
+    JitFunction fn = __atomic_load_n(&c->fn, __ATOMIC_ACQUIRE);
+    if (!fn) {
+        __atomic_add_fetch(&c->calor, 1, __ATOMIC_RELAXED);
+        if (!contando(c)) return NULL;
+        Laco *l = NULL;
+        for (size_t i = 0; i < c->nlacos; i++) {
+            if (c->lacos[i].pc == pc) l = &c->lacos[i];
+        }
+        if (!l) {
+            Laco *v = (Laco *)realloc(c->lacos, (c->nlacos + 1) * sizeof(Laco));
+            if (!v) return NULL;
+            c->lacos = v;
+            l = &v[c->nlacos++];
+            l->pc = pc;
+            l->saltos = 0;
+        }
+        if (++l->saltos < limite_saltos) return NULL;
+        const CodeAttribute *code = cp_cache_code(frame->class_file, frame->method_info);
+        if (!code) return NULL;
+        promover(c, frame->class_file, code);
+        if (!__atomic_load_n(&c->fn, __ATOMIC_ACQUIRE)) return NULL;
+    }
+
+    /* busca binaria pelo cabecalho */
+    size_t lo = 0, hi = c->nosr;
+    while (lo < hi) {
+        size_t m = (lo + hi) / 2;
+        if (c->osr[m].pc < pc) lo = m + 1;
+        else hi = m;
+    }
+    if (lo == c->nosr || c->osr[lo].pc != pc) return NULL;
+    pthread_mutex_lock(&trava);
+    total_osr++;
+    pthread_mutex_unlock(&trava);
+    return (JitFunction)(uintptr_t)((uint8_t *)c->mem + c->osr[lo].offset);
+}
+
+int jit_execute(JitFunction fn, Frame *frame, const CliOptions *options) {
+    Compilado *c = procurar(frame->method_info);
+    if (!c) return fn(frame, options);
+    c->ativos++;
+    c->ultimo_uso = ++relogio;
+    int status = fn(frame, options);
+    c->ativos--;
+    return status;
+}
+
+void jit_release_all(void) {
+    pthread_mutex_lock(&trava);
+    encerrar = true;
+    pthread_cond_broadcast(&tem_pedido);
+    pthread_mutex_unlock(&trava);
+    for (int i = 0; i < ncompiladoras; i++) pthread_join(compiladoras[i], NULL);
+    free(compiladoras);
+    compiladoras = NULL;
+    ncompiladoras = 0;
+    free(fila);
+    fila = NULL;
+    fila_n = fila_cap = 0;
+
+    for (size_t i = 0; i < tabela_cap; i++) {
+        Compilado *c = tabela[i];
+        if (!c) continue;
+        liberar_sitios(c->sitios);
+        free(c->lacos);
+        free(c->osr);
+        free(c);
+    }
+    free(tabela);
+    tabela = NULL;
+    tabela_cap = tabela_n = 0;
+    code_cache_free(cache);
+    cache = NULL;
+    relogio = 0;
+    total_metodos = total_falhas = total_osr = total_pedidos = total_despejos = 0;
+    total_bytes = 0;
+    espera_total_ns = espera_max_ns = compilacao_total_ns = 0;
+}
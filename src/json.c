@@ -13,10 +13,12 @@
 #include "resolve.h"    // Pessoa D (para resolver nomes)
 #include "attributes.h" // Pessoa C (para parsear Code)
 #include "disasm.h"     // Pessoa D (para disassembly)
+#include "cfg.h"        // Grafo de fluxo de controle (--cfg)
 
 /* --- Protótipos Estáticos (Forward Declarations) --- */
 
-static void json_print_string(const char *str);
+static void json_escape(OutSink *out, const char *str);
+static void json_print_string(OutSink *out, const char *str);
 
 static const AttributeInfo* find_raw_attribute_by_name(
     const ClassFile *cf, 
@@ -25,48 +27,34 @@ static const AttributeInfo* find_raw_attribute_by_name(
     const char *name
 );
 
-static void json_print_cp(ClassFile *cf); // Corrigindo erro
-static void json_print_fields(ClassFile *cf, const CliOptions *options); // Corrigindo erro
+static void json_print_cp(OutSink *out, ClassFile *cf); // Corrigindo erro
+static void json_print_fields(OutSink *out, ClassFile *cf, const CliOptions *options); // Corrigindo erro
 
-static void json_print_code_attribute(
+static void json_print_code_attribute(OutSink *out, 
     ClassFile *cf, 
     const MethodInfo *method, 
-    const CliOptions *options
+    const CliOptions *options,
+    DisasmArena *arena,
+    Cfg *cfg
 );
 
-static void json_print_methods(ClassFile *cf, const CliOptions *options);
+static void json_print_method(OutSink *out, ClassFile *cf, const MethodInfo *method, const CliOptions *options,
+                              DisasmArena *arena, Cfg *cfg);
+static void json_print_methods(OutSink *out, ClassFile *cf, const CliOptions *options);
 
 
 /* --- Implementações das Funções --- */
 
+// Helper para escapar texto para JSON (sem as aspas); varredura por tabela em out_sink.c
+static void json_escape(OutSink *out, const char *str) {
+    out_json_escaped(out, str);
+}
+
 // Helper para escapar strings para JSON
-static void json_print_string(const char *str) {
-    if (!str) {
-        printf("\"\"");
-        return;
-    }
-    printf("\"");
-    while (*str) {
-        switch (*str) {
-            case '\"': printf("\\\""); break;
-            case '\\': printf("\\\\"); break;
-            case '\n': printf("\\n"); break;
-            case '\r': printf("\\r"); break;
-            case '\t': printf("\\t"); break;
-            default:
-                if (*str >= 0 && *str < 32) {
-                    printf("\\u00%02x", (unsigned char)*str);
-                } else if (*str == 127) {
-                     printf("\\u007f");
-                }
-                else {
-                    putchar(*str);
-                }
-                break;
-        }
-        str++;
-    }
-    printf("\"");
+static void json_print_string(OutSink *out, const char *str) {
+    out_char(out, '"');
+    if (str) json_escape(out, str);
+    out_char(out, '"');
 }
 
 /**
@@ -94,87 +82,167 @@ static const AttributeInfo* find_raw_attribute_by_name(
 /**
  * @brief (IMPLEMENTAÇÃO FALTANTE) Helper para imprimir o Constant Pool
  */
-static void json_print_cp(ClassFile *cf) {
-    printf("  \"constant_pool\": [\n");
-    printf("    null"); // CP[0] é sempre nulo
+static void json_print_cp(OutSink *out, ClassFile *cf) {
+    out_str(out, "  \"constant_pool\": [\n");
+    out_str(out, "    null"); // CP[0] é sempre nulo
 
     for (u2 i = 1; i < cf->constant_pool_count; i++) {
-        printf(",\n    { \"index\": %u, ", i);
+        out_str(out, ",\n    { \"index\": ");
+        out_u32(out, i);
+        out_str(out, ", ");
         CpInfo *cp = &cf->constant_pool[i];
         
         switch (cp->tag) {
             case CONSTANT_Utf8:
-                printf("\"tag\": \"Utf8\", \"value\": ");
-                json_print_string(cp->Utf8.bytes);
+                out_str(out, "\"tag\": \"Utf8\", \"value\": ");
+                json_print_string(out, cp->Utf8.bytes);
                 break;
             case CONSTANT_Class:
-                printf("\"tag\": \"Class\", \"name_index\": %u", cp->Class.name_index);
+                out_str(out, "\"tag\": \"Class\", \"name_index\": ");
+                out_u32(out, cp->Class.name_index);
                 break;
             case CONSTANT_String:
-                printf("\"tag\": \"String\", \"string_index\": %u", cp->String.string_index);
+                out_str(out, "\"tag\": \"String\", \"string_index\": ");
+                out_u32(out, cp->String.string_index);
                 break;
             case CONSTANT_Fieldref:
             case CONSTANT_Methodref:
             case CONSTANT_InterfaceMethodref:
-                printf("\"tag\": \"%s\", \"class_index\": %u, \"name_and_type_index\": %u",
-                       cp->tag == CONSTANT_Fieldref ? "Fieldref" : (cp->tag == CONSTANT_Methodref ? "Methodref" : "InterfaceMethodref"),
-                       cp->Ref.class_index, cp->Ref.name_and_type_index);
+                out_str(out, "\"tag\": \"");
+                out_str(out, cp->tag == CONSTANT_Fieldref ? "Fieldref" : (cp->tag == CONSTANT_Methodref ? "Methodref" : "InterfaceMethodref"));
+                out_str(out, "\", \"class_index\": ");
+                out_u32(out, cp->Ref.class_index);
+                out_str(out, ", \"name_and_type_index\": ");
+                out_u32(out, cp->Ref.name_and_type_index);
                 break;
             case CONSTANT_NameAndType:
-                printf("\"tag\": \"NameAndType\", \"name_index\": %u, \"descriptor_index\": %u",
-                       cp->NameAndType.name_index, cp->NameAndType.descriptor_index);
+                out_str(out, "\"tag\": \"NameAndType\", \"name_index\": ");
+                out_u32(out, cp->NameAndType.name_index);
+                out_str(out, ", \"descriptor_index\": ");
+                out_u32(out, cp->NameAndType.descriptor_index);
                 break;
             case CONSTANT_Integer:
-                printf("\"tag\": \"Integer\", \"value\": %d", (int32_t)cp->Num.bytes);
+                out_str(out, "\"tag\": \"Integer\", \"value\": ");
+                out_i32(out, (int32_t)cp->Num.bytes);
                 break;
             case CONSTANT_None:
-                printf("\"tag\": \"None (Slot Vazio)\"");
+                out_str(out, "\"tag\": \"None (Slot Vazio)\"");
                 break;
             default:
-                printf("\"tag\": \"TAG_DESCONHECIDA (%u)\"", cp->tag);
+                out_str(out, "\"tag\": \"TAG_DESCONHECIDA (");
+                out_u32(out, cp->tag);
+                out_str(out, ")\"");
         }
-        printf(" }");
+        out_str(out, " }");
         
         if (cp->tag == CONSTANT_Long || cp->tag == CONSTANT_Double) {
             i++; // Pula o proximo slot
         }
     }
-    printf("\n  ]"); // Fim do array constant_pool
+    out_str(out, "\n  ]"); // Fim do array constant_pool
 }
 
 /**
  * @brief (IMPLEMENTAÇÃO FALTANTE) Helper para imprimir Fields
  */
-static void json_print_fields(ClassFile *cf, const CliOptions *options) {
-    printf("  \"fields\": [\n");
+static void json_print_fields(OutSink *out, ClassFile *cf, const CliOptions *options) {
+    out_str(out, "  \"fields\": [\n");
     for (u2 i = 0; i < cf->fields_count; i++) {
         FieldInfo *field = &cf->fields[i];
         
-        char *name = resolve_literal_to_string(cf, field->name_index);
-        char *desc = resolve_literal_to_string(cf, field->descriptor_index);
+        const char *name = resolve_literal(cf, field->name_index);
+        const char *desc = resolve_literal(cf, field->descriptor_index);
+
+        out_str(out, "    { \"name\": ");
+        json_print_string(out, name);
+        out_str(out, ", \"descriptor\": ");
+        json_print_string(out, desc);
+        out_str(out, ", \"access_flags\": ");
+        out_u32(out, field->access_flags);
+        out_str(out, " }");
+
+        if (i < cf->fields_count - 1) out_str(out, ",\n");
+    }
+    out_str(out, "\n  ]"); // Fim do array fields
+}
 
-        printf("    { \"name\": ");
-        json_print_string(name);
-        printf(", \"descriptor\": ");
-        json_print_string(desc);
-        printf(", \"access_flags\": %u }", field->access_flags);
 
-        free(name);
-        free(desc);
-        
-        if (i < cf->fields_count - 1) printf(",\n");
-    }
-    printf("\n  ]"); // Fim do array fields
+/* indice de bloco/laco, ou null para CFG_NONE */
+static void json_print_indice(OutSink *out, uint32_t v) {
+    if (v == CFG_NONE) out_str(out, "null");
+    else out_u32(out, v);
 }
 
+/**
+ * @brief Imprime o grafo de fluxo de controle (--cfg): blocos, arestas e lacos.
+ */
+static void json_print_cfg(OutSink *out, const Cfg *cfg) {
+    out_str(out, ",\n        \"cfg\": {\n          \"blocks\": [");
+    for (uint32_t k = 0; k < cfg->block_count; k++) {
+        const CfgBlock *b = &cfg->blocks[k];
+        out_str(out, k ? ",\n            { \"id\": " : "\n            { \"id\": ");
+        out_u32(out, k);
+        out_str(out, ", \"start_pc\": ");
+        out_u32(out, b->start_pc);
+        out_str(out, ", \"end_pc\": ");
+        out_u32(out, b->end_pc);
+        out_str(out, ", \"preds\": [");
+        for (uint32_t j = 0; j < b->pred_count; j++) {
+            if (j) out_str(out, ", ");
+            out_u32(out, cfg->edges[cfg->preds[b->pred_first + j]].from);
+        }
+        out_str(out, "], \"succs\": [");
+        for (uint32_t j = 0; j < b->succ_count; j++) {
+            if (j) out_str(out, ", ");
+            out_u32(out, cfg->edges[b->succ_first + j].to);
+        }
+        out_str(out, "], \"idom\": ");
+        json_print_indice(out, b->idom);
+        out_str(out, ", \"loop\": ");
+        json_print_indice(out, b->loop);
+        out_str(out, ", \"loop_depth\": ");
+        out_u32(out, b->loop_depth);
+        out_str(out, (b->flags & CFG_BLOCK_HANDLER) ? ", \"handler\": true" : ", \"handler\": false");
+        out_str(out, (b->flags & CFG_BLOCK_REACHABLE) ? ", \"reachable\": true }" : ", \"reachable\": false }");
+    }
+    out_str(out, cfg->block_count ? "\n          ],\n          \"edges\": [" : "],\n          \"edges\": [");
+    for (uint32_t e = 0; e < cfg->edge_count; e++) {
+        out_str(out, e ? ",\n            { \"from\": " : "\n            { \"from\": ");
+        out_u32(out, cfg->edges[e].from);
+        out_str(out, ", \"to\": ");
+        out_u32(out, cfg->edges[e].to);
+        out_str(out, ", \"kind\": ");
+        json_print_string(out, cfg_edge_kind_name(cfg->edges[e].kind));
+        out_str(out, " }");
+    }
+    out_str(out, cfg->edge_count ? "\n          ],\n          \"loops\": [" : "],\n          \"loops\": [");
+    for (uint32_t l = 0; l < cfg->loop_count; l++) {
+        const CfgLoop *laco = &cfg->loops[l];
+        out_str(out, l ? ",\n            { \"id\": " : "\n            { \"id\": ");
+        out_u32(out, l);
+        out_str(out, ", \"header\": ");
+        out_u32(out, laco->header);
+        out_str(out, ", \"parent\": ");
+        json_print_indice(out, laco->parent);
+        out_str(out, ", \"depth\": ");
+        out_u32(out, laco->depth);
+        out_str(out, ", \"blocks\": ");
+        out_u32(out, laco->block_count);
+        out_str(out, " }");
+    }
+    out_str(out, cfg->loop_count ? "\n          ],\n          \"irreducible\": " : "],\n          \"irreducible\": ");
+    out_str(out, cfg->irreducible ? "true\n        }" : "false\n        }");
+}
 
 /**
  * @brief Imprime o Atributo Code e o Disassembly em JSON.
+ * Com cfg (--cfg), acrescenta o grafo de fluxo de controle.
  */
-static void json_print_code_attribute(ClassFile *cf, const MethodInfo *method, const CliOptions *options) {
+static void json_print_code_attribute(OutSink *out, ClassFile *cf, const MethodInfo *method, const CliOptions *options,
+                                      DisasmArena *arena, Cfg *cfg) {
     
     if (!options->disassemble_code) {
-        printf(",\n      \"code_attribute\": { \"status\": \"omitido via --no-code\" }");
+        out_str(out, ",\n      \"code_attribute\": { \"status\": \"omitido via --no-code\" }");
         return;
     }
 
@@ -186,7 +254,7 @@ static void json_print_code_attribute(ClassFile *cf, const MethodInfo *method, c
     );
 
     if (!code_attr_raw) {
-        printf(",\n      \"code_attribute\": { \"status\": \"ausente (abstrato/nativo)\" }");
+        out_str(out, ",\n      \"code_attribute\": { \"status\": \"ausente (abstrato/nativo)\" }");
         return;
     }
 
@@ -195,135 +263,222 @@ static void json_print_code_attribute(ClassFile *cf, const MethodInfo *method, c
     
     Status parse_status = parse_code_attribute(cf, code_attr_raw, &parsed_code);
     if (parse_status != OK) {
-        printf(",\n      \"code_attribute\": { \"status\": \"erro no parse (Pessoa C)\", \"codigo\": %d }", parse_status);
+        out_str(out, ",\n      \"code_attribute\": { \"status\": \"erro no parse (Pessoa C)\", \"codigo\": ");
+        out_i32(out, parse_status);
+        out_str(out, " }");
         return;
     }
 
-    printf(",\n      \"code_attribute\": {\n");
-    printf("        \"status\": \"parsed\",\n");
-    printf("        \"max_stack\": %u,\n", parsed_code.max_stack);
-    printf("        \"max_locals\": %u,\n", parsed_code.max_locals);
-    printf("        \"code_length\": %u", parsed_code.code_length); // Virgula removida
-
-    DisasmOutput disasm_out;
-    memset(&disasm_out, 0, sizeof(DisasmOutput));
-
-    bool disasm_status = disassemble_method(cf, &parsed_code, &disasm_out);
-
-    if (disasm_status && disasm_out.count > 0) {
-        printf(",\n        \"disassembly\": [\n"); // Virgula adicionada
-        
-        for (u4 i = 0; i < disasm_out.count; i++) {
-            DisasmInstruction *inst = &disasm_out.instructions[i];
-            
-            printf("          { \"pc\": %u, \"mnemonic\": ", (unsigned int)inst->pc);
-            json_print_string(inst->mnemonic);
-            printf(", \"args\": ");
-            json_print_string(inst->args_str);
-            
-            if (inst->resolved_info && inst->resolved_info[0] != '\0') {
-                printf(", \"resolved\": ");
-                json_print_string(inst->resolved_info);
+    out_str(out, ",\n      \"code_attribute\": {\n");
+    out_str(out, "        \"status\": \"parsed\",\n        \"max_stack\": ");
+    out_u32(out, parsed_code.max_stack);
+    out_str(out, ",\n        \"max_locals\": ");
+    out_u32(out, parsed_code.max_locals);
+    out_str(out, ",\n        \"code_length\": ");
+    out_u32(out, parsed_code.code_length); // Virgula removida
+
+    DisasmMethod disasm;
+    bool disasm_status = disasm_decode(cf, &parsed_code, arena, &disasm);
+
+    if (disasm_status && disasm.count > 0) {
+        out_str(out, ",\n        \"disassembly\": [\n"); // Virgula adicionada
+
+        char args[64];
+        for (u4 i = 0; i < disasm.count; i++) {
+            const DisasmInsn *insn = &disasm.insns[i];
+            disasm_format_args(insn, args, sizeof args);
+
+            out_str(out, "          { \"pc\": ");
+            out_u32(out, insn->pc);
+            out_str(out, ", \"mnemonic\": ");
+            json_print_string(out, insn->mnemonic);
+            out_str(out, ", \"args\": ");
+            json_print_string(out, args);
+
+            if (disasm_has_resolved(insn)) {
+                out_str(out, ", \"resolved\": \"");
+                disasm_write_resolved(out, insn, json_escape);
+                out_char(out, '"');
             }
-            
-            printf(" }"); // Fim do objeto instrução
-            if (i < disasm_out.count - 1) printf(",\n");
+
+            out_str(out, " }"); // Fim do objeto instrução
+            if (i < disasm.count - 1) out_str(out, ",\n");
         }
-        
-        printf("\n        ]\n"); // Fim do array de instruções
+
+        out_str(out, "\n        ]"); // Fim do array de instruções
     } else if (disasm_status) {
-         printf(",\n        \"disassembly\": []\n"); // Array vazio
+         out_str(out, ",\n        \"disassembly\": []"); // Array vazio
     } else {
-        printf(",\n        \"disassembly\": { \"status\": \"erro no disassembly (Pessoa D)\" }\n"); // Virgula adicionada
+        out_str(out, ",\n        \"disassembly\": { \"status\": \"erro no disassembly (Pessoa D)\" }"); // Virgula adicionada
     }
-    
-    printf("      }"); // Fim do objeto code_attribute
 
-    free_disasm_output(&disasm_out);
+    if (cfg && disasm_status) {
+        if (cfg_build(cfg, &disasm, &parsed_code) == OK) json_print_cfg(out, cfg);
+        else out_str(out, ",\n        \"cfg\": { \"status\": \"erro ao montar o CFG\" }");
+    }
+
+    out_str(out, "\n      }"); // Fim do objeto code_attribute
+
     free_code_attribute(&parsed_code);
 }
 
 
 /**
- * @brief Imprime Methods, agora com disassembly.
+ * @brief Imprime um metodo (nome, descritor, flags e Code).
  */
-static void json_print_methods(ClassFile *cf, const CliOptions *options) {
-    printf("  \"methods\": [\n");
-    for (u2 i = 0; i < cf->methods_count; i++) {
-        MethodInfo *method = &cf->methods[i];
-        
-        char *name = resolve_literal_to_string(cf, method->name_index);
-        char *desc = resolve_literal_to_string(cf, method->descriptor_index);
-
-        printf("    { \"name\": ");
-        json_print_string(name);
-        printf(", \"descriptor\": ");
-        json_print_string(desc);
-        printf(", \"access_flags\": %u", method->access_flags);
-        
-        // Chama o helper para o disassembly
-        json_print_code_attribute(cf, method, options);
+static void json_print_method(OutSink *out, ClassFile *cf, const MethodInfo *method, const CliOptions *options,
+                              DisasmArena *arena, Cfg *cfg) {
+    const char *name = resolve_literal(cf, method->name_index);
+    const char *desc = resolve_literal(cf, method->descriptor_index);
+
+    out_str(out, "    { \"name\": ");
+    json_print_string(out, name);
+    out_str(out, ", \"descriptor\": ");
+    json_print_string(out, desc);
+    out_str(out, ", \"access_flags\": ");
+    out_u32(out, method->access_flags);
+    
+    // Chama o helper para o disassembly
+    json_print_code_attribute(out, cf, method, options, arena, cfg);
 
-        printf("\n    }"); // Fim do objeto método
+    out_str(out, "\n    }"); // Fim do objeto método
+}
 
-        free(name);
-        free(desc);
-        
-        if (i < cf->methods_count - 1) printf(",\n");
+/**
+ * @brief Imprime Methods, agora com disassembly.
+ */
+static void json_print_methods(OutSink *out, ClassFile *cf, const CliOptions *options) {
+    out_str(out, "  \"methods\": [\n");
+    DisasmArena arena;      // reaproveitada entre os metodos da classe
+    Cfg cfg;
+    disasm_arena_init(&arena);
+    cfg_init(&cfg);
+    for (u2 i = 0; i < cf->methods_count; i++) {
+        json_print_method(out, cf, &cf->methods[i], options, &arena, options->print_cfg ? &cfg : NULL);
+        if (i < cf->methods_count - 1) out_str(out, ",\n");
     }
-    printf("\n  ]"); // Fim do array methods
+    disasm_arena_free(&arena);
+    cfg_free(&cfg);
+    out_str(out, "\n  ]"); // Fim do array methods
 }
 
 
 /* --- Funcao Publica (contrato de json.h) --- */
-Status json_classfile(ClassFile *cf, const CliOptions *options) {
+Status json_classfile(OutSink *out, ClassFile *cf, const CliOptions *options) {
     
-    char *this_class = NULL;
-    char *super_class = NULL;
+    const char *this_class = NULL;
+    const char *super_class = NULL;
 
-    printf("{\n"); // Inicio do objeto JSON principal
+    out_str(out, "{\n"); // Inicio do objeto JSON principal
 
     // 1. Header e Info da Classe
-    this_class = resolve_class_name_to_string(cf, cf->this_class);
-    super_class = resolve_class_name_to_string(cf, cf->super_class);
-
-    printf("  \"header\": {\n");
-    printf("    \"magic\": \"0x%X\",\n", cf->magic);
-    printf("    \"major_version\": %u,\n", cf->major_version);
-    printf("    \"minor_version\": %u\n", cf->minor_version);
-    printf("  },\n");
-
-    printf("  \"class_info\": {\n");
-    printf("    \"this_class\": ");
-    json_print_string(this_class);
-    printf(",\n    \"super_class\": ");
-    json_print_string(super_class);
-    printf(",\n    \"access_flags\": %u\n", cf->access_flags);
-    printf("  },\n");
-    
-    free(this_class);
-    free(super_class);
+    this_class = resolve_class_name(cf, cf->this_class);
+    super_class = resolve_class_name(cf, cf->super_class);
+
+    out_str(out, "  \"header\": {\n");
+    out_str(out, "    \"magic\": \"0x");
+    out_hex(out, cf->magic, 0);
+    out_str(out, "\",\n    \"major_version\": ");
+    out_u32(out, cf->major_version);
+    out_str(out, ",\n    \"minor_version\": ");
+    out_u32(out, cf->minor_version);
+    out_str(out, "\n  },\n");
+
+    out_str(out, "  \"class_info\": {\n");
+    out_str(out, "    \"this_class\": ");
+    json_print_string(out, this_class);
+    out_str(out, ",\n    \"super_class\": ");
+    json_print_string(out, super_class);
+    out_str(out, ",\n    \"access_flags\": ");
+    out_u32(out, cf->access_flags);
+    out_str(out, "\n  },\n");
 
     // 2. Constant Pool
     if (options->print_constant_pool) {
-        json_print_cp(cf);
-        printf(",\n");
+        json_print_cp(out, cf);
+        out_str(out, ",\n");
     }
 
     // 3. Fields
     if (options->print_fields) {
-        json_print_fields(cf, options);
-        printf(",\n");
+        json_print_fields(out, cf, options);
+        out_str(out, ",\n");
     }
 
     // 4. Methods
     if (options->print_methods) {
-        json_print_methods(cf, options);
+        json_print_methods(out, cf, options);
     } else {
-        printf("  \"methods\": []");
+        out_str(out, "  \"methods\": []");
     }
     
-    printf("\n}\n"); // Fim do objeto JSON principal
+    out_str(out, "\n}\n"); // Fim do objeto JSON principal
     
-    return OK;
-}
\ No newline at end of file
+    return out->status;
+}
+
+
+/* --- JSON Lines (contrato de json.h) --- */
+
+/* Copia o JSON de src para out sem os espacos fora de strings */
+static void json_compactar(OutSink *out, const char *src, size_t n) {
+    size_t inicio = 0;
+    bool em_string = false;
+    for (size_t i = 0; i < n; i++) {
+        char c = src[i];
+        if (em_string) {
+            if (c == '\\') i++;               // pula o caractere escapado
+            else if (c == '"') em_string = false;
+        } else if (c == '"') {
+            em_string = true;
+        } else if (c == ' ' || c == '\n') {
+            out_put(out, src + inicio, i - inicio);
+            inicio = i + 1;
+        }
+    }
+    out_put(out, src + inicio, n - inicio);
+}
+
+Status json_line_classfile(OutSink *out, const char *path, ClassFile *cf, const CliOptions *options) {
+    OutSink rascunho;
+    if (out_sink_open_memory(&rascunho) != OK) return ERR_MEMORY;
+
+    if (!options->jsonl_per_method) {
+        // Registro da classe: {"record":"class","path":...,<campos de json_classfile>}
+        json_classfile(&rascunho, cf, options);
+        out_str(out, "{\"record\":\"class\",\"path\":");
+        json_print_string(out, path);
+        out_char(out, ',');
+        if (rascunho.status == OK && rascunho.len > 1) {
+            json_compactar(out, rascunho.buf + 1, rascunho.len - 1);   // sem o '{' inicial
+        }
+        out_char(out, '\n');
+    } else {
+        // Um registro por metodo: {"record":"method","path":...,"class":...,"index":i,"method":{...}}
+        const char *this_class = resolve_class_name(cf, cf->this_class);
+        DisasmArena arena;
+        Cfg cfg;
+        disasm_arena_init(&arena);
+        cfg_init(&cfg);
+        for (u2 i = 0; i < cf->methods_count; i++) {
+            out_sink_clear(&rascunho);
+            json_print_method(&rascunho, cf, &cf->methods[i], options, &arena, options->print_cfg ? &cfg : NULL);
+
+            out_str(out, "{\"record\":\"method\",\"path\":");
+            json_print_string(out, path);
+            out_str(out, ",\"class\":");
+            json_print_string(out, this_class);
+            out_str(out, ",\"index\":");
+            out_u32(out, i);
+            out_str(out, ",\"method\":");
+            json_compactar(out, rascunho.buf, rascunho.len);
+            out_str(out, "}\n");
+        }
+        disasm_arena_free(&arena);
+        cfg_free(&cfg);
+    }
+
+    Status status = rascunho.status;
+    out_sink_close(&rascunho);
+    return status != OK ? status : out->status;
+}
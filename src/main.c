@@ -1,7 +1,9 @@
 /* --- src/main.c --- */
+#define _POSIX_C_SOURCE 200809L  /* clock_gettime */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 // Módulos principais do projeto
 #include "base.h"
@@ -10,14 +12,605 @@
 #include "classfile.h"  // (Pessoa B) Para o parser
 #include "print.h"      // (Pessoa E) Para saida --pretty
 #include "json.h"       // (Pessoa E) Para saida --json
+#include "dot.h"        // Grafo de fluxo de controle para o Graphviz (--dot)
 #include "jvm.h"        // Novo: Estruturas da JVM
 #include "execute.h"    // Novo: Execução
+#include "jit.h"        // JIT de templates para x86-64 (--jit)
+#include "class_loader.h" // Carga paralela de diretorios
+#include "batch.h"        // Visualizacao em lote (varias entradas, diretorios, jars)
+#include "class_archive.h" // Arquivo de classes compartilhado (--dump-archive/--use-archive)
+#include "cp_cache.h"     // Cache de resolucao do constant pool (carregador da execucao)
+#include "meta_export.h"  // Exportacao binaria de metadados (--export-meta)
+#include "ref_index.h"    // Indice de referencias entre classes (index/query)
+#include "analysis_cache.h" // Cache de resultados por conteudo (--cache)
+#include "out_sink.h"
+#include "thread_pool.h"
 
 /* logger condicional: escreve no stderr quando --verbose */
 #define VLOG(opt_ptr, fmt, ...) \
     do { if ((opt_ptr) && (opt_ptr)->verbose) fprintf(stderr, "[DEBUG] " fmt "\n", ##__VA_ARGS__); } while (0)
 
 
+/* relogio de parede em segundos (para os logs de --verbose) */
+static double agora(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Gera a saida (pretty/json/jsonl/dot) de uma classe ja analisada.
+ *
+ * @param path Origem da classe (vai nos registros JSONL).
+ */
+static Status render_classfile(ClassFile *class_file, const char *path, const CliOptions *options) {
+    if (options->output_mode == OUTPUT_MODE_READER) {
+        // Modo Leitor: Apenas lê e analisa, sem exibir.
+        return OK;
+    }
+    OutSink out;
+    Status status = out_sink_open_file(&out, stdout);
+    if (status == OK) {
+        if (options->output_mode == OUTPUT_MODE_JSONL) {
+            status = json_line_classfile(&out, path, class_file, options);
+        } else if (options->output_mode == OUTPUT_MODE_DOT) {
+            status = dot_classfile(&out, class_file, options);
+        } else {
+            status = (options->output_mode == OUTPUT_MODE_JSON)
+                   ? json_classfile(&out, class_file, options)
+                   : print_classfile(&out, class_file, options);
+        }
+    }
+    Status fechou = out_sink_close(&out);
+    return status != OK ? status : fechou;
+}
+
+/**
+ * @brief Raiz de pacotes de uma classe: "out/pkg/Main.class" com this_class
+ * "pkg/Main" vira "out"; "app.jar!/pkg/Main.class" vira "app.jar".
+ */
+static char *raiz_do_classpath(const char *input, const char *this_name) {
+    const char *sep = strstr(input, "!/");
+    size_t n = sep ? (size_t)(sep - input) : strlen(input);
+    if (!sep) {
+        /* um componente do caminho por nivel de pacote, mais o arquivo */
+        int niveis = 1;
+        for (const char *p = this_name; *p; ++p) niveis += (*p == '/');
+        while (niveis-- > 0) {
+            while (n > 0 && input[n - 1] != '/') n--;
+            if (n > 0) n--;
+        }
+    }
+    char *raiz = (char *)malloc(n + 2);
+    if (!raiz) return NULL;
+    if (n == 0 && !sep) {
+        strcpy(raiz, input[0] == '/' ? "/" : ".");
+    } else {
+        memcpy(raiz, input, n);
+        raiz[n] = '\0';
+    }
+    return raiz;
+}
+
+/**
+ * @brief -run/-debug: classe principal no registro, classpath como carregador e main.
+ *
+ * main_cf e do chamador quando vem de um arquivo compartilhado (archive != NULL);
+ * caso contrario precisa estar no heap e passa a ser do registro.
+ */
+static int run_main_class(ClassFile *main_cf, ClassArchive *archive, const CliOptions *options) {
+    ClassRegistry *registry = class_registry_new();
+    ClassPath *classpath = registry ? class_path_new(registry) : NULL;
+    if (!classpath) {
+        fprintf(stderr, "Erro: Falha ao criar o classpath.\n");
+        class_registry_free(registry);
+        if (!archive) {
+            free_classfile(main_cf);
+            free(main_cf);
+        }
+        return 1;
+    }
+
+    if (archive) {
+        class_path_set_archive(classpath, archive);
+    } else if (class_registry_publish(registry, main_cf) != main_cf) {
+        free_classfile(main_cf);
+        free(main_cf);
+        class_path_free(classpath);
+        class_registry_free(registry);
+        return 1;
+    }
+
+    Status st = OK;
+    if (options->classpath) {
+        st = class_path_add(classpath, options->classpath);
+    } else if (options->input_file && !archive) {
+        char *raiz = raiz_do_classpath(options->input_file, classfile_this_name(main_cf));
+        st = raiz ? class_path_add(classpath, raiz) : ERR_MEMORY;
+        free(raiz);
+    }
+    if (st != OK) {
+        fprintf(stderr, "Aviso: Entrada do classpath ignorada (codigo %d).\n", st);
+    }
+    VLOG(options, "Classpath: %s", options->classpath ? options->classpath : "(padrao)");
+
+    if (options->jit && !jit_available()) {
+        fprintf(stderr, "Aviso: --jit indisponivel nesta arquitetura; usando o interpretador.\n");
+    }
+    cp_cache_set_loader(class_path_load, classpath);
+    int exit_code = execute_main_method(main_cf, options);
+    cp_cache_set_loader(NULL, NULL);
+
+    VLOG(options, "%lu classes no registro apos a execucao", (unsigned long)class_registry_count(registry));
+    class_path_free(classpath);
+    class_registry_free(registry);
+    return exit_code;
+}
+
+/**
+ * @brief Modo lote: varias entradas, diretorio, jar inteiro ou "@lista".
+ */
+static bool eh_lote(const CliOptions *options) {
+    const char *entrada = options->input_file;
+    return options->input_count > 1 || entrada[0] == '@' ||
+           class_source_is_dir(entrada) || class_source_is_jar(entrada);
+}
+
+/**
+ * @brief Fluxo para lotes: leitura, parse e formatacao em paralelo (batch.h).
+ */
+static int run_viewer_batch(const CliOptions *options) {
+    if (options->execution_mode != MODE_NONE) {
+        fprintf(stderr, "Erro: -run/-debug exigem um unico arquivo .class (ou app.jar!/pkg/Main.class).\n");
+        return 1;
+    }
+    return batch_run(options);
+}
+
+/**
+ * @brief --dump-archive: analisa a entrada (arquivo ou diretorio) e grava o arquivo compartilhado.
+ */
+static int run_dump_archive(const CliOptions *options) {
+    ClassList list;
+    memset(&list, 0, sizeof list);
+
+    for (int i = 0; i < options->input_count; i++) {
+        Status io_status = class_list_collect(&list, options->inputs[i]);
+        if (io_status != OK) {
+            fprintf(stderr, "Erro (IO): Nao foi possivel listar '%s'. Codigo: %d\n",
+                    options->inputs[i], io_status);
+            class_list_free(&list);
+            return 1;
+        }
+    }
+
+    ThreadPool *pool = thread_pool_create(options->threads);
+    double t0 = agora();
+    size_t falhas = class_loader_parse_all(&list, pool, NULL);
+    thread_pool_destroy(pool);
+
+    ClassFile **classes = (ClassFile **)calloc(list.count ? list.count : 1, sizeof(ClassFile *));
+    if (!classes) {
+        fprintf(stderr, "Erro: Falha de alocacao.\n");
+        class_list_free(&list);
+        return 1;
+    }
+    for (size_t i = 0; i < list.count; i++) {
+        LoadedClass *lc = &list.items[i];
+        if (!lc->cf) {
+            fprintf(stderr, "Erro: Falha ao ler/analisar '%s' (IO=%d, Parser=%d); classe ignorada.\n",
+                    lc->path, lc->io_status, lc->cf_status);
+        }
+        classes[i] = lc->cf;
+    }
+
+    size_t bytes = 0;
+    Status st = class_archive_dump(options->dump_archive, classes, list.count, &bytes);
+    VLOG(options, "Arquivo gravado em %.3f ms", (agora() - t0) * 1e3);
+    if (st != OK) {
+        fprintf(stderr, "Erro (IO): Nao foi possivel gravar '%s'. Codigo: %d\n",
+                options->dump_archive, st);
+    } else {
+        printf("Arquivo '%s' gravado: %lu bytes (%lu classes analisadas).\n", options->dump_archive,
+               (unsigned long)bytes, (unsigned long)(list.count - falhas));
+    }
+
+    free(classes);
+    class_list_free(&list);
+    return (st == OK && falhas == 0) ? 0 : 1;
+}
+
+/* Classes analisadas por vez (exportacao/indice): limita as ClassFile vivas */
+#define JANELA_ANALISE 1024
+
+/*
+ * Trabalho paralelo de cada classe (i = posicao na janela). Deve deixar
+ * io_status/cf_status indicando falha; sem ele, so faz o parse.
+ */
+typedef void (*PrepararClasse)(void *ctx, LoadedClass *lc, size_t i);
+
+/* Recebe cada classe preparada, na ordem das entradas; a classe e liberada em seguida */
+typedef Status (*ConsumirClasse)(void *ctx, const LoadedClass *lc, size_t i);
+
+typedef struct {
+    LoadedClass *itens;
+    PrepararClasse preparar;
+    void *ctx;
+} JanelaAnalise;
+
+static void analisar_item(void *ctx, size_t i) {
+    JanelaAnalise *janela = (JanelaAnalise *)ctx;
+    if (janela->preparar) janela->preparar(janela->ctx, &janela->itens[i], i);
+    else class_loader_parse_item(&janela->itens[i]);
+}
+
+/**
+ * @brief Lista as entradas, prepara em janelas paralelas (parse, por
+ * padrao) e entrega as classes em ordem a 'consumir' (para no primeiro
+ * erro dele).
+ *
+ * @return Classes que falharam na leitura/parse, ou -1 se a listagem falhou.
+ */
+static long analisar_em_janelas(const CliOptions *options, PrepararClasse preparar, ConsumirClasse consumir,
+                                void *ctx, size_t *out_analisadas, Status *out_status) {
+    ClassList list;
+    memset(&list, 0, sizeof list);
+    *out_analisadas = 0;
+    *out_status = OK;
+
+    for (int i = 0; i < options->input_count; i++) {
+        Status io_status = class_list_collect(&list, options->inputs[i]);
+        if (io_status != OK) {
+            fprintf(stderr, "Erro (IO): Nao foi possivel listar '%s'. Codigo: %d\n",
+                    options->inputs[i], io_status);
+            class_list_free(&list);
+            return -1;
+        }
+    }
+
+    ThreadPool *pool = thread_pool_create(options->threads);
+    if (!pool) {
+        fprintf(stderr, "Erro: Falha ao criar o pool de threads.\n");
+        class_list_free(&list);
+        return -1;
+    }
+
+    long falhas = 0;
+    Status st = OK;
+    for (size_t inicio = 0; inicio < list.count && st == OK; inicio += JANELA_ANALISE) {
+        size_t n = list.count - inicio;
+        if (n > JANELA_ANALISE) n = JANELA_ANALISE;
+        JanelaAnalise janela = { &list.items[inicio], preparar, ctx };
+        thread_pool_for(pool, n, analisar_item, &janela);
+
+        for (size_t i = 0; i < n; i++) {
+            LoadedClass *lc = &janela.itens[i];
+            if (lc->io_status != OK || lc->cf_status != CF_STATUS_OK) {
+                fprintf(stderr, "Erro: Falha ao ler/analisar '%s' (IO=%d, Parser=%d); classe ignorada.\n",
+                        lc->path, lc->io_status, lc->cf_status);
+                falhas++;
+            } else if (st == OK) {
+                st = consumir(ctx, lc, i);
+                (*out_analisadas)++;
+            }
+            class_loader_release_item(lc);
+        }
+    }
+    thread_pool_destroy(pool);
+    class_list_free(&list);
+    *out_status = st;
+    return falhas;
+}
+
+static Status exportar_classe(void *ctx, const LoadedClass *lc, size_t i) {
+    (void)i;
+    return meta_writer_add((MetaWriter *)ctx, lc->cf, lc->path);
+}
+
+/**
+ * @brief --export-meta: analisa as entradas em janelas paralelas e grava a
+ * exportacao binaria (cada classe e liberada assim que entra no gravador).
+ */
+static int run_export_meta(const CliOptions *options) {
+    MetaWriter *w = meta_writer_new();
+    if (!w) {
+        fprintf(stderr, "Erro: Falha de alocacao.\n");
+        return 1;
+    }
+
+    double t0 = agora();
+    size_t analisadas;
+    Status st;
+    long falhas = analisar_em_janelas(options, NULL, exportar_classe, w, &analisadas, &st);
+    if (falhas < 0) {
+        meta_writer_free(w);
+        return 1;
+    }
+
+    size_t bytes = 0;
+    if (st == OK) st = meta_writer_finish(w, options->export_meta, &bytes);
+    VLOG(options, "Exportacao gravada em %.3f ms", (agora() - t0) * 1e3);
+    if (st != OK) {
+        fprintf(stderr, "Erro (IO): Nao foi possivel gravar '%s'. Codigo: %d\n",
+                options->export_meta, st);
+    } else {
+        printf("Exportacao '%s' gravada: %lu bytes (%lu classes analisadas).\n", options->export_meta,
+               (unsigned long)bytes, (unsigned long)analisadas);
+    }
+
+    meta_writer_free(w);
+    return (st == OK && falhas == 0) ? 0 : 1;
+}
+
+/* Indexacao: fragmentos da janela (ref_index_fragment), gerados em paralelo */
+typedef struct {
+    RefIndexBuilder *builder;
+    AnalysisCache *cache;           /* --cache (NULL = sem cache) */
+    uint64_t semente;
+    OutSink fragmentos[JANELA_ANALISE];
+    Status status[JANELA_ANALISE];
+} Indexacao;
+
+/* Le os bytes; com cache, so analisa e desmonta se o fragmento nao estiver guardado */
+static void fragmentar_classe(void *ctx, LoadedClass *lc, size_t i) {
+    Indexacao *ix = (Indexacao *)ctx;
+    OutSink *frag = &ix->fragmentos[i];
+    out_sink_clear(frag);
+    ix->status[i] = OK;
+
+    Buffer bytes;
+    if (!class_loader_read_item(lc, &bytes)) return;
+    uint64_t chave = 0;
+    if (ix->cache) {
+        char *dados;
+        size_t tamanho;
+        chave = analysis_cache_hash(bytes.data, bytes.size, ix->semente);
+        if (analysis_cache_get(ix->cache, chave, &dados, &tamanho)) {
+            buffer_free(&bytes);
+            out_put(frag, dados, tamanho);
+            ix->status[i] = frag->status;
+            free(dados);
+            return;
+        }
+    }
+    if (!class_loader_parse_buffer(lc, &bytes)) return;
+    ix->status[i] = ref_index_fragment(lc->cf, frag);
+    if (ix->cache && ix->status[i] == OK) analysis_cache_put(ix->cache, chave, frag->buf, frag->len);
+    class_loader_release_item(lc);
+}
+
+static Status indexar_classe(void *ctx, const LoadedClass *lc, size_t i) {
+    Indexacao *ix = (Indexacao *)ctx;
+    (void)lc;
+    if (ix->status[i] != OK) return ix->status[i];
+    return ref_index_builder_add_fragment(ix->builder, ix->fragmentos[i].buf, ix->fragmentos[i].len);
+}
+
+/**
+ * @brief index: desmonta todos os metodos das entradas e grava o indice de
+ * referencias (usos de metodos, campos e classes). Com --cache, classes
+ * inalteradas reaproveitam o fragmento da execucao anterior.
+ */
+static int run_build_index(const CliOptions *options) {
+    Indexacao *ix = (Indexacao *)calloc(1, sizeof(Indexacao));
+    Status st = ix ? OK : ERR_MEMORY;
+    if (ix) ix->builder = ref_index_builder_new();
+    if (ix && !ix->builder) st = ERR_MEMORY;
+    for (size_t i = 0; i < JANELA_ANALISE && st == OK; i++) st = out_sink_open_memory(&ix->fragmentos[i]);
+    if (st != OK) {
+        fprintf(stderr, "Erro: Falha de alocacao.\n");
+        if (ix) {
+            for (size_t i = 0; i < JANELA_ANALISE; i++) out_sink_close(&ix->fragmentos[i]);
+            ref_index_builder_free(ix->builder);
+        }
+        free(ix);
+        return 1;
+    }
+    if (options->cache_dir) {
+        ix->cache = analysis_cache_open(options->cache_dir, (uint64_t)options->cache_max_mb << 20, &st);
+        if (!ix->cache) {
+            fprintf(stderr, "Aviso: Cache '%s' indisponivel (codigo %d); seguindo sem cache.\n", options->cache_dir, st);
+        }
+        ix->semente = analysis_cache_seed("index");
+    }
+
+    double t0 = agora();
+    size_t analisadas;
+    long falhas = analisar_em_janelas(options, fragmentar_classe, indexar_classe, ix, &analisadas, &st);
+
+    size_t bytes = 0;
+    if (falhas >= 0 && st == OK) st = ref_index_builder_finish(ix->builder, options->build_index, &bytes);
+    VLOG(options, "Indice gravado em %.3f ms", (agora() - t0) * 1e3);
+    if (falhas < 0) {
+        /* listagem ja relatada */
+    } else if (st != OK) {
+        fprintf(stderr, "Erro (IO): Nao foi possivel gravar '%s'. Codigo: %d\n",
+                options->build_index, st);
+    } else {
+        printf("Indice '%s' gravado: %lu bytes (%lu classes indexadas).\n", options->build_index,
+               (unsigned long)bytes, (unsigned long)analisadas);
+    }
+
+    if (ix->cache) {
+        analysis_cache_trim(ix->cache);
+        uint64_t acertos, faltas, removidas;
+        analysis_cache_stats(ix->cache, &acertos, &faltas, &removidas);
+        VLOG(options, "Cache: %llu acertos, %llu faltas, %llu entradas removidas", (unsigned long long)acertos,
+             (unsigned long long)faltas, (unsigned long long)removidas);
+        analysis_cache_close(ix->cache);
+    }
+    for (size_t i = 0; i < JANELA_ANALISE; i++) out_sink_close(&ix->fragmentos[i]);
+    ref_index_builder_free(ix->builder);
+    free(ix);
+    return (falhas == 0 && st == OK) ? 0 : 1;
+}
+
+/* Escreve os usos de uma chave: "Classe.metodo(desc):pc opcode Dono.nome desc" */
+static void escrever_usos(OutSink *out, const RefIndex *idx, const RefIndexKey *k) {
+    for (uint32_t i = 0; i < k->site_count; i++) {
+        RefIndexSite s;
+        if (!ref_index_site(idx, k->first_site + i, &s)) break;
+        out_str(out, s.class_name);
+        out_char(out, '.');
+        out_str(out, s.method);
+        out_str(out, s.method_descriptor);
+        out_char(out, ':');
+        out_u32(out, s.pc);
+        out_char(out, ' ');
+        out_str(out, ref_index_opcode_name(s.opcode));
+        out_char(out, ' ');
+        out_str(out, k->owner);
+        if (k->kind != REF_INDEX_CLASS) {
+            out_char(out, '.');
+            out_str(out, k->name);
+            if (k->kind == REF_INDEX_FIELD) out_char(out, ':');
+            out_str(out, k->descriptor);
+        }
+        out_char(out, '\n');
+    }
+}
+
+/**
+ * @brief Responde uma consulta: "Dono" (todos os usos da classe e dos seus
+ * membros), "Dono.nome" (qualquer descritor), "Dono.nome(desc)ret" ou
+ * "Dono.campo:desc" (chave exata, pelo diretorio hash). Retorna os usos.
+ */
+static uint32_t consultar(OutSink *out, const RefIndex *idx, const char *consulta) {
+    size_t n = strlen(consulta);
+    char *dono = (char *)malloc(n + 1);
+    if (!dono) return 0;
+    memcpy(dono, consulta, n + 1);
+
+    char *nome = strchr(dono, '.');
+    const char *desc = NULL;
+    if (nome) {
+        *nome++ = '\0';
+        char *sep = nome + strcspn(nome, "(:");
+        if (*sep == '(') {
+            desc = consulta + (sep - dono);     /* o descritor comeca no '(' */
+            *sep = '\0';
+        } else if (*sep == ':') {
+            *sep = '\0';
+            desc = sep + 1;
+        }
+    }
+
+    uint32_t usos = 0;
+    RefIndexKey k;
+    if (desc) {
+        int64_t i = ref_index_find(idx, dono, nome, desc);
+        if (i >= 0 && ref_index_key(idx, (uint32_t)i, &k)) {
+            escrever_usos(out, idx, &k);
+            usos = k.site_count;
+        }
+    } else {
+        uint32_t primeiro, chaves = ref_index_range(idx, dono, nome, &primeiro);
+        for (uint32_t i = 0; i < chaves; i++) {
+            if (!ref_index_key(idx, primeiro + i, &k)) break;
+            escrever_usos(out, idx, &k);
+            usos += k.site_count;
+        }
+    }
+    free(dono);
+    return usos;
+}
+
+/**
+ * @brief query: mapeia o indice e lista os usos de cada consulta.
+ */
+static int run_query_index(const CliOptions *options) {
+    double t0 = agora();
+    Status st;
+    RefIndex *idx = ref_index_open(options->query_index, &st);
+    if (!idx) {
+        fprintf(stderr, "Erro (IO): Indice '%s' invalido ou inacessivel. Codigo: %d\n",
+                options->query_index, st);
+        return 1;
+    }
+    VLOG(options, "Indice mapeado em %.3f ms (%u chaves, %u usos)", (agora() - t0) * 1e3,
+         ref_index_key_count(idx), ref_index_site_count(idx));
+
+    OutSink out;
+    if (out_sink_open_file(&out, stdout) != OK) {
+        ref_index_close(idx);
+        return 1;
+    }
+    uint32_t total = 0;
+    for (int i = 0; i < options->input_count; i++) {
+        double t1 = agora();
+        uint32_t usos = consultar(&out, idx, options->inputs[i]);
+        VLOG(options, "'%s': %u usos em %.1f us", options->inputs[i], usos, (agora() - t1) * 1e6);
+        total += usos;
+    }
+    st = out_sink_close(&out);
+    ref_index_close(idx);
+    /* como o grep: 1 se nada foi encontrado */
+    return (st == OK && total > 0) ? 0 : 1;
+}
+
+/**
+ * @brief --use-archive: mapeia o arquivo e exibe/executa uma classe (ou todas) sem parse.
+ */
+static int run_use_archive(const CliOptions *options) {
+    double t0 = agora();
+    Status st;
+    ClassArchive *archive = class_archive_open(options->use_archive, &st);
+    if (!archive) {
+        fprintf(stderr, "Erro (IO): Arquivo de classes '%s' invalido ou inacessivel. Codigo: %d\n",
+                options->use_archive, st);
+        return 1;
+    }
+    VLOG(options, "Arquivo mapeado em %.3f ms (%lu classes)",
+         (agora() - t0) * 1e3, (unsigned long)class_archive_count(archive));
+
+    int exit_code = 0;
+    if (options->input_file) {
+        /* aceita "pkg.Classe" ou "pkg/Classe" */
+        size_t n = strlen(options->input_file);
+        char *nome = (char *)malloc(n + 1);
+        if (!nome) {
+            class_archive_close(archive);
+            return 1;
+        }
+        for (size_t i = 0; i <= n; i++) {
+            nome[i] = options->input_file[i] == '.' ? '/' : options->input_file[i];
+        }
+
+        ClassFile *cf = class_archive_find(archive, nome);
+        VLOG(options, "Classe '%s' obtida em %.3f ms", nome, (agora() - t0) * 1e3);
+        if (!cf) {
+            fprintf(stderr, "Erro: Classe '%s' nao encontrada no arquivo '%s'.\n",
+                    nome, options->use_archive);
+            exit_code = 1;
+        } else if (options->execution_mode != MODE_NONE) {
+            exit_code = run_main_class(cf, archive, options);
+        } else if (render_classfile(cf, nome, options) != OK) {
+            fprintf(stderr, "Erro (Impressao): Falha ao gerar a saida.\n");
+            exit_code = 1;
+        }
+        free(nome);
+    } else if (options->execution_mode != MODE_NONE) {
+        fprintf(stderr, "Erro: -run/-debug exigem o nome da classe.\n");
+        exit_code = 1;
+    } else {
+        for (size_t i = 0; i < class_archive_count(archive); i++) {
+            ClassFile *cf = class_archive_get(archive, i);
+            if (!cf) {
+                fprintf(stderr, "Erro: Registro corrompido para '%s'.\n", class_archive_name(archive, i));
+                exit_code = 1;
+                continue;
+            }
+            if (options->output_mode == OUTPUT_MODE_PRETTY) {
+                printf("%s==> %s <==\n", i ? "\n" : "", class_archive_name(archive, i));
+            }
+            if (render_classfile(cf, class_archive_name(archive, i), options) != OK) exit_code = 1;
+        }
+    }
+
+    class_archive_close(archive);
+    return exit_code;
+}
+
 /**
  * @brief Roda o fluxo principal do programa apos a validacao dos argumentos.
  */
@@ -32,7 +625,7 @@ static int run_viewer(const CliOptions *options) {
 
     /* A) carregar arquivo */
     VLOG(options, "Abrindo arquivo: %s", options->input_file);
-    io_status = buffer_from_file(options->input_file, &buffer);
+    io_status = class_source_read(options->input_file, &buffer);
     if (io_status != OK) {
         fprintf(stderr, "Erro (IO): Nao foi possivel ler o arquivo '%s'. Codigo: %d\n",
                 options->input_file, io_status);
@@ -63,7 +656,9 @@ static int run_viewer(const CliOptions *options) {
          (unsigned)class_file.attributes_count);
 
     /* E) imprimir resultado */
-    const char *mode = (options->output_mode == OUTPUT_MODE_JSON) ? "json" : "pretty";
+    const char *mode = (options->output_mode == OUTPUT_MODE_JSON) ? "json" :
+                       (options->output_mode == OUTPUT_MODE_JSONL) ? "jsonl" :
+                       (options->output_mode == OUTPUT_MODE_DOT) ? "dot" : "pretty";
     VLOG(options, "Gerando saida (%s). disassemble_code=%s",
          mode, options->disassemble_code ? "true" : "false");
 
@@ -72,20 +667,20 @@ static int run_viewer(const CliOptions *options) {
         const char *exec_mode = (options->execution_mode == MODE_DEBUG) ? "DEBUG" : "EXECUTE";
         VLOG(options, "Modo de execucao: %s", exec_mode);
         
-        int exec_status = execute_main_method(&class_file, options);
-        free_classfile(&class_file);
-        return exec_status;
+        /* o registro do classpath passa a ser dono da classe principal */
+        ClassFile *main_cf = (ClassFile *)malloc(sizeof(ClassFile));
+        if (!main_cf) {
+            free_classfile(&class_file);
+            return 1;
+        }
+        *main_cf = class_file;
+        return run_main_class(main_cf, NULL, options);
     }
 
     if (options->output_mode == OUTPUT_MODE_READER) {
-        // Modo Leitor: Apenas lê e analisa, sem exibir.
-        io_status = OK;
         VLOG(options, "Modo Leitor ativado. Nenhuma saida gerada.");
-    } else {
-        io_status = (options->output_mode == OUTPUT_MODE_JSON)
-                  ? json_classfile(&class_file, options)
-                  : print_classfile(&class_file, options);
     }
+    io_status = render_classfile(&class_file, options->input_file, options);
 
     if (io_status != OK) {
         fprintf(stderr, "Erro (Impressao): Falha ao gerar a saida. Codigo: %d\n", io_status);
@@ -106,15 +701,34 @@ int main(int argc, char *argv[]) {
     // Se parse_cli_options encontrou um erro (ex: sem input)
     if (options.error) {
         // A mensagem de erro já foi impressa pelo cli.c
+        free_cli_options(&options);
         return 1; 
     }
     
     // Se o usuário pediu --help
     if (options.show_help) {
         // A mensagem de ajuda já foi impressa pelo cli.c
+        free_cli_options(&options);
         return 0; // Sai com sucesso
     }
 
     // Se os argumentos são válidos, executa o programa
-    return run_viewer(&options);
+    int exit_code;
+    if (options.dump_archive) {
+        exit_code = run_dump_archive(&options);
+    } else if (options.use_archive) {
+        exit_code = run_use_archive(&options);
+    } else if (options.export_meta) {
+        exit_code = run_export_meta(&options);
+    } else if (options.build_index) {
+        exit_code = run_build_index(&options);
+    } else if (options.query_index) {
+        exit_code = run_query_index(&options);
+    } else if (eh_lote(&options)) {
+        exit_code = run_viewer_batch(&options);
+    } else {
+        exit_code = run_viewer(&options);
+    }
+    free_cli_options(&options);
+    return exit_code;
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "member_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ============================================================
+ * Hash
+ * ============================================================ */
+u4 member_hash(const char *name, const char *descriptor) {
+    u4 h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; ++p) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    h *= 16777619u;         /* byte separador '\0' entre nome e descritor */
+    for (const unsigned char *p = (const unsigned char *)descriptor; *p; ++p) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* ============================================================
+ * Helpers internos
+ * ============================================================ */
+
+/* Menor potencia de 2 >= 2*count (carga maxima de 50%). */
+static u4 capacidade_para(u2 count) {
+    u4 cap = 4;
+    while (cap < (u4)count * 2) cap <<= 1;
+    return cap;
+}
+
+static int membro_confere(const ClassFile *cf, const FieldInfo *m,
+                          const char *name, const char *descriptor) {
+    const char *mn = cp_utf8(cf->constant_pool, cf->constant_pool_count, m->name_index);
+    const char *md = cp_utf8(cf->constant_pool, cf->constant_pool_count, m->descriptor_index);
+    return strcmp(mn, name) == 0 && strcmp(md, descriptor) == 0;
+}
+
+static MemberSlot *montar_tabela(const ClassFile *cf, const FieldInfo *members, u2 count, u4 *out_mask) {
+    u4 cap = capacidade_para(count);
+    MemberSlot *slots = (MemberSlot *)malloc(sizeof(MemberSlot) * cap);
+    if (!slots) return NULL;
+
+    for (u4 i = 0; i < cap; ++i) slots[i].member = MEMBER_SLOT_EMPTY;
+
+    u4 mask = cap - 1;
+    for (u2 i = 0; i < count; ++i) {
+        const char *mn = cp_utf8(cf->constant_pool, cf->constant_pool_count, members[i].name_index);
+        const char *md = cp_utf8(cf->constant_pool, cf->constant_pool_count, members[i].descriptor_index);
+        u4 h = member_hash(mn, md);
+        u4 pos = h & mask;
+        while (slots[pos].member != MEMBER_SLOT_EMPTY) pos = (pos + 1) & mask;
+        slots[pos].hash = h;
+        slots[pos].member = i;
+    }
+
+    *out_mask = mask;
+    return slots;
+}
+
+static FieldInfo *buscar(const ClassFile *cf, FieldInfo *members, u2 count,
+                         const MemberSlot *slots, u4 mask,
+                         const char *name, const char *descriptor) {
+    if (!name || !descriptor) return NULL;
+
+    if (!slots) {
+        /* Sem indice: varredura linear (comportamento antigo) */
+        for (u2 i = 0; i < count; ++i) {
+            if (membro_confere(cf, &members[i], name, descriptor)) return &members[i];
+        }
+        return NULL;
+    }
+
+    u4 h = member_hash(name, descriptor);
+    for (u4 pos = h & mask; slots[pos].member != MEMBER_SLOT_EMPTY; pos = (pos + 1) & mask) {
+        if (slots[pos].hash == h && membro_confere(cf, &members[slots[pos].member], name, descriptor)) {
+            return &members[slots[pos].member];
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================
+ * API pública
+ * ============================================================ */
+ClassFileStatus member_index_build(ClassFile *cf) {
+    if (!cf) return CF_STATUS_ERR_ALLOC;
+    if (cf->members) return CF_STATUS_OK;
+
+    MemberIndex *idx = (MemberIndex *)calloc(1, sizeof(MemberIndex));
+    if (!idx) return CF_STATUS_ERR_ALLOC;
+
+    idx->method_slots = montar_tabela(cf, cf->methods, cf->methods_count, &idx->method_mask);
+    idx->field_slots = montar_tabela(cf, cf->fields, cf->fields_count, &idx->field_mask);
+    if (!idx->method_slots || !idx->field_slots) {
+        free(idx->method_slots);
+        free(idx->field_slots);
+        free(idx);
+        return CF_STATUS_ERR_ALLOC;
+    }
+
+    cf->members = idx;
+    return CF_STATUS_OK;
+}
+
+void member_index_free(ClassFile *cf) {
+    if (!cf || !cf->members) return;
+    free(cf->members->method_slots);
+    free(cf->members->field_slots);
+    free(cf->members);
+    cf->members = NULL;
+}
+
+MethodInfo *member_index_find_method(const ClassFile *cf, const char *name, const char *descriptor) {
+    if (!cf) return NULL;
+    const MemberIndex *idx = cf->members;
+    return buscar(cf, cf->methods, cf->methods_count,
+                  idx ? idx->method_slots : NULL, idx ? idx->method_mask : 0,
+                  name, descriptor);
+}
+
+FieldInfo *member_index_find_field(const ClassFile *cf, const char *name, const char *descriptor) {
+    if (!cf) return NULL;
+    const MemberIndex *idx = cf->members;
+    return buscar(cf, cf->fields, cf->fields_count,
+                  idx ? idx->field_slots : NULL, idx ? idx->field_mask : 0,
+                  name, descriptor);
+}
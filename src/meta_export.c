@@ -0,0 +1,413 @@
+#include "meta_export.h"
+#include "meta_reader.h"
+#include "out_sink.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Secoes montadas em memoria; a de nomes so existe no finish */
+enum { SEC_GRAVADAS = META_SEC_NAMES };
+
+typedef struct {
+    u4 hash;
+    u4 off;         /* na secao de strings; 0 = livre (o "" nao entra na tabela) */
+    u4 len;
+} Texto;
+
+struct meta_writer {
+    OutSink sec[SEC_GRAVADAS];
+    u4 classes, interfaces, fields, methods, refs;
+
+    Texto *textos;  /* internacao: hash aberto, carga maxima de 50% */
+    u4 textos_cap, textos_count;
+
+    u4 *nomes;      /* nome de cada classe (offset na secao de strings) */
+    u4 nomes_cap;
+};
+
+/* ============================================================
+ * Little-endian
+ * ============================================================ */
+static void put_u2(OutSink *s, u4 v) {
+    char b[2] = { (char)(v & 0xFF), (char)((v >> 8) & 0xFF) };
+    out_put(s, b, 2);
+}
+
+static void put_u4(OutSink *s, u4 v) {
+    char b[4] = { (char)(v & 0xFF), (char)((v >> 8) & 0xFF), (char)((v >> 16) & 0xFF), (char)(v >> 24) };
+    out_put(s, b, 4);
+}
+
+static void put_u8(OutSink *s, uint64_t v) {
+    put_u4(s, (u4)v);
+    put_u4(s, (u4)(v >> 32));
+}
+
+static void grava_u4(u1 *p, u4 v) {
+    p[0] = (u1)v;
+    p[1] = (u1)(v >> 8);
+    p[2] = (u1)(v >> 16);
+    p[3] = (u1)(v >> 24);
+}
+
+static void grava_u8(u1 *p, uint64_t v) {
+    grava_u4(p, (u4)v);
+    grava_u4(p + 4, (u4)(v >> 32));
+}
+
+static u2 be16(const u1 *p) {
+    return (u2)((p[0] << 8) | p[1]);
+}
+
+static u4 be32(const u1 *p) {
+    return ((u4)p[0] << 24) | ((u4)p[1] << 16) | ((u4)p[2] << 8) | p[3];
+}
+
+/* ============================================================
+ * Strings
+ * ============================================================ */
+static u4 hash_bytes(const char *p, size_t n) {
+    u4 h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (u1)p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int crescer_textos(MetaWriter *w) {
+    u4 nova = w->textos_cap ? w->textos_cap * 2 : 4096;
+    Texto *t = (Texto *)calloc(nova, sizeof(Texto));
+    if (!t) return 0;
+    for (u4 i = 0; i < w->textos_cap; ++i) {
+        if (!w->textos[i].off) continue;
+        u4 pos = w->textos[i].hash & (nova - 1);
+        while (t[pos].off) pos = (pos + 1) & (nova - 1);
+        t[pos] = w->textos[i];
+    }
+    free(w->textos);
+    w->textos = t;
+    w->textos_cap = nova;
+    return 1;
+}
+
+/* Offset da string na secao (interna na primeira vez); 0 para "" ou em erro */
+static u4 internar(MetaWriter *w, const char *str) {
+    OutSink *s = &w->sec[META_SEC_STRINGS];
+    size_t len = strlen(str);
+    if (len == 0 || s->status != OK) return 0;
+    if ((w->textos_count + 1) * 2 > w->textos_cap && !crescer_textos(w)) {
+        s->status = ERR_MEMORY;
+        return 0;
+    }
+
+    u4 h = hash_bytes(str, len);
+    u4 mask = w->textos_cap - 1;
+    u4 pos = h & mask;
+    for (; w->textos[pos].off; pos = (pos + 1) & mask) {
+        const Texto *t = &w->textos[pos];
+        if (t->hash == h && t->len == len && memcmp(s->buf + t->off, str, len) == 0) return t->off;
+    }
+    if (s->len + len + 1 > 0xFFFFFFFFu) {
+        s->status = ERR_BOUNDS;
+        return 0;
+    }
+
+    u4 off = (u4)s->len;
+    out_put(s, str, len + 1);
+    if (s->status != OK) return 0;
+    w->textos[pos].hash = h;
+    w->textos[pos].off = off;
+    w->textos[pos].len = (u4)len;
+    w->textos_count++;
+    return off;
+}
+
+/* ============================================================
+ * Classes
+ * ============================================================ */
+static const char *nome_atributo(const ClassFile *cf, const AttributeInfo *a) {
+    return cp_utf8(cf->constant_pool, cf->constant_pool_count, a->attribute_name_index);
+}
+
+static const char *source_file(const ClassFile *cf) {
+    for (u2 i = 0; i < cf->attributes_count; ++i) {
+        const AttributeInfo *a = &cf->attributes[i];
+        if (a->attribute_length >= 2 && a->info && strcmp(nome_atributo(cf, a), "SourceFile") == 0) {
+            return cp_utf8(cf->constant_pool, cf->constant_pool_count, be16(a->info));
+        }
+    }
+    return "";
+}
+
+static void gravar_metodo(MetaWriter *w, const ClassFile *cf, const MethodInfo *m, u4 ordinal) {
+    const CpInfo *cp = cf->constant_pool;
+    u2 n = cf->constant_pool_count;
+    OutSink *rec = &w->sec[META_SEC_METHODS];
+    OutSink *code = &w->sec[META_SEC_CODE];
+
+    /* Code cru: max_stack, max_locals, code_length, code[] */
+    const u1 *bytecode = NULL;
+    u4 code_length = 0, insns = 0;
+    u2 max_stack = 0, max_locals = 0;
+    for (u2 i = 0; i < m->attributes_count; ++i) {
+        const AttributeInfo *a = &m->attributes[i];
+        if (!a->info || a->attribute_length < 8 || strcmp(nome_atributo(cf, a), "Code") != 0) continue;
+        u4 len = be32(a->info + 4);
+        if (len == 0 || len > a->attribute_length - 8) break;
+        max_stack = be16(a->info);
+        max_locals = be16(a->info + 2);
+        bytecode = a->info + 8;
+        code_length = len;
+        break;
+    }
+    if (bytecode) {
+        for (u4 pc = 0, k; pc < code_length && (k = meta_insn_length(bytecode, code_length, pc)) != 0; pc += k) {
+            insns++;
+        }
+    }
+
+    put_u4(rec, ordinal);
+    put_u4(rec, internar(w, cp_utf8(cp, n, m->name_index)));
+    put_u4(rec, internar(w, cp_utf8(cp, n, m->descriptor_index)));
+    put_u4(rec, code_length);
+    put_u8(rec, bytecode ? (uint64_t)code->len : 0);
+    put_u4(rec, insns);
+    put_u2(rec, m->access_flags);
+    put_u2(rec, max_stack);
+    put_u2(rec, max_locals);
+    put_u2(rec, 0);
+    put_u4(rec, 0);
+    if (bytecode) out_put(code, (const char *)bytecode, code_length);
+}
+
+static void gravar_referencia(MetaWriter *w, u1 tag, u2 idx, const char *dono, const char *nome, const char *desc) {
+    OutSink *rec = &w->sec[META_SEC_REFS];
+    char cab[4] = { (char)tag, 0, (char)(idx & 0xFF), (char)(idx >> 8) };
+    out_put(rec, cab, 4);
+    put_u4(rec, internar(w, dono));
+    put_u4(rec, internar(w, nome));
+    put_u4(rec, internar(w, desc));
+    w->refs++;
+}
+
+/* Referencias do CP, em ordem crescente de indice (meta_find_ref faz busca binaria) */
+static u4 gravar_referencias(MetaWriter *w, const ClassFile *cf) {
+    const CpInfo *cp = cf->constant_pool;
+    u2 n = cf->constant_pool_count;
+    u4 antes = w->refs;
+    for (u2 i = 1; i < n; ++i) {
+        const CpInfo *c = &cp[i];
+        const char *dono, *nome, *desc;
+        switch (c->tag) {
+        case CONSTANT_Class:
+            gravar_referencia(w, c->tag, i, cp_nome_classe(cp, n, i), "", "");
+            break;
+        case CONSTANT_String:
+            gravar_referencia(w, c->tag, i, "", cp_utf8(cp, n, c->String.string_index), "");
+            break;
+        case CONSTANT_Fieldref:
+        case CONSTANT_Methodref:
+        case CONSTANT_InterfaceMethodref:
+            cp_referencia_metodo(cp, n, i, &dono, &nome, &desc);
+            gravar_referencia(w, c->tag, i, dono, nome, desc);
+            break;
+        case CONSTANT_MethodType:
+            gravar_referencia(w, c->tag, i, "", "", cp_utf8(cp, n, c->MethodType.descriptor_index));
+            break;
+        case CONSTANT_InvokeDynamic: {
+            u2 nt = c->InvokeDynamic.name_and_type_index;
+            nome = desc = "";
+            if (nt > 0 && nt < n && cp[nt].tag == CONSTANT_NameAndType) {
+                nome = cp_utf8(cp, n, cp[nt].NameAndType.name_index);
+                desc = cp_utf8(cp, n, cp[nt].NameAndType.descriptor_index);
+            }
+            gravar_referencia(w, c->tag, i, "", nome, desc);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return w->refs - antes;
+}
+
+/* ============================================================
+ * API publica
+ * ============================================================ */
+MetaWriter *meta_writer_new(void) {
+    MetaWriter *w = (MetaWriter *)calloc(1, sizeof(MetaWriter));
+    if (!w) return NULL;
+    int ok = 1;
+    for (int s = 0; s < SEC_GRAVADAS; s++) {
+        if (out_sink_open_memory(&w->sec[s]) != OK) ok = 0;
+    }
+    if (!ok) {
+        meta_writer_free(w);
+        return NULL;
+    }
+    out_char(&w->sec[META_SEC_STRINGS], '\0');   /* offset 0 = "" */
+    return w;
+}
+
+static Status situacao(const MetaWriter *w) {
+    for (int s = 0; s < SEC_GRAVADAS; s++) {
+        if (w->sec[s].status != OK) return w->sec[s].status;
+    }
+    return OK;
+}
+
+Status meta_writer_add(MetaWriter *w, const ClassFile *cf, const char *path) {
+    Status st = situacao(w);
+    if (st != OK) return st;
+    if (w->classes == w->nomes_cap) {
+        u4 nova = w->nomes_cap ? w->nomes_cap * 2 : 1024;
+        u4 *nomes = (u4 *)realloc(w->nomes, (size_t)nova * sizeof(u4));
+        if (!nomes) return ERR_MEMORY;
+        w->nomes = nomes;
+        w->nomes_cap = nova;
+    }
+
+    const CpInfo *cp = cf->constant_pool;
+    u2 n = cf->constant_pool_count;
+    u4 ordinal = w->classes;
+    u4 nome = internar(w, cp_nome_classe(cp, n, cf->this_class));
+    u4 first_interface = w->interfaces, first_field = w->fields, first_method = w->methods;
+    u4 first_ref = w->refs;
+
+    for (u2 i = 0; i < cf->interfaces_count; ++i) {
+        put_u4(&w->sec[META_SEC_INTERFACES], internar(w, cp_nome_classe(cp, n, cf->interfaces[i])));
+    }
+    w->interfaces += cf->interfaces_count;
+
+    OutSink *campos = &w->sec[META_SEC_FIELDS];
+    for (u2 i = 0; i < cf->fields_count; ++i) {
+        const FieldInfo *f = &cf->fields[i];
+        put_u4(campos, ordinal);
+        put_u4(campos, internar(w, cp_utf8(cp, n, f->name_index)));
+        put_u4(campos, internar(w, cp_utf8(cp, n, f->descriptor_index)));
+        put_u2(campos, f->access_flags);
+        put_u2(campos, 0);
+    }
+    w->fields += cf->fields_count;
+
+    for (u2 i = 0; i < cf->methods_count; ++i) gravar_metodo(w, cf, &cf->methods[i], ordinal);
+    w->methods += cf->methods_count;
+
+    u4 ref_count = gravar_referencias(w, cf);
+
+    OutSink *rec = &w->sec[META_SEC_CLASSES];
+    put_u4(rec, nome);
+    put_u4(rec, internar(w, cp_nome_classe(cp, n, cf->super_class)));
+    put_u4(rec, internar(w, source_file(cf)));
+    put_u4(rec, internar(w, path ? path : ""));
+    put_u4(rec, first_interface);
+    put_u4(rec, first_field);
+    put_u4(rec, first_method);
+    put_u4(rec, first_ref);
+    put_u4(rec, ref_count);
+    put_u2(rec, cf->interfaces_count);
+    put_u2(rec, cf->fields_count);
+    put_u2(rec, cf->methods_count);
+    put_u2(rec, cf->access_flags);
+    put_u2(rec, cf->major_version);
+    put_u2(rec, cf->minor_version);
+
+    w->nomes[w->classes++] = nome;
+    return situacao(w);
+}
+
+typedef struct {
+    const char *nome;
+    u4 ordinal;
+} ItemNome;
+
+static int comparar_nome(const void *a, const void *b) {
+    const ItemNome *x = (const ItemNome *)a, *y = (const ItemNome *)b;
+    int c = strcmp(x->nome, y->nome);
+    if (c) return c;
+    return x->ordinal < y->ordinal ? -1 : x->ordinal > y->ordinal;
+}
+
+/* Grava os pedacos em path via tmp + rename */
+static Status escrever_arquivo(const char *path, const void *const *pedacos, const size_t *tamanhos, int n) {
+    size_t lp = strlen(path);
+    char *tmp = (char *)malloc(lp + 5);
+    if (!tmp) return ERR_MEMORY;
+    memcpy(tmp, path, lp);
+    memcpy(tmp + lp, ".tmp", 5);
+
+    Status st = OK;
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        st = ERR_FILE;
+    } else {
+        for (int i = 0; i < n && st == OK; i++) {
+            if (tamanhos[i] && fwrite(pedacos[i], 1, tamanhos[i], f) != tamanhos[i]) st = ERR_FILE;
+        }
+        if (fclose(f) != 0) st = ERR_FILE;
+        if (st == OK && rename(tmp, path) != 0) st = ERR_FILE;
+        if (st != OK) remove(tmp);
+    }
+    free(tmp);
+    return st;
+}
+
+Status meta_writer_finish(MetaWriter *w, const char *path, size_t *out_size) {
+    Status st = situacao(w);
+    if (st != OK) return st;
+
+    /* indice de nomes: ordinais ordenados pelo nome interno */
+    u4 *nomes = (u4 *)malloc((size_t)(w->classes ? w->classes : 1) * sizeof(u4));
+    ItemNome *itens = (ItemNome *)malloc((size_t)(w->classes ? w->classes : 1) * sizeof(ItemNome));
+    if (!nomes || !itens) {
+        free(nomes);
+        free(itens);
+        return ERR_MEMORY;
+    }
+    const char *strings = w->sec[META_SEC_STRINGS].buf;
+    for (u4 i = 0; i < w->classes; ++i) {
+        itens[i].nome = strings + w->nomes[i];
+        itens[i].ordinal = i;
+    }
+    qsort(itens, w->classes, sizeof(ItemNome), comparar_nome);
+    for (u4 i = 0; i < w->classes; ++i) grava_u4((u1 *)&nomes[i], itens[i].ordinal);
+    free(itens);
+
+    const void *pedacos[1 + META_SECTION_COUNT];
+    size_t tamanhos[1 + META_SECTION_COUNT];
+    u1 cab[META_HEADER_SIZE];
+    memset(cab, 0, sizeof cab);
+
+    uint64_t off = META_HEADER_SIZE;
+    for (int s = 0; s < META_SECTION_COUNT; s++) {
+        pedacos[1 + s] = s == META_SEC_NAMES ? (const void *)nomes : (const void *)w->sec[s].buf;
+        tamanhos[1 + s] = s == META_SEC_NAMES ? (size_t)w->classes * 4 : w->sec[s].len;
+        grava_u8(cab + 48 + 8 * s, off);
+        off += tamanhos[1 + s];
+    }
+    memcpy(cab, META_MAGIC, 8);
+    grava_u4(cab + 8, META_VERSION);
+    grava_u8(cab + 16, off);
+    grava_u4(cab + 24, w->classes);
+    grava_u4(cab + 28, w->interfaces);
+    grava_u4(cab + 32, w->fields);
+    grava_u4(cab + 36, w->methods);
+    grava_u4(cab + 40, w->refs);
+    grava_u4(cab + 44, w->textos_count);
+    pedacos[0] = cab;
+    tamanhos[0] = sizeof cab;
+
+    st = escrever_arquivo(path, pedacos, tamanhos, 1 + META_SECTION_COUNT);
+    if (st == OK && out_size) *out_size = (size_t)off;
+    free(nomes);
+    return st;
+}
+
+void meta_writer_free(MetaWriter *w) {
+    if (!w) return;
+    for (int s = 0; s < SEC_GRAVADAS; s++) out_sink_close(&w->sec[s]);
+    free(w->textos);
+    free(w->nomes);
+    free(w);
+}
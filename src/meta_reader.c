@@ -0,0 +1,311 @@
+#define _POSIX_C_SOURCE 200809L
+#include "meta_reader.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct meta_file {
+    const uint8_t *base;
+    size_t size;
+    uint32_t count[5];          /* classes, interfaces, campos, metodos, referencias */
+    uint64_t sec[META_SECTION_COUNT];
+    uint64_t sec_end[META_SECTION_COUNT];
+};
+
+enum { N_CLASSES, N_INTERFACES, N_FIELDS, N_METHODS, N_REFS };
+
+/* ============================================================
+ * Leitura little-endian (independe do host e do alinhamento)
+ * ============================================================ */
+static uint16_t le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t le64(const uint8_t *p) {
+    return (uint64_t)le32(p) | ((uint64_t)le32(p + 4) << 32);
+}
+
+static int32_t be32(const uint8_t *p) {
+    return (int32_t)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3]);
+}
+
+/* ============================================================
+ * Abertura
+ * ============================================================ */
+
+/* Bytes de cada secao de registros (a de strings e a de codigo nao tem tamanho fixo) */
+static uint64_t bytes_da_secao(const MetaFile *mf, int s) {
+    switch (s) {
+    case META_SEC_CLASSES:    return (uint64_t)mf->count[N_CLASSES] * META_CLASS_SIZE;
+    case META_SEC_INTERFACES: return (uint64_t)mf->count[N_INTERFACES] * 4;
+    case META_SEC_FIELDS:     return (uint64_t)mf->count[N_FIELDS] * META_FIELD_SIZE;
+    case META_SEC_METHODS:    return (uint64_t)mf->count[N_METHODS] * META_METHOD_SIZE;
+    case META_SEC_REFS:       return (uint64_t)mf->count[N_REFS] * META_REF_SIZE;
+    case META_SEC_NAMES:      return (uint64_t)mf->count[N_CLASSES] * 4;
+    default:                  return 0;
+    }
+}
+
+static Status validar(MetaFile *mf) {
+    const uint8_t *h = mf->base;
+    if (mf->size < META_HEADER_SIZE || memcmp(h, META_MAGIC, 8) != 0) return ERR_BOUNDS;
+    if (le32(h + 8) != META_VERSION || le64(h + 16) != mf->size) return ERR_BOUNDS;
+
+    for (int i = 0; i < 5; i++) mf->count[i] = le32(h + 24 + 4 * i);
+    for (int s = 0; s < META_SECTION_COUNT; s++) mf->sec[s] = le64(h + 48 + 8 * s);
+
+    /* secoes em ordem crescente, dentro do arquivo; cada uma vai ate a proxima */
+    for (int s = 0; s < META_SECTION_COUNT; s++) {
+        uint64_t fim = s + 1 < META_SECTION_COUNT ? mf->sec[s + 1] : mf->size;
+        if (mf->sec[s] < META_HEADER_SIZE || mf->sec[s] > fim || fim > mf->size) return ERR_BOUNDS;
+        if (fim - mf->sec[s] < bytes_da_secao(mf, s)) return ERR_BOUNDS;
+        mf->sec_end[s] = fim;
+    }
+    /* strings: comeca com "" e termina em '\0' */
+    uint64_t ini = mf->sec[META_SEC_STRINGS], fim = mf->sec_end[META_SEC_STRINGS];
+    if (fim == ini || mf->base[ini] != 0 || mf->base[fim - 1] != 0) return ERR_BOUNDS;
+    return OK;
+}
+
+MetaFile *meta_open(const char *path, Status *out_status) {
+    Status st = ERR_FILE;
+    MetaFile *mf = NULL;
+    int fd = open(path, O_RDONLY);
+    struct stat sb;
+    if (fd >= 0 && fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        void *base = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (base != MAP_FAILED) {
+            mf = (MetaFile *)calloc(1, sizeof(MetaFile));
+            if (!mf) {
+                munmap(base, (size_t)sb.st_size);
+                st = ERR_MEMORY;
+            } else {
+                mf->base = (const uint8_t *)base;
+                mf->size = (size_t)sb.st_size;
+                st = validar(mf);
+                if (st != OK) {
+                    meta_close(mf);
+                    mf = NULL;
+                }
+            }
+        }
+    }
+    if (fd >= 0) close(fd);
+    if (out_status) *out_status = st;
+    return mf;
+}
+
+void meta_close(MetaFile *mf) {
+    if (!mf) return;
+    munmap((void *)mf->base, mf->size);
+    free(mf);
+}
+
+uint32_t meta_class_count(const MetaFile *mf) { return mf->count[N_CLASSES]; }
+uint32_t meta_field_count(const MetaFile *mf) { return mf->count[N_FIELDS]; }
+uint32_t meta_method_count(const MetaFile *mf) { return mf->count[N_METHODS]; }
+
+/* ============================================================
+ * Registros
+ * ============================================================ */
+static const char *texto(const MetaFile *mf, uint32_t ref) {
+    uint64_t off = mf->sec[META_SEC_STRINGS] + ref;
+    if (off >= mf->sec_end[META_SEC_STRINGS]) return "";
+    return (const char *)mf->base + off;
+}
+
+static const uint8_t *registro(const MetaFile *mf, int s, uint32_t i, uint32_t tamanho) {
+    return mf->base + mf->sec[s] + (uint64_t)i * tamanho;
+}
+
+bool meta_class(const MetaFile *mf, uint32_t i, MetaClass *out) {
+    if (i >= mf->count[N_CLASSES]) return false;
+    const uint8_t *r = registro(mf, META_SEC_CLASSES, i, META_CLASS_SIZE);
+    out->name = texto(mf, le32(r));
+    out->super_name = texto(mf, le32(r + 4));
+    out->source_file = texto(mf, le32(r + 8));
+    out->path = texto(mf, le32(r + 12));
+    out->first_interface = le32(r + 16);
+    out->first_field = le32(r + 20);
+    out->first_method = le32(r + 24);
+    out->first_ref = le32(r + 28);
+    out->ref_count = le32(r + 32);
+    out->interface_count = le16(r + 36);
+    out->field_count = le16(r + 38);
+    out->method_count = le16(r + 40);
+    out->access_flags = le16(r + 42);
+    out->major_version = le16(r + 44);
+    out->minor_version = le16(r + 46);
+    return true;
+}
+
+bool meta_field(const MetaFile *mf, uint32_t i, MetaField *out) {
+    if (i >= mf->count[N_FIELDS]) return false;
+    const uint8_t *r = registro(mf, META_SEC_FIELDS, i, META_FIELD_SIZE);
+    out->class_index = le32(r);
+    out->name = texto(mf, le32(r + 4));
+    out->descriptor = texto(mf, le32(r + 8));
+    out->access_flags = le16(r + 12);
+    return true;
+}
+
+bool meta_method(const MetaFile *mf, uint32_t i, MetaMethod *out) {
+    if (i >= mf->count[N_METHODS]) return false;
+    const uint8_t *r = registro(mf, META_SEC_METHODS, i, META_METHOD_SIZE);
+    out->class_index = le32(r);
+    out->name = texto(mf, le32(r + 4));
+    out->descriptor = texto(mf, le32(r + 8));
+    out->code_length = le32(r + 12);
+    uint64_t code = le64(r + 16);
+    out->insn_count = le32(r + 24);
+    out->access_flags = le16(r + 28);
+    out->max_stack = le16(r + 30);
+    out->max_locals = le16(r + 32);
+
+    uint64_t ini = mf->sec[META_SEC_CODE] + code;
+    if (out->code_length == 0 || ini > mf->sec_end[META_SEC_CODE] ||
+        mf->sec_end[META_SEC_CODE] - ini < out->code_length) {
+        out->code = NULL;
+        out->code_length = 0;
+        out->insn_count = 0;
+    } else {
+        out->code = mf->base + ini;
+    }
+    return true;
+}
+
+bool meta_ref(const MetaFile *mf, uint32_t i, MetaRef *out) {
+    if (i >= mf->count[N_REFS]) return false;
+    const uint8_t *r = registro(mf, META_SEC_REFS, i, META_REF_SIZE);
+    out->tag = r[0];
+    out->cp_index = le16(r + 2);
+    out->owner = texto(mf, le32(r + 4));
+    out->name = texto(mf, le32(r + 8));
+    out->descriptor = texto(mf, le32(r + 12));
+    return true;
+}
+
+const char *meta_interface(const MetaFile *mf, uint32_t i) {
+    if (i >= mf->count[N_INTERFACES]) return "";
+    return texto(mf, le32(registro(mf, META_SEC_INTERFACES, i, 4)));
+}
+
+int64_t meta_find_class(const MetaFile *mf, const char *name) {
+    uint32_t lo = 0, hi = mf->count[N_CLASSES];
+    while (lo < hi) {
+        uint32_t meio = lo + (hi - lo) / 2;
+        uint32_t idx = le32(registro(mf, META_SEC_NAMES, meio, 4));
+        if (idx >= mf->count[N_CLASSES]) return -1;
+        const char *nome = texto(mf, le32(registro(mf, META_SEC_CLASSES, idx, META_CLASS_SIZE)));
+        int c = strcmp(nome, name);
+        if (c == 0) return idx;
+        if (c < 0) lo = meio + 1;
+        else hi = meio;
+    }
+    return -1;
+}
+
+bool meta_find_ref(const MetaFile *mf, const MetaClass *cls, uint16_t cp_index, MetaRef *out) {
+    uint32_t lo = cls->first_ref, hi = cls->first_ref + cls->ref_count;
+    if (hi > mf->count[N_REFS] || hi < lo) return false;
+    while (lo < hi) {
+        uint32_t meio = lo + (hi - lo) / 2;
+        uint16_t idx = le16(registro(mf, META_SEC_REFS, meio, META_REF_SIZE) + 2);
+        if (idx == cp_index) return meta_ref(mf, meio, out);
+        if (idx < cp_index) lo = meio + 1;
+        else hi = meio;
+    }
+    return false;
+}
+
+/* ============================================================
+ * Instrucoes
+ * ============================================================ */
+
+/* Tamanho das instrucoes de formato fixo (0 = variavel ou invalida) */
+static uint32_t tamanho_fixo(uint8_t op) {
+    if (op <= 0x0F) return 1;
+    if (op == 0x10 || op == 0x12) return 2;
+    if (op == 0x11 || op == 0x13 || op == 0x14) return 3;
+    if (op >= 0x15 && op <= 0x19) return 2;
+    if (op >= 0x1A && op <= 0x35) return 1;
+    if (op >= 0x36 && op <= 0x3A) return 2;
+    if (op >= 0x3B && op <= 0x83) return 1;
+    if (op == 0x84) return 3;
+    if (op >= 0x85 && op <= 0x98) return 1;
+    if (op >= 0x99 && op <= 0xA8) return 3;
+    if (op == 0xA9) return 2;
+    if (op >= 0xAC && op <= 0xB1) return 1;
+    if (op >= 0xB2 && op <= 0xB8) return 3;
+    switch (op) {
+    case 0xB9: case 0xBA: case 0xC8: case 0xC9: return 5;
+    case 0xBB: case 0xBD: case 0xC0: case 0xC1: case 0xC6: case 0xC7: return 3;
+    case 0xBC: return 2;
+    case 0xBE: case 0xBF: case 0xC2: case 0xC3: return 1;
+    case 0xC5: return 4;
+    default: return 0;
+    }
+}
+
+uint32_t meta_insn_length(const uint8_t *code, uint32_t len, uint32_t pc) {
+    if (pc >= len) return 0;
+    uint8_t op = code[pc];
+    uint32_t n = tamanho_fixo(op);
+    if (n) return pc + n <= len ? n : 0;
+
+    if (op == 0xAA || op == 0xAB) {
+        /* padding ate multiplo de 4, relativo ao inicio do codigo */
+        uint32_t base = (pc + 4) & ~3u;
+        if (base > len || len - base < 12) return 0;
+        if (op == 0xAA) {
+            int32_t low = be32(code + base + 4), high = be32(code + base + 8);
+            if (high < low) return 0;
+            uint32_t casos = (uint32_t)((int64_t)high - low + 1);
+            if (casos > (len - base - 12) / 4) return 0;
+            return base + 12 + 4 * casos - pc;
+        }
+        int32_t pares = be32(code + base + 4);
+        if (pares < 0 || (uint32_t)pares > (len - base - 8) / 8) return 0;
+        return base + 8 + 8 * (uint32_t)pares - pc;
+    }
+    if (op == 0xC4 && pc + 1 < len) {
+        uint8_t alvo = code[pc + 1];
+        if (alvo == 0x84) n = 6;
+        else if ((alvo >= 0x15 && alvo <= 0x19) || (alvo >= 0x36 && alvo <= 0x3A) || alvo == 0xA9) n = 4;
+        return n && pc + n <= len ? n : 0;
+    }
+    return 0;
+}
+
+bool meta_next_insn(const MetaMethod *m, uint32_t *pc, MetaInsn *out) {
+    uint32_t n = m->code ? meta_insn_length(m->code, m->code_length, *pc) : 0;
+    if (!n) return false;
+
+    const uint8_t *p = m->code + *pc;
+    out->pc = *pc;
+    out->length = n;
+    out->opcode = p[0];
+    out->cp_index = 0;
+    switch (p[0]) {
+    case 0x12:                                  /* ldc */
+        out->cp_index = p[1];
+        break;
+    case 0x13: case 0x14:                       /* ldc_w, ldc2_w */
+    case 0xB2: case 0xB3: case 0xB4: case 0xB5: /* get/put field/static */
+    case 0xB6: case 0xB7: case 0xB8: case 0xB9: case 0xBA:   /* invoke* */
+    case 0xBB: case 0xBD: case 0xC0: case 0xC1: case 0xC5:   /* new, anewarray, checkcast, instanceof, multianewarray */
+        out->cp_index = (uint16_t)((p[1] << 8) | p[2]);
+        break;
+    default:
+        break;
+    }
+    *pc += n;
+    return true;
+}
@@ -0,0 +1,97 @@
+#include "natives.h"
+#include <stdio.h>
+#include <string.h>
+
+/* ============================================================
+ * Implementacoes
+ * ============================================================ */
+
+/* Object.<init>: nada a fazer */
+static int nativo_nada(const Slot *args, Slot *ret) {
+    (void)args;
+    (void)ret;
+    return 0;
+}
+
+static void escrever_texto(ObjectRef obj) {
+    const char *s = jvm_heap_string_chars(obj);
+    if (s) fputs(s, stdout);
+    else if (!obj) fputs("null", stdout);
+    else printf("Object@%lx", (unsigned long)(uintptr_t)obj);
+}
+
+/* PrintStream.print*: args[0] e o PrintStream (ignorado: sempre stdout) */
+static int print_int(const Slot *args, Slot *ret) { (void)ret; printf("%d", (int32_t)args[1]); return 0; }
+static int print_char(const Slot *args, Slot *ret) { (void)ret; putchar((int)(args[1] & 0xFF)); return 0; }
+static int print_bool(const Slot *args, Slot *ret) { (void)ret; fputs(args[1] ? "true" : "false", stdout); return 0; }
+static int print_obj(const Slot *args, Slot *ret) { (void)ret; escrever_texto(jvm_heap_deref(args[1])); return 0; }
+
+static int println_vazio(const Slot *args, Slot *ret) { (void)args; (void)ret; putchar('\n'); return 0; }
+static int println_int(const Slot *args, Slot *ret) { print_int(args, ret); putchar('\n'); return 0; }
+static int println_char(const Slot *args, Slot *ret) { print_char(args, ret); putchar('\n'); return 0; }
+static int println_bool(const Slot *args, Slot *ret) { print_bool(args, ret); putchar('\n'); return 0; }
+static int println_obj(const Slot *args, Slot *ret) { print_obj(args, ret); putchar('\n'); return 0; }
+
+/* java/lang/Math (estaticos: sem 'this') */
+static int math_abs(const Slot *args, Slot *ret) {
+    int32_t v = (int32_t)args[0];
+    ret[0] = (Slot)(v < 0 ? -(u4)v : (u4)v);
+    return 0;
+}
+static int math_max(const Slot *args, Slot *ret) {
+    ret[0] = (int32_t)args[0] > (int32_t)args[1] ? args[0] : args[1];
+    return 0;
+}
+static int math_min(const Slot *args, Slot *ret) {
+    ret[0] = (int32_t)args[0] < (int32_t)args[1] ? args[0] : args[1];
+    return 0;
+}
+
+/* String.length(): so strings de ldc */
+static int string_length(const Slot *args, Slot *ret) {
+    const char *s = jvm_heap_string_chars(jvm_heap_deref(args[0]));
+    if (!s) return -1;
+    ret[0] = (Slot)strlen(s);
+    return 0;
+}
+
+/* ============================================================
+ * Tabela
+ * ============================================================ */
+typedef struct {
+    const char *class_name;
+    const char *name;
+    const char *descriptor;
+    NativeMethod fn;
+} EntradaNativa;
+
+static const EntradaNativa nativos[] = {
+    { "java/lang/Object",    "<init>",  "()V",                     nativo_nada },
+    { "java/io/PrintStream", "println", "()V",                     println_vazio },
+    { "java/io/PrintStream", "println", "(I)V",                    println_int },
+    { "java/io/PrintStream", "println", "(C)V",                    println_char },
+    { "java/io/PrintStream", "println", "(Z)V",                    println_bool },
+    { "java/io/PrintStream", "println", "(Ljava/lang/String;)V",   println_obj },
+    { "java/io/PrintStream", "println", "(Ljava/lang/Object;)V",   println_obj },
+    { "java/io/PrintStream", "print",   "(I)V",                    print_int },
+    { "java/io/PrintStream", "print",   "(C)V",                    print_char },
+    { "java/io/PrintStream", "print",   "(Z)V",                    print_bool },
+    { "java/io/PrintStream", "print",   "(Ljava/lang/String;)V",   print_obj },
+    { "java/io/PrintStream", "print",   "(Ljava/lang/Object;)V",   print_obj },
+    { "java/lang/Math",      "abs",     "(I)I",                    math_abs },
+    { "java/lang/Math",      "max",     "(II)I",                   math_max },
+    { "java/lang/Math",      "min",     "(II)I",                   math_min },
+    { "java/lang/String",    "length",  "()I",                     string_length },
+};
+
+NativeMethod native_lookup(const char *class_name, const char *name, const char *descriptor) {
+    if (!class_name || !name || !descriptor) return NULL;
+    for (size_t i = 0; i < sizeof nativos / sizeof nativos[0]; ++i) {
+        const EntradaNativa *e = &nativos[i];
+        if (strcmp(e->name, name) == 0 && strcmp(e->descriptor, descriptor) == 0 &&
+            strcmp(e->class_name, class_name) == 0) {
+            return e->fn;
+        }
+    }
+    return NULL;
+}
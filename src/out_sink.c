@@ -0,0 +1,235 @@
+#include "out_sink.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* ============================================================
+ * Ciclo de vida
+ * ============================================================ */
+static Status abrir(OutSink *s, FILE *f, size_t cap) {
+    s->buf = (char *)malloc(cap);
+    s->len = 0;
+    s->cap = s->buf ? cap : 0;
+    s->file = f;
+    s->status = s->buf ? OK : ERR_MEMORY;
+    return s->status;
+}
+
+Status out_sink_open_file(OutSink *s, FILE *f) {
+    return abrir(s, f, OUT_SINK_BUFFER);
+}
+
+Status out_sink_open_memory(OutSink *s) {
+    return abrir(s, NULL, 4096);
+}
+
+static void falhar(OutSink *s, Status st) {
+    if (s->status == OK) s->status = st;
+}
+
+Status out_sink_flush(OutSink *s) {
+    if (s->file && s->len > 0) {
+        if (fwrite(s->buf, 1, s->len, s->file) != s->len) falhar(s, ERR_FILE);
+        s->len = 0;
+    }
+    return s->status;
+}
+
+Status out_sink_close(OutSink *s) {
+    out_sink_flush(s);
+    free(s->buf);
+    s->buf = NULL;
+    s->len = s->cap = 0;
+    return s->status;
+}
+
+void out_sink_clear(OutSink *s) {
+    s->len = 0;
+}
+
+char *out_sink_take(OutSink *s, size_t *len) {
+    char *buf = s->buf;
+    *len = s->len;
+    s->buf = NULL;
+    s->len = s->cap = 0;
+    return buf;
+}
+
+bool out_sink_reserve(OutSink *s, size_t n) {
+    if (n <= s->cap - s->len) return true;
+    if (s->status != OK) return false;
+
+    if (s->file) {
+        out_sink_flush(s);
+        if (n <= s->cap) return s->status == OK;
+    }
+    /* Memoria, ou um pedaco maior que o buffer inteiro: cresce */
+    size_t nova = s->cap ? s->cap : 4096;
+    while (nova - s->len < n) nova *= 2;
+    char *buf = (char *)realloc(s->buf, nova);
+    if (!buf) {
+        falhar(s, ERR_MEMORY);
+        return false;
+    }
+    s->buf = buf;
+    s->cap = nova;
+    return true;
+}
+
+/* ============================================================
+ * Numeros e padding
+ * ============================================================ */
+static const char DIGITOS2[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+size_t out_format_u64(char *dst, uint64_t v) {
+    char tmp[20];
+    char *p = tmp + sizeof tmp;
+    while (v >= 100) {
+        unsigned d = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--p = DIGITOS2[d + 1];
+        *--p = DIGITOS2[d];
+    }
+    if (v >= 10) {
+        *--p = DIGITOS2[v * 2 + 1];
+        *--p = DIGITOS2[v * 2];
+    } else {
+        *--p = (char)('0' + v);
+    }
+    size_t n = (size_t)(tmp + sizeof tmp - p);
+    memcpy(dst, p, n);
+    return n;
+}
+
+size_t out_format_i64(char *dst, int64_t v) {
+    if (v >= 0) return out_format_u64(dst, (uint64_t)v);
+    dst[0] = '-';
+    return 1 + out_format_u64(dst + 1, 0 - (uint64_t)v);
+}
+
+void out_u32(OutSink *s, uint32_t v) {
+    char tmp[24];
+    out_put(s, tmp, out_format_u64(tmp, v));
+}
+
+void out_i32(OutSink *s, int32_t v) {
+    char tmp[24];
+    out_put(s, tmp, out_format_i64(tmp, v));
+}
+
+void out_i64(OutSink *s, int64_t v) {
+    char tmp[24];
+    out_put(s, tmp, out_format_i64(tmp, v));
+}
+
+static void repetir(OutSink *s, char c, size_t n) {
+    if (!out_sink_reserve(s, n)) return;
+    memset(s->buf + s->len, c, n);
+    s->len += n;
+}
+
+void out_u32_zero(OutSink *s, uint32_t v, int width) {
+    char tmp[24];
+    size_t n = out_format_u64(tmp, v);
+    if ((size_t)width > n) repetir(s, '0', (size_t)width - n);
+    out_put(s, tmp, n);
+}
+
+void out_hex(OutSink *s, uint32_t v, int digits) {
+    static const char HEX[] = "0123456789ABCDEF";
+    char tmp[8];
+    int n = 0;
+    do {
+        tmp[7 - n++] = HEX[v & 0xF];
+        v >>= 4;
+    } while (v);
+    if (digits > n) repetir(s, '0', (size_t)(digits - n));
+    out_put(s, tmp + 8 - n, (size_t)n);
+}
+
+void out_str_padded(OutSink *s, const char *str, size_t width) {
+    size_t n = strlen(str);
+    out_put(s, str, n);
+    if (width > n) repetir(s, ' ', width - n);
+}
+
+void out_fmt(OutSink *s, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(s->buf + s->len, s->cap - s->len, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+        falhar(s, ERR_FILE);
+        return;
+    }
+    if ((size_t)n >= s->cap - s->len) {
+        /* Nao coube: abre espaco e formata de novo */
+        if (!out_sink_reserve(s, (size_t)n + 1)) return;
+        va_start(ap, fmt);
+        vsnprintf(s->buf + s->len, s->cap - s->len, fmt, ap);
+        va_end(ap);
+    }
+    s->len += (size_t)n;
+}
+
+/* ============================================================
+ * Escape JSON
+ * ============================================================ */
+
+/* 0 = copia; senao o caractere depois da '\' ('u' = \u00XX) */
+static const char ESCAPE[256] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 't', 'n', 'u', 'u', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    ['"'] = '"', ['\\'] = '\\', [0x7F] = 'u',
+};
+
+/* Quantos bytes de p[0..n) podem ser copiados sem escape */
+static size_t trecho_limpo(const unsigned char *p, size_t n) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i aspas = _mm_set1_epi8('"');
+    const __m128i barra = _mm_set1_epi8('\\');
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i limite = _mm_set1_epi8(0x1F);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i ruim = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, aspas), _mm_cmpeq_epi8(v, barra)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, del),
+                                                 _mm_cmpeq_epi8(_mm_min_epu8(v, limite), v)));  /* v <= 0x1F */
+        int mascara = _mm_movemask_epi8(ruim);
+        if (mascara) return i + (size_t)__builtin_ctz((unsigned)mascara);
+    }
+#endif
+    while (i < n && !ESCAPE[p[i]]) i++;
+    return i;
+}
+
+void out_json_escaped(OutSink *s, const char *str) {
+    static const char HEX[] = "0123456789abcdef";
+    const unsigned char *p = (const unsigned char *)str;
+    size_t n = strlen(str);
+
+    while (n > 0) {
+        size_t k = trecho_limpo(p, n);
+        out_put(s, (const char *)p, k);
+        p += k;
+        n -= k;
+        if (n == 0) break;
+
+        char e = ESCAPE[*p];
+        if (e == 'u') {
+            char u[6] = { '\\', 'u', '0', '0', HEX[*p >> 4], HEX[*p & 0xF] };
+            out_put(s, u, 6);
+        } else {
+            char d[2] = { '\\', e };
+            out_put(s, d, 2);
+        }
+        p++;
+        n--;
+    }
+}
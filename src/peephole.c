@@ -0,0 +1,681 @@
+#include "peephole.h"
+#include "cfg.h"
+#include "class_registry.h"
+#include "disasm.h"
+#include "verifier.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NENHUM UINT32_MAX
+
+static PeepholeConfig config;
+static PeepholeStats totais;          /* sob o mutex do cp_cache */
+
+void peephole_configure(const PeepholeConfig *c) {
+    config = *c;
+}
+
+bool peephole_enabled(void) {
+    return !config.disabled;
+}
+
+void peephole_totals(PeepholeStats *out) {
+    *out = totais;
+}
+
+/* ============================================================
+ * Instrucoes
+ * ============================================================ */
+
+typedef struct {
+    u4 pc, len;                 /* no original */
+    u1 op;                      /* opcode de saida */
+    u1 n;                       /* bytes em b; 0 = os do original */
+    u1 b[3];
+    bool removida;
+    bool alvo;                  /* alguem salta para ca */
+    u4 desvio;                  /* if<cc>, goto, ifnull: instrucao alvo */
+    u4 rodar;                   /* goto de laco contado: 1a instrucao do teste copiado */
+    u4 novo_pc;
+} Insn;
+
+typedef struct {
+    Insn *ins;
+    u4 n;
+    const u1 *code;
+    const DisasmInsn *dm;
+    PeepholeStats st;
+} Otimizador;
+
+static int32_t ler_s16(const u1 *p) {
+    return (int16_t)((p[0] << 8) | p[1]);
+}
+
+static int32_t ler_s32(const u1 *p) {
+    return (int32_t)((u4)p[0] << 24 | (u4)p[1] << 16 | (u4)p[2] << 8 | p[3]);
+}
+
+static void gravar_s16(u1 *p, int32_t v) {
+    p[0] = (u1)(v >> 8);
+    p[1] = (u1)v;
+}
+
+static void gravar_s32(u1 *p, int32_t v) {
+    p[0] = (u1)((u4)v >> 24);
+    p[1] = (u1)((u4)v >> 16);
+    p[2] = (u1)((u4)v >> 8);
+    p[3] = (u1)v;
+}
+
+static bool eh_desvio(u1 op) {
+    return (op >= 0x99 && op <= 0xA7) || op == 0xC6 || op == 0xC7;
+}
+
+static u4 proxima(const Otimizador *o, u4 i) {
+    for (u4 j = i + 1; j < o->n; j++) {
+        if (!o->ins[j].removida) return j;
+    }
+    return NENHUM;
+}
+
+static u4 anterior(const Otimizador *o, u4 i) {
+    for (u4 j = i; j-- > 0;) {
+        if (!o->ins[j].removida) return j;
+    }
+    return NENHUM;
+}
+
+/* Quem saltava para i passa a cair na seguinte */
+static void remover(Otimizador *o, u4 i) {
+    o->ins[i].removida = true;
+    u4 j = proxima(o, i);
+    if (o->ins[i].alvo && j != NENHUM) o->ins[j].alvo = true;
+}
+
+static void reescrever(Insn *x, u1 op) {
+    x->op = x->b[0] = op;
+    x->n = 1;
+}
+
+/* ============================================================
+ * Locais
+ * ============================================================ */
+
+enum { L_NADA = 0, L_USO, L_DEF, L_AMBOS };
+
+typedef struct {
+    u1 efeito;
+    u1 tipo;                    /* 0 int, 1 long, 2 float, 3 double, 4 referencia */
+    u1 largura;                 /* slots */
+    u2 local;
+} Acesso;
+
+static Acesso acesso(const u1 *ins) {
+    Acesso a = { L_NADA, 0, 1, 0 };
+    u1 op = ins[0];
+    bool largo = op == 0xC4;
+    if (largo) op = ins[1];
+    if ((op >= 0x15 && op <= 0x19) || (op >= 0x36 && op <= 0x3A) || op == 0x84) {
+        a.efeito = op == 0x84 ? L_AMBOS : op <= 0x19 ? L_USO : L_DEF;
+        a.tipo = op == 0x84 ? 0 : (u1)(op <= 0x19 ? op - 0x15 : op - 0x36);
+        a.local = largo ? (u2)((ins[2] << 8) | ins[3]) : ins[1];
+    } else if ((op >= 0x1A && op <= 0x2D) || (op >= 0x3B && op <= 0x4E)) {
+        u1 base = op <= 0x2D ? 0x1A : 0x3B;
+        a.efeito = op <= 0x2D ? L_USO : L_DEF;
+        a.tipo = (u1)((op - base) / 4);
+        a.local = (u2)((op - base) % 4);
+    } else {
+        return a;
+    }
+    a.largura = a.tipo == 1 || a.tipo == 3 ? 2 : 1;
+    return a;
+}
+
+/* vivas antes da instrucao, a partir das vivas depois */
+static void transferir(u4 *vivas, Acesso a) {
+    for (u4 k = 0; k < a.largura && a.efeito != L_NADA; k++) {
+        u4 l = (u4)a.local + k;
+        if (a.efeito == L_DEF) vivas[l / 32] &= ~(1u << (l % 32));
+        else vivas[l / 32] |= 1u << (l % 32);
+    }
+}
+
+static bool viva(const u4 *vivas, Acesso a) {
+    for (u4 k = 0; k < a.largura; k++) {
+        u4 l = (u4)a.local + k;
+        if (vivas[l / 32] & (1u << (l % 32))) return true;
+    }
+    return false;
+}
+
+/*
+ * Vivacidade das locais sobre o CFG (sem excecoes: so fluxo, desvios e
+ * switches). morta[i]: a local que a instrucao i le ou grava nao e lida
+ * depois dela.
+ */
+static Status vivacidade(const Otimizador *o, const Cfg *cfg, u2 max_locals, u1 *morta) {
+    u4 palavras = ((u4)max_locals + 31) / 32;
+    if (palavras == 0) palavras = 1;
+    u4 *entrada = (u4 *)calloc((size_t)cfg->block_count * palavras, sizeof(u4));
+    u4 *vivas = (u4 *)malloc(palavras * sizeof(u4));
+    if (!entrada || !vivas) {
+        free(entrada);
+        free(vivas);
+        return ERR_MEMORY;
+    }
+
+    for (int fase = 0; fase < 2; fase++) {
+        bool mudou = true;
+        while (mudou) {
+            mudou = false;
+            for (u4 b = cfg->block_count; b-- > 0;) {
+                const CfgBlock *bl = &cfg->blocks[b];
+                memset(vivas, 0, palavras * sizeof(u4));
+                for (u4 e = bl->succ_first; e < bl->succ_first + bl->succ_count; e++) {
+                    const u4 *s = entrada + (size_t)cfg->edges[e].to * palavras;
+                    for (u4 w = 0; w < palavras; w++) vivas[w] |= s[w];
+                }
+                for (u4 i = bl->first_insn + bl->insn_count; i-- > bl->first_insn;) {
+                    Acesso a = acesso(o->code + o->ins[i].pc);
+                    if (fase == 1 && a.efeito != L_NADA) morta[i] = !viva(vivas, a);
+                    transferir(vivas, a);
+                }
+                u4 *e = entrada + (size_t)b * palavras;
+                if (fase == 0 && memcmp(e, vivas, palavras * sizeof(u4)) != 0) {
+                    memcpy(e, vivas, palavras * sizeof(u4));
+                    mudou = true;
+                }
+            }
+            if (fase == 1) break;
+        }
+    }
+    free(entrada);
+    free(vivas);
+    return OK;
+}
+
+/* ============================================================
+ * Padroes
+ * ============================================================ */
+
+static bool constante(const Otimizador *o, u4 i, int32_t *k) {
+    const Insn *x = &o->ins[i];
+    const u1 *p = x->n ? x->b : o->code + x->pc;
+    if (x->op >= 0x02 && x->op <= 0x08) *k = x->op - 0x03;
+    else if (x->op == 0x10) *k = (int8_t)p[1];
+    else if (x->op == 0x11) *k = ler_s16(p + 1);
+    else if ((x->op == 0x12 || x->op == 0x13) && o->dm[i].res_kind == DISASM_RES_INT) *k = o->dm[i].res.i;
+    else return false;
+    return true;
+}
+
+/* Forma mais curta de empilhar v; false se so um ldc serviria */
+static bool codificar_constante(Insn *x, int32_t v) {
+    if (v >= -1 && v <= 5) {
+        reescrever(x, (u1)(0x03 + v));
+    } else if (v >= INT8_MIN && v <= INT8_MAX) {
+        reescrever(x, 0x10);
+        x->b[1] = (u1)v;
+        x->n = 2;
+    } else if (v >= INT16_MIN && v <= INT16_MAX) {
+        reescrever(x, 0x11);
+        gravar_s16(x->b + 1, v);
+        x->n = 3;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/* a op b com a aritmetica do int do Java */
+static bool dobrar(u1 op, int32_t a, int32_t b, int32_t *r) {
+    u4 x = (u4)a, y = (u4)b;
+    switch (op) {
+        case 0x60: *r = (int32_t)(x + y); return true;          /* iadd */
+        case 0x64: *r = (int32_t)(x - y); return true;          /* isub */
+        case 0x68: *r = (int32_t)(x * y); return true;          /* imul */
+        case 0x6C: case 0x70:                                   /* idiv, irem */
+            if (b == 0) return false;
+            if (a == INT32_MIN && b == -1) *r = op == 0x6C ? INT32_MIN : 0;
+            else *r = op == 0x6C ? a / b : a % b;
+            return true;
+        case 0x78: *r = (int32_t)(x << (y & 31)); return true;  /* ishl */
+        case 0x7A: *r = a >> (y & 31); return true;             /* ishr */
+        case 0x7C: *r = (int32_t)(x >> (y & 31)); return true;  /* iushr */
+        case 0x7E: *r = (int32_t)(x & y); return true;          /* iand */
+        case 0x80: *r = (int32_t)(x | y); return true;          /* ior */
+        case 0x82: *r = (int32_t)(x ^ y); return true;          /* ixor */
+        default: return false;
+    }
+}
+
+/* Constantes seguidas (sem alvo no meio) e a operacao que as consome */
+static void dobrar_constantes(Otimizador *o) {
+    u4 pend[2];
+    u4 np = 0;
+    for (u4 i = 0; i < o->n; i++) {
+        Insn *x = &o->ins[i];
+        if (x->removida) continue;
+        if (x->alvo) np = 0;
+        int32_t a, b, r;
+        if (constante(o, i, &b)) {
+            if (np == 2) pend[0] = pend[1];
+            pend[np < 2 ? np++ : 1] = i;
+            continue;
+        }
+        if (x->op == 0x74 && np >= 1 && constante(o, pend[np - 1], &a)) {
+            Insn c = o->ins[pend[np - 1]];
+            if (codificar_constante(&c, (int32_t)(0u - (u4)a))) {
+                o->ins[pend[np - 1]] = c;
+                remover(o, i);
+                o->st.folded++;
+                continue;
+            }
+        }
+        if (np == 2 && constante(o, pend[0], &a) && constante(o, pend[1], &b) && dobrar(x->op, a, b, &r)) {
+            Insn c = o->ins[pend[0]];
+            if (codificar_constante(&c, r)) {
+                o->ins[pend[0]] = c;
+                remover(o, pend[1]);
+                remover(o, i);
+                np = 1;
+                o->st.folded++;
+                continue;
+            }
+        }
+        np = 0;
+    }
+}
+
+/* Slots empilhados por uma instrucao sem efeito colateral (0 se nao e uma) */
+static u4 empilha_puro(const Otimizador *o, u4 i) {
+    const Insn *x = &o->ins[i];
+    u1 op = x->op;
+    if (op == 0x12 || op == 0x13) {
+        return o->dm[i].res_kind == DISASM_RES_INT || o->dm[i].res_kind == DISASM_RES_FLOAT ? 1 : 0;
+    }
+    if (op == 0x01 || (op >= 0x02 && op <= 0x08) || (op >= 0x0B && op <= 0x0D) || op == 0x10 || op == 0x11) return 1;
+    if (op == 0x09 || op == 0x0A || op == 0x0E || op == 0x0F) return 2;
+    Acesso a = x->n ? (Acesso){ L_NADA, 0, 1, 0 } : acesso(o->code + x->pc);
+    return a.efeito == L_USO ? a.largura : 0;
+}
+
+/* xstore n; xload n com n morta depois; stores mortos */
+static void remover_stores(Otimizador *o, const u1 *morta) {
+    for (u4 i = 0; i < o->n; i++) {
+        Insn *x = &o->ins[i];
+        if (x->removida || x->n) continue;
+        Acesso s = acesso(o->code + x->pc);
+        if (s.efeito != L_DEF) continue;
+
+        u4 j = proxima(o, i);
+        if (j != NENHUM && !o->ins[j].alvo && !o->ins[j].n) {
+            Acesso l = acesso(o->code + o->ins[j].pc);
+            if (l.efeito == L_USO && l.local == s.local && l.tipo == s.tipo && morta[j]) {
+                remover(o, i);
+                remover(o, j);
+                o->st.store_loads++;
+                continue;
+            }
+        }
+        if (!morta[i]) continue;
+        u4 p = anterior(o, i);
+        if (!x->alvo && p != NENHUM && empilha_puro(o, p) == s.largura) {
+            remover(o, p);
+            remover(o, i);
+        } else {
+            reescrever(x, s.largura == 2 ? 0x58 : 0x57);        /* pop2, pop */
+        }
+        o->st.dead_stores++;
+    }
+}
+
+/* Desvio para goto vai direto ao alvo final */
+static void encurtar_saltos(Otimizador *o) {
+    for (u4 i = 0; i < o->n; i++) {
+        Insn *x = &o->ins[i];
+        if (x->removida || x->desvio == NENHUM) continue;
+        u4 t = x->desvio;
+        for (int passos = 0; passos < 32 && o->ins[t].op == 0xA7 && !o->ins[t].removida && t != i; passos++) {
+            t = o->ins[t].desvio;
+        }
+        if (t != x->desvio) {
+            x->desvio = t;
+            o->ins[t].alvo = true;
+            o->st.jumps++;
+        }
+    }
+}
+
+/* goto cujo alvo e a instrucao seguinte */
+static void remover_gotos(Otimizador *o) {
+    for (u4 i = 0; i < o->n; i++) {
+        Insn *x = &o->ins[i];
+        if (x->removida || x->op != 0xA7 || x->rodar != NENHUM || x->desvio != proxima(o, i)) continue;
+        remover(o, i);
+        o->st.jumps++;
+    }
+}
+
+/* Fim do teste iload i; <limite>; if<cc> que comeca em h (o if), ou NENHUM */
+static u4 teste_do_laco(const Otimizador *o, u4 h, u2 indice) {
+    const Insn *x = &o->ins[h];
+    Acesso a = acesso(o->code + x->pc);
+    if (x->removida || x->n || a.efeito != L_USO || a.tipo != 0 || a.local != indice || x->op == 0xC4) return NENHUM;
+
+    u4 f = h + 1;
+    if (f >= o->n || o->ins[f].removida || o->ins[f].n) return NENHUM;
+    if (o->ins[f].op >= 0x99 && o->ins[f].op <= 0x9E) return f;                      /* if<cc> i */
+    u1 op = o->ins[f].op;
+    Acesso l = acesso(o->code + o->ins[f].pc);
+    if (op == 0x19 || (op >= 0x2A && op <= 0x2D)) {                                  /* aload a; arraylength */
+        if (++f >= o->n || o->ins[f].op != 0xBE || o->ins[f].removida) return NENHUM;
+    } else if (!((l.efeito == L_USO && l.tipo == 0 && op != 0xC4) || (op >= 0x02 && op <= 0x08) ||
+                 op == 0x10 || op == 0x11)) {
+        return NENHUM;
+    }
+    f++;
+    return f < o->n && o->ins[f].op >= 0x9F && o->ins[f].op <= 0xA4 ? f : NENHUM;
+}
+
+/*
+ * corpo: ...; iinc i k; goto H  e  H: iload i; <limite>; if<cc> saida, com a
+ * saida logo apos o goto: o goto vira a copia do teste com a condicao
+ * invertida, saltando para depois do if de H.
+ */
+static void contar_lacos(Otimizador *o) {
+    for (u4 g = 0; g + 1 < o->n; g++) {
+        Insn *x = &o->ins[g];
+        if (x->removida || x->op != 0xA7 || x->n || x->desvio >= g) continue;
+        u4 c = anterior(o, g);
+        if (c == NENHUM || o->ins[c].op != 0x84 || o->ins[c].n) continue;
+        u4 h = x->desvio;
+        u4 f = teste_do_laco(o, h, o->code[o->ins[c].pc + 1]);
+        if (f == NENHUM || f >= g || o->ins[f].removida || o->ins[f].n || o->ins[f].desvio != g + 1) continue;
+        x->rodar = h;
+        o->ins[f + 1].alvo = true;
+        o->st.loops++;
+    }
+}
+
+/* ============================================================
+ * Recodificacao
+ * ============================================================ */
+
+static u4 fim_do_teste(const Otimizador *o, u4 h) {
+    while (!eh_desvio(o->ins[h].op)) h++;
+    return h;
+}
+
+static u4 padding(u4 pc) {
+    return (4 - (pc + 1) % 4) % 4;
+}
+
+static u4 tamanho(const Otimizador *o, u4 i, u4 novo_pc) {
+    const Insn *x = &o->ins[i];
+    if (x->rodar != NENHUM) return o->ins[fim_do_teste(o, x->rodar)].pc - o->ins[x->rodar].pc + 3;
+    if (x->n) return x->n;
+    if (x->op == 0xAA || x->op == 0xAB) return x->len - padding(x->pc) + padding(novo_pc);
+    return x->len;
+}
+
+/* Alvo de um switch do original (pc antigo) no codigo novo */
+static bool alvo_switch(const Otimizador *o, const u4 *mapa, u4 len, const Insn *x, int32_t off, u4 de,
+                        int32_t *novo) {
+    int64_t pc = (int64_t)x->pc + off;
+    if (pc < 0 || pc >= len || mapa[pc] == NENHUM) return false;
+    *novo = (int32_t)o->ins[mapa[pc]].novo_pc - (int32_t)de;
+    return true;
+}
+
+static bool codificar_desvio(u1 *p, u1 op, u4 de, u4 para) {
+    int32_t off = (int32_t)para - (int32_t)de;
+    if (off < INT16_MIN || off > INT16_MAX) return false;
+    p[0] = op;
+    gravar_s16(p + 1, off);
+    return true;
+}
+
+/* Escreve o codigo novo em out (tamanho ja calculado). false se um deslocamento nao cabe */
+static bool emitir(const Otimizador *o, const u4 *mapa, u4 len, u1 *out) {
+    for (u4 i = 0; i < o->n; i++) {
+        const Insn *x = &o->ins[i];
+        if (x->removida) continue;
+        u1 *p = out + x->novo_pc;
+        const u1 *orig = o->code + x->pc;
+        if (x->rodar != NENHUM) {
+            u4 f = fim_do_teste(o, x->rodar);
+            u4 n = o->ins[f].pc - o->ins[x->rodar].pc;
+            memcpy(p, o->code + o->ins[x->rodar].pc, n);
+            u1 base = o->ins[f].op >= 0x9F ? 0x9F : 0x99;
+            u1 op = (u1)(base + ((o->ins[f].op - base) ^ 1));         /* condicao invertida */
+            if (!codificar_desvio(p + n, op, x->novo_pc + n, o->ins[f + 1].novo_pc)) return false;
+        } else if (x->n) {
+            memcpy(p, x->b, x->n);
+        } else if (x->desvio != NENHUM) {
+            if (!codificar_desvio(p, x->op, x->novo_pc, o->ins[x->desvio].novo_pc)) return false;
+        } else if (x->op == 0xAA || x->op == 0xAB) {
+            const u1 *s = orig + 1 + padding(x->pc);
+            u1 *d = p + 1 + padding(x->novo_pc);
+            p[0] = x->op;
+            memset(p + 1, 0, padding(x->novo_pc));
+            u4 resto = x->len - 1 - padding(x->pc);
+            memcpy(d, s, resto);
+            int32_t novo;
+            if (!alvo_switch(o, mapa, len, x, ler_s32(s), x->novo_pc, &novo)) return false;
+            gravar_s32(d, novo);
+            if (x->op == 0xAA) {
+                u4 casos = (u4)(ler_s32(s + 8) - ler_s32(s + 4)) + 1;
+                for (u4 k = 0; k < casos; k++) {
+                    if (!alvo_switch(o, mapa, len, x, ler_s32(s + 12 + 4 * k), x->novo_pc, &novo)) return false;
+                    gravar_s32(d + 12 + 4 * k, novo);
+                }
+            } else {
+                u4 pares = (u4)ler_s32(s + 4);
+                for (u4 k = 0; k < pares; k++) {
+                    if (!alvo_switch(o, mapa, len, x, ler_s32(s + 12 + 8 * k), x->novo_pc, &novo)) return false;
+                    gravar_s32(d + 12 + 8 * k, novo);
+                }
+            }
+        } else {
+            memcpy(p, orig, x->len);
+        }
+    }
+    return true;
+}
+
+/* pc do original -> pc novo (fim do codigo -> fim do novo); NENHUM no meio de instrucao */
+static u4 novo_pc(const Otimizador *o, const u4 *mapa, u4 len, u4 novo_len, u4 pc) {
+    if (pc == len) return novo_len;
+    if (pc > len || mapa[pc] == NENHUM) return NENHUM;
+    return o->ins[mapa[pc]].novo_pc;
+}
+
+/* ============================================================
+ * API
+ * ============================================================ */
+
+static void relatar(const ClassFile *cf, const MethodInfo *method, const PeepholeStats *st, const char *mantido) {
+    if (!config.stats) return;
+    fprintf(stderr, "[peephole] %s.%s%s: ", classfile_this_name(cf),
+            cp_utf8(cf->constant_pool, cf->constant_pool_count, method->name_index),
+            cp_utf8(cf->constant_pool, cf->constant_pool_count, method->descriptor_index));
+    if (mantido) {
+        fprintf(stderr, "%u instrucoes, mantido (%s)\n", st->insns_before, mantido);
+        return;
+    }
+    fprintf(stderr, "%u -> %u instrucoes (%+d); constantes %u, store/load %u, stores mortos %u, "
+            "saltos %u, lacos contados %u\n", st->insns_before, st->insns_after,
+            (int)st->insns_after - (int)st->insns_before, st->folded, st->store_loads, st->dead_stores,
+            st->jumps, st->loops);
+}
+
+Status peephole_optimize(const ClassFile *cf, const MethodInfo *method, CodeAttribute *code) {
+    DisasmArena arena;
+    DisasmMethod dm;
+    Cfg cfg;
+    Otimizador o;
+    memset(&o, 0, sizeof o);
+    disasm_arena_init(&arena);
+    cfg_init(&cfg);
+    u4 *mapa = NULL;
+    u1 *morta = NULL, *novo = NULL;
+    LineNumberTableEntry *linhas = NULL;
+    LocalVariableTableEntry *variaveis = NULL;
+    const char *mantido = NULL;
+    Status status = ERR_MEMORY;
+
+    u4 len = code->code_length;
+    if (!disasm_decode(cf, code, &arena, &dm)) goto fim;
+    o.n = dm.count;
+    o.code = code->code;
+    o.dm = dm.insns;
+    o.st.insns_before = o.st.insns_after = dm.count;
+    status = OK;
+    if (code->exception_table_length > 0) {
+        mantido = "exception_table";
+        goto fim;
+    }
+    if (dm.count == 0) goto fim;
+
+    status = ERR_MEMORY;
+    o.ins = (Insn *)calloc(dm.count, sizeof(Insn));
+    mapa = (u4 *)malloc(len * sizeof(u4));
+    morta = (u1 *)calloc(dm.count, 1);
+    if (!o.ins || !mapa || !morta || cfg_build(&cfg, &dm, code) != OK) goto fim;
+
+    for (u4 pc = 0; pc < len; pc++) mapa[pc] = NENHUM;
+    for (u4 i = 0; i < dm.count; i++) mapa[dm.insns[i].pc] = i;
+    for (u4 i = 0; i < dm.count; i++) {
+        Insn *x = &o.ins[i];
+        x->pc = dm.insns[i].pc;
+        x->len = dm.insns[i].length;
+        x->op = dm.insns[i].opcode;
+        x->desvio = x->rodar = NENHUM;
+        if (eh_desvio(x->op)) {
+            int64_t alvo = (int64_t)x->pc + ler_s16(code->code + x->pc + 1);
+            if (alvo < 0 || alvo >= len || mapa[alvo] == NENHUM) goto fim;
+            x->desvio = mapa[alvo];
+        } else if (x->op == 0xC8 || x->op == 0xC9) {            /* goto_w, jsr_w: raros, fica o original */
+            status = OK;
+            mantido = "goto_w";
+            goto fim;
+        }
+    }
+    for (u4 b = 0; b < cfg.block_count; b++) o.ins[cfg.blocks[b].first_insn].alvo = b > 0;
+
+    if (vivacidade(&o, &cfg, code->max_locals, morta) != OK) goto fim;
+    dobrar_constantes(&o);
+    remover_stores(&o, morta);
+    contar_lacos(&o);
+    encurtar_saltos(&o);
+    remover_gotos(&o);
+
+    /* novo layout: removidas ficam no pc da seguinte */
+    u4 pc = 0;
+    o.st.insns_after = 0;
+    for (u4 i = 0; i < o.n; i++) {
+        Insn *x = &o.ins[i];
+        if (x->removida) continue;
+        x->novo_pc = pc;
+        pc += tamanho(&o, i, pc);
+        o.st.insns_after += x->rodar != NENHUM ? fim_do_teste(&o, x->rodar) - x->rodar + 1 : 1;
+    }
+    u4 novo_len = pc;
+    for (u4 i = o.n; i-- > 0;) {
+        if (o.ins[i].removida) o.ins[i].novo_pc = pc;
+        else pc = o.ins[i].novo_pc;
+    }
+
+    status = OK;
+    if (o.st.folded + o.st.store_loads + o.st.dead_stores + o.st.jumps + o.st.loops == 0) goto fim;
+    if (novo_len == 0 || novo_len > 65535) {
+        mantido = "tamanho";
+        goto fim;
+    }
+    status = ERR_MEMORY;
+    novo = (u1 *)malloc(novo_len);
+    if (code->line_number_table_length &&
+        !(linhas = (LineNumberTableEntry *)malloc(code->line_number_table_length * sizeof *linhas))) goto fim;
+    if (code->local_variable_table_length &&
+        !(variaveis = (LocalVariableTableEntry *)malloc(code->local_variable_table_length * sizeof *variaveis))) {
+        goto fim;
+    }
+    if (!novo) goto fim;
+    status = OK;
+    if (!emitir(&o, mapa, len, novo)) {
+        mantido = "deslocamento";
+        goto fim;
+    }
+
+    u2 nlinhas = 0, nvariaveis = 0;
+    for (u2 k = 0; k < code->line_number_table_length; k++) {
+        u4 inicio = novo_pc(&o, mapa, len, novo_len, code->line_number_table[k].start_pc);
+        if (inicio == NENHUM || inicio >= novo_len) continue;
+        linhas[nlinhas] = code->line_number_table[k];
+        linhas[nlinhas++].start_pc = (u2)inicio;
+    }
+    for (u2 k = 0; k < code->local_variable_table_length; k++) {
+        const LocalVariableTableEntry *v = &code->local_variable_table[k];
+        u4 inicio = novo_pc(&o, mapa, len, novo_len, v->start_pc);
+        u4 fim = novo_pc(&o, mapa, len, novo_len, (u4)v->start_pc + v->length);
+        if (inicio == NENHUM || fim == NENHUM || fim < inicio) continue;
+        variaveis[nvariaveis] = *v;
+        variaveis[nvariaveis].start_pc = (u2)inicio;
+        variaveis[nvariaveis++].length = (u2)(fim - inicio);
+    }
+
+    CodeAttribute otimizado = *code;
+    otimizado.code = novo;
+    otimizado.code_length = novo_len;
+    otimizado.attributes_count = 0;
+    otimizado.attributes = NULL;
+    otimizado.line_number_table = linhas;
+    otimizado.line_number_table_length = nlinhas;
+    otimizado.local_variable_table = variaveis;
+    otimizado.local_variable_table_length = nvariaveis;
+    VerifyError err;
+    Status v = verify_method(cf, method, &otimizado, &err);
+    if (v != OK) {
+        status = v == ERR_MEMORY ? ERR_MEMORY : OK;
+        mantido = "recusado pelo verificador";
+        goto fim;
+    }
+
+    /* aceito: troca o codigo; os sub-atributos crus (StackMapTable...) saem */
+    for (u2 k = 0; k < code->attributes_count; k++) free(code->attributes[k].info);
+    free(code->attributes);
+    free(code->code);
+    free(code->line_number_table);
+    free(code->local_variable_table);
+    *code = otimizado;
+    novo = NULL;
+    linhas = NULL;
+    variaveis = NULL;
+
+    totais.methods++;
+    totais.insns_before += o.st.insns_before;
+    totais.insns_after += o.st.insns_after;
+    totais.folded += o.st.folded;
+    totais.store_loads += o.st.store_loads;
+    totais.dead_stores += o.st.dead_stores;
+    totais.jumps += o.st.jumps;
+    totais.loops += o.st.loops;
+
+fim:
+    if (status == OK) {
+        if (mantido || novo) o.st.insns_after = o.st.insns_before;
+        relatar(cf, method, &o.st, mantido);
+    }
+    free(novo);
+    free(linhas);
+    free(variaveis);
+    free(mapa);
+    free(morta);
+    free(o.ins);
+    cfg_free(&cfg);
+    disasm_arena_free(&arena);
+    return status;
+}
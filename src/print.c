@@ -14,7 +14,8 @@
 // APIs das outras equipes que precisamos
 #include "attributes.h" // Pessoa C (parse_code_attribute, free_code_attribute)
 #include "resolve.h"    // Pessoa D (resolve_*, funcoes de consulta)
-#include "disasm.h"     // Pessoa D (disassemble_method, free_disasm_output)
+#include "disasm.h"     // Pessoa D (disasm_decode, DisasmArena)
+#include "cfg.h"        // Blocos basicos, dominadores e lacos (--cfg)
 
 
 /* -----------------------------------------------------------
@@ -48,19 +49,17 @@ static const char* java_version_str(int major) {
     }
 }
 
+/* Constantes do pre-processador viram literais: sem buffer estatico (o lote formata em paralelo) */
+#define VERSAO_STR_(x) #x
+#define VERSAO_STR(x) VERSAO_STR_(x)
+
 static const char* compiler_version_str(void) {
 #if defined(__clang__)
-    static char buf[64];
-    sprintf(buf, "Clang %d.%d.%d", __clang_major__, __clang_minor__, __clang_patchlevel__);
-    return buf;
+    return "Clang " VERSAO_STR(__clang_major__) "." VERSAO_STR(__clang_minor__) "." VERSAO_STR(__clang_patchlevel__);
 #elif defined(__GNUC__)
-    static char buf[64];
-    sprintf(buf, "GCC %d.%d.%d", __GNUC__, __GNUC_MINOR__, __GNUC_PATCHLEVEL__);
-    return buf;
+    return "GCC " VERSAO_STR(__GNUC__) "." VERSAO_STR(__GNUC_MINOR__) "." VERSAO_STR(__GNUC_PATCHLEVEL__);
 #elif defined(_MSC_VER)
-    static char buf[64];
-    sprintf(buf, "MSVC %d", _MSC_VER);
-    return buf;
+    return "MSVC " VERSAO_STR(_MSC_VER);
 #else
     return "Compilador desconhecido";
 #endif
@@ -95,15 +94,93 @@ static const AttributeInfo* find_raw_attribute_by_name(
 }
 
 
+/* "B3" (ou "-" para CFG_NONE) */
+static void print_bloco(OutSink *out, uint32_t bloco) {
+    if (bloco == CFG_NONE) {
+        out_char(out, '-');
+        return;
+    }
+    out_char(out, 'B');
+    out_u32(out, bloco);
+}
+
+/**
+ * @brief Imprime o grafo de fluxo de controle (--cfg): um bloco por linha
+ * com predecessores, sucessores, dominador imediato e laco; depois os lacos.
+ */
+static void print_cfg(OutSink *out, const Cfg *cfg) {
+    out_str(out, "    CFG (");
+    out_u32(out, cfg->block_count);
+    out_str(out, " blocos, ");
+    out_u32(out, cfg->edge_count);
+    out_str(out, " arestas, ");
+    out_u32(out, cfg->loop_count);
+    out_str(out, cfg->irreducible ? " lacos, irredutivel):\n" : " lacos):\n");
+
+    for (uint32_t k = 0; k < cfg->block_count; k++) {
+        const CfgBlock *b = &cfg->blocks[k];
+        out_str(out, "      ");
+        print_bloco(out, k);
+        out_str(out, " [");
+        out_u32(out, b->start_pc);
+        out_str(out, ", ");
+        out_u32(out, b->end_pc);
+        out_char(out, ')');
+        if (b->flags & CFG_BLOCK_HANDLER) out_str(out, " handler");
+        if (!(b->flags & CFG_BLOCK_REACHABLE)) out_str(out, " inalcancavel");
+
+        out_str(out, "  preds:");
+        if (b->pred_count == 0) out_str(out, " -");
+        for (uint32_t j = 0; j < b->pred_count; j++) {
+            out_char(out, ' ');
+            print_bloco(out, cfg->edges[cfg->preds[b->pred_first + j]].from);
+        }
+        out_str(out, "  succs:");
+        if (b->succ_count == 0) out_str(out, " -");
+        for (uint32_t j = 0; j < b->succ_count; j++) {
+            const CfgEdge *e = &cfg->edges[b->succ_first + j];
+            out_char(out, ' ');
+            print_bloco(out, e->to);
+            if (e->kind == CFG_EDGE_EXCEPTION) out_str(out, "(exc)");
+        }
+        out_str(out, "  idom: ");
+        print_bloco(out, b->idom);
+        if (b->loop != CFG_NONE) {
+            out_str(out, "  laco: L");
+            out_u32(out, b->loop);
+            if (b->flags & CFG_BLOCK_LOOP_HEADER) out_str(out, " (cabecalho)");
+        }
+        out_char(out, '\n');
+    }
+
+    for (uint32_t l = 0; l < cfg->loop_count; l++) {
+        const CfgLoop *laco = &cfg->loops[l];
+        out_str(out, "      L");
+        out_u32(out, l);
+        out_str(out, ": cabecalho ");
+        print_bloco(out, laco->header);
+        out_str(out, ", ");
+        out_u32(out, laco->block_count);
+        out_str(out, " blocos, profundidade ");
+        out_u32(out, laco->depth);
+        if (laco->parent != CFG_NONE) {
+            out_str(out, ", dentro de L");
+            out_u32(out, laco->parent);
+        }
+        out_char(out, '\n');
+    }
+}
+
 /**
  * @brief Imprime o corpo de um metodo, incluindo o disassembly.
- * Esta funcao chama as Pessoas C e D.
+ * Esta funcao chama as Pessoas C e D. Com cfg (--cfg), imprime tambem o grafo.
  */
-static void print_method_body(const ClassFile *cf, const MethodInfo *method, const CliOptions *options) {
+static void print_method_body(OutSink *out, const ClassFile *cf, const MethodInfo *method, const CliOptions *options,
+                              DisasmArena *arena, Cfg *cfg) {
     
     // Respeita a flag --no-code
     if (!options->disassemble_code) {
-        printf("    [Disassembly desativado via --no-code]\n");
+        out_str(out, "    [Disassembly desativado via --no-code]\n");
         return;
     }
 
@@ -116,7 +193,7 @@ static void print_method_body(const ClassFile *cf, const MethodInfo *method, con
     );
 
     if (!code_attr_raw) {
-        printf("    (Metodo abstrato ou nativo - sem atributo Code)\n");
+        out_str(out, "    (Metodo abstrato ou nativo - sem atributo Code)\n");
         return;
     }
 
@@ -130,42 +207,57 @@ static void print_method_body(const ClassFile *cf, const MethodInfo *method, con
         return;
     }
 
-    printf("    Code (max_stack=%u, max_locals=%u, code_length=%u):\n",
-           parsed_code.max_stack, parsed_code.max_locals, parsed_code.code_length);
-
-    // 3. Chama Pessoa D para o disassembly
-    DisasmOutput disasm_out;
-    memset(&disasm_out, 0, sizeof(DisasmOutput));
-
-    // A API da Pessoa D (disasm.h) pode não ser 'const-correct', 
-    // então fazemos um cast se necessário.
-    bool disasm_status = disassemble_method((ClassFile*)cf, &parsed_code, &disasm_out);
-
-    if (disasm_status) {
-        // Itera sobre as instrucoes desmontadas
-        for (u4 i = 0; i < disasm_out.count; i++) {
-            DisasmInstruction *inst = &disasm_out.instructions[i];
-            
-            // Imprime: PC: MNEMONIC ARGS // RESOLVIDO
-            printf("      %04u: %-15s %-10s", 
-                   (unsigned int)inst->pc, 
-                   inst->mnemonic ? inst->mnemonic : "<?>",
-                   inst->args_str ? inst->args_str : "");
-                   
-            if (inst->resolved_info && inst->resolved_info[0] != '\0') {
-                printf("// %s", inst->resolved_info);
+    out_str(out, "    Code (max_stack=");
+    out_u32(out, parsed_code.max_stack);
+    out_str(out, ", max_locals=");
+    out_u32(out, parsed_code.max_locals);
+    out_str(out, ", code_length=");
+    out_u32(out, parsed_code.code_length);
+    out_str(out, "):\n");
+
+    // 3. Disassembly na arena da classe (sem alocacao por instrucao)
+    DisasmMethod disasm;
+    if (disasm_decode(cf, &parsed_code, arena, &disasm)) {
+        char args[64];
+        for (u4 i = 0; i < disasm.count; i++) {
+            const DisasmInsn *insn = &disasm.insns[i];
+            disasm_format_args(insn, args, sizeof args);
+
+            // Imprime: PC: MNEMONIC ARGS // RESOLVIDO ("      %04u: %-15s %-10s")
+            out_str(out, "      ");
+            out_u32_zero(out, insn->pc, 4);
+            out_str(out, ": ");
+            out_str_padded(out, insn->mnemonic, 15);
+            out_char(out, ' ');
+            out_str_padded(out, args, 10);
+
+            if (disasm_has_resolved(insn)) {
+                out_str(out, "// ");
+                disasm_write_resolved(out, insn, out_str);
             }
-            printf("\n");
+            out_char(out, '\n');
+        }
+        if (cfg) {
+            if (cfg_build(cfg, &disasm, &parsed_code) == OK) print_cfg(out, cfg);
+            else fprintf(stderr, "    Erro: Falha ao montar o CFG.\n");
         }
     } else {
         fprintf(stderr, "    Erro: Falha ao fazer disassembly (Pessoa D).\n");
     }
 
-    // 4. Limpeza (Libera memoria alocada pelas Pessoas D e C)
-    free_disasm_output(&disasm_out);
+    // 4. Limpeza (a arena fica para o proximo metodo)
     free_code_attribute(&parsed_code);
 }
 
+/* "  #N // texto\n" e variacoes: indice seguido de comentario */
+static void print_indice_comentado(OutSink *out, const char *prefixo, u4 idx, const char *texto) {
+    out_str(out, prefixo);
+    out_u32(out, idx);
+    out_str(out, " // ");
+    out_str(out, texto);
+    out_char(out, '\n');
+}
+
 
 /* --- Funcao Publica (contrato de print.h) --- */
 
@@ -173,58 +265,68 @@ static void print_method_body(const ClassFile *cf, const MethodInfo *method, con
  * @brief Imprime o ClassFile de forma legivel, 
  * respeitando as flags de CLI.
  */
-Status print_classfile(ClassFile *cf, const CliOptions *options) {
+Status print_classfile(OutSink *out, ClassFile *cf, const CliOptions *options) {
     
     // --- 1. Cabeçalho (Header) ---
     if (options->print_header) {
-        printf("--- ClassFile (Pretty Print) ---\n");
-        printf("Magic: 0x%08X\n", cf->magic);
-        printf("Major Version: %u (0x%04X)  ->  %s\n",
-            cf->major_version, cf->major_version,
-            java_version_str(cf->major_version));
-
-        printf("Minor Version: %u (0x%04X)\n",
-            cf->minor_version, cf->minor_version);
-
-
-        printf("C Compiler: %s\n", compiler_version_str());
-
-        printf("Constant Pool Count: %u\n", cf->constant_pool_count);
-        printf("Access Flags: 0x%04X\n", cf->access_flags);
+        out_str(out, "--- ClassFile (Pretty Print) ---\n");
+        out_str(out, "Magic: 0x");
+        out_hex(out, cf->magic, 8);
+        out_str(out, "\nMajor Version: ");
+        out_u32(out, cf->major_version);
+        out_str(out, " (0x");
+        out_hex(out, cf->major_version, 4);
+        out_str(out, ")  ->  ");
+        out_str(out, java_version_str(cf->major_version));
+
+        out_str(out, "\nMinor Version: ");
+        out_u32(out, cf->minor_version);
+        out_str(out, " (0x");
+        out_hex(out, cf->minor_version, 4);
+        out_str(out, ")\n");
+
+
+        out_str(out, "C Compiler: ");
+        out_str(out, compiler_version_str());
+
+        out_str(out, "\nConstant Pool Count: ");
+        out_u32(out, cf->constant_pool_count);
+        out_str(out, "\nAccess Flags: 0x");
+        out_hex(out, cf->access_flags, 4);
+        out_char(out, '\n');
 
         // Resolve 'this_class' e 'super_class' usando a API da Pessoa D
-        char *this_class = resolve_class_name_to_string(cf, cf->this_class);
-        char *super_class = resolve_class_name_to_string(cf, cf->super_class);
-
-        printf("This Class:  #%u // %s\n", cf->this_class, this_class ? this_class : "ERRO_RESOLVE");
-        printf("Super Class: #%u // %s\n", cf->super_class, super_class ? super_class : "ERRO_RESOLVE");
-        
+        const char *this_class = resolve_class_name(cf, cf->this_class);
+        const char *super_class = resolve_class_name(cf, cf->super_class);
 
-        // A API de Pessoa D aloca memoria, precisamos liberar
-        free(this_class);
-        free(super_class);
+        print_indice_comentado(out, "This Class:  #", cf->this_class, this_class ? this_class : "ERRO_RESOLVE");
+        print_indice_comentado(out, "Super Class: #", cf->super_class, super_class ? super_class : "ERRO_RESOLVE");
     }
 
     // --- 2. Interfaces ---
     if (options->print_interfaces) {
-        printf("\nInterfaces (%u):\n", cf->interfaces_count);
+        out_str(out, "\nInterfaces (");
+        out_u32(out, cf->interfaces_count);
+        out_str(out, "):\n");
         for (u2 i = 0; i < cf->interfaces_count; i++) {
             u2 interface_idx = cf->interfaces[i];
-            char *if_name = resolve_class_name_to_string(cf, interface_idx);
-            printf("  - #%u // %s\n", interface_idx, if_name ? if_name : "ERRO_RESOLVE");
-            free(if_name);
+            const char *if_name = resolve_class_name(cf, interface_idx);
+            print_indice_comentado(out, "  - #", interface_idx, if_name ? if_name : "ERRO_RESOLVE");
         }
     }
     if (options->print_constant_pool) {
-            printf("\nConstant Pool (%u entries):\n", cf->constant_pool_count - 1);
+            out_str(out, "\nConstant Pool (");
+            out_u32(out, cf->constant_pool_count - 1);
+            out_str(out, " entries):\n");
             for (u2 i = 1; i < cf->constant_pool_count; i++) {
                 CpInfo *cp = &cf->constant_pool[i];
-                printf("  #%u = ", i);
+                out_str(out, "  #");
+                out_u32(out, i);
+                out_str(out, " = ");
 
                 switch (cp->tag) {
                     case CONSTANT_Class:
-                        printf("Class\t\t#%u // %s\n",
-                            cp->Class.name_index,
+                        print_indice_comentado(out, "Class\t\t#", cp->Class.name_index,
                             cp_utf8(cf->constant_pool, cf->constant_pool_count, cp->Class.name_index));
                         break;
 
@@ -237,32 +339,47 @@ Status print_classfile(ClassFile *cf, const CliOptions *options) {
                         const char *ds  = cp_utf8(cf->constant_pool, cf->constant_pool_count, nt->NameAndType.descriptor_index);
                         const char *kind = (cp->tag == CONSTANT_Fieldref) ? "Fieldref" :
                                         (cp->tag == CONSTANT_Methodref) ? "Methodref" : "InterfaceMethodref";
-                        printf("%s\t#%u.#%u // %s.%s:%s\n", kind,
-                            cp->Ref.class_index, cp->Ref.name_and_type_index,
-                            cls ? cls : "?", nm ? nm : "?", ds ? ds : "?");
+                        out_str(out, kind);
+                        out_str(out, "\t#");
+                        out_u32(out, cp->Ref.class_index);
+                        out_str(out, ".#");
+                        out_u32(out, cp->Ref.name_and_type_index);
+                        out_str(out, " // ");
+                        out_str(out, cls ? cls : "?");
+                        out_char(out, '.');
+                        out_str(out, nm ? nm : "?");
+                        out_char(out, ':');
+                        out_str(out, ds ? ds : "?");
+                        out_char(out, '\n');
                         break;
                     }
 
                     case CONSTANT_String:
-                        printf("String\t\t#%u // \"%s\"\n",
-                            cp->String.string_index,
-                            cp_utf8(cf->constant_pool, cf->constant_pool_count, cp->String.string_index));
+                        out_str(out, "String\t\t#");
+                        out_u32(out, cp->String.string_index);
+                        out_str(out, " // \"");
+                        out_str(out, cp_utf8(cf->constant_pool, cf->constant_pool_count, cp->String.string_index));
+                        out_str(out, "\"\n");
                         break;
 
                     case CONSTANT_Integer:
-                        printf("Integer\t\t%d\n", (int32_t)cp->Num.bytes);
+                        out_str(out, "Integer\t\t");
+                        out_i32(out, (int32_t)cp->Num.bytes);
+                        out_char(out, '\n');
                         break;
 
                     case CONSTANT_Float: {
                         float f;
                         memcpy(&f, &cp->Num.bytes, 4);
-                        printf("Float\t\t%g\n", f);
+                        out_fmt(out, "Float\t\t%g\n", f);
                         break;
                     }
 
                     case CONSTANT_Long: {
                         uint64_t val = ((uint64_t)cp->LongDouble.high_bytes << 32) | cp->LongDouble.low_bytes;
-                        printf("Long\t\t%lld\n", (long long)val);
+                        out_str(out, "Long\t\t");
+                        out_i64(out, (int64_t)val);
+                        out_char(out, '\n');
                         i++; // Longs ocupam 2 slots
                         break;
                     }
@@ -271,24 +388,32 @@ Status print_classfile(ClassFile *cf, const CliOptions *options) {
                         uint64_t bits = ((uint64_t)cp->LongDouble.high_bytes << 32) | cp->LongDouble.low_bytes;
                         double d;
                         memcpy(&d, &bits, 8);
-                        printf("Double\t\t%g\n", d);
+                        out_fmt(out, "Double\t\t%g\n", d);
                         i++; // também ocupa 2 slots
                         break;
                     }
 
                     case CONSTANT_Utf8:
-                        printf("Utf8\t\t%s\n", cp->Utf8.bytes);
+                        out_str(out, "Utf8\t\t");
+                        out_str(out, cp->Utf8.bytes);
+                        out_char(out, '\n');
                         break;
                     case CONSTANT_NameAndType:
-                        printf("NameAndType\t#%u:#%u // %s:%s\n",
-                            cp->NameAndType.name_index,
-                            cp->NameAndType.descriptor_index,
-                            cp_utf8(cf->constant_pool, cf->constant_pool_count, cp->NameAndType.name_index),
-                            cp_utf8(cf->constant_pool, cf->constant_pool_count, cp->NameAndType.descriptor_index));
+                        out_str(out, "NameAndType\t#");
+                        out_u32(out, cp->NameAndType.name_index);
+                        out_str(out, ":#");
+                        out_u32(out, cp->NameAndType.descriptor_index);
+                        out_str(out, " // ");
+                        out_str(out, cp_utf8(cf->constant_pool, cf->constant_pool_count, cp->NameAndType.name_index));
+                        out_char(out, ':');
+                        out_str(out, cp_utf8(cf->constant_pool, cf->constant_pool_count, cp->NameAndType.descriptor_index));
+                        out_char(out, '\n');
                         break;
 
                     default:
-                        printf("Unknown tag %u\n", cp->tag);
+                        out_str(out, "Unknown tag ");
+                        out_u32(out, cp->tag);
+                        out_char(out, '\n');
                 }
             }
         }
@@ -297,51 +422,61 @@ Status print_classfile(ClassFile *cf, const CliOptions *options) {
 
     // --- 3. Fields (Campos) ---
     if (options->print_fields) {
-        printf("\nFields (%u):\n", cf->fields_count);
+        out_str(out, "\nFields (");
+        out_u32(out, cf->fields_count);
+        out_str(out, "):\n");
         for (u2 i = 0; i < cf->fields_count; i++) {
             FieldInfo *field = &cf->fields[i];
             
             // Usa Pessoa D (resolve.h) para obter os nomes
-            char *field_name = resolve_literal_to_string(cf, field->name_index);
-            char *field_desc = resolve_literal_to_string(cf, field->descriptor_index);
-
-            printf("  - %s (Desc: %s), Flags: 0x%04X\n", 
-                   field_name ? field_name : "?", 
-                   field_desc ? field_desc : "?", 
-                   field->access_flags);
-            
-            free(field_name);
-            free(field_desc);
+            const char *field_name = resolve_literal(cf, field->name_index);
+            const char *field_desc = resolve_literal(cf, field->descriptor_index);
+
+            out_str(out, "  - ");
+            out_str(out, field_name ? field_name : "?");
+            out_str(out, " (Desc: ");
+            out_str(out, field_desc ? field_desc : "?");
+            out_str(out, "), Flags: 0x");
+            out_hex(out, field->access_flags, 4);
+            out_char(out, '\n');
         }
     }
 
     // --- 4. Methods (Métodos) ---
     if (options->print_methods) {
-        printf("\nMethods (%u):\n", cf->methods_count);
+        out_str(out, "\nMethods (");
+        out_u32(out, cf->methods_count);
+        out_str(out, "):\n");
+        DisasmArena arena;
+        Cfg cfg;
+        disasm_arena_init(&arena);
+        cfg_init(&cfg);
         for (u2 i = 0; i < cf->methods_count; i++) {
             MethodInfo *method = &cf->methods[i];
             
-            char *method_name = resolve_literal_to_string(cf, method->name_index);
-            char *method_desc = resolve_literal_to_string(cf, method->descriptor_index);
-
-            printf("  ----------------------------------\n");
-            printf("  %s%s\n", 
-                   method_name ? method_name : "?", 
-                   method_desc ? method_desc : "?");
-            printf("  Flags: 0x%04X\n", method->access_flags);
-            
-            free(method_name);
-            free(method_desc);
+            const char *method_name = resolve_literal(cf, method->name_index);
+            const char *method_desc = resolve_literal(cf, method->descriptor_index);
+
+            out_str(out, "  ----------------------------------\n  ");
+            out_str(out, method_name ? method_name : "?");
+            out_str(out, method_desc ? method_desc : "?");
+            out_str(out, "\n  Flags: 0x");
+            out_hex(out, method->access_flags, 4);
+            out_char(out, '\n');
             
             // Chama o helper para o disassembly
-            print_method_body(cf, method, options);
+            print_method_body(out, cf, method, options, &arena, options->print_cfg ? &cfg : NULL);
         }
-        printf("  ----------------------------------\n");
+        disasm_arena_free(&arena);
+        cfg_free(&cfg);
+        out_str(out, "  ----------------------------------\n");
     }
 
     // --- 5. Atributos de Classe (ex: SourceFile) ---
     if (options->print_attributes) {
-        printf("\nAttributes (%u):\n", cf->attributes_count);
+        out_str(out, "\nAttributes (");
+        out_u32(out, cf->attributes_count);
+        out_str(out, "):\n");
         for (u2 i = 0; i < cf->attributes_count; i++) {
             AttributeInfo *attr = &cf->attributes[i];
             const char *attr_name = cp_utf8(cf->constant_pool, cf->constant_pool_count, 
@@ -351,15 +486,21 @@ Status print_classfile(ClassFile *cf, const CliOptions *options) {
                 // atributo SourceFile tem payload de 2 bytes = índice para CONSTANT_Utf8 com o nome
                 u2 idx = (attr->info[0] << 8) | attr->info[1];
                 const char *filename = cp_utf8(cf->constant_pool, cf->constant_pool_count, idx);
-                printf("  - SourceFile: %s\n", filename ? filename : "?");
+                out_str(out, "  - SourceFile: ");
+                out_str(out, filename ? filename : "?");
+                out_char(out, '\n');
             } else {
                 // impressão genérica para qualquer outro atributo
-                printf("  - %s (Length: %u)\n", attr_name ? attr_name : "?", attr->attribute_length);
+                out_str(out, "  - ");
+                out_str(out, attr_name ? attr_name : "?");
+                out_str(out, " (Length: ");
+                out_u32(out, attr->attribute_length);
+                out_str(out, ")\n");
             }
         }
     }
 
     
-    printf("\n--- Fim (Pretty Print) ---\n");
-    return OK; // (de base.h)
-}
\ No newline at end of file
+    out_str(out, "\n--- Fim (Pretty Print) ---\n");
+    return out->status; // (de base.h)
+}
@@ -0,0 +1,656 @@
+#define _POSIX_C_SOURCE 200809L
+#include "ref_index.h"
+#include "attributes.h"
+#include "disasm.h"
+#include "out_sink.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* ============================================================
+ * Little-endian e hash
+ * ============================================================ */
+static u4 le32(const u1 *p) {
+    return (u4)p[0] | ((u4)p[1] << 8) | ((u4)p[2] << 16) | ((u4)p[3] << 24);
+}
+
+static uint64_t le64(const u1 *p) {
+    return (uint64_t)le32(p) | ((uint64_t)le32(p + 4) << 32);
+}
+
+static void grava_u4(u1 *p, u4 v) {
+    p[0] = (u1)v;
+    p[1] = (u1)(v >> 8);
+    p[2] = (u1)(v >> 16);
+    p[3] = (u1)(v >> 24);
+}
+
+static void grava_u8(u1 *p, uint64_t v) {
+    grava_u4(p, (u4)v);
+    grava_u4(p + 4, (u4)(v >> 32));
+}
+
+#define FNV_BASE 2166136261u
+
+static u4 fnv(u4 h, const char *s) {
+    for (; *s; s++) {
+        h ^= (u1)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* hash de "dono\0nome\0descritor" (o mesmo na gravacao e na consulta) */
+static u4 hash_chave(const char *owner, const char *name, const char *desc) {
+    u4 h = fnv(FNV_BASE, owner);
+    h *= 16777619u;
+    h = fnv(h, name);
+    h *= 16777619u;
+    return fnv(h, desc);
+}
+
+/* ============================================================
+ * Construcao
+ * ============================================================ */
+typedef struct {
+    u4 hash, off, len;      /* off = 0: livre */
+} Texto;
+
+typedef struct {
+    u4 owner, name, desc;   /* offsets na secao de strings */
+    u4 count;
+    u1 kind;
+} Chave;
+
+typedef struct {
+    u4 key, cls, method, desc, pc;
+    u1 opcode;
+} Uso;
+
+struct ref_index_builder {
+    OutSink strings;
+    Texto *textos;
+    u4 textos_cap, textos_count;
+
+    Chave *chaves;
+    u4 chaves_count, chaves_cap;
+    u4 *dir;                /* (owner, name, desc) -> chave + 1 */
+    u4 dir_cap;
+
+    Uso *usos;
+    u4 usos_count, usos_cap;
+
+    u4 classes;
+    OutSink rascunho;       /* fragmento da classe em ref_index_builder_add */
+    Status status;
+};
+
+static int crescer_textos(RefIndexBuilder *b) {
+    u4 nova = b->textos_cap ? b->textos_cap * 2 : 4096;
+    Texto *t = (Texto *)calloc(nova, sizeof(Texto));
+    if (!t) return 0;
+    for (u4 i = 0; i < b->textos_cap; ++i) {
+        if (!b->textos[i].off) continue;
+        u4 pos = b->textos[i].hash & (nova - 1);
+        while (t[pos].off) pos = (pos + 1) & (nova - 1);
+        t[pos] = b->textos[i];
+    }
+    free(b->textos);
+    b->textos = t;
+    b->textos_cap = nova;
+    return 1;
+}
+
+static u4 internar(RefIndexBuilder *b, const char *str) {
+    OutSink *s = &b->strings;
+    size_t len = strlen(str);
+    if (len == 0 || b->status != OK) return 0;
+    if ((b->textos_count + 1) * 2 > b->textos_cap && !crescer_textos(b)) {
+        b->status = ERR_MEMORY;
+        return 0;
+    }
+
+    u4 h = fnv(FNV_BASE, str);
+    u4 mask = b->textos_cap - 1;
+    u4 pos = h & mask;
+    for (; b->textos[pos].off; pos = (pos + 1) & mask) {
+        const Texto *t = &b->textos[pos];
+        if (t->hash == h && t->len == len && memcmp(s->buf + t->off, str, len) == 0) return t->off;
+    }
+    if (s->len + len + 1 > 0xFFFFFFFFu) {
+        b->status = ERR_BOUNDS;
+        return 0;
+    }
+
+    u4 off = (u4)s->len;
+    out_put(s, str, len + 1);
+    if (s->status != OK) {
+        b->status = s->status;
+        return 0;
+    }
+    b->textos[pos].hash = h;
+    b->textos[pos].off = off;
+    b->textos[pos].len = (u4)len;
+    b->textos_count++;
+    return off;
+}
+
+/* Como os textos sao internados, a chave e identificada pelos tres offsets */
+static u4 hash_offsets(u4 owner, u4 name, u4 desc) {
+    u4 h = owner * 0x9E3779B1u;
+    h ^= name + 0x7F4A7C15u + (h << 6) + (h >> 2);
+    h ^= desc + 0x7F4A7C15u + (h << 6) + (h >> 2);
+    return h;
+}
+
+static int crescer_diretorio(RefIndexBuilder *b) {
+    u4 nova = b->dir_cap ? b->dir_cap * 2 : 4096;
+    u4 *dir = (u4 *)calloc(nova, sizeof(u4));
+    if (!dir) return 0;
+    for (u4 i = 0; i < b->chaves_count; ++i) {
+        const Chave *c = &b->chaves[i];
+        u4 pos = hash_offsets(c->owner, c->name, c->desc) & (nova - 1);
+        while (dir[pos]) pos = (pos + 1) & (nova - 1);
+        dir[pos] = i + 1;
+    }
+    free(b->dir);
+    b->dir = dir;
+    b->dir_cap = nova;
+    return 1;
+}
+
+static u4 chave(RefIndexBuilder *b, RefIndexKind kind, const char *owner, const char *name, const char *desc) {
+    u4 o = internar(b, owner), n = internar(b, name), d = internar(b, desc);
+    if (b->status != OK) return 0;
+    if ((b->chaves_count + 1) * 2 > b->dir_cap && !crescer_diretorio(b)) {
+        b->status = ERR_MEMORY;
+        return 0;
+    }
+
+    u4 mask = b->dir_cap - 1;
+    u4 pos = hash_offsets(o, n, d) & mask;
+    for (; b->dir[pos]; pos = (pos + 1) & mask) {
+        const Chave *c = &b->chaves[b->dir[pos] - 1];
+        if (c->owner == o && c->name == n && c->desc == d) return b->dir[pos] - 1;
+    }
+
+    if (b->chaves_count == b->chaves_cap) {
+        u4 nova = b->chaves_cap ? b->chaves_cap * 2 : 1024;
+        Chave *v = (Chave *)realloc(b->chaves, (size_t)nova * sizeof(Chave));
+        if (!v) {
+            b->status = ERR_MEMORY;
+            return 0;
+        }
+        b->chaves = v;
+        b->chaves_cap = nova;
+    }
+    Chave *c = &b->chaves[b->chaves_count];
+    c->owner = o;
+    c->name = n;
+    c->desc = d;
+    c->count = 0;
+    c->kind = (u1)kind;
+    b->dir[pos] = b->chaves_count + 1;
+    return b->chaves_count++;
+}
+
+static void registrar_uso(RefIndexBuilder *b, u4 key, u4 cls, u4 method, u4 desc, u4 pc, u1 opcode) {
+    if (b->status != OK) return;
+    if (b->usos_count == b->usos_cap) {
+        u4 nova = b->usos_cap ? b->usos_cap * 2 : 4096;
+        Uso *v = (Uso *)realloc(b->usos, (size_t)nova * sizeof(Uso));
+        if (!v) {
+            b->status = ERR_MEMORY;
+            return;
+        }
+        b->usos = v;
+        b->usos_cap = nova;
+    }
+    Uso *u = &b->usos[b->usos_count++];
+    u->key = key;
+    u->cls = cls;
+    u->method = method;
+    u->desc = desc;
+    u->pc = pc;
+    u->opcode = opcode;
+    b->chaves[key].count++;
+}
+
+/* ============================================================
+ * Fragmentos
+ *
+ * Os usos de uma classe, serializados (strings terminadas em '\0',
+ * inteiros little-endian): nome da classe; depois, por metodo com usos,
+ * 'M' nome descritor seguido de um 'S' tipo opcode u4 pc dono nome
+ * descritor por uso.
+ * ============================================================ */
+
+/* Tipo do uso pelo opcode; 0 se a instrucao nao e indexada */
+static RefIndexKind tipo_do_opcode(u1 op) {
+    if (op >= 0xB2 && op <= 0xB5) return REF_INDEX_FIELD;
+    if (op >= 0xB6 && op <= 0xB9) return REF_INDEX_METHOD;
+    if (op == 0xBB || op == 0xBD || op == 0xC0 || op == 0xC1 || op == 0xC5) return REF_INDEX_CLASS;
+    return (RefIndexKind)0;
+}
+
+static void texto_fragmento(OutSink *out, const char *s) {
+    out_put(out, s, strlen(s) + 1);
+}
+
+static bool fragmento_metodo(OutSink *out, const ClassFile *cf, const MethodInfo *m, DisasmArena *arena) {
+    const CpInfo *cp = cf->constant_pool;
+    u2 n = cf->constant_pool_count;
+    const AttributeInfo *raw = NULL;
+    for (u2 i = 0; i < m->attributes_count && !raw; i++) {
+        if (strcmp(cp_utf8(cp, n, m->attributes[i].attribute_name_index), "Code") == 0) raw = &m->attributes[i];
+    }
+    if (!raw) return true;
+
+    CodeAttribute code;
+    memset(&code, 0, sizeof code);
+    if (parse_code_attribute(cf, raw, &code) != OK) return true;   // nada alocado
+
+    DisasmMethod dm;
+    bool ok = disasm_decode(cf, &code, arena, &dm);
+    bool cabecalho = false;
+    for (u4 i = 0; ok && i < dm.count; i++) {
+        const DisasmInsn *insn = &dm.insns[i];
+        RefIndexKind kind = tipo_do_opcode(insn->opcode);
+        bool membro = kind && kind != REF_INDEX_CLASS && insn->res_kind == DISASM_RES_MEMBER;
+        if (!membro && !(kind == REF_INDEX_CLASS && insn->res_kind == DISASM_RES_TEXT)) continue;
+
+        if (!cabecalho) {
+            out_char(out, 'M');
+            texto_fragmento(out, cp_utf8(cp, n, m->name_index));
+            texto_fragmento(out, cp_utf8(cp, n, m->descriptor_index));
+            cabecalho = true;
+        }
+        char rec[7] = { 'S', (char)kind, (char)insn->opcode, (char)(insn->pc & 0xFF), (char)((insn->pc >> 8) & 0xFF),
+                        (char)((insn->pc >> 16) & 0xFF), (char)(insn->pc >> 24) };
+        out_put(out, rec, sizeof rec);
+        texto_fragmento(out, insn->res.view[0]);
+        texto_fragmento(out, membro ? insn->res.view[1] : "");
+        texto_fragmento(out, membro ? insn->res.view[2] : "");
+    }
+    free_code_attribute(&code);
+    return ok;
+}
+
+Status ref_index_fragment(const ClassFile *cf, OutSink *out) {
+    DisasmArena arena;
+    disasm_arena_init(&arena);
+    texto_fragmento(out, cp_nome_classe(cf->constant_pool, cf->constant_pool_count, cf->this_class));
+    bool ok = true;
+    for (u2 i = 0; i < cf->methods_count && ok; i++) ok = fragmento_metodo(out, cf, &cf->methods[i], &arena);
+    disasm_arena_free(&arena);
+    return ok ? out->status : ERR_MEMORY;
+}
+
+/* Proximo texto do fragmento; NULL se nao terminar dentro dele */
+static const char *ler_texto(const char *data, size_t len, size_t *pos) {
+    const char *s = data + *pos;
+    const char *fim = (const char *)memchr(s, '\0', len - *pos);
+    if (!fim) return NULL;
+    *pos += (size_t)(fim - s) + 1;
+    return s;
+}
+
+Status ref_index_builder_add_fragment(RefIndexBuilder *b, const char *data, size_t len) {
+    if (b->status != OK) return b->status;
+    size_t pos = 0;
+    const char *nome_classe = len ? ler_texto(data, len, &pos) : NULL;
+    if (!nome_classe) return ERR_BOUNDS;
+
+    u4 cls = internar(b, nome_classe);
+    u4 metodo = 0, desc = 0;
+    bool tem_metodo = false;
+    while (pos < len && b->status == OK) {
+        char tag = data[pos++];
+        if (tag == 'M') {
+            const char *n = pos < len ? ler_texto(data, len, &pos) : NULL;
+            const char *d = n && pos < len ? ler_texto(data, len, &pos) : NULL;
+            if (!d) return ERR_BOUNDS;
+            metodo = internar(b, n);
+            desc = internar(b, d);
+            tem_metodo = true;
+        } else if (tag == 'S' && tem_metodo && len - pos >= 6) {
+            const u1 *p = (const u1 *)data + pos;
+            RefIndexKind kind = (RefIndexKind)p[0];
+            u1 opcode = p[1];
+            u4 pc = le32(p + 2);
+            pos += 6;
+            const char *o = pos < len ? ler_texto(data, len, &pos) : NULL;
+            const char *n = o && pos < len ? ler_texto(data, len, &pos) : NULL;
+            const char *d = n && pos < len ? ler_texto(data, len, &pos) : NULL;
+            if (!d || kind < REF_INDEX_CLASS || kind > REF_INDEX_METHOD) return ERR_BOUNDS;
+            u4 key = chave(b, kind, o, n, d);
+            if (b->status == OK) registrar_uso(b, key, cls, metodo, desc, pc, opcode);
+        } else {
+            return ERR_BOUNDS;
+        }
+    }
+    b->classes++;
+    return b->status;
+}
+
+RefIndexBuilder *ref_index_builder_new(void) {
+    RefIndexBuilder *b = (RefIndexBuilder *)calloc(1, sizeof(RefIndexBuilder));
+    if (!b) return NULL;
+    if (out_sink_open_memory(&b->strings) != OK || out_sink_open_memory(&b->rascunho) != OK) {
+        out_sink_close(&b->strings);
+        free(b);
+        return NULL;
+    }
+    out_char(&b->strings, '\0');   /* offset 0 = "" */
+    return b;
+}
+
+Status ref_index_builder_add(RefIndexBuilder *b, const ClassFile *cf) {
+    if (b->status != OK) return b->status;
+    out_sink_clear(&b->rascunho);
+    Status st = ref_index_fragment(cf, &b->rascunho);
+    if (st != OK) return b->status = st;
+    return ref_index_builder_add_fragment(b, b->rascunho.buf, b->rascunho.len);
+}
+
+typedef struct {
+    const char *owner, *name, *desc;
+    u4 id;
+} ItemChave;
+
+static int comparar_chave(const void *a, const void *b) {
+    const ItemChave *x = (const ItemChave *)a, *y = (const ItemChave *)b;
+    int c = strcmp(x->owner, y->owner);
+    if (!c) c = strcmp(x->name, y->name);
+    if (!c) c = strcmp(x->desc, y->desc);
+    return c;
+}
+
+static Status escrever_arquivo(const char *path, const void *const *pedacos, const size_t *tamanhos, int n) {
+    size_t lp = strlen(path);
+    char *tmp = (char *)malloc(lp + 5);
+    if (!tmp) return ERR_MEMORY;
+    memcpy(tmp, path, lp);
+    memcpy(tmp + lp, ".tmp", 5);
+
+    Status st = OK;
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        st = ERR_FILE;
+    } else {
+        for (int i = 0; i < n && st == OK; i++) {
+            if (tamanhos[i] && fwrite(pedacos[i], 1, tamanhos[i], f) != tamanhos[i]) st = ERR_FILE;
+        }
+        if (fclose(f) != 0) st = ERR_FILE;
+        if (st == OK && rename(tmp, path) != 0) st = ERR_FILE;
+        if (st != OK) remove(tmp);
+    }
+    free(tmp);
+    return st;
+}
+
+Status ref_index_builder_finish(RefIndexBuilder *b, const char *path, size_t *out_size) {
+    if (b->status != OK) return b->status;
+    u4 nk = b->chaves_count, nu = b->usos_count;
+    u4 cap = 4;
+    while (cap < nk * 2) cap <<= 1;
+
+    ItemChave *itens = (ItemChave *)malloc((size_t)(nk ? nk : 1) * sizeof(ItemChave));
+    u4 *rank = (u4 *)malloc((size_t)(nk ? nk : 1) * sizeof(u4));
+    u4 *cursor = (u4 *)malloc((size_t)(nk ? nk : 1) * sizeof(u4));
+    u1 *chaves = (u1 *)calloc(nk ? nk : 1, REF_INDEX_KEY_SIZE);
+    u1 *usos = (u1 *)calloc(nu ? nu : 1, REF_INDEX_SITE_SIZE);
+    u1 *dir = (u1 *)calloc(cap, 4);
+    Status st = OK;
+    if (!itens || !rank || !cursor || !chaves || !usos || !dir) st = ERR_MEMORY;
+
+    if (st == OK) {
+        const char *s = b->strings.buf;
+        for (u4 i = 0; i < nk; i++) {
+            itens[i].owner = s + b->chaves[i].owner;
+            itens[i].name = s + b->chaves[i].name;
+            itens[i].desc = s + b->chaves[i].desc;
+            itens[i].id = i;
+        }
+        qsort(itens, nk, sizeof(ItemChave), comparar_chave);
+
+        /* chaves na ordem final; usos agrupados por chave (estavel: ordem de entrada) */
+        u4 primeiro = 0;
+        for (u4 r = 0; r < nk; r++) {
+            const Chave *c = &b->chaves[itens[r].id];
+            u1 *p = chaves + (size_t)r * REF_INDEX_KEY_SIZE;
+            p[0] = c->kind;
+            grava_u4(p + 4, c->owner);
+            grava_u4(p + 8, c->name);
+            grava_u4(p + 12, c->desc);
+            grava_u4(p + 16, primeiro);
+            grava_u4(p + 20, c->count);
+            rank[itens[r].id] = r;
+            cursor[r] = primeiro;
+            primeiro += c->count;
+
+            u4 pos = hash_chave(itens[r].owner, itens[r].name, itens[r].desc) & (cap - 1);
+            while (le32(dir + 4 * pos)) pos = (pos + 1) & (cap - 1);
+            grava_u4(dir + 4 * pos, r + 1);
+        }
+        for (u4 i = 0; i < nu; i++) {
+            const Uso *u = &b->usos[i];
+            u1 *p = usos + (size_t)cursor[rank[u->key]]++ * REF_INDEX_SITE_SIZE;
+            grava_u4(p, u->cls);
+            grava_u4(p + 4, u->method);
+            grava_u4(p + 8, u->desc);
+            grava_u4(p + 12, u->pc);
+            p[16] = u->opcode;
+        }
+
+        u1 cab[REF_INDEX_HEADER_SIZE];
+        memset(cab, 0, sizeof cab);
+        const void *pedacos[5] = { cab, b->strings.buf, chaves, usos, dir };
+        size_t tamanhos[5] = { sizeof cab, b->strings.len, (size_t)nk * REF_INDEX_KEY_SIZE,
+                               (size_t)nu * REF_INDEX_SITE_SIZE, (size_t)cap * 4 };
+        uint64_t off = sizeof cab;
+        for (int i = 1; i < 5; i++) {
+            grava_u8(cab + 40 + 8 * (i - 1), off);
+            off += tamanhos[i];
+        }
+        memcpy(cab, REF_INDEX_MAGIC, 8);
+        grava_u4(cab + 8, REF_INDEX_VERSION);
+        grava_u8(cab + 16, off);
+        grava_u4(cab + 24, nk);
+        grava_u4(cab + 28, nu);
+        grava_u4(cab + 32, b->classes);
+        grava_u4(cab + 36, cap - 1);
+
+        st = escrever_arquivo(path, pedacos, tamanhos, 5);
+        if (st == OK && out_size) *out_size = (size_t)off;
+    }
+
+    free(itens);
+    free(rank);
+    free(cursor);
+    free(chaves);
+    free(usos);
+    free(dir);
+    return st;
+}
+
+void ref_index_builder_free(RefIndexBuilder *b) {
+    if (!b) return;
+    out_sink_close(&b->strings);
+    out_sink_close(&b->rascunho);
+    free(b->textos);
+    free(b->chaves);
+    free(b->dir);
+    free(b->usos);
+    free(b);
+}
+
+/* ============================================================
+ * Consulta
+ * ============================================================ */
+struct ref_index {
+    const u1 *base;
+    size_t size;
+    u4 keys, sites, mask;
+    const u1 *strings, *key_recs, *site_recs, *dir;
+    size_t strings_size;
+};
+
+static Status validar(RefIndex *idx) {
+    const u1 *h = idx->base;
+    if (idx->size < REF_INDEX_HEADER_SIZE || memcmp(h, REF_INDEX_MAGIC, 8) != 0) return ERR_BOUNDS;
+    if (le32(h + 8) != REF_INDEX_VERSION || le64(h + 16) != idx->size) return ERR_BOUNDS;
+    idx->keys = le32(h + 24);
+    idx->sites = le32(h + 28);
+    idx->mask = le32(h + 36);
+    if (idx->mask & (idx->mask + 1)) return ERR_BOUNDS;   /* potencia de 2 menos 1 */
+
+    uint64_t off[4], fim[4];
+    uint64_t minimo[4] = { 1, (uint64_t)idx->keys * REF_INDEX_KEY_SIZE,
+                           (uint64_t)idx->sites * REF_INDEX_SITE_SIZE, ((uint64_t)idx->mask + 1) * 4 };
+    for (int i = 0; i < 4; i++) off[i] = le64(h + 40 + 8 * i);
+    for (int i = 0; i < 4; i++) {
+        fim[i] = i + 1 < 4 ? off[i + 1] : idx->size;
+        if (off[i] < REF_INDEX_HEADER_SIZE || off[i] > fim[i] || fim[i] > idx->size) return ERR_BOUNDS;
+        if (fim[i] - off[i] < minimo[i]) return ERR_BOUNDS;
+    }
+    idx->strings = idx->base + off[0];
+    idx->strings_size = (size_t)(fim[0] - off[0]);
+    if (idx->strings[0] != 0 || idx->strings[idx->strings_size - 1] != 0) return ERR_BOUNDS;
+    idx->key_recs = idx->base + off[1];
+    idx->site_recs = idx->base + off[2];
+    idx->dir = idx->base + off[3];
+    return OK;
+}
+
+RefIndex *ref_index_open(const char *path, Status *out_status) {
+    Status st = ERR_FILE;
+    RefIndex *idx = NULL;
+    int fd = open(path, O_RDONLY);
+    struct stat sb;
+    if (fd >= 0 && fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        void *base = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (base != MAP_FAILED) {
+            idx = (RefIndex *)calloc(1, sizeof(RefIndex));
+            if (!idx) {
+                munmap(base, (size_t)sb.st_size);
+                st = ERR_MEMORY;
+            } else {
+                idx->base = (const u1 *)base;
+                idx->size = (size_t)sb.st_size;
+                st = validar(idx);
+                if (st != OK) {
+                    ref_index_close(idx);
+                    idx = NULL;
+                }
+            }
+        }
+    }
+    if (fd >= 0) close(fd);
+    if (out_status) *out_status = st;
+    return idx;
+}
+
+void ref_index_close(RefIndex *idx) {
+    if (!idx) return;
+    munmap((void *)idx->base, idx->size);
+    free(idx);
+}
+
+uint32_t ref_index_key_count(const RefIndex *idx) { return idx->keys; }
+uint32_t ref_index_site_count(const RefIndex *idx) { return idx->sites; }
+
+static const char *texto(const RefIndex *idx, u4 off) {
+    return off < idx->strings_size ? (const char *)idx->strings + off : "";
+}
+
+bool ref_index_key(const RefIndex *idx, uint32_t i, RefIndexKey *out) {
+    if (i >= idx->keys) return false;
+    const u1 *p = idx->key_recs + (size_t)i * REF_INDEX_KEY_SIZE;
+    out->kind = (RefIndexKind)p[0];
+    out->owner = texto(idx, le32(p + 4));
+    out->name = texto(idx, le32(p + 8));
+    out->descriptor = texto(idx, le32(p + 12));
+    out->first_site = le32(p + 16);
+    out->site_count = le32(p + 20);
+    /* faixa de usos corrompida: trata como vazia */
+    if (out->first_site > idx->sites || out->site_count > idx->sites - out->first_site) out->site_count = 0;
+    return true;
+}
+
+bool ref_index_site(const RefIndex *idx, uint32_t i, RefIndexSite *out) {
+    if (i >= idx->sites) return false;
+    const u1 *p = idx->site_recs + (size_t)i * REF_INDEX_SITE_SIZE;
+    out->class_name = texto(idx, le32(p));
+    out->method = texto(idx, le32(p + 4));
+    out->method_descriptor = texto(idx, le32(p + 8));
+    out->pc = le32(p + 12);
+    out->opcode = p[16];
+    return true;
+}
+
+static const char *texto_da_chave(const RefIndex *idx, u4 i, int campo) {
+    return texto(idx, le32(idx->key_recs + (size_t)i * REF_INDEX_KEY_SIZE + 4 + 4 * campo));
+}
+
+int64_t ref_index_find(const RefIndex *idx, const char *owner, const char *name, const char *descriptor) {
+    u4 pos = hash_chave(owner, name, descriptor) & idx->mask;
+    for (u4 tentativas = 0; tentativas <= idx->mask; tentativas++, pos = (pos + 1) & idx->mask) {
+        u4 e = le32(idx->dir + 4 * (size_t)pos);
+        if (e == 0 || e > idx->keys) return -1;
+        u4 k = e - 1;
+        if (strcmp(texto_da_chave(idx, k, 0), owner) == 0 && strcmp(texto_da_chave(idx, k, 1), name) == 0 &&
+            strcmp(texto_da_chave(idx, k, 2), descriptor) == 0) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+/* (dono, nome) da chave i comparado ao prefixo pedido */
+static int comparar_prefixo(const RefIndex *idx, u4 i, const char *owner, const char *name) {
+    int c = strcmp(texto_da_chave(idx, i, 0), owner);
+    if (c || !name) return c;
+    return strcmp(texto_da_chave(idx, i, 1), name);
+}
+
+uint32_t ref_index_range(const RefIndex *idx, const char *owner, const char *name, uint32_t *first) {
+    u4 lo = 0, hi = idx->keys;
+    while (lo < hi) {
+        u4 meio = lo + (hi - lo) / 2;
+        if (comparar_prefixo(idx, meio, owner, name) < 0) lo = meio + 1;
+        else hi = meio;
+    }
+    u4 inicio = lo;
+    hi = idx->keys;
+    while (lo < hi) {
+        u4 meio = lo + (hi - lo) / 2;
+        if (comparar_prefixo(idx, meio, owner, name) <= 0) lo = meio + 1;
+        else hi = meio;
+    }
+    *first = inicio;
+    return lo - inicio;
+}
+
+const char *ref_index_opcode_name(uint8_t opcode) {
+    switch (opcode) {
+    case 0xB2: return "getstatic";
+    case 0xB3: return "putstatic";
+    case 0xB4: return "getfield";
+    case 0xB5: return "putfield";
+    case 0xB6: return "invokevirtual";
+    case 0xB7: return "invokespecial";
+    case 0xB8: return "invokestatic";
+    case 0xB9: return "invokeinterface";
+    case 0xBB: return "new";
+    case 0xBD: return "anewarray";
+    case 0xC0: return "checkcast";
+    case 0xC1: return "instanceof";
+    case 0xC5: return "multianewarray";
+    default:   return "?";
+    }
+}
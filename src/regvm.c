@@ -0,0 +1,1358 @@
+#include "regvm.h"
+#include "cfg.h"
+#include "class_registry.h"
+#include "cp_cache.h"
+#include "disasm.h"
+#include "execute.h"
+#include "jit.h"
+#include "vectorize.h"
+#include "verifier.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ACC_PRIVATE 0x0002
+#define ACC_STATIC  0x0008
+#define ACC_FINAL   0x0010
+
+/* Registradores alem dos do Frame (locais e pilha dos inlinados) */
+#define REGS_INLINE 256
+
+/* target_pc dos desvios que a propria traducao liga */
+#define ALVO_RETORNO UINT32_MAX         /* return do inlinado: fim da chamada */
+#define ALVO_LENTO (UINT32_MAX - 1)     /* guarda: chamada pelo interpretador */
+#define ALVO_DESOTIMIZAR (UINT32_MAX - 2)   /* guarda num inlinado: sem alvo na IR */
+
+static RegVmConfig config;
+
+void regvm_configure(const RegVmConfig *c) {
+    config = *c;
+}
+
+/* ============================================================
+ * Traducao: uma instrucao de tres enderecos por instrucao da pilha
+ * ============================================================ */
+typedef struct {
+    RegInsn *v;
+    u1 *rotulo;                 /* por indice (n + 1): inicio de bloco, fronteira das otimizacoes */
+    u4 n, cap;
+    u2 site;                    /* das instrucoes emitidas agora */
+    bool sem_memoria;
+} Ir;
+
+/* Chamada inlinada com guarda: a chamada pelo interpretador fica no fim da IR */
+typedef struct {
+    u4 guarda;                  /* indice do RV_GUARD */
+    u4 pc;
+    u1 opcode;
+    u2 prof, depois;
+} Lento;
+
+typedef struct {
+    Ir ir;
+    RegMethod *m;
+    u4 orcamento;               /* bytes de bytecode que ainda podem ser inlinados */
+    u4 topo;                    /* proximo registrador livre */
+    u2 cap_sites, cap_classes, cap_deps;
+    Lento *lentos;
+    u4 nlentos, cap_lentos;
+} Tradutor;
+
+/* Metodo sendo traduzido: o do Frame (nivel 0) ou um inlinado */
+typedef struct corpo {
+    ClassFile *cf;
+    const MethodInfo *method;
+    const CodeAttribute *code;
+    const struct corpo *pai;
+    u2 site, base, nivel;
+    int32_t prof_fixa;          /* -1 no nivel 0 */
+    u2 destino;                 /* inlinado: registrador do valor de retorno */
+    bool this_fixo;             /* de instancia e nunca grava a local 0 */
+    int32_t *depth;             /* por pc (verificador) */
+    u4 *indice;                 /* por pc: indice na IR do inicio de bloco */
+    u4 primeiro, bloco;         /* primeira instrucao do corpo e do bloco atual */
+} Corpo;
+
+static bool garantir(Ir *ir) {
+    if (ir->n < ir->cap) return true;
+    u4 cap = ir->cap ? ir->cap * 2 : 64;
+    RegInsn *v = (RegInsn *)realloc(ir->v, cap * sizeof(RegInsn));
+    if (v) ir->v = v;
+    u1 *r = (u1 *)realloc(ir->rotulo, cap + 1);
+    if (r) ir->rotulo = r;
+    if (!v || !r) {
+        ir->sem_memoria = true;
+        return false;
+    }
+    memset(ir->rotulo + ir->cap + (ir->cap ? 1 : 0), 0, cap + 1 - ir->cap - (ir->cap ? 1 : 0));
+    ir->cap = cap;
+    return true;
+}
+
+static void rotular(Ir *ir) {
+    if (garantir(ir)) ir->rotulo[ir->n] = 1;
+}
+
+static void emitir(Ir *ir, u1 op, const DisasmInsn *x, int32_t prof, int32_t depois,
+                   u2 a, u2 b, u2 c, int32_t k, u4 alvo_pc) {
+    if (!garantir(ir)) return;
+    RegInsn *y = &ir->v[ir->n++];
+    memset(y, 0, sizeof *y);
+    y->op = op;
+    y->opcode = x->opcode;
+    y->a = a;
+    y->b = b;
+    y->c = c;
+    y->depth = (u2)prof;
+    y->depth_after = (u2)depois;
+    y->site = ir->site;
+    y->k = k;
+    y->target = REGVM_NONE;
+    y->target_pc = alvo_pc;
+    y->pc = x->pc;
+    ir->rotulo[ir->n] = 0;
+}
+
+static int16_t le_s16(const u1 *p) {
+    return (int16_t)((p[0] << 8) | p[1]);
+}
+
+static u2 le_u16(const u1 *p) {
+    return (u2)((p[0] << 8) | p[1]);
+}
+
+static bool define(u1 op) {
+    return op >= RV_MOV && op <= RV_GETFIELD;
+}
+
+static bool eh_desvio(u1 op) {
+    return (op >= RV_IFEQ && op <= RV_GOTO) || op == RV_GUARD || op == RV_VLOOP;
+}
+
+/* getfield/putfield de campo de 1 slot ja resolvido */
+static const ResolvedEntry *campo(ClassFile *cf, const u1 *ins) {
+    const ResolvedEntry *e = cp_resolved(cf, le_u16(ins + 1));
+    return e && e->kind == RESOLVED_FIELD && e->field_slots == 1 ? e : NULL;
+}
+
+/* true se a IR modela a instrucao; as outras viram RV_STACK */
+static bool modelada(ClassFile *cf, const CodeAttribute *code, const DisasmInsn *x) {
+    u1 op = x->opcode;
+    if (op == 0x12) return x->res_kind == DISASM_RES_INT || x->res_kind == DISASM_RES_FLOAT;
+    if (op == 0xB4 || op == 0xB5) return campo(cf, code->code + x->pc) != NULL;
+    return op <= 0x08 || op == 0x10 || op == 0x11 || op == 0x15 || op == 0x19 || (op >= 0x1A && op <= 0x1D) ||
+           (op >= 0x2A && op <= 0x2D) || op == 0x36 || op == 0x3A || (op >= 0x3B && op <= 0x3E) ||
+           (op >= 0x4B && op <= 0x4E) || op == 0x57 || op == 0x59 ||
+           op == 0x60 || op == 0x64 || op == 0x68 || op == 0x6C || op == 0x70 || op == 0x74 ||
+           op == 0x84 || (op >= 0x99 && op <= 0xA4) || op == 0xA7 || op == 0xAC || op == 0xB0 || op == 0xB1;
+}
+
+/*
+ * reg guarda o this do corpo: definido no bloco atual por um mov da
+ * local 0, que o corpo nunca grava.
+ */
+static bool eh_this(const Tradutor *t, const Corpo *c, u2 reg) {
+    if (!c->this_fixo) return false;
+    for (u4 i = t->ir.n; i-- > c->bloco;) {
+        const RegInsn *y = &t->ir.v[i];
+        if (define(y->op) && y->a == reg) return y->op == RV_MOV && y->b == c->base;
+    }
+    return false;
+}
+
+/*
+ * Traduz x (pilha com prof slots na entrada): locais de c a partir de
+ * c->base, pilha logo depois. false se x nao pode ficar num corpo inlinado.
+ */
+static bool traduzir(Tradutor *t, const Corpo *c, const DisasmInsn *x, int32_t prof, int32_t depois) {
+    Ir *ir = &t->ir;
+    const u1 *ins = c->code->code + x->pc;
+    const bool inlinado = c->nivel > 0;
+    u1 op = x->opcode;
+    u2 base = c->base, novo = (u2)(base + c->code->max_locals + prof), topo = (u2)(novo - 1),
+       segundo = (u2)(novo - 2);
+    int32_t k;
+
+    if (!modelada(c->cf, c->code, x)) {
+        if (inlinado) return false;
+        emitir(ir, RV_STACK, x, prof, depois, 0, 0, 0, 0, 0);
+        return true;
+    }
+    switch (op) {
+        case 0x00: case 0x57:                                   /* nop, pop */
+            return true;
+        case 0x01: emitir(ir, RV_CONST, x, prof, depois, novo, 0, 0, 0, 0); return true;   /* aconst_null */
+        case 0x10: emitir(ir, RV_CONST, x, prof, depois, novo, 0, 0, (int8_t)ins[1], 0); return true;
+        case 0x11: emitir(ir, RV_CONST, x, prof, depois, novo, 0, 0, le_s16(ins + 1), 0); return true;
+        case 0x12:                                              /* ldc (so Integer/Float): os bits */
+            if (x->res_kind == DISASM_RES_INT) k = x->res.i;
+            else memcpy(&k, &x->res.f, sizeof k);
+            emitir(ir, RV_CONST, x, prof, depois, novo, 0, 0, k, 0);
+            return true;
+        case 0x15: case 0x19:                                   /* iload, aload */
+            emitir(ir, RV_MOV, x, prof, depois, novo, (u2)(base + ins[1]), 0, 0, 0);
+            return true;
+        case 0x36: case 0x3A:                                   /* istore, astore */
+            emitir(ir, RV_MOV, x, prof, depois, (u2)(base + ins[1]), topo, 0, 0, 0);
+            return true;
+        case 0x59: emitir(ir, RV_MOV, x, prof, depois, novo, topo, 0, 0, 0); return true;  /* dup */
+        case 0x60: emitir(ir, RV_ADD, x, prof, depois, segundo, segundo, topo, 0, 0); return true;
+        case 0x64: emitir(ir, RV_SUB, x, prof, depois, segundo, segundo, topo, 0, 0); return true;
+        case 0x68: emitir(ir, RV_MUL, x, prof, depois, segundo, segundo, topo, 0, 0); return true;
+        case 0x6C: case 0x70:                                   /* idiv, irem: podem desotimizar */
+            emitir(ir, op == 0x6C ? RV_DIV : RV_REM, x, prof, depois, segundo, segundo, topo, 0, 0);
+            return true;
+        case 0x74: emitir(ir, RV_NEG, x, prof, depois, topo, topo, 0, 0, 0); return true;
+        case 0x84:
+            emitir(ir, RV_ADDK, x, prof, depois, (u2)(base + ins[1]), (u2)(base + ins[1]), 0, (int8_t)ins[2], 0);
+            return true;
+        case 0xA7:
+            emitir(ir, RV_GOTO, x, prof, depois, 0, 0, 0, 0, (u4)(x->pc + le_s16(ins + 1)));
+            return true;
+        case 0xAC: case 0xB0:                                   /* ireturn, areturn */
+            if (!inlinado) {
+                emitir(ir, RV_RET, x, prof, depois, 0, topo, 0, 0, 0);
+                return true;
+            }
+            emitir(ir, RV_MOV, x, prof, depois, c->destino, topo, 0, 0, 0);
+            emitir(ir, RV_GOTO, x, prof, depois, 0, 0, 0, 0, ALVO_RETORNO);
+            return true;
+        case 0xB1:
+            if (inlinado) emitir(ir, RV_GOTO, x, prof, depois, 0, 0, 0, 0, ALVO_RETORNO);
+            else emitir(ir, RV_RETV, x, prof, depois, 0, 0, 0, 0, 0);
+            return true;
+        case 0xB4:                                              /* getfield */
+            emitir(ir, RV_GETFIELD, x, prof, depois, topo, topo, 0, (int32_t)campo(c->cf, ins)->u.offset, 0);
+            return true;
+        case 0xB5:                                              /* putfield */
+            emitir(ir, RV_PUTFIELD, x, prof, depois, 0, segundo, topo, (int32_t)campo(c->cf, ins)->u.offset, 0);
+            return true;
+        default: break;
+    }
+    if (op >= 0x02 && op <= 0x08) {                             /* iconst_<n> */
+        emitir(ir, RV_CONST, x, prof, depois, novo, 0, 0, op - 0x03, 0);
+    } else if ((op >= 0x1A && op <= 0x1D) || (op >= 0x2A && op <= 0x2D)) {     /* iload_<n>, aload_<n> */
+        emitir(ir, RV_MOV, x, prof, depois, novo, (u2)(base + (op - 0x1A) % 16), 0, 0, 0);
+    } else if ((op >= 0x3B && op <= 0x3E) || (op >= 0x4B && op <= 0x4E)) {     /* istore_<n>, astore_<n> */
+        emitir(ir, RV_MOV, x, prof, depois, (u2)(base + (op - 0x3B) % 16), topo, 0, 0, 0);
+    } else if (op >= 0x99 && op <= 0x9E) {                      /* if<cond> */
+        emitir(ir, (u1)(RV_IFEQ + op - 0x99), x, prof, depois, 0, topo, 0, 0, (u4)(x->pc + le_s16(ins + 1)));
+    } else {                                                    /* if_icmp<cond> */
+        emitir(ir, (u1)(RV_IFCMPEQ + op - 0x9F), x, prof, depois, 0, segundo, topo, 0,
+               (u4)(x->pc + le_s16(ins + 1)));
+    }
+    return true;
+}
+
+/* ============================================================
+ * Inlining
+ * ============================================================ */
+static bool traduzir_corpo(Tradutor *t, Corpo *c);
+
+static int novo_site(Tradutor *t, ClassFile *cls, const MethodInfo *method, const CodeAttribute *code, u4 call_pc,
+                     u2 parent, u2 base) {
+    RegMethod *m = t->m;
+    if (m->nsites == 0xFFFF) return -1;
+    if (m->nsites == t->cap_sites) {
+        u2 cap = t->cap_sites ? (u2)(t->cap_sites >= 0x8000 ? 0xFFFF : t->cap_sites * 2) : 8;
+        RegInlineSite *v = (RegInlineSite *)realloc(m->sites, cap * sizeof(RegInlineSite));
+        if (!v) return -1;
+        m->sites = v;
+        t->cap_sites = cap;
+    }
+    RegInlineSite *s = &m->sites[m->nsites];
+    s->cls = cls;
+    s->method = method;
+    s->call_pc = call_pc;
+    s->parent = parent;
+    s->base = base;
+    s->code = code;
+    s->call_depth = s->arg_slots = s->frame_depth = 0;
+    s->ret_slots = 0;
+    return m->nsites++;
+}
+
+/* Indice da classe em m->classes (acrescenta); -1 sem memoria */
+static int32_t classe(Tradutor *t, ClassFile *cls) {
+    RegMethod *m = t->m;
+    for (u2 i = 0; i < m->nclasses; i++) {
+        if (m->classes[i] == cls) return i;
+    }
+    if (m->nclasses == t->cap_classes) {
+        if (t->cap_classes >= 0x8000) return -1;
+        u2 cap = t->cap_classes ? (u2)(t->cap_classes * 2) : 4;
+        ClassFile **v = (ClassFile **)realloc(m->classes, cap * sizeof(ClassFile *));
+        if (!v) return -1;
+        m->classes = v;
+        t->cap_classes = cap;
+    }
+    m->classes[m->nclasses] = cls;
+    return m->nclasses++;
+}
+
+/* Dependencia da analise de hierarquia (repetidas uma vez so) */
+static bool depender(Tradutor *t, ClassFile *cls, const MethodInfo *method) {
+    RegMethod *m = t->m;
+    for (u2 i = 0; i < m->ndeps; i++) {
+        if (m->deps[i].method == method) return true;
+    }
+    if (m->ndeps == t->cap_deps) {
+        if (t->cap_deps >= 0x8000) return false;
+        u2 cap = t->cap_deps ? (u2)(t->cap_deps * 2) : 4;
+        RegChaDep *v = (RegChaDep *)realloc(m->deps, cap * sizeof(RegChaDep));
+        if (!v) return false;
+        m->deps = v;
+        t->cap_deps = cap;
+    }
+    m->deps[m->ndeps].cls = cls;
+    m->deps[m->ndeps].method = method;
+    m->ndeps++;
+    return true;
+}
+
+static bool adiar(Tradutor *t, u4 guarda, const DisasmInsn *x, int32_t prof, int32_t depois) {
+    if (t->nlentos == t->cap_lentos) {
+        u4 cap = t->cap_lentos ? t->cap_lentos * 2 : 8;
+        Lento *v = (Lento *)realloc(t->lentos, cap * sizeof(Lento));
+        if (!v) return false;
+        t->lentos = v;
+        t->cap_lentos = cap;
+    }
+    Lento *l = &t->lentos[t->nlentos++];
+    l->guarda = guarda;
+    l->pc = x->pc;
+    l->opcode = x->opcode;
+    l->prof = (u2)prof;
+    l->depois = (u2)depois;
+    return true;
+}
+
+/*
+ * Substitui a chamada x pelo corpo do alvo. 0: nao inlinada (nada
+ * emitido); 1: inlinada; 2: inlinada com guarda no nivel 0 (a chamada
+ * pelo interpretador volta na entrada do pc seguinte). Num corpo
+ * inlinado a guarda desotimiza.
+ */
+static int inlinar(Tradutor *t, const Corpo *c, const DisasmInsn *x, int32_t prof, int32_t depois) {
+    if (config.no_inline || c->nivel >= REGVM_INLINE_DEPTH) return 0;
+    u4 limite = config.inline_size ? config.inline_size : REGVM_DEFAULT_INLINE_SIZE;
+    u1 op = x->opcode;
+    const ResolvedEntry *e = cp_resolved(c->cf, le_u16(c->code->code + x->pc + 1));
+    if (!e || e->kind != RESOLVED_METHOD || !e->cls || !e->u.method || e->ret_slots > 1) return 0;
+    ClassFile *cls = e->cls;
+    const MethodInfo *alvo = e->u.method;
+    const bool estatico = op == 0xB8;
+    if (estatico != ((alvo->access_flags & ACC_STATIC) != 0)) return 0;
+    const CodeAttribute *code = cp_cache_code(cls, alvo);
+    if (!code || code->code_length > limite || code->code_length > t->orcamento) return 0;
+    /* as faixas de handler do chamado nao teriam onde ficar na IR */
+    if (code->exception_table_length > 0) return 0;
+
+    bool da_cadeia = false;                     /* estatico: classe ja inicializada */
+    for (const Corpo *k = c; k; k = k->pai) {
+        if (k->method == alvo) return 0;        /* recursao */
+        if (k->cf == cls) da_cadeia = true;
+    }
+    if (estatico && !da_cadeia) return 0;
+
+    u2 nslots = (u2)(e->arg_slots + (estatico ? 0 : 1));
+    u2 args = (u2)(c->base + c->code->max_locals + prof - nslots);
+    bool guarda = false, cha = false;
+    int32_t k = -1;
+    if (!estatico) {
+        bool exato = op == 0xB7 || (alvo->access_flags & (ACC_PRIVATE | ACC_FINAL)) ||
+                     (cls->access_flags & ACC_FINAL);
+        if (!exato) exato = cha = !cp_cache_overridden(cls, alvo);
+        bool nao_nulo = eh_this(t, c, args);
+        if (!exato && (k = classe(t, cls)) < 0) return 0;
+        guarda = !exato || !nao_nulo;
+    }
+    u4 base = t->topo, regs = (u4)code->max_locals + code->max_stack;
+    if (base + regs > (u4)t->m->frame_regs + REGS_INLINE) return 0;
+
+    Ir *ir = &t->ir;
+    if (!garantir(ir)) return 0;
+    u4 n0 = ir->n, lentos0 = t->nlentos;
+    u1 rotulo0 = ir->rotulo[n0];
+    u2 sites0 = t->m->nsites, deps0 = t->m->ndeps, site_pai = ir->site;
+    int site = novo_site(t, cls, alvo, code, x->pc, c->site, (u2)base);
+    if (site < 0) return 0;
+    RegInlineSite *s = &t->m->sites[site];
+    s->call_depth = (u2)prof;
+    s->arg_slots = nslots;
+    s->ret_slots = e->ret_slots;
+    s->frame_depth = (u2)(c->prof_fixa >= 0 ? c->prof_fixa : prof - nslots + e->ret_slots);
+
+    u4 iguarda = ir->n;
+    if (guarda) emitir(ir, RV_GUARD, x, prof, prof, 0, args, 0, k, c->nivel == 0 ? ALVO_LENTO : ALVO_DESOTIMIZAR);
+    ir->site = (u2)site;
+    for (u2 i = 0; i < nslots; i++) emitir(ir, RV_MOV, x, 0, 0, (u2)(base + i), (u2)(args + i), 0, 0, 0);
+
+    Corpo filho;
+    memset(&filho, 0, sizeof filho);
+    filho.cf = cls;
+    filho.method = alvo;
+    filho.code = code;
+    filho.pai = c;
+    filho.site = (u2)site;
+    filho.base = (u2)base;
+    filho.nivel = (u2)(c->nivel + 1);
+    filho.prof_fixa = s->frame_depth;
+    filho.destino = args;
+    t->topo = base + regs;
+    if (t->topo > t->m->nregs) t->m->nregs = (u2)t->topo;
+    t->orcamento -= code->code_length;
+
+    bool ok = traduzir_corpo(t, &filho);
+    ir->site = site_pai;
+    t->topo = base;
+    if (ok && guarda && c->nivel == 0) ok = adiar(t, iguarda, x, prof, depois);
+    if (ok && cha) ok = depender(t, cls, alvo);
+    if (!ok || ir->sem_memoria) {
+        ir->n = n0;
+        ir->rotulo[n0] = rotulo0;
+        t->nlentos = lentos0;
+        t->m->nsites = sites0;
+        t->m->ndeps = deps0;
+        t->orcamento += code->code_length;
+        return 0;
+    }
+
+    /* return do inlinado: goto para o fim da chamada (o ultimo cai nele) */
+    const RegInsn *u = ir->n > n0 ? &ir->v[ir->n - 1] : NULL;
+    if (u && u->op == RV_GOTO && u->target_pc == ALVO_RETORNO && u->site == site) ir->n--;
+    for (u4 i = n0; i < ir->n; i++) {
+        RegInsn *y = &ir->v[i];
+        if (y->op == RV_GOTO && y->target_pc == ALVO_RETORNO && y->site == site) {
+            y->target = ir->n;
+            rotular(ir);
+        }
+    }
+    t->m->inlined++;
+    if (cha) t->m->devirtualized++;
+    return guarda && c->nivel == 0 ? 2 : 1;
+}
+
+/* Indice em m->vloops do laco vetorizavel com cabecalho em pc; -1 se nenhum */
+static int32_t laco_vetorial(const RegMethod *m, u4 pc) {
+    for (u2 i = 0; i < m->nvloops; i++) {
+        if (m->vloops[i].head_pc == pc) return i;
+    }
+    return -1;
+}
+
+/*
+ * Traduz o corpo de c. No nivel 0 todo inicio de bloco e entrada (e
+ * rotulo), assim como o pc seguinte a uma instrucao generica; no corpo
+ * inlinado so os alvos de desvio viram rotulo, e qualquer instrucao que
+ * precise do interpretador faz o inlining desistir.
+ */
+static bool traduzir_corpo(Tradutor *t, Corpo *c) {
+    const CodeAttribute *code = c->code;
+    Ir *ir = &t->ir;
+    DisasmArena arena;
+    DisasmMethod dm;
+    Cfg cfg;
+    disasm_arena_init(&arena);
+    cfg_init(&cfg);
+    u1 *inicio = NULL;
+    int32_t *depth = NULL;
+    u4 *indice = NULL;
+    bool ok = true;
+
+    if (!c->depth) {
+        depth = (int32_t *)malloc(code->code_length * sizeof(int32_t));
+        indice = (u4 *)malloc(code->code_length * sizeof(u4));
+        ok = depth && indice && verify_method_depths(c->cf, c->method, code, depth, NULL) == OK;
+        for (u4 pc = 0; ok && pc < code->code_length; pc++) indice[pc] = REGVM_NONE;
+        c->depth = depth;
+        c->indice = indice;
+    }
+    ok = ok && disasm_decode(c->cf, code, &arena, &dm) && dm.count > 0 && cfg_build(&cfg, &dm, code) == OK &&
+         (inicio = (u1 *)calloc(dm.count, 1)) != NULL;
+
+    if (ok && c->nivel == 0 && !config.no_vectorize && cfg.loop_count > 0) {
+        RegMethod *m = t->m;
+        m->vloops = (VecLoop *)malloc(cfg.loop_count * sizeof(VecLoop));
+        ok = m->vloops != NULL;
+        u4 cap = cfg.loop_count > 0xFFFF ? 0xFFFF : cfg.loop_count;
+        if (ok) m->nvloops = (u2)vec_find_loops(code, &dm, &cfg, m->vloops, cap);
+    }
+    if (ok) {
+        for (u4 b = 0; b < cfg.block_count; b++) {
+            if (cfg.blocks[b].flags & CFG_BLOCK_REACHABLE) inicio[cfg.blocks[b].first_insn] = 1;
+        }
+        c->this_fixo = !(c->method->access_flags & ACC_STATIC);
+        for (u4 i = 0; i < dm.count && c->this_fixo; i++) {
+            const DisasmInsn *x = &dm.insns[i];
+            u1 local = code->code[x->pc + (x->length > 1 ? 1 : 0)];
+            if (x->opcode == 0x3B || x->opcode == 0x4B || x->opcode == 0xC4 ||      /* istore_0, astore_0, wide */
+                ((x->opcode == 0x36 || x->opcode == 0x3A || x->opcode == 0x84) && local == 0)) {
+                c->this_fixo = false;
+            }
+        }
+        c->primeiro = c->bloco = ir->n;
+
+        bool apos_generica = false;
+        for (u4 i = 0; i < dm.count && ok; i++) {
+            const DisasmInsn *x = &dm.insns[i];
+            int32_t prof = c->depth[x->pc];
+            if (prof < 0) continue;
+            u4 prox = x->pc + x->length;
+            int32_t depois = prox < code->code_length && c->depth[prox] >= 0 ? c->depth[prox] : 0;
+            if (x->opcode == 0xA7) {
+                int32_t alvo = (int32_t)x->pc + le_s16(code->code + x->pc + 1);
+                depois = alvo >= 0 && (u4)alvo < code->code_length && c->depth[alvo] >= 0 ? c->depth[alvo] : prof;
+            }
+            if (inicio[i] || apos_generica) {
+                if (c->nivel == 0) rotular(ir);
+                c->indice[x->pc] = ir->n;
+                c->bloco = ir->n;
+            }
+            int32_t v = inicio[i] && c->nivel == 0 ? laco_vetorial(t->m, x->pc) : -1;
+            if (v >= 0) {
+                /* so quem chega pela frente passa pelo kernel; o salto de volta vai direto ao laco escalar */
+                emitir(ir, RV_VLOOP, x, prof, prof, 0, 0, 0, v, t->m->vloops[v].exit_pc);
+                rotular(ir);
+                c->indice[x->pc] = ir->n;
+                c->bloco = ir->n;
+            }
+            if (c->nivel == 0) t->m->bytecodes++;
+
+            bool chamada = x->opcode >= 0xB6 && x->opcode <= 0xB8;
+            int inlinada = chamada ? inlinar(t, c, x, prof, depois) : 0;
+            if (inlinada) {
+                apos_generica = inlinada == 2;
+                continue;
+            }
+            bool generica = chamada || !modelada(c->cf, code, x);
+            if (generica && c->nivel > 0) {
+                ok = false;
+            } else if (generica) {
+                rotular(ir);
+                c->indice[x->pc] = ir->n;
+                c->bloco = ir->n;
+                emitir(ir, RV_STACK, x, prof, depois, 0, 0, 0, 0, 0);
+            } else {
+                ok = traduzir(t, c, x, prof, depois);
+            }
+            apos_generica = generica;
+        }
+    }
+
+    /* desvios do proprio corpo */
+    for (u4 j = c->primeiro; ok && j < ir->n; j++) {
+        RegInsn *y = &ir->v[j];
+        if (y->site != c->site || !eh_desvio(y->op) || y->target_pc >= ALVO_DESOTIMIZAR) {
+            continue;
+        }
+        if (y->target_pc >= code->code_length || c->indice[y->target_pc] == REGVM_NONE) {
+            ok = false;
+            break;
+        }
+        y->target = c->indice[y->target_pc];
+        ir->rotulo[y->target] = 1;
+    }
+
+    free(inicio);
+    if (depth || indice) {
+        /* vetores do corpo inlinado: nao sobrevivem a traducao */
+        free(depth);
+        free(indice);
+        c->depth = NULL;
+        c->indice = NULL;
+    }
+    cfg_free(&cfg);
+    disasm_arena_free(&arena);
+    return ok && !ir->sem_memoria;
+}
+
+/* Chamadas com guarda: o caminho lento (manipulador do interpretador) depois do corpo */
+static void emitir_lentos(Tradutor *t) {
+    Ir *ir = &t->ir;
+    for (u4 i = 0; i < t->nlentos; i++) {
+        const Lento *l = &t->lentos[i];
+        DisasmInsn x;
+        memset(&x, 0, sizeof x);
+        x.pc = l->pc;
+        x.opcode = l->opcode;
+        rotular(ir);
+        if (ir->sem_memoria) return;
+        ir->v[l->guarda].target = ir->n;
+        emitir(ir, RV_STACK, &x, l->prof, l->depois, 0, 0, 0, 0, 0);
+    }
+}
+
+/* ============================================================
+ * Otimizacao
+ * ============================================================ */
+
+/* cond na ordem eq, ne, lt, ge, gt, le */
+static bool comparar(int cond, int32_t x, int32_t y) {
+    switch (cond) {
+        case 0: return x == y;
+        case 1: return x != y;
+        case 2: return x < y;
+        case 3: return x >= y;
+        case 4: return x > y;
+        default: return x <= y;
+    }
+}
+
+/* Condicao com os operandos trocados (k ? b vira b ? k) */
+static int espelhar(int cond) {
+    static const int espelho[6] = { 0, 1, 4, 5, 2, 3 };
+    return espelho[cond];
+}
+
+/* Aritmetica do int do Java (sem UB); false so na divisao por zero */
+static bool calcular(u1 op, int32_t x, int32_t y, int32_t *r) {
+    switch (op) {
+        case RV_ADD: case RV_ADDK: *r = (int32_t)((uint32_t)x + (uint32_t)y); return true;
+        case RV_SUB: *r = (int32_t)((uint32_t)x - (uint32_t)y); return true;
+        case RV_MUL: case RV_MULK: *r = (int32_t)((uint32_t)x * (uint32_t)y); return true;
+        case RV_NEG: *r = (int32_t)(0u - (uint32_t)x); return true;
+        case RV_DIV: case RV_DIVK:
+            if (y == 0) return false;
+            *r = y == -1 ? (int32_t)(0u - (uint32_t)x) : x / y;
+            return true;
+        case RV_REM: case RV_REMK:
+            if (y == 0) return false;
+            *r = y == -1 ? 0 : x % y;
+            return true;
+        default: return false;
+    }
+}
+
+/* Valor conhecido de um registrador dentro do bloco */
+enum { DESCONHECIDO = 0, COPIA, CONSTANTE };
+
+typedef struct {
+    u4 marca;                   /* valido se igual a marca do bloco */
+    u1 tipo;
+    u2 fonte;
+    int32_t k;
+} Valor;
+
+typedef struct {
+    Valor *val;
+    u4 marca;
+    u2 nregs, nlocals;
+    u4 trocas;
+} Propagacao;
+
+static bool constante(const Propagacao *p, u2 r, int32_t *k) {
+    const Valor *v = &p->val[r];
+    if (v->marca != p->marca || v->tipo != CONSTANTE) return false;
+    *k = v->k;
+    return true;
+}
+
+static u2 origem(Propagacao *p, u2 r) {
+    const Valor *v = &p->val[r];
+    if (v->marca != p->marca || v->tipo != COPIA) return r;
+    p->trocas++;
+    return v->fonte;
+}
+
+/* Desvio decidido na traducao: goto ou nada */
+static void decidir(RegInsn *x, bool salta) {
+    x->op = salta ? RV_GOTO : RV_NOP;
+}
+
+/*
+ * Propagacao de copias e constantes, para frente, zerada em cada rotulo:
+ * os operandos passam a ler a local (ou o imediato) de onde a pilha foi
+ * copiada. So copias para registradores alem das locais do Frame (pilha
+ * e inlinados) sao seguidas; constantes, em qualquer registrador.
+ */
+static void propagar(Ir *ir, Propagacao *p) {
+    for (u4 i = 0; i < ir->n; i++) {
+        RegInsn *x = &ir->v[i];
+        if (ir->rotulo[i]) p->marca++;
+        int32_t kb = 0, kc = 0, r;
+        bool cb, cc;
+
+        switch (x->op) {
+            case RV_MOV:
+                if (constante(p, x->b, &kb)) {
+                    x->op = RV_CONST;
+                    x->k = kb;
+                    p->trocas++;
+                } else {
+                    x->b = origem(p, x->b);
+                }
+                break;
+            case RV_ADD: case RV_SUB: case RV_MUL: case RV_DIV: case RV_REM:
+                cb = constante(p, x->b, &kb);
+                cc = constante(p, x->c, &kc);
+                if (cb && cc && calcular(x->op, kb, kc, &r)) {
+                    x->op = RV_CONST;
+                    x->k = r;
+                } else if (cc && (x->op == RV_ADD || x->op == RV_SUB || x->op == RV_MUL ||
+                                  (kc != 0 && kc != -1))) {
+                    x->k = x->op == RV_SUB ? (int32_t)(0u - (uint32_t)kc) : kc;
+                    x->op = x->op == RV_ADD || x->op == RV_SUB ? RV_ADDK
+                          : x->op == RV_MUL ? RV_MULK : x->op == RV_DIV ? RV_DIVK : RV_REMK;
+                    x->b = origem(p, x->b);
+                } else if (cb && (x->op == RV_ADD || x->op == RV_MUL)) {
+                    x->op = x->op == RV_ADD ? RV_ADDK : RV_MULK;
+                    x->k = kb;
+                    x->b = origem(p, x->c);
+                } else {
+                    x->b = origem(p, x->b);
+                    x->c = origem(p, x->c);
+                    break;
+                }
+                p->trocas++;
+                break;
+            case RV_NEG: case RV_ADDK: case RV_MULK: case RV_DIVK: case RV_REMK:
+                if (constante(p, x->b, &kb) && calcular(x->op, kb, x->k, &r)) {
+                    x->op = RV_CONST;
+                    x->k = r;
+                    p->trocas++;
+                } else {
+                    x->b = origem(p, x->b);
+                }
+                break;
+            case RV_IFEQ: case RV_IFNE: case RV_IFLT: case RV_IFGE: case RV_IFGT: case RV_IFLE:
+                if (constante(p, x->b, &kb)) decidir(x, comparar(x->op - RV_IFEQ, kb, 0));
+                else x->b = origem(p, x->b);
+                break;
+            case RV_IFCMPEQ: case RV_IFCMPNE: case RV_IFCMPLT: case RV_IFCMPGE: case RV_IFCMPGT: case RV_IFCMPLE:
+                cb = constante(p, x->b, &kb);
+                cc = constante(p, x->c, &kc);
+                if (cb && cc) {
+                    decidir(x, comparar(x->op - RV_IFCMPEQ, kb, kc));
+                } else if (cc) {
+                    x->op = (u1)(RV_IFKEQ + x->op - RV_IFCMPEQ);
+                    x->k = kc;
+                    x->b = origem(p, x->b);
+                } else if (cb) {
+                    x->op = (u1)(RV_IFKEQ + espelhar(x->op - RV_IFCMPEQ));
+                    x->k = kb;
+                    x->b = origem(p, x->c);
+                } else {
+                    x->b = origem(p, x->b);
+                    x->c = origem(p, x->c);
+                }
+                break;
+            case RV_GETFIELD: case RV_GUARD: case RV_RET:
+                x->b = origem(p, x->b);
+                break;
+            case RV_PUTFIELD:
+                x->b = origem(p, x->b);
+                x->c = origem(p, x->c);
+                break;
+            case RV_STACK:
+                p->marca++;             /* o manipulador grava a pilha */
+                break;
+            default:
+                break;
+        }
+
+        if (!define(x->op)) continue;
+        u2 a = x->a;
+        for (u2 r2 = 0; r2 < p->nregs; r2++) {
+            Valor *v = &p->val[r2];
+            if (v->marca == p->marca && v->tipo == COPIA && v->fonte == a) v->marca = 0;
+        }
+        Valor *v = &p->val[a];
+        v->marca = 0;
+        if (x->op == RV_MOV && x->b == a) {
+            x->op = RV_NOP;
+        } else if (x->op == RV_MOV && a >= p->nlocals) {
+            v->marca = p->marca;
+            v->tipo = COPIA;
+            v->fonte = x->b;
+        } else if (x->op == RV_CONST) {
+            v->marca = p->marca;
+            v->tipo = CONSTANTE;
+            v->k = x->k;
+        }
+    }
+}
+
+/*
+ * Vivos onde o interpretador de pilha pode assumir ou o bloco termina:
+ * locais e pilha do Frame ate prof e, dentro de um inlinado, todos os
+ * registradores dos inlinados. Com somar, acrescenta aos ja vivos.
+ */
+static void vivos(u1 *vivo, const RegMethod *m, u2 prof, bool inlinados, bool somar) {
+    memset(vivo, 1, m->nlocals);
+    for (u2 r = m->nlocals; r < m->nregs; r++) {
+        bool v = r < m->frame_regs ? (u2)(r - m->nlocals) < prof : inlinados;
+        vivo[r] = somar ? (u1)(vivo[r] | v) : (u1)v;
+    }
+}
+
+/* Pilha do Frame em x: a propria no site 0, a da chamada mais externa num inlinado */
+static u2 pilha_frame(const RegMethod *m, const RegInsn *x, bool depois) {
+    if (x->site) return m->sites[x->site].frame_depth;
+    return depois ? x->depth_after : x->depth;
+}
+
+/* Pode desotimizar no pc de origem: le tudo o que os Frames refeitos leem */
+static bool armadilha(const RegInsn *x) {
+    return x->op == RV_DIV || x->op == RV_REM || x->op == RV_GETFIELD || x->op == RV_PUTFIELD;
+}
+
+/*
+ * Para tras, por bloco: remove definicoes mortas (locais estao sempre
+ * vivas no fim do bloco; a pilha, ate a profundidade de saida) e troca
+ * "op pilha; mov local, pilha" por "op local". RV_STACK e as instrucoes
+ * que podem voltar ao interpretador leem tudo; os desvios condicionais
+ * e as guardas somam o que o alvo pode ler.
+ */
+static void eliminar(Ir *ir, u1 *vivo, const RegMethod *m) {
+    for (u4 i = ir->n; i-- > 0;) {
+        RegInsn *x = &ir->v[i];
+        u1 op = x->op;
+        if (i + 1 == ir->n || ir->rotulo[i + 1] || op == RV_GOTO) {
+            vivos(vivo, m, pilha_frame(m, x, true), x->site != 0, false);
+        }
+        if (op == RV_NOP) continue;
+        if (op == RV_STACK) {
+            vivos(vivo, m, x->depth, false, false);
+            continue;
+        }
+        if (define(op)) {
+            if (!vivo[x->a] && !armadilha(x)) {
+                x->op = RV_NOP;
+                continue;
+            }
+            if (op == RV_MOV && x->b >= m->nlocals && x->b != x->a && !vivo[x->b] && i > 0 && !ir->rotulo[i] &&
+                define(ir->v[i - 1].op) && ir->v[i - 1].a == x->b) {
+                ir->v[i - 1].a = x->a;
+                x->op = RV_NOP;
+                continue;
+            }
+            vivo[x->a] = 0;
+            if (armadilha(x)) vivos(vivo, m, pilha_frame(m, x, false), x->site != 0, true);
+            if (op != RV_CONST) vivo[x->b] = 1;
+            if (op >= RV_ADD && op <= RV_REM) vivo[x->c] = 1;
+            continue;
+        }
+        if (eh_desvio(op) && op != RV_GOTO) vivos(vivo, m, pilha_frame(m, x, true), x->site != 0, true);
+        if (op == RV_PUTFIELD) {
+            vivos(vivo, m, pilha_frame(m, x, false), x->site != 0, true);
+            vivo[x->b] = 1;
+            vivo[x->c] = 1;
+        } else if ((op >= RV_IFEQ && op <= RV_IFLE) || (op >= RV_IFKEQ && op <= RV_IFKLE) || op == RV_GUARD ||
+                   op == RV_RET) {
+            vivo[x->b] = 1;
+        } else if (op >= RV_IFCMPEQ && op <= RV_IFCMPLE) {
+            vivo[x->b] = 1;
+            vivo[x->c] = 1;
+        }
+    }
+}
+
+/* Remove os RV_NOP e refaz entradas e alvos */
+static bool compactar(Ir *ir, RegMethod *m) {
+    u4 *novo = (u4 *)malloc(((size_t)ir->n + 1) * sizeof(u4));
+    if (!novo) return false;
+    u4 j = 0;
+    for (u4 i = 0; i < ir->n; i++) {
+        novo[i] = j;
+        if (ir->v[i].op != RV_NOP) ir->v[j++] = ir->v[i];
+    }
+    novo[ir->n] = j;
+    for (u4 pc = 0; pc < m->code_length; pc++) {
+        if (m->entry[pc] != REGVM_NONE) m->entry[pc] = novo[m->entry[pc]];
+    }
+    bool ok = true;
+    for (u4 i = 0; i < j; i++) {
+        RegInsn *x = &ir->v[i];
+        if (!eh_desvio(x->op) || x->target_pc == ALVO_DESOTIMIZAR) continue;
+        if (x->target > ir->n) ok = false;
+        else x->target = novo[x->target];
+    }
+    free(novo);
+    m->removed = ir->n - j;
+    ir->n = j;
+    return ok;
+}
+
+void regvm_free(RegMethod *m) {
+    if (!m) return;
+    free(m->insns);
+    free(m->entry);
+    free(m->depth);
+    free(m->sites);
+    free(m->classes);
+    free(m->deps);
+    free(m->vloops);
+    free(m);
+}
+
+RegMethod *regvm_translate(ClassFile *cf, const MethodInfo *method, const CodeAttribute *code) {
+    if (!cf || !method || !code || !code->code || code->code_length == 0) return NULL;
+    if ((u4)code->max_locals + code->max_stack + REGS_INLINE > 0xFFFFu) return NULL;
+    RegMethod *m = (RegMethod *)calloc(1, sizeof(RegMethod));
+    if (!m) return NULL;
+    m->code_length = code->code_length;
+    m->nlocals = code->max_locals;
+    m->frame_regs = m->nregs = (u2)(code->max_locals + code->max_stack);
+    m->hierarchy_version = cp_cache_hierarchy_version();    /* antes de qualquer carga pela traducao */
+    m->depth = (int32_t *)malloc(code->code_length * sizeof(int32_t));
+    m->entry = (u4 *)malloc(code->code_length * sizeof(u4));
+    if (!m->depth || !m->entry ||
+        verify_method_depths(cf, method, code, m->depth, NULL) != OK) {
+        regvm_free(m);
+        return NULL;
+    }
+    for (u4 pc = 0; pc < code->code_length; pc++) m->entry[pc] = REGVM_NONE;
+
+    Tradutor t;
+    memset(&t, 0, sizeof t);
+    t.m = m;
+    t.orcamento = REGVM_INLINE_BUDGET;
+    t.topo = m->frame_regs;
+    Corpo raiz;
+    memset(&raiz, 0, sizeof raiz);
+    raiz.cf = cf;
+    raiz.method = method;
+    raiz.code = code;
+    raiz.prof_fixa = -1;
+    raiz.depth = m->depth;
+    raiz.indice = m->entry;
+
+    /* 1. traducao direta, com os inlinados; 2. copias e constantes; 3. definicoes mortas */
+    bool ok = novo_site(&t, cf, method, code, 0, 0, 0) == 0 && traduzir_corpo(&t, &raiz);
+    if (ok) emitir_lentos(&t);
+    ok = ok && !t.ir.sem_memoria && t.ir.n > 0;
+    Valor *val = ok ? (Valor *)calloc(m->nregs, sizeof(Valor)) : NULL;
+    u1 *vivo = ok ? (u1 *)malloc(m->nregs) : NULL;
+    ok = ok && val && vivo;
+    if (ok) {
+        Propagacao p = { val, 1, m->nregs, m->nlocals, 0 };
+        propagar(&t.ir, &p);
+        m->propagated = p.trocas;
+        eliminar(&t.ir, vivo, m);
+        ok = compactar(&t.ir, m);
+    }
+
+    free(val);
+    free(vivo);
+    free(t.ir.rotulo);
+    free(t.lentos);
+    if (!ok) {
+        free(t.ir.v);
+        regvm_free(m);
+        return NULL;
+    }
+    RegInsn *v = (RegInsn *)realloc(t.ir.v, t.ir.n * sizeof(RegInsn));
+    m->insns = v ? v : t.ir.v;
+    m->count = t.ir.n;
+    return m;
+}
+
+/* ============================================================
+ * Tabela de traducoes (MethodInfo* -> RegMethod; NULL se nao traduzivel)
+ * ============================================================ */
+typedef struct {
+    const MethodInfo *method;
+    RegMethod *rm;
+} Traducao;
+
+static Traducao *tabela;
+static size_t tabela_cap, tabela_n;
+static RegVmStats totais;
+
+/* Invalidadas: podem estar em execucao numa ativacao mais externa */
+static RegMethod **aposentadas;
+static size_t aposentadas_n, aposentadas_cap;
+
+/* false se alguma dependencia de m foi sobrescrita desde a traducao */
+static bool valida(RegMethod *m) {
+    if (m->invalid) return false;
+    unsigned versao = cp_cache_hierarchy_version();
+    if (m->hierarchy_version == versao) return true;
+    for (u2 i = 0; i < m->ndeps; i++) {
+        if (cp_cache_overridden(m->deps[i].cls, m->deps[i].method)) {
+            m->invalid = true;
+            totais.invalidated++;
+            return false;
+        }
+    }
+    m->hierarchy_version = versao;
+    return true;
+}
+
+static bool aposentar(RegMethod *m) {
+    if (aposentadas_n == aposentadas_cap) {
+        size_t cap = aposentadas_cap ? aposentadas_cap * 2 : 8;
+        RegMethod **v = (RegMethod **)realloc(aposentadas, cap * sizeof(RegMethod *));
+        if (!v) return false;
+        aposentadas = v;
+        aposentadas_cap = cap;
+    }
+    aposentadas[aposentadas_n++] = m;
+    return true;
+}
+
+static size_t posicao(const MethodInfo *m, size_t cap) {
+    uintptr_t h = (uintptr_t)m;
+    h ^= h >> 17;
+    h *= 0x9E3779B1u;
+    return (size_t)(h ^ (h >> 15)) & (cap - 1);
+}
+
+static bool crescer(void) {
+    size_t cap = tabela_cap ? tabela_cap * 2 : 64;
+    Traducao *nova = (Traducao *)calloc(cap, sizeof(Traducao));
+    if (!nova) return false;
+    for (size_t i = 0; i < tabela_cap; i++) {
+        if (!tabela[i].method) continue;
+        size_t j = posicao(tabela[i].method, cap);
+        while (nova[j].method) j = (j + 1) & (cap - 1);
+        nova[j] = tabela[i];
+    }
+    free(tabela);
+    tabela = nova;
+    tabela_cap = cap;
+    return true;
+}
+
+static RegMethod *traduzir_metodo(ClassFile *cf, const MethodInfo *method) {
+    const CodeAttribute *code = cp_cache_code(cf, method);
+    RegMethod *rm = code ? regvm_translate(cf, method, code) : NULL;
+    if (rm) {
+        totais.methods++;
+        totais.bytecodes += rm->bytecodes;
+        totais.insns += rm->count;
+        totais.propagated += rm->propagated;
+        totais.removed += rm->removed;
+        totais.inlined += rm->inlined;
+        totais.devirtualized += rm->devirtualized;
+        totais.vectorized += rm->nvloops;
+    } else {
+        totais.failed++;
+    }
+    return rm;
+}
+
+/*
+ * Traducao valida de method. A invalidada (inclusive por uma classe
+ * carregada durante a propria traducao) e trocada por uma nova.
+ */
+static RegMethod *traducao(ClassFile *cf, const MethodInfo *method) {
+    size_t i = 0;
+    if (tabela) {
+        for (i = posicao(method, tabela_cap); tabela[i].method; i = (i + 1) & (tabela_cap - 1)) {
+            if (tabela[i].method != method) continue;
+            RegMethod *rm = tabela[i].rm;
+            if (!rm || valida(rm)) return rm;
+            if (!aposentar(rm)) return NULL;
+            rm = tabela[i].rm = traduzir_metodo(cf, method);
+            return rm && valida(rm) ? rm : NULL;
+        }
+    }
+    if ((tabela_n + 1) * 2 > tabela_cap && !crescer()) return NULL;
+
+    RegMethod *rm = traduzir_metodo(cf, method);
+    for (i = posicao(method, tabela_cap); tabela[i].method; i = (i + 1) & (tabela_cap - 1)) {}
+    tabela[i].method = method;
+    tabela[i].rm = rm;
+    tabela_n++;
+    if (rm && !valida(rm)) {
+        if (!aposentar(rm)) return NULL;
+        rm = tabela[i].rm = traduzir_metodo(cf, method);
+        if (rm && !valida(rm)) return NULL;
+    }
+    return rm;
+}
+
+/* ============================================================
+ * Execucao
+ * ============================================================ */
+
+/* --verbose: origem da desotimizacao, do inlinado mais interno ao metodo traduzido */
+static void relatar_desotimizacao(const RegMethod *m, const RegInsn *x) {
+    RegOrigin o[REGVM_INLINE_DEPTH + 1];
+    u2 n = regvm_origin(m, (u4)(x - m->insns), o, REGVM_INLINE_DEPTH + 1);
+    fputs("[regvm] desotimização:", stderr);
+    for (u2 i = 0; i < n; i++) {
+        const ClassFile *cf = o[i].cls;
+        fprintf(stderr, "%s %s.%s%s pc %u", i ? " <-" : "", classfile_this_name(cf),
+                cp_utf8(cf->constant_pool, cf->constant_pool_count, o[i].method->name_index),
+                cp_utf8(cf->constant_pool, cf->constant_pool_count, o[i].method->descriptor_index), o[i].pc);
+        if (o[i].line >= 0) fprintf(stderr, " linha %d", o[i].line);
+    }
+    fputc('\n', stderr);
+}
+
+/*
+ * Desotimizacao em x (pc e pilha do metodo de x->site). O Frame do
+ * proprio metodo recebe os registradores dele e fica na chamada inlinada
+ * mais externa em andamento (ou em x, no site 0). Para cada inlinado
+ * ativo, de fora para dentro, um Frame novo recebe as locais e a pilha
+ * de sites[s].base; o de fora fica parado na chamada, com a pilha sem os
+ * argumentos. Depois, de dentro para fora, cada um roda no interpretador
+ * de pilha ate o return e o valor e empilhado no de fora, que segue na
+ * instrucao depois da chamada.
+ */
+static int desotimizar(Frame *frame, const RegMethod *m, const Slot *r, const RegInsn *x,
+                       const CliOptions *options) {
+    u2 cadeia[REGVM_INLINE_DEPTH + 1], n = 0;       /* de dentro para fora */
+    for (u2 s = x->site; s != 0 && n <= REGVM_INLINE_DEPTH; s = m->sites[s].parent) cadeia[n++] = s;
+    totais.deoptimized++;
+    totais.deopt_frames += n;
+    if (options->verbose) relatar_desotimizacao(m, x);
+
+    const RegInlineSite *fora = n ? &m->sites[cadeia[n - 1]] : NULL;
+    if (r != frame->local_vars) memcpy(frame->local_vars, r, m->frame_regs * sizeof(Slot));
+    frame->pc = frame->code + (fora ? fora->call_pc : x->pc);
+    frame->stack_top = frame->operand_stack + (fora ? fora->call_depth - fora->arg_slots : x->depth);
+
+    Frame *frames[REGVM_INLINE_DEPTH + 1];
+    Frame *pai = frame;
+    for (u2 i = n; i-- > 0;) {
+        const RegInlineSite *s = &m->sites[cadeia[i]], *dentro = i ? &m->sites[cadeia[i - 1]] : NULL;
+        u2 prof = dentro ? (u2)(dentro->call_depth - dentro->arg_slots) : x->depth;
+        Frame *f = frame_new(s->cls, (MethodInfo *)s->method, s->code->max_locals, s->code->max_stack);
+        if (!f) {
+            for (u2 j = i + 1; j < n; j++) frame_free(frames[j]);
+            fprintf(stderr, "Erro: Falha ao criar o Frame de Execucao.\n");
+            return -1;
+        }
+        memcpy(f->local_vars, r + s->base, ((size_t)s->code->max_locals + prof) * sizeof(Slot));
+        f->next = pai;
+        f->code = s->code->code;
+        f->pc = f->code + (dentro ? dentro->call_pc : x->pc);
+        f->stack_top = f->operand_stack + prof;
+        frames[i] = pai = f;
+    }
+
+    for (u2 i = 0; i < n; i++) {
+        int status = execute_resume_frame(frames[i], options);
+        Frame *destino = i + 1 < n ? frames[i + 1] : frame;
+        u1 ret = m->sites[cadeia[i]].ret_slots;
+        if (status == 1) {
+            memcpy(destino->stack_top, frames[i]->stack_top - ret, ret * sizeof(Slot));
+            destino->stack_top += ret;
+            destino->pc += 3;                           /* invokevirtual/special/static */
+        }
+        frame_free(frames[i]);
+        if (status != 1) {
+            for (u2 j = i + 1; j < n; j++) frame_free(frames[j]);
+            return status;
+        }
+    }
+    return REGVM_INTERPRET;
+}
+
+/* Desvio tomado para x->target; para tras no proprio metodo, passa pelo OSR */
+#define DESVIAR(cond)                                                   \
+    if (cond) {                                                         \
+        if (osr && x->site == 0 && x->target <= (u4)(x - base)) {       \
+            alvo_pc = x->target_pc;                                     \
+            goto laco;                                                  \
+        }                                                               \
+        x = base + x->target;                                           \
+    } else {                                                            \
+        x++;                                                            \
+    }                                                                   \
+    continue
+
+#define SAIR(v)                                         \
+    do {                                                \
+        totais.dispatches += despachos;                 \
+        return (v);                                     \
+    } while (0)
+
+/* Com inlinados, os registradores sao uma copia local do Frame */
+#define GRAVAR_FRAME()                                                              \
+    do {                                                                            \
+        if (separado) memcpy(frame->local_vars, r, m->frame_regs * sizeof(Slot));   \
+    } while (0)
+
+#define LER_FRAME()                                                                 \
+    do {                                                                            \
+        if (separado) memcpy(r, frame->local_vars, m->frame_regs * sizeof(Slot));   \
+    } while (0)
+
+int regvm_execute(Frame *frame, const CliOptions *options) {
+    RegMethod *m = traducao(frame->class_file, frame->method_info);
+    if (!m) return REGVM_INTERPRET;
+    u4 pc = (u4)(frame->pc - frame->code);
+    if (pc >= m->code_length || m->entry[pc] == REGVM_NONE ||
+        frame->stack_top - frame->operand_stack != m->depth[pc]) {
+        return REGVM_INTERPRET;
+    }
+
+    const bool osr = options->jit, estresse = config.deopt_stress;
+    const bool separado = m->nregs > m->frame_regs;
+    Slot copia[separado ? m->nregs : 1];
+    Slot *r = separado ? copia : frame->local_vars;
+    LER_FRAME();
+    const RegInsn *base = m->insns, *x = base + m->entry[pc];
+    uint64_t despachos = 0;
+    u4 alvo_pc;
+    int32_t d;
+    ObjectRef o;
+
+    for (;; despachos++) {
+        switch ((RegOp)x->op) {
+            case RV_NOP: x++; continue;
+            case RV_MOV: r[x->a] = r[x->b]; x++; continue;
+            case RV_CONST: r[x->a] = (Slot)x->k; x++; continue;
+            case RV_ADD: r[x->a] = r[x->b] + r[x->c]; x++; continue;
+            case RV_SUB: r[x->a] = r[x->b] - r[x->c]; x++; continue;
+            case RV_MUL: r[x->a] = r[x->b] * r[x->c]; x++; continue;
+            case RV_DIV:
+            case RV_REM:
+                d = (int32_t)r[x->c];
+                if (d == 0) goto desotimiza;    /* o interpretador refaz a instrucao e reporta o erro */
+                if (d == -1) r[x->a] = x->op == RV_DIV ? 0u - r[x->b] : 0u;
+                else r[x->a] = (Slot)(x->op == RV_DIV ? (int32_t)r[x->b] / d : (int32_t)r[x->b] % d);
+                x++;
+                continue;
+            case RV_NEG: r[x->a] = 0u - r[x->b]; x++; continue;
+            case RV_ADDK: r[x->a] = r[x->b] + (Slot)x->k; x++; continue;
+            case RV_MULK: r[x->a] = r[x->b] * (Slot)x->k; x++; continue;
+            case RV_DIVK: r[x->a] = (Slot)((int32_t)r[x->b] / x->k); x++; continue;
+            case RV_REMK: r[x->a] = (Slot)((int32_t)r[x->b] % x->k); x++; continue;
+            case RV_GETFIELD:
+                o = jvm_heap_deref(r[x->b]);
+                if (!o) goto desotimiza;        /* idem para o NullPointerException */
+                r[x->a] = o->fields[x->k];
+                x++;
+                continue;
+            case RV_PUTFIELD:
+                o = jvm_heap_deref(r[x->b]);
+                if (!o) goto desotimiza;
+                o->fields[x->k] = r[x->c];
+                x++;
+                continue;
+            case RV_GUARD:
+                o = jvm_heap_deref(r[x->b]);
+                if (!estresse && o && (x->k < 0 || o->class_info == m->classes[x->k])) {
+                    x++;
+                    continue;
+                }
+                if (x->target_pc == ALVO_DESOTIMIZAR) goto desotimiza;
+                totais.deoptimized++;   /* no site 0 so a chamada vai para o interpretador */
+                x = base + x->target;
+                continue;
+            case RV_VLOOP:
+                if (!vec_run(&m->vloops[x->k], r)) {
+                    x++;                /* limites nao provados: laco escalar */
+                    continue;
+                }
+                totais.vector_runs++;
+                x = base + x->target;
+                continue;
+            case RV_IFEQ: DESVIAR((int32_t)r[x->b] == 0);
+            case RV_IFNE: DESVIAR((int32_t)r[x->b] != 0);
+            case RV_IFLT: DESVIAR((int32_t)r[x->b] < 0);
+            case RV_IFGE: DESVIAR((int32_t)r[x->b] >= 0);
+            case RV_IFGT: DESVIAR((int32_t)r[x->b] > 0);
+            case RV_IFLE: DESVIAR((int32_t)r[x->b] <= 0);
+            case RV_IFCMPEQ: DESVIAR((int32_t)r[x->b] == (int32_t)r[x->c]);
+            case RV_IFCMPNE: DESVIAR((int32_t)r[x->b] != (int32_t)r[x->c]);
+            case RV_IFCMPLT: DESVIAR((int32_t)r[x->b] < (int32_t)r[x->c]);
+            case RV_IFCMPGE: DESVIAR((int32_t)r[x->b] >= (int32_t)r[x->c]);
+            case RV_IFCMPGT: DESVIAR((int32_t)r[x->b] > (int32_t)r[x->c]);
+            case RV_IFCMPLE: DESVIAR((int32_t)r[x->b] <= (int32_t)r[x->c]);
+            case RV_IFKEQ: DESVIAR((int32_t)r[x->b] == x->k);
+            case RV_IFKNE: DESVIAR((int32_t)r[x->b] != x->k);
+            case RV_IFKLT: DESVIAR((int32_t)r[x->b] < x->k);
+            case RV_IFKGE: DESVIAR((int32_t)r[x->b] >= x->k);
+            case RV_IFKGT: DESVIAR((int32_t)r[x->b] > x->k);
+            case RV_IFKLE: DESVIAR((int32_t)r[x->b] <= x->k);
+            case RV_GOTO: DESVIAR(1);
+            case RV_RET:
+                frame->operand_stack[0] = r[x->b];
+                frame->stack_top = frame->operand_stack + 1;
+                SAIR(1);
+            case RV_RETV:
+                frame->stack_top = frame->operand_stack;
+                SAIR(1);
+            case RV_STACK: {
+                frame->pc = frame->code + x->pc;
+                frame->stack_top = frame->operand_stack + x->depth;
+                GRAVAR_FRAME();
+                int status = opcode_handlers[x->opcode](frame, options);
+                if (status != 0) SAIR(status);
+                if (!valida(m)) SAIR(REGVM_INTERPRET);     /* o Frame ja esta no pc seguinte */
+                pc = (u4)(frame->pc - frame->code);
+                if (pc >= m->code_length || m->entry[pc] == REGVM_NONE ||
+                    frame->stack_top - frame->operand_stack != m->depth[pc]) {
+                    SAIR(REGVM_INTERPRET);
+                }
+                LER_FRAME();
+                x = base + m->entry[pc];
+                continue;
+            }
+        }
+        /* opcode da IR invalido: como as armadilhas */
+
+    desotimiza:
+        /* o interpretador de pilha continua do pc de origem, com os inlinados refeitos */
+        SAIR(desotimizar(frame, m, r, x, options));
+
+    laco:
+        /* salto para tras: laco quente continua no codigo compilado (OSR) */
+        frame->pc = frame->code + alvo_pc;
+        frame->stack_top = frame->operand_stack + m->depth[alvo_pc];
+        {
+            JitFunction fn = jit_on_backedge(frame);
+            if (fn) {
+                GRAVAR_FRAME();
+                SAIR(jit_execute(fn, frame, options));
+            }
+        }
+        x = base + m->entry[alvo_pc];
+    }
+}
+
+/* Linha do pc pela LineNumberTable (a entrada de maior start_pc <= pc); -1 sem tabela */
+static int32_t linha(const CodeAttribute *code, u4 pc) {
+    int32_t l = -1;
+    u4 melhor = 0;
+    for (u2 i = 0; code && i < code->line_number_table_length; i++) {
+        const LineNumberTableEntry *e = &code->line_number_table[i];
+        if (e->start_pc <= pc && (l < 0 || e->start_pc >= melhor)) {
+            melhor = e->start_pc;
+            l = e->line_number;
+        }
+    }
+    return l;
+}
+
+u2 regvm_origin(const RegMethod *m, u4 insn, RegOrigin *out, u2 cap) {
+    if (!m || insn >= m->count) return 0;
+    u2 n = 0;
+    u2 s = m->insns[insn].site;
+    u4 pc = m->insns[insn].pc;
+    for (int nivel = 0; n < cap && nivel <= REGVM_INLINE_DEPTH; nivel++) {
+        const RegInlineSite *site = &m->sites[s];
+        out[n].cls = site->cls;
+        out[n].method = site->method;
+        out[n].pc = pc;
+        out[n].line = linha(site->code, pc);
+        n++;
+        if (s == 0) break;
+        pc = site->call_pc;
+        s = site->parent;
+    }
+    return n;
+}
+
+void regvm_stats(RegVmStats *out) {
+    *out = totais;
+}
+
+void regvm_release_all(void) {
+    for (size_t i = 0; i < tabela_cap; i++) regvm_free(tabela[i].rm);
+    for (size_t i = 0; i < aposentadas_n; i++) regvm_free(aposentadas[i]);
+    free(tabela);
+    free(aposentadas);
+    tabela = NULL;
+    aposentadas = NULL;
+    tabela_cap = tabela_n = 0;
+    aposentadas_n = aposentadas_cap = 0;
+    memset(&totais, 0, sizeof totais);
+}
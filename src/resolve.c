@@ -2,6 +2,8 @@
 #define _GNU_SOURCE
 #include "resolve.h"
 #include "classfile.h" // Necessario para as funcoes de consulta cp_* e tipos
+#include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -12,149 +14,244 @@
 
 
 // =======================================================
-// IMPLEMENTAÇÕES DE FUNÇÕES HELPER (Baseado em classfile.c)
+// MEMO POR CLASSE (cf->names)
 // =======================================================
 
-/**
- * Helper para lidar com Methodref, Fieldref, e InterfaceMethodref (Opcoes 9, 10, 11)
- */
-char* resolve_ref_to_string(const Classe *cf, uint16_t idx) {
-    const char *out_classe = NULL;
-    const char *out_nome = NULL;
-    const char *out_desc = NULL;
-    static const char *ERRO = "ERRO_REF";
-
-    // OBTEM O PONTEIRO PARA O CP E SEU TAMANHO
-    const INFO_CP *cp = cf->constant_pool;
-    u2 cp_count = cf->constant_pool_count;
-
-    // 1. CHAMA O HELPER DA PESSOA B: Navegacao dos indices
-    cp_referencia_metodo(
-        cp,                      // O array do CP
-        cp_count,                // Tamanho do CP
-        idx,                     // O indice lido do bytecode (Ex: 26)
-        &out_classe,             // Retorna o nome da Classe
-        &out_nome,               // Retorna o nome do Metodo/Campo
-        &out_desc                // Retorna o Descritor
-    );
-
-    // Verifica se a Pessoa B falhou (retornou a string VAZIO/""/NULL)
-    if (!out_classe || out_classe[0] == '\0' || !out_nome || out_nome[0] == '\0') {
-        // Se a referência falhou, retorna erro
-        char *err_msg;
-        asprintf(&err_msg, "%s #%d", ERRO, idx); // Usa asprintf se disponivel, ou snprintf/malloc
-        if (err_msg) return err_msg;
-        return strdup(ERRO);
+// Textos guardados em blocos (um malloc a cada ~4 KiB, nao por texto)
+#define BLOCO_TEXTO 4096
+
+typedef struct bloco_texto {
+    struct bloco_texto *prox;
+    size_t usado, cap;
+    char dados[];
+} BlocoTexto;
+
+struct resolve_memo {
+    const char **textos;    // [constant_pool_count]; NULL = ainda nao formatado
+    BlocoTexto *blocos;
+};
+
+// Serializa quem formata; a leitura de um texto ja publicado nao trava
+static pthread_mutex_t trava = PTHREAD_MUTEX_INITIALIZER;
+
+static char *guardar(struct resolve_memo *m, size_t n) {
+    BlocoTexto *b = m->blocos;
+    if (!b || b->cap - b->usado < n) {
+        size_t cap = n > BLOCO_TEXTO ? n : BLOCO_TEXTO;
+        b = (BlocoTexto *)malloc(sizeof(BlocoTexto) + cap);
+        if (!b) return NULL;
+        b->prox = m->blocos;
+        b->usado = 0;
+        b->cap = cap;
+        m->blocos = b;
     }
-    
-    // 2. MONTAGEM FINAL DA STRING
-    // Formato: Classe.Nome:Descritor (Calcula tamanho maximo e aloca)
-    size_t required_size = strlen(out_classe) + strlen(out_nome) + strlen(out_desc) + 3; 
-    char *final_string = (char*)malloc(required_size);
-
-    if (final_string) {
-        sprintf(final_string, "%s.%s:%s", out_classe, out_nome, out_desc);
-    } else {
-        return strdup("ERRO_MEMORIA");
+    char *p = b->dados + b->usado;
+    b->usado += n;
+    return p;
+}
+
+// printf para dentro dos blocos do memo (chamar com a trava)
+static const char *formatar(struct resolve_memo *m, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    char *p = n >= 0 ? guardar(m, (size_t)n + 1) : NULL;
+    if (!p) return "ERRO_MEMORIA";
+    va_start(ap, fmt);
+    vsnprintf(p, (size_t)n + 1, fmt, ap);
+    va_end(ap);
+    return p;
+}
+
+// Cria o memo da classe, se ainda nao existe (chamar com a trava)
+static struct resolve_memo *memo_da_classe(const Classe *cf) {
+    struct resolve_memo *m = cf->names;
+    if (m) return m;
+    m = (struct resolve_memo *)calloc(1, sizeof *m);
+    if (!m) return NULL;
+    m->textos = (const char **)calloc(cf->constant_pool_count ? cf->constant_pool_count : 1, sizeof(const char *));
+    if (!m->textos) {
+        free(m);
+        return NULL;
     }
+    // o memo e um cache: a classe continua logicamente constante
+    __atomic_store_n(&((Classe *)cf)->names, m, __ATOMIC_RELEASE);
+    return m;
+}
 
-    // Retorna a string final para o disasm.c
-    return final_string; 
+static const char *ja_formatado(const Classe *cf, u2 idx) {
+    struct resolve_memo *m = __atomic_load_n(&cf->names, __ATOMIC_ACQUIRE);
+    if (!m || idx >= cf->constant_pool_count) return NULL;
+    return __atomic_load_n(&m->textos[idx], __ATOMIC_ACQUIRE);
 }
 
+void resolve_memo_release(Classe *cf) {
+    struct resolve_memo *m = cf->names;
+    if (!m) return;
+    while (m->blocos) {
+        BlocoTexto *prox = m->blocos->prox;
+        free(m->blocos);
+        m->blocos = prox;
+    }
+    free(m->textos);
+    free(m);
+    cf->names = NULL;
+}
+
+
+// =======================================================
+// IMPLEMENTAÇÕES DE FUNÇÕES HELPER (Baseado em classfile.c)
+// =======================================================
 
 /**
- * Helper para lidar com CONSTANT_Class (Opcao 7)
+ * Helper para lidar com Methodref, Fieldref, e InterfaceMethodref (Opcoes 9, 10, 11)
+ * Formato: Classe.Nome:Descritor. Chamar com a trava.
  */
-char* resolve_class_name_to_string(const Classe *cf, uint16_t idx) {
-    // OBTEM O PONTEIRO PARA O CP E SEU TAMANHO
-    const INFO_CP *cp = cf->constant_pool;
-    u2 cp_count = cf->constant_pool_count;
+static const char *formatar_ref(const Classe *cf, struct resolve_memo *m, uint16_t idx) {
+    const char *out_classe = NULL;
+    const char *out_nome = NULL;
+    const char *out_desc = NULL;
 
-    // 1. CHAMA O HELPER DA PESSOA B: Obtem o nome da Classe
-    const char *class_name = cp_nome_classe(cp, cp_count, idx);
+    // Navegacao dos indices: Ref -> Class/NameAndType -> Utf8
+    cp_referencia_metodo(cf->constant_pool, cf->constant_pool_count, idx, &out_classe, &out_nome, &out_desc);
 
-    // 2. RETORNA UMA COPIA ALOCADA
-    if (class_name && class_name[0] != '\0') {
-        return strdup(class_name);
+    // Referencia quebrada (cp_referencia_metodo devolve "" ou NULL)
+    if (!out_classe || out_classe[0] == '\0' || !out_nome || out_nome[0] == '\0') {
+        return formatar(m, "ERRO_REF #%d", idx);
     }
-    
-    // 3. Em caso de erro
-    char *err_msg;
-    asprintf(&err_msg, "CLASSE_NAO_ENCONTRADA #%d", idx);
-    if (err_msg) return err_msg;
-    return strdup("CLASSE_NAO_ENCONTRADA");
+    return formatar(m, "%s.%s:%s", out_classe, out_nome, out_desc ? out_desc : "");
 }
 
-
 /**
- * Helper para lidar com constantes literais (Opcao 1, 8, 9)
- * Focado em String/Utf8 para o disasm
+ * Helper para constantes literais que precisam de formatacao (String e numericas).
+ * Chamar com a trava.
  */
-char* resolve_literal_to_string(const ClassFile *cf, u2 idx) {
-    if (!cf || idx == 0 || idx >= cf->constant_pool_count) return strdup("<?>");
+static const char *formatar_literal(const Classe *cf, struct resolve_memo *m, u2 idx) {
     const CpInfo *cp = cf->constant_pool;
-    u1 tag = cp[idx].tag;
-
-    // Ignora slot vazio (após Long/Double)
-    if (tag == CONSTANT_None) return strdup("<?>");
-
-    switch (tag) {
-        case CONSTANT_String: {
-            const char *s = cp_utf8(cp, cf->constant_pool_count, cp[idx].String.string_index);
-            if (!s) return strdup("\"?\"");
-            size_t n = strlen(s) + 3;
-            char *out = (char*)malloc(n);
-            snprintf(out, n, "\"%s\"", s);
-            return out;
-        }
+    switch (cp[idx].tag) {
+        case CONSTANT_String:
+            return formatar(m, "\"%s\"", cp_utf8(cp, cf->constant_pool_count, cp[idx].String.string_index));
 
-        case CONSTANT_Integer: {
-            char buf[64];
-            snprintf(buf, sizeof(buf), "%d", (int32_t)cp[idx].Num.bytes);
-            return strdup(buf);
-        }
+        case CONSTANT_Integer:
+            return formatar(m, "%d", (int32_t)cp[idx].Num.bytes);
 
         case CONSTANT_Float: {
-            char buf[64];
             float f;
             memcpy(&f, &cp[idx].Num.bytes, 4);   // IEEE-754
-            snprintf(buf, sizeof(buf), "%g", f); // uso de %g
-            return strdup(buf);
+            return formatar(m, "%g", f);
         }
 
         case CONSTANT_Long: {
-            char buf[64];
             uint64_t bits = ((uint64_t)cp[idx].LongDouble.high_bytes << 32)
                           |  (uint64_t)cp[idx].LongDouble.low_bytes; // high<<32 | low
-            long long v = (long long)bits; // interpretado como assinado
-            snprintf(buf, sizeof(buf), "%lld", v);
-            return strdup(buf);
+            return formatar(m, "%lld", (long long)bits); // interpretado como assinado
         }
 
         case CONSTANT_Double: {
-            char buf[64];
             uint64_t bits = ((uint64_t)cp[idx].LongDouble.high_bytes << 32)
                           |  (uint64_t)cp[idx].LongDouble.low_bytes; // high<<32 | low
             double d;
             memcpy(&d, &bits, 8); // IEEE-754
-            snprintf(buf, sizeof(buf), "%f", d); // uso de %g
-            return strdup(buf);
+            return formatar(m, "%f", d);
         }
 
+        default:
+            return "<?>";
+    }
+}
+
+static int eh_ref(u1 tag) {
+    return tag == CONSTANT_Fieldref || tag == CONSTANT_Methodref || tag == CONSTANT_InterfaceMethodref;
+}
+
+const char *resolve_ref(const Classe *cf, uint16_t idx) {
+    const char *texto = ja_formatado(cf, idx);
+    if (texto) return texto;
+
+    pthread_mutex_lock(&trava);
+    struct resolve_memo *m = memo_da_classe(cf);
+    if (!m) {
+        texto = "ERRO_MEMORIA";
+    } else if (idx < cf->constant_pool_count && m->textos[idx]) {
+        texto = m->textos[idx];     // outra thread formatou antes
+    } else if (idx == 0 || idx >= cf->constant_pool_count || !eh_ref(cf->constant_pool[idx].tag)) {
+        texto = formatar(m, "ERRO_REF #%d", idx);   // so em classe malformada: sem slot
+    } else {
+        texto = formatar_ref(cf, m, idx);
+        __atomic_store_n(&m->textos[idx], texto, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&trava);
+    return texto;
+}
+
+const char *resolve_class_name(const Classe *cf, uint16_t idx) {
+    // O nome ja esta no constant pool: nada a formatar nem guardar
+    const char *class_name = cp_nome_classe(cf->constant_pool, cf->constant_pool_count, idx);
+    if (class_name && class_name[0] != '\0') return class_name;
+
+    pthread_mutex_lock(&trava);
+    struct resolve_memo *m = memo_da_classe(cf);
+    const char *texto = m ? formatar(m, "CLASSE_NAO_ENCONTRADA #%d", idx) : "CLASSE_NAO_ENCONTRADA";
+    pthread_mutex_unlock(&trava);
+    return texto;
+}
+
+const char *resolve_literal(const ClassFile *cf, u2 idx) {
+    if (!cf || idx == 0 || idx >= cf->constant_pool_count) return "<?>";
+    const CpInfo *cp = cf->constant_pool;
+
+    switch (cp[idx].tag) {
         case CONSTANT_Class: {
             // Mostra nome interno da classe (ex: java/lang/String)
             const char *name = cp_utf8(cp, cf->constant_pool_count, cp[idx].Class.name_index);
-            return strdup(name ? name : "<?>");
+            return name ? name : "<?>";
         }
-
         case CONSTANT_Utf8: {
             // Normalmente ldc não aponta pra Utf8 direto, mas deixamos por segurança
             const char *s = cp_utf8(cp, cf->constant_pool_count, idx);
-            return strdup(s ? s : "<?>");
+            return s ? s : "<?>";
         }
-
+        case CONSTANT_String:
+        case CONSTANT_Integer:
+        case CONSTANT_Float:
+        case CONSTANT_Long:
+        case CONSTANT_Double:
+            break;
         default:
-            return strdup("<?>");
+            return "<?>";   // inclui o slot vazio após Long/Double
     }
+
+    const char *texto = ja_formatado(cf, idx);
+    if (texto) return texto;
+
+    pthread_mutex_lock(&trava);
+    struct resolve_memo *m = memo_da_classe(cf);
+    if (!m) {
+        texto = "ERRO_MEMORIA";
+    } else if (m->textos[idx]) {
+        texto = m->textos[idx];
+    } else {
+        texto = formatar_literal(cf, m, idx);
+        __atomic_store_n(&m->textos[idx], texto, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&trava);
+    return texto;
+}
+
+
+// =======================================================
+// API ANTIGA (copia alocada)
+// =======================================================
+
+char* resolve_ref_to_string(const Classe *cf, uint16_t idx) {
+    return strdup(resolve_ref(cf, idx));
+}
+
+char* resolve_class_name_to_string(const Classe *cf, uint16_t idx) {
+    return strdup(resolve_class_name(cf, idx));
+}
+
+char* resolve_literal_to_string(const ClassFile *cf, u2 idx) {
+    return strdup(resolve_literal(cf, idx));
 }
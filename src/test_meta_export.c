@@ -0,0 +1,160 @@
+#include "classfile.h"
+#include "io.h"
+#include "meta_export.h"
+#include "meta_reader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Teste da exportacao de metadados: grava os .class dados num .jvbm,
+ * reabre com o leitor e confere cada registro contra a ClassFile
+ * (nomes, membros, bytecode, referencias e a busca por nome).
+ */
+
+static int falhas = 0;
+
+#define CONFERE(cond, ...) \
+    do { if (!(cond)) { fprintf(stderr, "FALHA: " __VA_ARGS__); fputc('\n', stderr); falhas++; } } while (0)
+
+static const u1 *bytecode(const ClassFile *cf, const MethodInfo *m, u4 *len) {
+    for (u2 i = 0; i < m->attributes_count; i++) {
+        const AttributeInfo *a = &m->attributes[i];
+        /* mesmas checagens do exportador: Code curto ou code_length fora dele = sem bytecode */
+        if (!a->info || a->attribute_length < 8 ||
+            strcmp(cp_utf8(cf->constant_pool, cf->constant_pool_count, a->attribute_name_index), "Code") != 0) continue;
+        u4 n = ((u4)a->info[4] << 24) | ((u4)a->info[5] << 16) | ((u4)a->info[6] << 8) | a->info[7];
+        if (n == 0 || n > a->attribute_length - 8) break;
+        *len = n;
+        return a->info + 8;
+    }
+    *len = 0;
+    return NULL;
+}
+
+static void conferir(const MetaFile *mf, u4 ordinal, const ClassFile *cf, const char *path) {
+    const CpInfo *cp = cf->constant_pool;
+    u2 n = cf->constant_pool_count;
+    MetaClass c;
+    CONFERE(meta_class(mf, ordinal, &c), "classe %u ausente", ordinal);
+    CONFERE(strcmp(c.name, cp_nome_classe(cp, n, cf->this_class)) == 0, "%s: nome", path);
+    CONFERE(strcmp(c.super_name, cp_nome_classe(cp, n, cf->super_class)) == 0, "%s: super", path);
+    CONFERE(strcmp(c.path, path) == 0, "%s: caminho", path);
+    CONFERE(c.access_flags == cf->access_flags && c.major_version == cf->major_version, "%s: flags/versao", path);
+    CONFERE(meta_find_class(mf, c.name) >= 0, "%s: busca por nome", path);
+
+    CONFERE(c.interface_count == cf->interfaces_count, "%s: interfaces", path);
+    for (u2 i = 0; i < cf->interfaces_count && i < c.interface_count; i++) {
+        CONFERE(strcmp(meta_interface(mf, c.first_interface + i), cp_nome_classe(cp, n, cf->interfaces[i])) == 0,
+                "%s: interface %u", path, i);
+    }
+
+    CONFERE(c.field_count == cf->fields_count, "%s: campos", path);
+    for (u2 i = 0; i < cf->fields_count && i < c.field_count; i++) {
+        MetaField f;
+        meta_field(mf, c.first_field + i, &f);
+        CONFERE(f.class_index == ordinal && strcmp(f.name, cp_utf8(cp, n, cf->fields[i].name_index)) == 0 &&
+                strcmp(f.descriptor, cp_utf8(cp, n, cf->fields[i].descriptor_index)) == 0,
+                "%s: campo %u", path, i);
+    }
+
+    CONFERE(c.method_count == cf->methods_count, "%s: metodos", path);
+    for (u2 i = 0; i < cf->methods_count && i < c.method_count; i++) {
+        const MethodInfo *mi = &cf->methods[i];
+        MetaMethod m;
+        meta_method(mf, c.first_method + i, &m);
+        u4 len;
+        const u1 *code = bytecode(cf, mi, &len);
+        CONFERE(strcmp(m.name, cp_utf8(cp, n, mi->name_index)) == 0 &&
+                strcmp(m.descriptor, cp_utf8(cp, n, mi->descriptor_index)) == 0,
+                "%s: metodo %u", path, i);
+        CONFERE(m.code_length == len && (!len || memcmp(m.code, code, len) == 0), "%s: bytecode de %s", path, m.name);
+
+        /* as instrucoes cobrem o codigo inteiro e os operandos de membro/classe tem referencia
+           (ldc de constante numerica nao gera referencia) */
+        u4 pc = 0, insns = 0;
+        MetaInsn insn;
+        while (meta_next_insn(&m, &pc, &insn)) {
+            MetaRef r;
+            insns++;
+            if (insn.cp_index && insn.opcode >= 0xB2) {
+                CONFERE(meta_find_ref(mf, &c, insn.cp_index, &r) && r.cp_index == insn.cp_index,
+                        "%s: %s pc %u sem referencia #%u", path, m.name, insn.pc, insn.cp_index);
+            }
+        }
+        CONFERE(pc == m.code_length && insns == m.insn_count, "%s: instrucoes de %s", path, m.name);
+    }
+
+    for (u4 i = 0; i < c.ref_count; i++) {
+        MetaRef r;
+        meta_ref(mf, c.first_ref + i, &r);
+        if (r.tag == CONSTANT_Methodref) {
+            const char *dono, *nome, *desc;
+            cp_referencia_metodo(cp, n, r.cp_index, &dono, &nome, &desc);
+            CONFERE(strcmp(r.owner, dono) == 0 && strcmp(r.name, nome) == 0 && strcmp(r.descriptor, desc) == 0,
+                    "%s: referencia #%u", path, r.cp_index);
+        }
+    }
+}
+
+static int carregar(const char *path, ClassFile *cf) {
+    Buffer buf;
+    memset(cf, 0, sizeof *cf);
+    if (buffer_from_file(path, &buf) != OK) return 0;
+    ClassFileStatus st = parse_classfile(cf, &buf);
+    buffer_free(&buf);
+    if (st != CF_STATUS_OK) free_classfile(cf);
+    return st == CF_STATUS_OK;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <arquivo.class>...\n", argv[0]);
+        return 1;
+    }
+    const char *saida = "test_meta_export.jvbm";
+
+    MetaWriter *w = meta_writer_new();
+    int validas = 0;
+    for (int i = 1; i < argc; i++) {
+        ClassFile cf;
+        if (!carregar(argv[i], &cf)) continue;
+        CONFERE(meta_writer_add(w, &cf, argv[i]) == OK, "%s: add", argv[i]);
+        free_classfile(&cf);
+        validas++;
+    }
+    size_t bytes = 0;
+    CONFERE(meta_writer_finish(w, saida, &bytes) == OK, "finish");
+    meta_writer_free(w);
+
+    Status st;
+    MetaFile *mf = meta_open(saida, &st);
+    if (!mf) {
+        fprintf(stderr, "FALHA: meta_open (%d)\n", st);
+        return 1;
+    }
+    CONFERE(meta_class_count(mf) == (u4)validas, "numero de classes");
+
+    u4 ordinal = 0;
+    for (int i = 1; i < argc; i++) {
+        ClassFile cf;
+        if (!carregar(argv[i], &cf)) continue;
+        conferir(mf, ordinal++, &cf, argv[i]);
+        free_classfile(&cf);
+    }
+    CONFERE(meta_find_class(mf, "nao/Existe") == -1, "classe inexistente encontrada");
+    meta_close(mf);
+
+    /* arquivo truncado precisa ser recusado */
+    FILE *f = fopen(saida, "r+b");
+    if (f) {
+        fseek(f, 16, SEEK_SET);
+        fputc(1, f);
+        fclose(f);
+        CONFERE(meta_open(saida, &st) == NULL, "arquivo com tamanho errado aceito");
+    }
+    remove(saida);
+
+    printf("%d classes, %lu bytes: %s\n", validas, (unsigned long)bytes, falhas ? "FALHOU" : "OK");
+    return falhas ? 1 : 0;
+}
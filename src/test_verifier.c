@@ -0,0 +1,115 @@
+#include "attributes.h"
+#include "classfile.h"
+#include "io.h"
+#include "verifier.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Teste do verificador:
+ *   1. todo metodo com Code do .class dado precisa ser aceito;
+ *   2. bytecodes montados a mao sobre um metodo static ...V da classe
+ *      (locais: 1 argumento de referencia) precisam ser aceitos/rejeitados.
+ */
+
+typedef struct {
+    const char *nome;
+    u1 code[16];
+    u4 tamanho;
+    u2 max_stack, max_locals;
+    int aceito;
+} Caso;
+
+static const Caso casos[] = {
+    { "return",                 { 0xB1 }, 1, 0, 1, 1 },
+    { "underflow (pop)",        { 0x57, 0xB1 }, 2, 1, 1, 0 },
+    { "max_stack estourado",    { 0x03, 0x57, 0xB1 }, 3, 0, 1, 0 },
+    { "push/pop",               { 0x03, 0x57, 0xB1 }, 3, 1, 1, 1 },
+    { "passa do fim",           { 0x03, 0x57 }, 2, 1, 1, 0 },
+    { "salto no meio",          { 0xA7, 0x00, 0x02, 0xB1 }, 4, 0, 1, 0 },
+    { "salto fora do codigo",   { 0xA7, 0x00, 0x10, 0xB1 }, 4, 0, 1, 0 },
+    { "ref + int",              { 0x2A, 0x04, 0x60, 0x57, 0xB1 }, 5, 2, 1, 0 },
+    { "local fora de max",      { 0x1B, 0x57, 0xB1 }, 3, 1, 1, 0 },
+    { "local nao inicializado", { 0x1B, 0x57, 0xB1 }, 3, 1, 2, 0 },
+    { "ireturn em void",        { 0x03, 0xAC }, 2, 1, 1, 0 },
+    { "profundidade diverge",   { 0x03, 0x99, 0x00, 0x04, 0x04, 0xB1 }, 6, 1, 1, 0 },
+    { "laco com iinc",          { 0x03, 0x3C, 0x84, 0x01, 0x01, 0xA7, 0xFF, 0xFD }, 8, 1, 2, 1 },
+    { "long inteiro",           { 0x09, 0x3F, 0x1E, 0x58, 0xB1 }, 5, 2, 3, 1 },
+    { "metade de long",         { 0x09, 0x3F, 0x1F, 0x57, 0xB1 }, 5, 2, 3, 0 },
+    { "jsr",                    { 0xA8, 0x00, 0x03, 0xB1 }, 4, 1, 1, 0 },
+};
+
+static const MethodInfo *metodo_de_teste(const ClassFile *cf) {
+    for (u2 i = 0; i < cf->methods_count; i++) {
+        const MethodInfo *m = &cf->methods[i];
+        const char *desc = cp_utf8(cf->constant_pool, cf->constant_pool_count, m->descriptor_index);
+        if ((m->access_flags & 0x0008) && strcmp(desc, "([Ljava/lang/String;)V") == 0) return m;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <arquivo.class> (com main(String[]))\n", argv[0]);
+        return 1;
+    }
+
+    Buffer buf;
+    if (buffer_from_file(argv[1], &buf) != OK) {
+        fprintf(stderr, "Erro ao abrir arquivo: %s\n", argv[1]);
+        return 1;
+    }
+    ClassFile cf;
+    if (parse_classfile(&cf, &buf) != CF_STATUS_OK) {
+        fprintf(stderr, "Erro ao parsear classfile\n");
+        buffer_free(&buf);
+        return 1;
+    }
+
+    int falhas = 0;
+    printf("=== Teste do Verificador ===\n\n");
+
+    for (u2 i = 0; i < cf.methods_count; i++) {
+        const MethodInfo *m = &cf.methods[i];
+        const CodeAttribute *code = find_code_attribute(&cf, m);
+        if (!code) continue;
+        VerifyError err;
+        Status st = verify_method(&cf, m, code, &err);
+        printf("  %-40s %s", cp_utf8(cf.constant_pool, cf.constant_pool_count, m->name_index),
+               st == OK ? "aceito\n" : "REJEITADO");
+        if (st != OK) {
+            printf(" (pc=%u: %s)\n", err.pc, err.message);
+            falhas++;
+        }
+        free_code_attribute((CodeAttribute *)code);   /* estatico em find_code_attribute */
+    }
+
+    const MethodInfo *alvo = metodo_de_teste(&cf);
+    if (!alvo) {
+        fprintf(stderr, "Classe sem static main(String[])\n");
+        falhas++;
+    }
+    for (size_t i = 0; alvo && i < sizeof casos / sizeof casos[0]; i++) {
+        const Caso *c = &casos[i];
+        CodeAttribute code;
+        memset(&code, 0, sizeof code);
+        code.code = (u1 *)c->code;
+        code.code_length = c->tamanho;
+        code.max_stack = c->max_stack;
+        code.max_locals = c->max_locals;
+
+        VerifyError err;
+        int aceito = verify_method(&cf, alvo, &code, &err) == OK;
+        int ok = aceito == c->aceito;
+        printf("  [%s] %-24s %s", ok ? "OK" : "FALHOU", c->nome, aceito ? "aceito" : "rejeitado");
+        if (!aceito) printf(" (pc=%u: %s)", err.pc, err.message);
+        printf("\n");
+        if (!ok) falhas++;
+    }
+
+    printf("\n%s (%d falha(s))\n", falhas ? "FALHOU" : "OK", falhas);
+    free_classfile(&cf);
+    buffer_free(&buf);
+    return falhas ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+#define _POSIX_C_SOURCE 200809L
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct thread_pool {
+    pthread_t *workers;
+    int num_workers;            /* threads extras (total = num_workers + 1) */
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;        /* novo lote ou shutdown */
+    pthread_cond_t done;        /* ultima trabalhadora terminou o lote */
+
+    /* lote corrente (protegido por 'lock', exceto 'next') */
+    ThreadPoolTask task;
+    void *ctx;
+    size_t count;
+    size_t next;                /* proximo indice livre (atomico) */
+    unsigned long generation;   /* incrementa a cada lote */
+    int active;                 /* trabalhadoras ainda no lote */
+    int shutdown;
+};
+
+/* Consome indices do lote corrente ate acabarem. */
+static void executar_lote(ThreadPool *pool, ThreadPoolTask task, void *ctx, size_t count) {
+    for (;;) {
+        size_t i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+        if (i >= count) break;
+        task(ctx, i);
+    }
+}
+
+static void *trabalhadora(void *arg) {
+    ThreadPool *pool = (ThreadPool *)arg;
+    unsigned long visto = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == visto) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        visto = pool->generation;
+
+        ThreadPoolTask task = pool->task;
+        void *ctx = pool->ctx;
+        size_t count = pool->count;
+        pthread_mutex_unlock(&pool->lock);
+
+        executar_lote(pool, task, ctx, count);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/* ============================================================
+ * API pública
+ * ============================================================ */
+int thread_pool_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+ThreadPool *thread_pool_create(int threads) {
+    if (threads <= 0) threads = thread_pool_cpu_count();
+
+    ThreadPool *pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    if (threads > 1) {
+        pool->workers = (pthread_t *)calloc((size_t)threads - 1, sizeof(pthread_t));
+        if (!pool->workers) {
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+        for (int i = 0; i < threads - 1; ++i) {
+            if (pthread_create(&pool->workers[i], NULL, trabalhadora, pool) != 0) break;
+            pool->num_workers++;
+        }
+    }
+    return pool;
+}
+
+int thread_pool_size(const ThreadPool *pool) {
+    return pool ? pool->num_workers + 1 : 1;
+}
+
+void thread_pool_for(ThreadPool *pool, size_t count, ThreadPoolTask task, void *ctx) {
+    if (count == 0 || !task) return;
+
+    /* Sem trabalhadoras (ou lote unitario): executa direto */
+    if (!pool || pool->num_workers == 0 || count == 1) {
+        for (size_t i = 0; i < count; ++i) task(ctx, i);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->ctx = ctx;
+    pool->count = count;
+    pool->next = 0;
+    pool->active = pool->num_workers;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    /* a chamadora tambem trabalha */
+    executar_lote(pool, task, ctx, count);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_destroy(ThreadPool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_workers; ++i) pthread_join(pool->workers[i], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
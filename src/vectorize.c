@@ -0,0 +1,444 @@
+#include "vectorize.h"
+#include "heap_manager.h"
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define VEC_X86 1
+#include <immintrin.h>
+#endif
+
+/* ============================================================
+ * Reconhecimento
+ * ============================================================ */
+
+/* Instrucao normalizada (formas curtas e longas juntas) */
+enum {
+    P_OUTRA = 0, P_ILOAD, P_ALOAD, P_ISTORE, P_CONST, P_IALOAD, P_IASTORE,
+    P_IADD, P_ISUB, P_ARRAYLENGTH, P_IINC, P_GOTO, P_IF_ICMPGE, P_IF_ICMPLT
+};
+
+typedef struct {
+    u1 tipo;
+    u2 local;
+    int32_t k;                  /* constante, incremento do iinc */
+    u4 alvo;                    /* desvios */
+} Passo;
+
+static Passo normalizar(const CodeAttribute *code, const DisasmInsn *x) {
+    const u1 *ins = code->code + x->pc;
+    u1 op = x->opcode;
+    Passo p = { P_OUTRA, 0, 0, 0 };
+    if (op == 0x15 || op == 0x19 || op == 0x36) {
+        p.tipo = op == 0x15 ? P_ILOAD : op == 0x19 ? P_ALOAD : P_ISTORE;
+        p.local = ins[1];
+    } else if (op >= 0x1A && op <= 0x1D) {
+        p.tipo = P_ILOAD;
+        p.local = (u2)(op - 0x1A);
+    } else if (op >= 0x2A && op <= 0x2D) {
+        p.tipo = P_ALOAD;
+        p.local = (u2)(op - 0x2A);
+    } else if (op >= 0x3B && op <= 0x3E) {
+        p.tipo = P_ISTORE;
+        p.local = (u2)(op - 0x3B);
+    } else if (op >= 0x02 && op <= 0x08) {
+        p.tipo = P_CONST;
+        p.k = op - 0x03;
+    } else if (op == 0x10 || op == 0x11) {
+        p.tipo = P_CONST;
+        p.k = op == 0x10 ? (int8_t)ins[1] : (int16_t)((ins[1] << 8) | ins[2]);
+    } else if ((op == 0x12 || op == 0x13) && x->res_kind == DISASM_RES_INT) {
+        p.tipo = P_CONST;
+        p.k = x->res.i;
+    } else if (op == 0x84) {
+        p.tipo = P_IINC;
+        p.local = ins[1];
+        p.k = (int8_t)ins[2];
+    } else if (op == 0xA7 || op == 0xA2 || op == 0xA1) {
+        p.tipo = op == 0xA7 ? P_GOTO : op == 0xA2 ? P_IF_ICMPGE : P_IF_ICMPLT;
+        p.alvo = (u4)((int32_t)x->pc + (int16_t)((ins[1] << 8) | ins[2]));
+    } else {
+        switch (op) {
+            case 0x2E: p.tipo = P_IALOAD; break;
+            case 0x4F: p.tipo = P_IASTORE; break;
+            case 0x60: p.tipo = P_IADD; break;
+            case 0x64: p.tipo = P_ISUB; break;
+            case 0xBE: p.tipo = P_ARRAYLENGTH; break;
+            default: break;
+        }
+    }
+    return p;
+}
+
+/* Locais dos moldes: a primeira ocorrencia liga, as seguintes conferem */
+enum { V_NENHUMA = 0, V_I, V_ACC, V_D, V_A, V_B, V_VARS };
+
+typedef struct {
+    u1 tipo;
+    u1 var;
+} Molde;
+
+#define FIM { P_OUTRA, V_NENHUMA }
+
+static const Molde soma[] = { { P_ILOAD, V_ACC }, { P_ALOAD, V_A }, { P_ILOAD, V_I }, { P_IALOAD, 0 },
+                              { P_IADD, 0 }, { P_ISTORE, V_ACC }, FIM };
+static const Molde soma_trocada[] = { { P_ALOAD, V_A }, { P_ILOAD, V_I }, { P_IALOAD, 0 }, { P_ILOAD, V_ACC },
+                                      { P_IADD, 0 }, { P_ISTORE, V_ACC }, FIM };
+static const Molde somar_arrays[] = { { P_ALOAD, V_D }, { P_ILOAD, V_I }, { P_ALOAD, V_A }, { P_ILOAD, V_I },
+                                      { P_IALOAD, 0 }, { P_ALOAD, V_B }, { P_ILOAD, V_I }, { P_IALOAD, 0 },
+                                      { P_IADD, 0 }, { P_IASTORE, 0 }, FIM };
+static const Molde subtrair_arrays[] = { { P_ALOAD, V_D }, { P_ILOAD, V_I }, { P_ALOAD, V_A }, { P_ILOAD, V_I },
+                                         { P_IALOAD, 0 }, { P_ALOAD, V_B }, { P_ILOAD, V_I }, { P_IALOAD, 0 },
+                                         { P_ISUB, 0 }, { P_IASTORE, 0 }, FIM };
+static const Molde preencher_local[] = { { P_ALOAD, V_D }, { P_ILOAD, V_I }, { P_ILOAD, V_ACC },
+                                         { P_IASTORE, 0 }, FIM };
+static const Molde preencher_constante[] = { { P_ALOAD, V_D }, { P_ILOAD, V_I }, { P_CONST, 0 },
+                                             { P_IASTORE, 0 }, FIM };
+static const Molde copiar[] = { { P_ALOAD, V_D }, { P_ILOAD, V_I }, { P_ALOAD, V_A }, { P_ILOAD, V_I },
+                                { P_IALOAD, 0 }, { P_IASTORE, 0 }, FIM };
+
+static const struct {
+    const Molde *molde;
+    u1 kind;
+} idiomas[] = {
+    { soma, VEC_SUM }, { soma_trocada, VEC_SUM }, { somar_arrays, VEC_ADD }, { subtrair_arrays, VEC_SUB },
+    { preencher_local, VEC_FILL }, { preencher_constante, VEC_FILL }, { copiar, VEC_COPY },
+};
+
+/* Corpo p[0..n) no molde; vars[V_I] ja ligada. k: a constante do molde, se houver */
+static bool casar(const Passo *p, u4 n, const Molde *molde, int32_t *vars, int32_t *k) {
+    u4 j = 0;
+    for (; molde[j].tipo != P_OUTRA; j++) {
+        if (j >= n || p[j].tipo != molde[j].tipo) return false;
+        if (molde[j].tipo == P_CONST) *k = p[j].k;
+        u1 v = molde[j].var;
+        if (v == V_NENHUMA) continue;
+        if (vars[v] < 0) vars[v] = p[j].local;
+        else if (vars[v] != p[j].local) return false;
+    }
+    return j == n;
+}
+
+/* Teste iload i; <limite>; desvio em h[0..n) */
+static bool teste(const Passo *h, u4 n, u1 desvio, VecLoop *out) {
+    if (n < 3 || n > 4 || h[0].tipo != P_ILOAD || h[n - 1].tipo != desvio) return false;
+    out->index = h[0].local;
+    if (n == 4) {
+        if (h[1].tipo != P_ALOAD || h[2].tipo != P_ARRAYLENGTH) return false;
+        out->limit_kind = VEC_LIMIT_LENGTH;
+        out->limit = h[1].local;
+    } else if (h[1].tipo == P_ILOAD && h[1].local != out->index) {
+        out->limit_kind = VEC_LIMIT_LOCAL;
+        out->limit = h[1].local;
+    } else if (h[1].tipo == P_CONST) {
+        out->limit_kind = VEC_LIMIT_CONST;
+        out->limit_k = h[1].k;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/* Corpo p[0..n) (sem o iinc) num dos idiomas */
+static bool idioma(const Passo *p, u4 n, VecLoop *out) {
+    for (size_t d = 0; d < sizeof idiomas / sizeof idiomas[0]; d++) {
+        int32_t vars[V_VARS] = { -1, out->index, -1, -1, -1, -1 };
+        int32_t k = 0;
+        if (!casar(p, n, idiomas[d].molde, vars, &k)) continue;
+        out->kind = idiomas[d].kind;
+        out->acc = (u2)(vars[V_ACC] >= 0 ? vars[V_ACC] : 0);
+        out->dst = (u2)(vars[V_D] >= 0 ? vars[V_D] : 0);
+        out->src1 = (u2)(vars[V_A] >= 0 ? vars[V_A] : 0);
+        out->src2 = (u2)(vars[V_B] >= 0 ? vars[V_B] : 0);
+        out->value_const = out->kind == VEC_FILL && vars[V_ACC] < 0;
+        out->value_k = k;
+        /* o acumulador (ou o valor) nao pode ser o indice nem o limite */
+        if (vars[V_ACC] >= 0 && (vars[V_ACC] == out->index ||
+                                 (out->limit_kind == VEC_LIMIT_LOCAL && vars[V_ACC] == out->limit))) {
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Forma contada (peephole.h): um bloco so, com o teste no fim
+ *
+ *     corpo: <idioma>; iinc i 1; iload i; <limite>; if_icmplt corpo
+ *
+ * Quem entra pela frente ja passou pelo teste de cima (ou e um do-while:
+ * com i >= limite vec_run nao faz nada e o corpo roda uma vez).
+ */
+static bool reconhecer_contado(const CodeAttribute *code, const DisasmMethod *dm, const Cfg *cfg,
+                               const CfgLoop *laco, VecLoop *out) {
+    const CfgBlock *b = &cfg->blocks[laco->header];
+    if (laco->block_count != 1 || b->insn_count < 5 || b->insn_count > 19) return false;
+    Passo p[19];
+    for (u4 j = 0; j < b->insn_count; j++) p[j] = normalizar(code, &dm->insns[b->first_insn + j]);
+    for (u4 t = 3; t <= 4; t++) {
+        memset(out, 0, sizeof *out);
+        u4 n = b->insn_count - t - 1;
+        if (!teste(p + n + 1, t, P_IF_ICMPLT, out) || p[b->insn_count - 1].alvo != b->start_pc) continue;
+        if (p[n].tipo != P_IINC || p[n].local != out->index || p[n].k != 1) continue;
+        out->head_pc = b->start_pc;
+        out->exit_pc = b->end_pc;
+        return idioma(p, n, out);
+    }
+    return false;
+}
+
+static bool reconhecer(const CodeAttribute *code, const DisasmMethod *dm, const Cfg *cfg, const CfgLoop *laco,
+                       u4 nlaco, VecLoop *out) {
+    if (laco->block_count == 1) return reconhecer_contado(code, dm, cfg, laco, out);
+    const CfgBlock *cab = &cfg->blocks[laco->header];
+    if (laco->block_count != 2 || cab->insn_count < 3 || cab->insn_count > 4) return false;
+
+    /* cabecalho: iload i; limite; if_icmpge saida */
+    Passo h[4];
+    for (u4 j = 0; j < cab->insn_count; j++) h[j] = normalizar(code, &dm->insns[cab->first_insn + j]);
+    memset(out, 0, sizeof *out);
+    if (!teste(h, cab->insn_count, P_IF_ICMPGE, out)) return false;
+    out->head_pc = cab->start_pc;
+    out->exit_pc = h[cab->insn_count - 1].alvo;
+
+    /* corpo: um bloco so, alcancado so pelo cabecalho, terminando em iinc i 1; goto cabecalho */
+    u4 corpo = CFG_NONE;
+    for (u4 e = cab->succ_first; e < cab->succ_first + cab->succ_count; e++) {
+        const CfgEdge *a = &cfg->edges[e];
+        if (a->kind == CFG_EDGE_FALLTHROUGH) corpo = a->to;
+        else if (a->kind != CFG_EDGE_BRANCH || cfg->blocks[a->to].loop == nlaco) return false;
+    }
+    if (corpo == CFG_NONE || cfg->blocks[corpo].loop != nlaco || cfg->blocks[corpo].pred_count != 1) return false;
+    const CfgBlock *b = &cfg->blocks[corpo];
+    if (b->insn_count < 3 || b->insn_count > 16) return false;
+    Passo p[16];
+    for (u4 j = 0; j < b->insn_count; j++) p[j] = normalizar(code, &dm->insns[b->first_insn + j]);
+    u4 n = b->insn_count - 2;
+    if (p[n].tipo != P_IINC || p[n].local != out->index || p[n].k != 1 ||
+        p[n + 1].tipo != P_GOTO || p[n + 1].alvo != cab->start_pc) {
+        return false;
+    }
+    return idioma(p, n, out);
+}
+
+u4 vec_find_loops(const CodeAttribute *code, const DisasmMethod *dm, const Cfg *cfg, VecLoop *out, u4 cap) {
+    u4 n = 0;
+    if (cfg->irreducible) return 0;
+    for (u4 l = 0; l < cfg->loop_count && n < cap; l++) {
+        if (reconhecer(code, dm, cfg, &cfg->loops[l], l, &out[n])) n++;
+    }
+    /* em ordem de cabecalho (os lacos vem por aninhamento) */
+    for (u4 i = 1; i < n; i++) {
+        VecLoop v = out[i];
+        u4 j = i;
+        for (; j > 0 && out[j - 1].head_pc > v.head_pc; j--) out[j] = out[j - 1];
+        out[j] = v;
+    }
+    return n;
+}
+
+/* ============================================================
+ * Kernels (aritmetica do int do Java: sem sinal, modulo 2^32)
+ * ============================================================ */
+typedef struct {
+    u4 (*somar)(const u4 *a, u4 n);
+    void (*somar_arrays)(u4 *d, const u4 *a, const u4 *b, u4 n);
+    void (*subtrair_arrays)(u4 *d, const u4 *a, const u4 *b, u4 n);
+    void (*preencher)(u4 *d, u4 v, u4 n);
+} Kernels;
+
+static u4 somar_escalar(const u4 *a, u4 n) {
+    u4 s = 0;
+    for (u4 i = 0; i < n; i++) s += a[i];
+    return s;
+}
+
+static void somar_arrays_escalar(u4 *d, const u4 *a, const u4 *b, u4 n) {
+    for (u4 i = 0; i < n; i++) d[i] = a[i] + b[i];
+}
+
+static void subtrair_arrays_escalar(u4 *d, const u4 *a, const u4 *b, u4 n) {
+    for (u4 i = 0; i < n; i++) d[i] = a[i] - b[i];
+}
+
+static void preencher_escalar(u4 *d, u4 v, u4 n) {
+    for (u4 i = 0; i < n; i++) d[i] = v;
+}
+
+static const Kernels kernels_escalar = { somar_escalar, somar_arrays_escalar, subtrair_arrays_escalar,
+                                         preencher_escalar };
+
+#ifdef VEC_X86
+__attribute__((target("sse2"))) static u4 somar_sse2(const u4 *a, u4 n) {
+    __m128i s0 = _mm_setzero_si128(), s1 = s0;
+    u4 i = 0;
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm_add_epi32(s0, _mm_loadu_si128((const __m128i *)(a + i)));
+        s1 = _mm_add_epi32(s1, _mm_loadu_si128((const __m128i *)(a + i + 4)));
+    }
+    s0 = _mm_add_epi32(s0, s1);
+    s0 = _mm_add_epi32(s0, _mm_shuffle_epi32(s0, 0x4E));
+    s0 = _mm_add_epi32(s0, _mm_shuffle_epi32(s0, 0xB1));
+    u4 s = (u4)_mm_cvtsi128_si32(s0);
+    for (; i < n; i++) s += a[i];
+    return s;
+}
+
+__attribute__((target("sse2"))) static void somar_arrays_sse2(u4 *d, const u4 *a, const u4 *b, u4 n) {
+    u4 i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i)), y = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_add_epi32(x, y));
+    }
+    for (; i < n; i++) d[i] = a[i] + b[i];
+}
+
+__attribute__((target("sse2"))) static void subtrair_arrays_sse2(u4 *d, const u4 *a, const u4 *b, u4 n) {
+    u4 i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i)), y = _mm_loadu_si128((const __m128i *)(b + i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_sub_epi32(x, y));
+    }
+    for (; i < n; i++) d[i] = a[i] - b[i];
+}
+
+__attribute__((target("sse2"))) static void preencher_sse2(u4 *d, u4 v, u4 n) {
+    __m128i x = _mm_set1_epi32((int)v);
+    u4 i = 0;
+    for (; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i *)(d + i), x);
+    for (; i < n; i++) d[i] = v;
+}
+
+__attribute__((target("avx2"))) static u4 somar_avx2(const u4 *a, u4 n) {
+    __m256i s0 = _mm256_setzero_si256(), s1 = s0;
+    u4 i = 0;
+    for (; i + 16 <= n; i += 16) {
+        s0 = _mm256_add_epi32(s0, _mm256_loadu_si256((const __m256i *)(a + i)));
+        s1 = _mm256_add_epi32(s1, _mm256_loadu_si256((const __m256i *)(a + i + 8)));
+    }
+    s0 = _mm256_add_epi32(s0, s1);
+    __m128i q = _mm_add_epi32(_mm256_castsi256_si128(s0), _mm256_extracti128_si256(s0, 1));
+    q = _mm_add_epi32(q, _mm_shuffle_epi32(q, 0x4E));
+    q = _mm_add_epi32(q, _mm_shuffle_epi32(q, 0xB1));
+    u4 s = (u4)_mm_cvtsi128_si32(q);
+    for (; i < n; i++) s += a[i];
+    return s;
+}
+
+__attribute__((target("avx2"))) static void somar_arrays_avx2(u4 *d, const u4 *a, const u4 *b, u4 n) {
+    u4 i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i)), y = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(d + i), _mm256_add_epi32(x, y));
+    }
+    for (; i < n; i++) d[i] = a[i] + b[i];
+}
+
+__attribute__((target("avx2"))) static void subtrair_arrays_avx2(u4 *d, const u4 *a, const u4 *b, u4 n) {
+    u4 i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i)), y = _mm256_loadu_si256((const __m256i *)(b + i));
+        _mm256_storeu_si256((__m256i *)(d + i), _mm256_sub_epi32(x, y));
+    }
+    for (; i < n; i++) d[i] = a[i] - b[i];
+}
+
+__attribute__((target("avx2"))) static void preencher_avx2(u4 *d, u4 v, u4 n) {
+    __m256i x = _mm256_set1_epi32((int)v);
+    u4 i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_si256((__m256i *)(d + i), x);
+    for (; i < n; i++) d[i] = v;
+}
+
+static const Kernels kernels_sse2 = { somar_sse2, somar_arrays_sse2, subtrair_arrays_sse2, preencher_sse2 };
+static const Kernels kernels_avx2 = { somar_avx2, somar_arrays_avx2, subtrair_arrays_avx2, preencher_avx2 };
+#endif
+
+static VecIsa limite = VEC_ISA_AUTO;
+static VecIsa escolhido = VEC_ISA_AUTO;
+static const Kernels *kernels = &kernels_escalar;
+
+void vec_configure(VecIsa max) {
+    limite = max;
+    escolhido = VEC_ISA_AUTO;
+}
+
+VecIsa vec_isa(void) {
+    if (escolhido != VEC_ISA_AUTO) return escolhido;
+    VecIsa isa = VEC_ISA_SCALAR;
+    kernels = &kernels_escalar;
+#ifdef VEC_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && (limite == VEC_ISA_AUTO || limite >= VEC_ISA_AVX2)) {
+        isa = VEC_ISA_AVX2;
+        kernels = &kernels_avx2;
+    } else if (__builtin_cpu_supports("sse2") && (limite == VEC_ISA_AUTO || limite >= VEC_ISA_SSE2)) {
+        isa = VEC_ISA_SSE2;
+        kernels = &kernels_sse2;
+    }
+#endif
+    escolhido = isa;
+    return isa;
+}
+
+const char *vec_isa_name(VecIsa isa) {
+    switch (isa) {
+        case VEC_ISA_AVX2: return "avx2";
+        case VEC_ISA_SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+/* ============================================================
+ * Execucao
+ * ============================================================ */
+
+/* Array da local com pelo menos fim elementos; NULL se nulo ou curto */
+static Array *array_ate(const Slot *locals, u2 local, u4 fim) {
+    Array *a = (Array *)(void *)jvm_heap_deref(locals[local]);
+    return a && a->length >= fim ? a : NULL;
+}
+
+bool vec_run(const VecLoop *l, Slot *locals) {
+    int32_t inicio = (int32_t)locals[l->index], fim;
+    if (l->limit_kind == VEC_LIMIT_LOCAL) {
+        fim = (int32_t)locals[l->limit];
+    } else if (l->limit_kind == VEC_LIMIT_CONST) {
+        fim = l->limit_k;
+    } else {
+        const Array *a = (const Array *)(void *)jvm_heap_deref(locals[l->limit]);
+        if (!a) return false;
+        fim = (int32_t)a->length;
+    }
+    if (inicio < 0 || inicio >= fim) return false;
+
+    u4 n = (u4)(fim - inicio);
+    Array *d = NULL, *a = NULL, *b = NULL;
+    switch (l->kind) {
+        case VEC_SUM:
+            if (!(a = array_ate(locals, l->src1, (u4)fim))) return false;
+            break;
+        case VEC_ADD: case VEC_SUB:
+            if (!(b = array_ate(locals, l->src2, (u4)fim))) return false;
+            /* fall through */
+        case VEC_COPY:
+            if (!(a = array_ate(locals, l->src1, (u4)fim))) return false;
+            /* fall through */
+        default:
+            if (!(d = array_ate(locals, l->dst, (u4)fim))) return false;
+            break;
+    }
+
+    vec_isa();
+    switch (l->kind) {
+        case VEC_SUM: locals[l->acc] += kernels->somar(a->data + inicio, n); break;
+        case VEC_ADD: kernels->somar_arrays(d->data + inicio, a->data + inicio, b->data + inicio, n); break;
+        case VEC_SUB: kernels->subtrair_arrays(d->data + inicio, a->data + inicio, b->data + inicio, n); break;
+        case VEC_FILL:
+            kernels->preencher(d->data + inicio, l->value_const ? (u4)l->value_k : locals[l->acc], n);
+            break;
+        default: memmove(d->data + inicio, a->data + inicio, n * sizeof(u4)); break;
+    }
+    locals[l->index] = (Slot)fim;
+    return true;
+}
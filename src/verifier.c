@@ -0,0 +1,873 @@
+#include "verifier.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ACC_STATIC 0x0008
+
+/* Teto de memoria para os estados (instrucoes x slots) de um metodo */
+#define LIMITE_ESTADOS (64u << 20)
+
+/* Tipos de verificacao. long/double ocupam dois slots: T_LONG/T_DOUBLE + T_METADE. */
+enum {
+    T_TOP = 0,
+    T_INT,
+    T_FLOAT,
+    T_LONG,
+    T_DOUBLE,
+    T_REF,
+    T_METADE
+};
+
+typedef struct {
+    const ClassFile *cf;
+    const CodeAttribute *code;
+    u2 nlocals, nstack;
+    size_t largura;         /* nlocals + nstack */
+    char retorno;           /* tipo de retorno do descritor ('V', 'I', 'A'...) */
+
+    u4 ninsns;
+    u4 *insn_de;            /* pc -> indice + 1 (0 = meio de instrucao) */
+    u4 *pc_de;              /* indice -> pc */
+    u1 *estados;            /* ninsns * largura: locais, depois pilha */
+    u2 *sp;                 /* profundidade da pilha no inicio de cada instrucao */
+    u1 *alcancado;
+    u1 *declarado;          /* 1: estado fixo, vindo do StackMapTable */
+    u1 *na_fila;
+    u4 *fila;
+    u4 nfila;
+
+    VerifyError *err;
+} Verificador;
+
+/* Estado de trabalho da instrucao sendo simulada */
+typedef struct {
+    u1 *loc;
+    u1 *pilha;
+    u2 sp;
+} Estado;
+
+#define TENTAR(x) do { Status _st = (x); if (_st != OK) return _st; } while (0)
+
+static Status falhar(Verificador *v, u4 pc, const char *fmt, ...) {
+    if (v->err) {
+        va_list ap;
+        va_start(ap, fmt);
+        v->err->pc = pc;
+        vsnprintf(v->err->message, sizeof v->err->message, fmt, ap);
+        va_end(ap);
+    }
+    return ERR_BOUNDS;
+}
+
+static int16_t be16(const u1 *p) { return (int16_t)((p[0] << 8) | p[1]); }
+static u2 be16u(const u1 *p) { return (u2)((p[0] << 8) | p[1]); }
+static int32_t be32(const u1 *p) {
+    return (int32_t)(((u4)p[0] << 24) | ((u4)p[1] << 16) | ((u4)p[2] << 8) | (u4)p[3]);
+}
+
+static int categoria2(u1 t) { return t == T_LONG || t == T_DOUBLE; }
+
+/* ============================================================
+ * Decodificacao: tamanho de cada instrucao
+ * ============================================================ */
+
+/* Tamanho fixo por opcode; 0 = variavel (switch/wide) ou invalido */
+static u4 tamanho_fixo(u1 op) {
+    if (op <= 0x0F) return 1;
+    if (op == 0x10 || op == 0x12) return 2;
+    if (op == 0x11 || op == 0x13 || op == 0x14) return 3;
+    if (op >= 0x15 && op <= 0x19) return 2;
+    if (op >= 0x1A && op <= 0x35) return 1;
+    if (op >= 0x36 && op <= 0x3A) return 2;
+    if (op >= 0x3B && op <= 0x83) return 1;
+    if (op == 0x84) return 3;
+    if (op >= 0x85 && op <= 0x98) return 1;
+    if (op >= 0x99 && op <= 0xA8) return 3;
+    if (op == 0xA9) return 2;
+    if (op >= 0xAC && op <= 0xB1) return 1;
+    if (op >= 0xB2 && op <= 0xB8) return 3;
+    switch (op) {
+    case 0xB9: case 0xBA: case 0xC8: case 0xC9: return 5;
+    case 0xBB: case 0xBD: case 0xC0: case 0xC1: case 0xC6: case 0xC7: return 3;
+    case 0xBC: return 2;
+    case 0xBE: case 0xBF: case 0xC2: case 0xC3: return 1;
+    case 0xC5: return 4;
+    default: return 0;
+    }
+}
+
+/* Tamanho da instrucao em pc (0 se invalida ou truncada) */
+static u4 tamanho_instrucao(const u1 *code, u4 len, u4 pc) {
+    u1 op = code[pc];
+    u4 n = tamanho_fixo(op);
+    if (n) return pc + n <= len ? n : 0;
+
+    if (op == 0xAA || op == 0xAB) {
+        /* padding ate multiplo de 4, relativo ao inicio do codigo */
+        u4 base = (pc + 4) & ~3u;
+        if (base + 12 > len) return 0;
+        if (op == 0xAA) {
+            int32_t low = be32(code + base + 4), high = be32(code + base + 8);
+            if (high < low) return 0;
+            u4 casos = (u4)((int64_t)high - low + 1);
+            if (casos > (len - base - 12) / 4) return 0;
+            return base + 12 + 4 * casos - pc;
+        }
+        int32_t pares = be32(code + base + 4);
+        if (pares < 0 || (u4)pares > (len - base - 8) / 8) return 0;
+        return base + 8 + 8 * (u4)pares - pc;
+    }
+    if (op == 0xC4 && pc + 1 < len) {
+        u1 alvo = code[pc + 1];
+        if (alvo == 0x84) n = 6;
+        else if ((alvo >= 0x15 && alvo <= 0x19) || (alvo >= 0x36 && alvo <= 0x3A) || alvo == 0xA9) n = 4;
+        return n && pc + n <= len ? n : 0;
+    }
+    return 0;
+}
+
+/* ============================================================
+ * Descritores
+ * ============================================================ */
+
+/* Tipo do proximo componente de um descritor (avanca *p); -1 se malformado */
+static int tipo_descritor(const char **p) {
+    const char *s = *p;
+    int dims = 0;
+    while (*s == '[') { s++; dims++; }
+    int t;
+    switch (*s) {
+    case 'B': case 'C': case 'I': case 'S': case 'Z': t = T_INT; break;
+    case 'F': t = T_FLOAT; break;
+    case 'J': t = T_LONG; break;
+    case 'D': t = T_DOUBLE; break;
+    case 'L':
+        while (*s && *s != ';') s++;
+        if (*s != ';') return -1;
+        t = T_REF;
+        break;
+    default: return -1;
+    }
+    *p = s + 1;
+    return dims ? T_REF : t;
+}
+
+/* Tipos dos argumentos de "(...)R" em tipos[] (ate max); retorna quantos ou -1 */
+static int tipos_argumentos(const char *desc, u1 *tipos, int max, char *retorno) {
+    if (!desc || *desc != '(') return -1;
+    const char *p = desc + 1;
+    int n = 0;
+    while (*p && *p != ')') {
+        int t = tipo_descritor(&p);
+        if (t < 0 || n == max) return -1;
+        tipos[n++] = (u1)t;
+    }
+    if (*p != ')') return -1;
+    p++;
+    if (*p == 'V' && p[1] == '\0') {
+        *retorno = 'V';
+        return n;
+    }
+    int t = tipo_descritor(&p);
+    if (t < 0 || *p) return -1;
+    *retorno = (char)"?IFJDA"[t];
+    return n;
+}
+
+static u1 tipo_da_letra(char c) {
+    switch (c) {
+    case 'I': return T_INT;
+    case 'F': return T_FLOAT;
+    case 'J': return T_LONG;
+    case 'D': return T_DOUBLE;
+    default: return T_REF;
+    }
+}
+
+/* ============================================================
+ * Pilha e locais
+ * ============================================================ */
+static Status empilhar(Verificador *v, u4 pc, Estado *s, u1 t) {
+    u2 n = categoria2(t) ? 2 : 1;
+    if ((u4)s->sp + n > v->nstack) return falhar(v, pc, "pilha excede max_stack=%u", v->nstack);
+    s->pilha[s->sp++] = t;
+    if (n == 2) s->pilha[s->sp++] = T_METADE;
+    return OK;
+}
+
+static const char *nome_tipo(u1 t) {
+    static const char *nomes[] = { "top", "int", "float", "long", "double", "referencia", "metade de long/double" };
+    return t <= T_METADE ? nomes[t] : "?";
+}
+
+static Status desempilhar(Verificador *v, u4 pc, Estado *s, u1 t) {
+    if (categoria2(t)) {
+        if (s->sp < 2 || s->pilha[s->sp - 1] != T_METADE || s->pilha[s->sp - 2] != t) {
+            return falhar(v, pc, "esperado %s no topo da pilha", nome_tipo(t));
+        }
+        s->sp -= 2;
+        return OK;
+    }
+    if (s->sp < 1) return falhar(v, pc, "pilha vazia (esperado %s)", nome_tipo(t));
+    if (s->pilha[s->sp - 1] != t) {
+        return falhar(v, pc, "esperado %s no topo da pilha, encontrado %s", nome_tipo(t),
+                      nome_tipo(s->pilha[s->sp - 1]));
+    }
+    s->sp--;
+    return OK;
+}
+
+static Status carregar_local(Verificador *v, u4 pc, Estado *s, u4 idx, u1 t) {
+    u4 n = categoria2(t) ? 2 : 1;
+    if (idx + n > v->nlocals) return falhar(v, pc, "local %u fora de max_locals=%u", idx, v->nlocals);
+    if (s->loc[idx] != t || (n == 2 && s->loc[idx + 1] != T_METADE)) {
+        return falhar(v, pc, "local %u nao contem %s", idx, nome_tipo(t));
+    }
+    return empilhar(v, pc, s, t);
+}
+
+static Status gravar_local(Verificador *v, u4 pc, Estado *s, u4 idx, u1 t) {
+    u4 n = categoria2(t) ? 2 : 1;
+    if (idx + n > v->nlocals) return falhar(v, pc, "local %u fora de max_locals=%u", idx, v->nlocals);
+    TENTAR(desempilhar(v, pc, s, t));
+    /* sobrescrever a 2a metade de um long/double invalida a 1a */
+    if (idx > 0 && categoria2(s->loc[idx - 1])) s->loc[idx - 1] = T_TOP;
+    s->loc[idx] = t;
+    if (n == 2) s->loc[idx + 1] = T_METADE;
+    return OK;
+}
+
+/*
+ * Familia dup/pop/swap: opera em slots crus. Um corte na posicao p (entre
+ * pilha[p-1] e pilha[p]) so e valido se nao separa as metades de um
+ * long/double, isto e, pilha[p] != T_METADE.
+ */
+static int corte_valido(const Estado *s, u2 profundidade) {
+    return profundidade <= s->sp && (profundidade == 0 || s->pilha[s->sp - profundidade] != T_METADE);
+}
+
+/* Copia os 'n' slots do topo para baixo de 'abaixo' slots (dup, dup_x1, dup2_x2...) */
+static Status duplicar(Verificador *v, u4 pc, Estado *s, u2 n, u2 abaixo) {
+    if (!corte_valido(s, n) || !corte_valido(s, (u2)(n + abaixo))) {
+        return falhar(v, pc, "dup/pop sobre pilha incompativel");
+    }
+    if ((u4)s->sp + n > v->nstack) return falhar(v, pc, "pilha excede max_stack=%u", v->nstack);
+    u1 topo[2];
+    memcpy(topo, s->pilha + s->sp - n, n);
+    memmove(s->pilha + s->sp - n - abaixo + n, s->pilha + s->sp - n - abaixo, (size_t)(n + abaixo));
+    memcpy(s->pilha + s->sp - n - abaixo, topo, n);
+    s->sp = (u2)(s->sp + n);
+    return OK;
+}
+
+/* ============================================================
+ * Estados nas instrucoes (merge / StackMapTable)
+ * ============================================================ */
+static u1 *estado_de(Verificador *v, u4 i) {
+    return v->estados + (size_t)i * v->largura;
+}
+
+static void enfileirar(Verificador *v, u4 i) {
+    if (v->na_fila[i]) return;
+    v->na_fila[i] = 1;
+    v->fila[v->nfila++] = i;
+}
+
+/* Estado s chega em alvo (salto, queda ou handler) */
+static Status fluir(Verificador *v, u4 pc, const Estado *s, u4 alvo) {
+    if (alvo >= v->code->code_length || !v->insn_de[alvo]) {
+        return falhar(v, pc, "alvo %u nao e inicio de instrucao", alvo);
+    }
+    u4 i = v->insn_de[alvo] - 1;
+    u1 *dst = estado_de(v, i);
+    u1 *dst_pilha = dst + v->nlocals;
+
+    if (v->declarado[i]) {
+        /* o estado inferido precisa ser atribuivel ao quadro declarado */
+        if (v->sp[i] != s->sp) return falhar(v, pc, "profundidade %u difere do StackMapTable em %u", s->sp, alvo);
+        for (u2 k = 0; k < v->nlocals; k++) {
+            if (dst[k] != T_TOP && dst[k] != s->loc[k]) {
+                return falhar(v, pc, "local %u (%s) incompativel com o StackMapTable em %u", k,
+                              nome_tipo(s->loc[k]), alvo);
+            }
+        }
+        for (u2 k = 0; k < s->sp; k++) {
+            if (dst_pilha[k] != T_TOP && dst_pilha[k] != s->pilha[k]) {
+                return falhar(v, pc, "pilha incompativel com o StackMapTable em %u", alvo);
+            }
+        }
+        if (!v->alcancado[i]) {
+            v->alcancado[i] = 1;
+            enfileirar(v, i);
+        }
+        return OK;
+    }
+
+    if (!v->alcancado[i]) {
+        memcpy(dst, s->loc, v->nlocals);
+        memcpy(dst_pilha, s->pilha, s->sp);
+        v->sp[i] = s->sp;
+        v->alcancado[i] = 1;
+        enfileirar(v, i);
+        return OK;
+    }
+
+    if (v->sp[i] != s->sp) return falhar(v, pc, "profundidade da pilha difere em %u (%u x %u)", alvo, v->sp[i], s->sp);
+    for (u2 k = 0; k < s->sp; k++) {
+        if (dst_pilha[k] != s->pilha[k]) return falhar(v, pc, "tipos da pilha diferem em %u", alvo);
+    }
+    int mudou = 0;
+    for (u2 k = 0; k < v->nlocals; k++) {
+        if (dst[k] != s->loc[k] && dst[k] != T_TOP) {
+            dst[k] = T_TOP;
+            mudou = 1;
+        }
+    }
+    if (mudou) enfileirar(v, i);
+    return OK;
+}
+
+/* Locais correntes chegam aos handlers que cobrem pc (pilha = [excecao]) */
+static Status fluir_handlers(Verificador *v, u4 pc, const Estado *s, u1 *pilha_excecao) {
+    for (u2 h = 0; h < v->code->exception_table_length; h++) {
+        const ExceptionTableEntry *e = &v->code->exception_table[h];
+        if (pc < e->start_pc || pc >= e->end_pc) continue;
+        if (v->nstack < 1) return falhar(v, pc, "handler exige max_stack >= 1");
+        Estado he = { s->loc, pilha_excecao, 1 };
+        pilha_excecao[0] = T_REF;
+        TENTAR(fluir(v, pc, &he, e->handler_pc));
+    }
+    return OK;
+}
+
+/* Expande uma lista de tipos (long/double = 1 entrada) em slots */
+static int expandir(const u1 *lista, u2 n, u1 *slots, u2 max) {
+    u2 k = 0;
+    for (u2 i = 0; i < n; i++) {
+        if (k >= max) return -1;
+        slots[k++] = lista[i];
+        if (categoria2(lista[i])) {
+            if (k >= max) return -1;
+            slots[k++] = T_METADE;
+        }
+    }
+    return k;
+}
+
+/* Tipo de verificacao de um verification_type_info (avanca *p); -1 se invalido */
+static int ler_vti(const Verificador *v, const u1 **p, const u1 *fim) {
+    if (*p >= fim) return -1;
+    u1 tag = *(*p)++;
+    switch (tag) {
+    case 0: return T_TOP;
+    case 1: return T_INT;
+    case 2: return T_FLOAT;
+    case 3: return T_DOUBLE;
+    case 4: return T_LONG;
+    case 5: case 6: return T_REF;   /* null, uninitializedThis */
+    case 7: case 8:                 /* Object(cpool_index), Uninitialized(offset) */
+        if (fim - *p < 2) return -1;
+        if (tag == 8 && be16u(*p) >= v->code->code_length) return -1;
+        *p += 2;
+        return T_REF;
+    default: return -1;
+    }
+}
+
+static Status aplicar_stack_map(Verificador *v, const u1 *lista_inicial, u2 n_inicial) {
+    const AttributeInfo *smt = NULL;
+    for (u2 a = 0; a < v->code->attributes_count; a++) {
+        const char *nome = cp_utf8(v->cf->constant_pool, v->cf->constant_pool_count,
+                                   v->code->attributes[a].attribute_name_index);
+        if (strcmp(nome, "StackMapTable") == 0) smt = &v->code->attributes[a];
+    }
+    if (!smt || smt->attribute_length < 2 || !smt->info) return OK;
+
+    /* locais do quadro corrente como lista de tipos (long/double = 1 entrada) */
+    u1 *locais = (u1 *)malloc((size_t)v->nlocals + 1);
+    u1 *pilha = (u1 *)malloc(2 * (size_t)v->nstack + 2);
+    if (!locais || !pilha) {
+        free(locais);
+        free(pilha);
+        return ERR_MEMORY;
+    }
+    memcpy(locais, lista_inicial, n_inicial);
+    u2 nloc = n_inicial;
+
+    const u1 *p = smt->info + 2, *fim = smt->info + smt->attribute_length;
+    u2 quadros = be16u(smt->info);
+    long pc = -1;
+    Status st = OK;
+    for (u2 q = 0; q < quadros && st == OK; q++) {
+        if (p >= fim) { st = falhar(v, 0, "StackMapTable truncado"); break; }
+        u1 tipo = *p++;
+        u4 delta;
+        u2 npilha = 0;
+        if (tipo <= 63) {
+            delta = tipo;
+        } else if (tipo <= 127) {
+            delta = tipo - 64u;
+            int t = ler_vti(v, &p, fim);
+            if (t < 0) { st = falhar(v, 0, "StackMapTable: tipo invalido"); break; }
+            pilha[npilha++] = (u1)t;
+        } else if (tipo < 247) {
+            st = falhar(v, 0, "StackMapTable: tipo de quadro %u reservado", tipo);
+            break;
+        } else {
+            if (fim - p < 2) { st = falhar(v, 0, "StackMapTable truncado"); break; }
+            delta = be16u(p);
+            p += 2;
+            if (tipo == 247) {
+                int t = ler_vti(v, &p, fim);
+                if (t < 0) { st = falhar(v, 0, "StackMapTable: tipo invalido"); break; }
+                pilha[npilha++] = (u1)t;
+            } else if (tipo <= 250) {
+                u2 k = (u2)(251 - tipo);
+                if (k > nloc) { st = falhar(v, 0, "StackMapTable: chop alem dos locais"); break; }
+                nloc = (u2)(nloc - k);
+            } else if (tipo >= 252 && tipo <= 254) {
+                for (u2 k = 0; k < tipo - 251u && st == OK; k++) {
+                    int t = ler_vti(v, &p, fim);
+                    if (t < 0 || nloc >= v->nlocals) st = falhar(v, 0, "StackMapTable: append invalido");
+                    else locais[nloc++] = (u1)t;
+                }
+            } else if (tipo == 255) {
+                if (fim - p < 2) { st = falhar(v, 0, "StackMapTable truncado"); break; }
+                u2 n = be16u(p);
+                p += 2;
+                if (n > v->nlocals) { st = falhar(v, 0, "StackMapTable: locais demais"); break; }
+                nloc = 0;
+                for (u2 k = 0; k < n && st == OK; k++) {
+                    int t = ler_vti(v, &p, fim);
+                    if (t < 0) st = falhar(v, 0, "StackMapTable: tipo invalido");
+                    else locais[nloc++] = (u1)t;
+                }
+                if (st != OK) break;
+                if (fim - p < 2) { st = falhar(v, 0, "StackMapTable truncado"); break; }
+                n = be16u(p);
+                p += 2;
+                if (n > v->nstack) { st = falhar(v, 0, "StackMapTable: pilha demais"); break; }
+                for (u2 k = 0; k < n && st == OK; k++) {
+                    int t = ler_vti(v, &p, fim);
+                    if (t < 0) st = falhar(v, 0, "StackMapTable: tipo invalido");
+                    else pilha[npilha++] = (u1)t;
+                }
+                if (st != OK) break;
+            }
+        }
+        if (st != OK) break;
+
+        pc = pc < 0 ? (long)delta : pc + (long)delta + 1;
+        if (pc >= (long)v->code->code_length || !v->insn_de[pc]) {
+            st = falhar(v, (u4)(pc < 0 ? 0 : pc), "StackMapTable: quadro fora do inicio de instrucao");
+            break;
+        }
+        u4 i = v->insn_de[pc] - 1;
+        u1 *dst = estado_de(v, i);
+        memset(dst, T_TOP, v->largura);
+        int nl = expandir(locais, nloc, dst, v->nlocals);
+        int ns = expandir(pilha, npilha, dst + v->nlocals, v->nstack);
+        if (nl < 0 || ns < 0) {
+            st = falhar(v, (u4)pc, "StackMapTable: quadro excede max_locals/max_stack");
+            break;
+        }
+        v->sp[i] = (u2)ns;
+        v->declarado[i] = 1;
+    }
+
+    free(locais);
+    free(pilha);
+    return st;
+}
+
+/* ============================================================
+ * Simulacao de uma instrucao
+ * ============================================================ */
+
+/*
+ * Efeito de instrucoes sem operandos de CP/locais: "consome>produz", do
+ * mais fundo para o topo (I int, F float, J long, D double, A referencia).
+ */
+static const char *efeito_simples(u1 op) {
+    static const char *aritmetica[] = { "II>I", "JJ>J", "FF>F", "DD>D" };
+    static const char *negacao[] = { "I>I", "J>J", "F>F", "D>D" };
+    static const char *conversao[] = {
+        "I>J", "I>F", "I>D", "J>I", "J>F", "J>D", "F>I", "F>J", "F>D", "D>I", "D>J", "D>F", "I>I", "I>I", "I>I"
+    };
+    static const char *vetor_ler[] = { "AI>I", "AI>J", "AI>F", "AI>D", "AI>A", "AI>I", "AI>I", "AI>I" };
+    static const char *vetor_gravar[] = { "AII>", "AIJ>", "AIF>", "AID>", "AIA>", "AII>", "AII>", "AII>" };
+
+    if (op == 0x00) return ">";
+    if (op == 0x01) return ">A";
+    if (op >= 0x02 && op <= 0x08) return ">I";
+    if (op == 0x09 || op == 0x0A) return ">J";
+    if (op >= 0x0B && op <= 0x0D) return ">F";
+    if (op == 0x0E || op == 0x0F) return ">D";
+    if (op == 0x10 || op == 0x11) return ">I";
+    if (op >= 0x2E && op <= 0x35) return vetor_ler[op - 0x2E];
+    if (op >= 0x4F && op <= 0x56) return vetor_gravar[op - 0x4F];
+    if (op >= 0x60 && op <= 0x73) return aritmetica[(op - 0x60) % 4];
+    if (op >= 0x74 && op <= 0x77) return negacao[op - 0x74];
+    if (op >= 0x78 && op <= 0x7D) return (op % 2 == 0) ? "II>I" : "JI>J";   /* shl/shr/ushr */
+    if (op >= 0x7E && op <= 0x83) return (op % 2 == 0) ? "II>I" : "JJ>J";   /* and/or/xor */
+    if (op >= 0x85 && op <= 0x93) return conversao[op - 0x85];
+    if (op == 0x94) return "JJ>I";
+    if (op == 0x95 || op == 0x96) return "FF>I";
+    if (op == 0x97 || op == 0x98) return "DD>I";
+    if (op == 0xBE) return "A>I";   /* arraylength */
+    if (op == 0xC2 || op == 0xC3) return "A>";  /* monitorenter/exit */
+    return NULL;
+}
+
+static Status aplicar_efeito(Verificador *v, u4 pc, Estado *s, const char *efeito) {
+    const char *seta = strchr(efeito, '>');
+    for (const char *c = seta; c > efeito; ) {
+        c--;
+        TENTAR(desempilhar(v, pc, s, tipo_da_letra(*c)));
+    }
+    for (const char *c = seta + 1; *c; c++) TENTAR(empilhar(v, pc, s, tipo_da_letra(*c)));
+    return OK;
+}
+
+static Status exigir_tag(Verificador *v, u4 pc, u2 idx, u1 tag1, u1 tag2) {
+    if (idx == 0 || idx >= v->cf->constant_pool_count) return falhar(v, pc, "indice de CP #%u invalido", idx);
+    u1 tag = v->cf->constant_pool[idx].tag;
+    if (tag != tag1 && tag != tag2) return falhar(v, pc, "CP #%u com tag %u inesperada", idx, tag);
+    return OK;
+}
+
+static Status verificar_ldc(Verificador *v, u4 pc, Estado *s, u2 idx, int largo) {
+    if (idx == 0 || idx >= v->cf->constant_pool_count) return falhar(v, pc, "ldc com indice #%u invalido", idx);
+    const CpInfo *c = &v->cf->constant_pool[idx];
+    switch (c->tag) {
+    case CONSTANT_Integer: if (!largo) return empilhar(v, pc, s, T_INT); break;
+    case CONSTANT_Float: if (!largo) return empilhar(v, pc, s, T_FLOAT); break;
+    case CONSTANT_Long: if (largo) return empilhar(v, pc, s, T_LONG); break;
+    case CONSTANT_Double: if (largo) return empilhar(v, pc, s, T_DOUBLE); break;
+    case CONSTANT_String: case CONSTANT_Class: case CONSTANT_MethodType: case CONSTANT_MethodHandle:
+        if (!largo) return empilhar(v, pc, s, T_REF);
+        break;
+    case CONSTANT_Dynamic: {
+        u2 nat = c->InvokeDynamic.name_and_type_index;
+        if (nat == 0 || nat >= v->cf->constant_pool_count) break;
+        const char *d = cp_utf8(v->cf->constant_pool, v->cf->constant_pool_count,
+                                v->cf->constant_pool[nat].NameAndType.descriptor_index);
+        int t = tipo_descritor(&d);
+        if (t >= 0 && categoria2((u1)t) == (largo != 0)) return empilhar(v, pc, s, (u1)t);
+    } break;
+    default: break;
+    }
+    return falhar(v, pc, "ldc de constante incompativel (#%u)", idx);
+}
+
+static Status verificar_campo(Verificador *v, u4 pc, Estado *s, u1 op, u2 idx) {
+    TENTAR(exigir_tag(v, pc, idx, CONSTANT_Fieldref, CONSTANT_Fieldref));
+    const char *cls, *nome, *desc;
+    cp_referencia_metodo(v->cf->constant_pool, v->cf->constant_pool_count, idx, &cls, &nome, &desc);
+    const char *p = desc;
+    int t = tipo_descritor(&p);
+    if (t < 0 || *p) return falhar(v, pc, "descritor de campo invalido '%s'", desc);
+
+    switch (op) {
+    case 0xB2: return empilhar(v, pc, s, (u1)t);
+    case 0xB3: return desempilhar(v, pc, s, (u1)t);
+    case 0xB4:
+        TENTAR(desempilhar(v, pc, s, T_REF));
+        return empilhar(v, pc, s, (u1)t);
+    default:
+        TENTAR(desempilhar(v, pc, s, (u1)t));
+        return desempilhar(v, pc, s, T_REF);
+    }
+}
+
+static Status verificar_invocacao(Verificador *v, u4 pc, Estado *s, u1 op, const u1 *ins) {
+    u2 idx = be16u(ins + 1);
+    const char *nome, *desc;
+    if (op == 0xBA) {
+        TENTAR(exigir_tag(v, pc, idx, CONSTANT_InvokeDynamic, CONSTANT_InvokeDynamic));
+        if (ins[3] || ins[4]) return falhar(v, pc, "invokedynamic com bytes reservados nao nulos");
+        u2 nat = v->cf->constant_pool[idx].InvokeDynamic.name_and_type_index;
+        if (nat == 0 || nat >= v->cf->constant_pool_count) return falhar(v, pc, "invokedynamic sem NameAndType");
+        nome = cp_utf8(v->cf->constant_pool, v->cf->constant_pool_count, v->cf->constant_pool[nat].NameAndType.name_index);
+        desc = cp_utf8(v->cf->constant_pool, v->cf->constant_pool_count, v->cf->constant_pool[nat].NameAndType.descriptor_index);
+    } else {
+        if (op == 0xB9) {
+            TENTAR(exigir_tag(v, pc, idx, CONSTANT_InterfaceMethodref, CONSTANT_InterfaceMethodref));
+            if (ins[3] == 0 || ins[4] != 0) return falhar(v, pc, "invokeinterface com count/zero invalidos");
+        } else if (op == 0xB6) {
+            TENTAR(exigir_tag(v, pc, idx, CONSTANT_Methodref, CONSTANT_Methodref));
+        } else {
+            TENTAR(exigir_tag(v, pc, idx, CONSTANT_Methodref, CONSTANT_InterfaceMethodref));
+        }
+        const char *cls;
+        cp_referencia_metodo(v->cf->constant_pool, v->cf->constant_pool_count, idx, &cls, &nome, &desc);
+    }
+
+    if (nome[0] == '<' && (op != 0xB7 || strcmp(nome, "<init>") != 0)) {
+        return falhar(v, pc, "%s so pode ser chamado por invokespecial", nome);
+    }
+
+    u1 args[255];
+    char retorno;
+    int n = tipos_argumentos(desc, args, 255, &retorno);
+    if (n < 0) return falhar(v, pc, "descritor de metodo invalido '%s'", desc);
+    if (strcmp(nome, "<init>") == 0 && retorno != 'V') return falhar(v, pc, "<init> deve retornar void");
+
+    for (int k = n; k-- > 0; ) TENTAR(desempilhar(v, pc, s, args[k]));
+    if (op != 0xB8 && op != 0xBA) TENTAR(desempilhar(v, pc, s, T_REF));
+    if (retorno != 'V') TENTAR(empilhar(v, pc, s, tipo_da_letra(retorno)));
+    return OK;
+}
+
+static Status verificar_retorno(Verificador *v, u4 pc, Estado *s, u1 op) {
+    static const char esperado[] = { 'I', 'J', 'F', 'D', 'A', 'V' };
+    char r = esperado[op - 0xAC];
+    if (r != v->retorno) return falhar(v, pc, "instrucao de retorno nao bate com o descritor");
+    return r == 'V' ? OK : desempilhar(v, pc, s, tipo_da_letra(r));
+}
+
+/* Simula a instrucao em pc sobre s e propaga o estado para os sucessores */
+static Status simular(Verificador *v, u4 pc, Estado *s, u4 tam) {
+    const u1 *ins = v->code->code + pc;
+    u1 op = ins[0];
+    int cai = 1;    /* segue para pc + tam */
+
+    const char *efeito = efeito_simples(op);
+    if (efeito) {
+        TENTAR(aplicar_efeito(v, pc, s, efeito));
+    } else if (op >= 0x12 && op <= 0x14) {
+        TENTAR(verificar_ldc(v, pc, s, op == 0x12 ? ins[1] : be16u(ins + 1), op == 0x14));
+    } else if (op >= 0x15 && op <= 0x19) {
+        static const u1 tipos[] = { T_INT, T_LONG, T_FLOAT, T_DOUBLE, T_REF };
+        TENTAR(carregar_local(v, pc, s, ins[1], tipos[op - 0x15]));
+    } else if (op >= 0x1A && op <= 0x2D) {
+        static const u1 tipos[] = { T_INT, T_LONG, T_FLOAT, T_DOUBLE, T_REF };
+        TENTAR(carregar_local(v, pc, s, (u4)(op - 0x1A) % 4, tipos[(op - 0x1A) / 4]));
+    } else if (op >= 0x36 && op <= 0x3A) {
+        static const u1 tipos[] = { T_INT, T_LONG, T_FLOAT, T_DOUBLE, T_REF };
+        TENTAR(gravar_local(v, pc, s, ins[1], tipos[op - 0x36]));
+    } else if (op >= 0x3B && op <= 0x4E) {
+        static const u1 tipos[] = { T_INT, T_LONG, T_FLOAT, T_DOUBLE, T_REF };
+        TENTAR(gravar_local(v, pc, s, (u4)(op - 0x3B) % 4, tipos[(op - 0x3B) / 4]));
+    } else if (op >= 0x57 && op <= 0x5F) {
+        switch (op) {
+        case 0x57: /* pop */
+        case 0x58: /* pop2 */ {
+            u2 n = (u2)(op - 0x56);
+            if (!corte_valido(s, n)) return falhar(v, pc, "pop sobre pilha incompativel");
+            s->sp = (u2)(s->sp - n);
+        } break;
+        case 0x59: TENTAR(duplicar(v, pc, s, 1, 0)); break;
+        case 0x5A: TENTAR(duplicar(v, pc, s, 1, 1)); break;
+        case 0x5B: TENTAR(duplicar(v, pc, s, 1, 2)); break;
+        case 0x5C: TENTAR(duplicar(v, pc, s, 2, 0)); break;
+        case 0x5D: TENTAR(duplicar(v, pc, s, 2, 1)); break;
+        case 0x5E: TENTAR(duplicar(v, pc, s, 2, 2)); break;
+        default: /* swap: dois valores de categoria 1 */
+            if (s->sp < 2 || s->pilha[s->sp - 1] == T_METADE || s->pilha[s->sp - 2] == T_METADE ||
+                categoria2(s->pilha[s->sp - 1]) || categoria2(s->pilha[s->sp - 2])) {
+                return falhar(v, pc, "swap exige dois valores de categoria 1");
+            } else {
+                u1 t = s->pilha[s->sp - 1];
+                s->pilha[s->sp - 1] = s->pilha[s->sp - 2];
+                s->pilha[s->sp - 2] = t;
+            }
+            break;
+        }
+    } else if (op == 0x84 || (op == 0xC4 && ins[1] == 0x84)) {
+        u4 idx = op == 0x84 ? ins[1] : be16u(ins + 2);
+        if (idx >= v->nlocals || s->loc[idx] != T_INT) return falhar(v, pc, "iinc em local %u que nao e int", idx);
+    } else if (op == 0xC4) {
+        u1 alvo = ins[1];
+        u4 idx = be16u(ins + 2);
+        static const u1 tipos[] = { T_INT, T_LONG, T_FLOAT, T_DOUBLE, T_REF };
+        if (alvo == 0xA9) return falhar(v, pc, "jsr/ret nao suportados");
+        if (alvo <= 0x19) TENTAR(carregar_local(v, pc, s, idx, tipos[alvo - 0x15]));
+        else TENTAR(gravar_local(v, pc, s, idx, tipos[alvo - 0x36]));
+    } else if ((op >= 0x99 && op <= 0xA7) || op == 0xC6 || op == 0xC7 || op == 0xC8) {
+        if (op <= 0x9E) TENTAR(desempilhar(v, pc, s, T_INT));
+        else if (op <= 0xA4) {
+            TENTAR(desempilhar(v, pc, s, T_INT));
+            TENTAR(desempilhar(v, pc, s, T_INT));
+        } else if (op <= 0xA6) {
+            TENTAR(desempilhar(v, pc, s, T_REF));
+            TENTAR(desempilhar(v, pc, s, T_REF));
+        } else if (op == 0xC6 || op == 0xC7) {
+            TENTAR(desempilhar(v, pc, s, T_REF));
+        }
+        int32_t off = op == 0xC8 ? be32(ins + 1) : be16(ins + 1);
+        int64_t alvo = (int64_t)pc + off;
+        if (alvo < 0 || alvo >= v->code->code_length) return falhar(v, pc, "salto para fora do codigo");
+        TENTAR(fluir(v, pc, s, (u4)alvo));
+        cai = op != 0xA7 && op != 0xC8;
+    } else if (op == 0xA8 || op == 0xA9 || op == 0xC9) {
+        return falhar(v, pc, "jsr/ret nao suportados");
+    } else if (op == 0xAA || op == 0xAB) {
+        TENTAR(desempilhar(v, pc, s, T_INT));
+        u4 base = (pc + 4) & ~3u;
+        const u1 *tab = v->code->code + base;
+        u4 n = op == 0xAA ? (u4)((int64_t)be32(tab + 8) - be32(tab + 4) + 1) : (u4)be32(tab + 4);
+        for (u4 k = 0; k <= n; k++) {
+            /* k == n: default */
+            int32_t off = k == n ? be32(tab) : (op == 0xAA ? be32(tab + 12 + 4 * k) : be32(tab + 12 + 8 * k));
+            int64_t alvo = (int64_t)pc + off;
+            if (alvo < 0 || alvo >= v->code->code_length) return falhar(v, pc, "switch salta para fora do codigo");
+            TENTAR(fluir(v, pc, s, (u4)alvo));
+        }
+        cai = 0;
+    } else if (op >= 0xAC && op <= 0xB1) {
+        TENTAR(verificar_retorno(v, pc, s, op));
+        cai = 0;
+    } else if (op >= 0xB2 && op <= 0xB5) {
+        TENTAR(verificar_campo(v, pc, s, op, be16u(ins + 1)));
+    } else if (op >= 0xB6 && op <= 0xBA) {
+        TENTAR(verificar_invocacao(v, pc, s, op, ins));
+    } else if (op == 0xBB) {
+        TENTAR(exigir_tag(v, pc, be16u(ins + 1), CONSTANT_Class, CONSTANT_Class));
+        TENTAR(empilhar(v, pc, s, T_REF));
+    } else if (op == 0xBC) {
+        if (ins[1] < 4 || ins[1] > 11) return falhar(v, pc, "newarray com tipo %u invalido", ins[1]);
+        TENTAR(aplicar_efeito(v, pc, s, "I>A"));
+    } else if (op == 0xBD || op == 0xC0 || op == 0xC1) {
+        TENTAR(exigir_tag(v, pc, be16u(ins + 1), CONSTANT_Class, CONSTANT_Class));
+        TENTAR(aplicar_efeito(v, pc, s, op == 0xBD ? "I>A" : op == 0xC0 ? "A>A" : "A>I"));
+    } else if (op == 0xBF) {
+        TENTAR(desempilhar(v, pc, s, T_REF));
+        cai = 0;
+    } else if (op == 0xC5) {
+        TENTAR(exigir_tag(v, pc, be16u(ins + 1), CONSTANT_Class, CONSTANT_Class));
+        if (ins[3] == 0) return falhar(v, pc, "multianewarray com 0 dimensoes");
+        for (u1 k = 0; k < ins[3]; k++) TENTAR(desempilhar(v, pc, s, T_INT));
+        TENTAR(empilhar(v, pc, s, T_REF));
+    } else {
+        return falhar(v, pc, "opcode 0x%02X invalido", op);
+    }
+
+    if (cai) {
+        if (pc + tam >= v->code->code_length) return falhar(v, pc, "execucao passa do fim do codigo");
+        TENTAR(fluir(v, pc, s, pc + tam));
+    }
+    return OK;
+}
+
+/* ============================================================
+ * API publica
+ * ============================================================ */
+static Status verificar(Verificador *v, const MethodInfo *method) {
+    const CodeAttribute *code = v->code;
+    u4 len = code->code_length;
+
+    /* 1. limites das instrucoes */
+    for (u4 pc = 0; pc < len; ) {
+        u4 tam = tamanho_instrucao(code->code, len, pc);
+        if (!tam) return falhar(v, pc, "instrucao 0x%02X invalida ou truncada", code->code[pc]);
+        v->pc_de[v->ninsns] = pc;
+        v->insn_de[pc] = ++v->ninsns;
+        pc += tam;
+    }
+    for (u2 h = 0; h < code->exception_table_length; h++) {
+        const ExceptionTableEntry *e = &code->exception_table[h];
+        if (e->start_pc >= e->end_pc || e->end_pc > len || !v->insn_de[e->start_pc] ||
+            (e->end_pc < len && !v->insn_de[e->end_pc]) || e->handler_pc >= len || !v->insn_de[e->handler_pc]) {
+            return falhar(v, e->start_pc, "entrada %u da tabela de excecoes invalida", h);
+        }
+        if (e->catch_type) TENTAR(exigir_tag(v, e->handler_pc, e->catch_type, CONSTANT_Class, CONSTANT_Class));
+    }
+
+    if ((size_t)v->ninsns * v->largura > LIMITE_ESTADOS) return falhar(v, 0, "metodo grande demais para verificar");
+    v->estados = (u1 *)calloc((size_t)v->ninsns * v->largura + 1, 1);
+    v->sp = (u2 *)calloc(v->ninsns, sizeof(u2));
+    v->alcancado = (u1 *)calloc(v->ninsns, 1);
+    v->declarado = (u1 *)calloc(v->ninsns, 1);
+    v->na_fila = (u1 *)calloc(v->ninsns, 1);
+    v->fila = (u4 *)malloc(v->ninsns * sizeof(u4));
+    if (!v->estados || !v->sp || !v->alcancado || !v->declarado || !v->na_fila || !v->fila) return ERR_MEMORY;
+
+    /* 2. estado de entrada: 'this' + argumentos */
+    const CpInfo *cp = v->cf->constant_pool;
+    const char *desc = cp_utf8(cp, v->cf->constant_pool_count, method->descriptor_index);
+    u1 lista[256];
+    int n = 0;
+    if (!(method->access_flags & ACC_STATIC)) lista[n++] = T_REF;
+    int nargs = tipos_argumentos(desc, lista + n, 255 - n, &v->retorno);
+    if (nargs < 0) return falhar(v, 0, "descritor do metodo invalido '%s'", desc);
+    n += nargs;
+
+    u1 *trabalho = (u1 *)calloc(v->largura + 1, 1);
+    u1 *pilha_excecao = (u1 *)calloc((size_t)v->nstack + 1, 1);
+    if (!trabalho || !pilha_excecao) {
+        free(trabalho);
+        free(pilha_excecao);
+        return ERR_MEMORY;
+    }
+    Estado s = { trabalho, trabalho + v->nlocals, 0 };
+    Status st = OK;
+    if (expandir(lista, (u2)n, s.loc, v->nlocals) < 0) st = falhar(v, 0, "argumentos excedem max_locals=%u", v->nlocals);
+
+    /* 3. quadros declarados e ponto fixo */
+    if (st == OK) st = aplicar_stack_map(v, lista, (u2)n);
+    if (st == OK) st = fluir(v, 0, &s, 0);
+    while (st == OK && v->nfila) {
+        u4 i = v->fila[--v->nfila];
+        v->na_fila[i] = 0;
+        u4 pc = v->pc_de[i];
+
+        memcpy(trabalho, estado_de(v, i), v->largura);
+        s.sp = v->sp[i];
+        st = fluir_handlers(v, pc, &s, pilha_excecao);
+
+        u4 tam = (i + 1 < v->ninsns ? v->pc_de[i + 1] : len) - pc;
+        if (st == OK) st = simular(v, pc, &s, tam);
+        /* locais apos a instrucao tambem chegam aos handlers (ex: store dentro do try) */
+        if (st == OK) st = fluir_handlers(v, pc, &s, pilha_excecao);
+    }
+
+    free(trabalho);
+    free(pilha_excecao);
+    return st;
+}
+
+Status verify_method(const ClassFile *cf, const MethodInfo *method, const CodeAttribute *code,
+                     VerifyError *err) {
+    return verify_method_depths(cf, method, code, NULL, err);
+}
+
+Status verify_method_depths(const ClassFile *cf, const MethodInfo *method, const CodeAttribute *code,
+                            int32_t *depth, VerifyError *err) {
+    if (err) {
+        err->pc = 0;
+        err->message[0] = '\0';
+    }
+    if (!cf || !method || !code || !code->code || code->code_length == 0) return ERR_BOUNDS;
+
+    Verificador v;
+    memset(&v, 0, sizeof v);
+    v.cf = cf;
+    v.code = code;
+    v.nlocals = code->max_locals;
+    v.nstack = code->max_stack;
+    v.largura = (size_t)code->max_locals + code->max_stack;
+    v.err = err;
+    v.insn_de = (u4 *)calloc(code->code_length, sizeof(u4));
+    v.pc_de = (u4 *)malloc(code->code_length * sizeof(u4));
+
+    Status st = (v.insn_de && v.pc_de) ? verificar(&v, method) : ERR_MEMORY;
+    if (st == OK && depth) {
+        for (u4 pc = 0; pc < code->code_length; pc++) depth[pc] = -1;
+        for (u4 i = 0; i < v.ninsns; i++) {
+            if (v.alcancado[i]) depth[v.pc_de[i]] = v.sp[i];
+        }
+    }
+
+    free(v.insn_de);
+    free(v.pc_de);
+    free(v.estados);
+    free(v.sp);
+    free(v.alcancado);
+    free(v.declarado);
+    free(v.na_fila);
+    free(v.fila);
+    return st;
+}
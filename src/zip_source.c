@@ -0,0 +1,267 @@
+#define _POSIX_C_SOURCE 200809L
+#include "zip_source.h"
+#include "inflate.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SIG_LOCAL   0x04034b50u
+#define SIG_CENTRAL 0x02014b50u
+#define SIG_FIM     0x06054b50u
+
+#define TAM_LOCAL   30
+#define TAM_CENTRAL 46
+#define TAM_FIM     22
+
+#define METODO_ARMAZENADO 0
+#define METODO_DEFLATE    8
+
+typedef struct {
+    const char *name;       /* no pool de nomes (terminado em '\0') */
+    u4 name_hash;
+    u2 method;
+    u2 flags;
+    u4 crc;
+    u4 compressed_size;
+    u4 size;
+    u4 local_offset;
+} ZipEntry;
+
+struct zip_source {
+    const u1 *base;
+    size_t size;
+
+    ZipEntry *entries;
+    size_t count;
+    char *names;            /* pool com todos os nomes */
+
+    u4 *table;              /* indice + 1 (0 = livre) */
+    u4 mask;
+};
+
+/* Campos do zip sao little-endian */
+static u2 le16(const u1 *p) { return (u2)(p[0] | (p[1] << 8)); }
+static u4 le32(const u1 *p) { return (u4)p[0] | ((u4)p[1] << 8) | ((u4)p[2] << 16) | ((u4)p[3] << 24); }
+
+static u4 hash_nome(const char *s) {
+    u4 h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)s; *p; ++p) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* ============================================================
+ * CRC-32 (polinomio 0xEDB88320, tabela montada uma vez)
+ * ============================================================ */
+static u4 tabela_crc[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void montar_tabela_crc(void) {
+    for (u4 n = 0; n < 256; n++) {
+        u4 c = n;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        tabela_crc[n] = c;
+    }
+}
+
+static u4 crc32(const u1 *p, size_t n) {
+    u4 c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < n; i++) c = tabela_crc[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+/* ============================================================
+ * Diretorio central
+ * ============================================================ */
+
+/* Procura o registro de fim de diretorio nos ultimos 64 KiB (+22) do arquivo. */
+static const u1 *achar_fim(const u1 *base, size_t size) {
+    if (size < TAM_FIM) return NULL;
+    size_t limite = size - TAM_FIM;
+    size_t minimo = limite > 0xFFFF ? limite - 0xFFFF : 0;
+    for (size_t pos = limite + 1; pos-- > minimo; ) {
+        const u1 *p = base + pos;
+        if (le32(p) == SIG_FIM && pos + TAM_FIM + le16(p + 20) <= size) return p;
+    }
+    return NULL;
+}
+
+static Status indexar(ZipArchive *zip) {
+    const u1 *fim = achar_fim(zip->base, zip->size);
+    if (!fim) return ERR_FILE;
+
+    size_t total = le16(fim + 10);
+    u4 cd_size = le32(fim + 12);
+    u4 cd_off = le32(fim + 16);
+    /* discos multiplos / ZIP64 */
+    if (le16(fim + 4) != 0 || le16(fim + 8) != total || cd_off == 0xFFFFFFFFu) return ERR_FILE;
+    if ((size_t)cd_off > zip->size || (size_t)cd_size > zip->size - cd_off) return ERR_BOUNDS;
+
+    /* 1a passada: valida os registros e mede o pool de nomes */
+    size_t nomes = 0;
+    const u1 *p = zip->base + cd_off;
+    const u1 *cd_fim = p + cd_size;
+    for (size_t i = 0; i < total; i++) {
+        if ((size_t)(cd_fim - p) < TAM_CENTRAL || le32(p) != SIG_CENTRAL) return ERR_BOUNDS;
+        size_t reg = TAM_CENTRAL + (size_t)le16(p + 28) + le16(p + 30) + le16(p + 32);
+        if ((size_t)(cd_fim - p) < reg) return ERR_BOUNDS;
+        nomes += (size_t)le16(p + 28) + 1;
+        p += reg;
+    }
+
+    zip->entries = (ZipEntry *)calloc(total ? total : 1, sizeof(ZipEntry));
+    zip->names = (char *)malloc(nomes ? nomes : 1);
+    u4 cap = 4;
+    while (cap < total * 2) cap <<= 1;
+    zip->table = (u4 *)calloc(cap, sizeof(u4));
+    if (!zip->entries || !zip->names || !zip->table) return ERR_MEMORY;
+    zip->mask = cap - 1;
+
+    /* 2a passada: copia os nomes e indexa (nome repetido: vale o primeiro) */
+    char *nome = zip->names;
+    p = zip->base + cd_off;
+    for (size_t i = 0; i < total; i++) {
+        ZipEntry *e = &zip->entries[zip->count];
+        u2 nlen = le16(p + 28);
+
+        memcpy(nome, p + TAM_CENTRAL, nlen);
+        nome[nlen] = '\0';
+        e->name = nome;
+        e->name_hash = hash_nome(nome);
+        e->flags = le16(p + 8);
+        e->method = le16(p + 10);
+        e->crc = le32(p + 16);
+        e->compressed_size = le32(p + 20);
+        e->size = le32(p + 24);
+        e->local_offset = le32(p + 42);
+        nome += (size_t)nlen + 1;
+        p += TAM_CENTRAL + (size_t)nlen + le16(p + 30) + le16(p + 32);
+
+        u4 pos = e->name_hash & zip->mask;
+        int repetido = 0;
+        for (; zip->table[pos]; pos = (pos + 1) & zip->mask) {
+            const ZipEntry *o = &zip->entries[zip->table[pos] - 1];
+            if (o->name_hash == e->name_hash && strcmp(o->name, e->name) == 0) { repetido = 1; break; }
+        }
+        if (repetido) continue;
+        zip->count++;
+        zip->table[pos] = (u4)zip->count;
+    }
+    return OK;
+}
+
+/* ============================================================
+ * API pública
+ * ============================================================ */
+ZipArchive *zip_open(const char *path, Status *out_status) {
+    pthread_once(&crc_once, montar_tabela_crc);
+
+    Status st = OK;
+    ZipArchive *zip = NULL;
+    void *map = MAP_FAILED;
+    size_t size = 0;
+
+    int fd = path ? open(path, O_RDONLY) : -1;
+    if (fd < 0) { st = ERR_FILE; goto fim; }
+
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || sb.st_size < TAM_FIM) { st = ERR_FILE; goto fim; }
+    size = (size_t)sb.st_size;
+
+    map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) { st = ERR_FILE; goto fim; }
+
+    zip = (ZipArchive *)calloc(1, sizeof(ZipArchive));
+    if (!zip) { st = ERR_MEMORY; goto fim; }
+    zip->base = (const u1 *)map;
+    zip->size = size;
+
+    st = indexar(zip);
+    if (st != OK) {
+        zip_close(zip);
+        zip = NULL;
+        map = MAP_FAILED;   /* ja desfeito por zip_close */
+    }
+
+fim:
+    if (fd >= 0) close(fd);
+    if (!zip && map != MAP_FAILED) munmap(map, size);
+    if (out_status) *out_status = st;
+    return zip;
+}
+
+void zip_close(ZipArchive *zip) {
+    if (!zip) return;
+    free(zip->entries);
+    free(zip->names);
+    free(zip->table);
+    if (zip->base) munmap((void *)zip->base, zip->size);
+    free(zip);
+}
+
+size_t zip_entry_count(const ZipArchive *zip) {
+    return zip ? zip->count : 0;
+}
+
+const char *zip_entry_name(const ZipArchive *zip, size_t i) {
+    if (!zip || i >= zip->count) return "";
+    return zip->entries[i].name;
+}
+
+long zip_find(const ZipArchive *zip, const char *name) {
+    if (!zip || !name) return -1;
+    u4 h = hash_nome(name);
+    for (u4 pos = h & zip->mask; zip->table[pos]; pos = (pos + 1) & zip->mask) {
+        const ZipEntry *e = &zip->entries[zip->table[pos] - 1];
+        if (e->name_hash == h && strcmp(e->name, name) == 0) return (long)zip->table[pos] - 1;
+    }
+    return -1;
+}
+
+Status zip_read_entry(const ZipArchive *zip, size_t i, Buffer *out) {
+    if (!zip || !out || i >= zip->count) return ERR_FILE;
+    memset(out, 0, sizeof *out);
+
+    const ZipEntry *e = &zip->entries[i];
+    if (e->flags & 1) return ERR_FILE;  /* criptografada */
+
+    /* o cabecalho local tem seus proprios tamanhos de nome/extra */
+    size_t off = e->local_offset;
+    if (off > zip->size || zip->size - off < TAM_LOCAL) return ERR_BOUNDS;
+    const u1 *local = zip->base + off;
+    if (le32(local) != SIG_LOCAL) return ERR_BOUNDS;
+    off += TAM_LOCAL + (size_t)le16(local + 26) + le16(local + 28);
+    if (off > zip->size || zip->size - off < e->compressed_size) return ERR_BOUNDS;
+    const u1 *dados = zip->base + off;
+
+    if (e->method == METODO_ARMAZENADO) {
+        if (e->compressed_size != e->size) return ERR_BOUNDS;
+        /* sem copia: a classe e lida direto do mapeamento */
+        out->data = (u1 *)dados;
+        out->size = e->size;
+        out->borrowed = 1;
+        return OK;
+    }
+    if (e->method != METODO_DEFLATE) return ERR_FILE;
+
+    u1 *data = (u1 *)malloc(e->size ? e->size : 1);
+    if (!data) return ERR_MEMORY;
+
+    size_t gerados = 0;
+    Status st = inflate_raw(dados, e->compressed_size, data, e->size, &gerados);
+    if (st == OK && (gerados != e->size || crc32(data, gerados) != e->crc)) st = ERR_BOUNDS;
+    if (st != OK) {
+        free(data);
+        return st;
+    }
+
+    out->data = data;
+    out->size = e->size;
+    return OK;
+}
@@ -15,6 +15,16 @@ OUTPUT_DIR="tests/output"  # Saída do teste atual
 # Vamos usar o Example (simples) e o ExampleJava8 (complexo)
 TEST_FILES=("Example" "ExampleJava8")
 
+# Execução (-run): o golden é a saída do interpretador sem peephole
+# (stdout e depois stderr); cada modo tem de reproduzi-la
+RUN_FILES=("Vetores" "Constantes" "Inline")
+RUN_REFERENCE="-run --no-peephole"
+RUN_MODES=("-run --no-peephole" "-run" "-run --regvm" "-run --regvm --no-vectorize" "-run --regvm --no-peephole")
+
+# --verbose: linhas "[regvm] desotimização" (pc e linha do inlinado e de cada chamador)
+DEOPT_FILES=("Inline")
+DEOPT_FLAGS="-run --regvm --no-peephole --verbose"
+
 # Cores para a saída
 GREEN="\033[0;32m"
 RED="\033[0;31m"
@@ -58,6 +68,17 @@ if [ "$1" == "--generate" ]; then
         echo "    -> Gerando $GOLDEN_JSON"
         "$VISUALIZADOR" --json "$CLASS_FILE" > "$GOLDEN_JSON"
     done
+    for base_name in "${RUN_FILES[@]}"; do
+        GOLDEN_RUN="$GOLDEN_DIR/$base_name.run.golden"
+        echo "    -> Gerando $GOLDEN_RUN"
+        "$VISUALIZADOR" "$SAMPLES_DIR/$base_name.class" $RUN_REFERENCE > "$GOLDEN_RUN" 2> "$OUTPUT_DIR/$base_name.run.err" || true
+        cat "$OUTPUT_DIR/$base_name.run.err" >> "$GOLDEN_RUN"
+    done
+    for base_name in "${DEOPT_FILES[@]}"; do
+        GOLDEN_DEOPT="$GOLDEN_DIR/$base_name.deopt.golden"
+        echo "    -> Gerando $GOLDEN_DEOPT"
+        "$VISUALIZADOR" "$SAMPLES_DIR/$base_name.class" $DEOPT_FLAGS 2>&1 >/dev/null | grep '^\[regvm\] desotimiza' > "$GOLDEN_DEOPT" || true
+    done
     echo -e "${GREEN}[✓] Golden files gerados! Verifique-os manualmente e faca o commit.${NC}"
     exit 0
 fi
@@ -114,6 +135,36 @@ for base_name in "${TEST_FILES[@]}"; do
     fi
 done
 
+for base_name in "${RUN_FILES[@]}"; do
+    echo "  --- Executando: $base_name ---"
+    GOLDEN_RUN="$GOLDEN_DIR/$base_name.run.golden"
+    OUTPUT_RUN="$OUTPUT_DIR/$base_name.run.out"
+    for mode in "${RUN_MODES[@]}"; do
+        # O sample pode terminar em erro de propósito: o código de saída não conta
+        "$VISUALIZADOR" "$SAMPLES_DIR/$base_name.class" $mode > "$OUTPUT_RUN" 2> "$OUTPUT_DIR/$base_name.run.err" || true
+        cat "$OUTPUT_DIR/$base_name.run.err" >> "$OUTPUT_RUN"
+        if diff -u "$GOLDEN_RUN" "$OUTPUT_RUN"; then
+            echo -e "    ${GREEN}PASSOU ($mode)${NC}"
+        else
+            echo -e "    ${RED}FALHOU ($mode): Saida difere do golden file.${NC}"
+            FAILED_TESTS=$((FAILED_TESTS + 1))
+        fi
+    done
+done
+
+for base_name in "${DEOPT_FILES[@]}"; do
+    echo "  --- Desotimizando: $base_name ---"
+    GOLDEN_DEOPT="$GOLDEN_DIR/$base_name.deopt.golden"
+    OUTPUT_DEOPT="$OUTPUT_DIR/$base_name.deopt.out"
+    "$VISUALIZADOR" "$SAMPLES_DIR/$base_name.class" $DEOPT_FLAGS 2>&1 >/dev/null | grep '^\[regvm\] desotimiza' > "$OUTPUT_DEOPT" || true
+    if diff -u "$GOLDEN_DEOPT" "$OUTPUT_DEOPT"; then
+        echo -e "    ${GREEN}PASSOU (desotimizacao)${NC}"
+    else
+        echo -e "    ${RED}FALHOU (desotimizacao): Saida difere do golden file.${NC}"
+        FAILED_TESTS=$((FAILED_TESTS + 1))
+    fi
+done
+
 # --- Etapa 5: Relatório Final ---
 if [ "$FAILED_TESTS" -eq 0 ]; then
     echo -e "\n${GREEN}[✓] Todos os testes passaram!${NC}"
@@ -0,0 +1,31 @@
+/**
+ * Aritmética inteira com operandos constantes, que o otimizador peephole
+ * dobra na carga: a saída tem de ser a mesma com --no-peephole
+ * (tests/golden/Constantes.run.golden). Inclui os casos que não podem ser
+ * dobrados: resultado fora do sipush, Integer.MIN_VALUE / -1 e divisão por zero.
+ *
+ * O javac dobraria estas expressões na compilação; Constantes.class foi
+ * montado à mão para que os operandos cheguem à pilha (bipush/sipush/ldc;
+ * iconst; op).
+ */
+public class Constantes {
+    public static void main(String[] args) {
+        System.out.println(6 + 7);                          // 13
+        System.out.println(100 - 250);                      // -150
+        System.out.println(-300 * 100);                     // -30000
+        System.out.println(1000 * 1000);                    // 1000000 (não cabe num sipush)
+        System.out.println(-(2 * 3 + 4));                   // -10 (dobras encadeadas)
+        System.out.println(100 / 7);                        // 14
+        System.out.println(-100 / 7);                       // -14
+        System.out.println(-100 % 7);                       // -2
+        System.out.println(100 % -7);                       // 2
+        System.out.println(-128 / -1);                      // 128
+        System.out.println(-32768 / -1);                    // 32768
+        System.out.println(Integer.MIN_VALUE / -1);         // -2147483648
+        System.out.println(Integer.MIN_VALUE % -1);         // 0
+        System.out.println(-Integer.MIN_VALUE);             // -2147483648
+        System.out.println(Integer.MIN_VALUE - 1);          // 2147483647
+        System.out.println(5 / 0);                          // Divisão por zero: a execução para aqui
+        System.out.println(1);
+    }
+}
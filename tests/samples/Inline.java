@@ -0,0 +1,22 @@
+/**
+ * Chamada inlinada pelo --regvm que desotimiza: dividir(7, 0) divide por
+ * zero dentro do corpo inlinado em main. Com --verbose, a linha
+ * "[regvm] desotimização" tem de apontar dividir, linha 13, chamado de
+ * main, linha 20 (tests/golden/Inline.deopt.golden); a saída é a do
+ * interpretador (tests/golden/Inline.run.golden).
+ *
+ * Inline.class foi montado à mão, no formato do javac, com a
+ * LineNumberTable das linhas deste arquivo.
+ */
+public class Inline {
+    static int dividir(int a, int b) {
+        return a / b;
+    }
+
+    public static void main(String[] args) {
+        int s = 0;
+        for (int i = 1; i <= 5; i++) s += dividir(100, i);
+        System.out.println(s);                  // 228
+        System.out.println(dividir(7, 0));      // Divisão por zero
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * Laços sobre int[] que o --regvm vetoriza (soma, a + b, a - b, preenchimento
+ * e cópia) e um laço cujo limite passa do tamanho do array.
+ * A saída de toda combinação de --regvm, --no-vectorize e --no-peephole tem
+ * de ser a do interpretador (tests/golden/Vetores.run.golden).
+ *
+ * Vetores.class foi montado à mão, no formato do javac (teste no cabeçalho,
+ * goto no fim do corpo), com i e s sempre nas locais 6 e 5.
+ */
+public class Vetores {
+    public static void main(String[] args) {
+        int n = 1000;
+        int[] a = new int[n];
+        int[] b = new int[n];
+        int[] c = new int[n];
+        int s;
+        for (int i = 0; i < n; i++) {
+            a[i] = i * 3 + 1;
+            b[i] = i - 500;
+        }
+
+        for (int i = 0; i < n; i++) c[i] = a[i] + b[i];
+        s = 0;
+        for (int i = 0; i < n; i++) s += c[i];
+        System.out.println(s);              // 1499000
+
+        for (int i = 0; i < n; i++) c[i] = a[i] - b[i];
+        s = 0;
+        for (int i = 0; i < n; i++) s += c[i];
+        System.out.println(s);              // 1500000
+        System.out.println(c[999]);         // 2499
+
+        for (int i = 0; i < c.length; i++) c[i] = 7;
+        s = 0;
+        for (int i = 0; i < n; i++) s += c[i];
+        System.out.println(s);              // 7000
+
+        for (int i = 0; i < n; i++) c[i] = 2000000000;
+        s = 0;
+        for (int i = 0; i < n; i++) s += c[i];
+        System.out.println(s);              // -1454759936 (transborda como int)
+
+        for (int i = 0; i < n; i++) c[i] = a[i];
+        s = 0;
+        for (int i = 0; i < n; i++) s += c[i];
+        System.out.println(s);              // 1499500
+        System.out.println(c[500]);         // 1501
+
+        // Limite além do tamanho: ArrayIndexOutOfBoundsException no índice 1000
+        s = n + 4;
+        for (int i = 0; i < s; i++) c[i] = b[i];
+        System.out.println(c[0]);           // não chega aqui
+    }
+}